@@ -19,7 +19,42 @@ setup(name='auracore',
           Extension('auracore.windtri',
                     define_macros=[('HAVE_PYBIND11', '1')],
                     sources=['util/windtri.cxx'],
-                    depends=['util/windtri.hxx']
+                    depends=['util/windtri.hxx', 'util/arrays.hxx']
+          ),
+          Extension('auracore.lowpass',
+                    define_macros=[('HAVE_PYBIND11', '1')],
+                    sources=['util/lowpass.cxx'],
+                    depends=['util/lowpass.hxx', 'util/arrays.hxx']
+          ),
+          Extension('auracore.geodesy',
+                    define_macros=[('HAVE_PYBIND11', '1')],
+                    sources=['util/geodesy.cxx',
+                             '../src/filters/nav_common/nav_functions_double.cxx'],
+                    depends=['util/geodesy.hxx', 'util/arrays.hxx']
+          ),
+          Extension('auracore.ekf15',
+                    define_macros=[('HAVE_PYBIND11', '1')],
+                    sources=['util/ekf15.cxx',
+                             '../src/filters/nav_ekf15/EKF_15state.cxx',
+                             '../src/filters/nav_common/nav_functions_float.cxx'],
+                    depends=['util/ekf15.hxx', 'util/arrays.hxx']
+          ),
+          Extension('auracore.packets',
+                    define_macros=[('HAVE_PYBIND11', '1')],
+                    sources=['util/packets.cxx'],
+                    depends=['util/packets.hxx', 'util/arrays.hxx']
+          ),
+          Extension('auracore.routegeo',
+                    define_macros=[('HAVE_PYBIND11', '1')],
+                    sources=['util/routegeo.cxx',
+                             '../src/filters/nav_common/nav_functions_double.cxx'],
+                    depends=['util/routegeo.hxx']
+          ),
+          Extension('auracore.coverage',
+                    define_macros=[('HAVE_PYBIND11', '1')],
+                    sources=['util/coverage.cxx',
+                             '../src/filters/nav_common/nav_functions_double.cxx'],
+                    depends=['util/coverage.hxx']
           )
       ]
       )
@@ -0,0 +1,26 @@
+#pragma once
+
+// numpy buffers shared by the array kernels.  Inputs are taken as c
+// contiguous doubles; arrays that already are that are used in place,
+// anything else is converted once on the way in.
+
+#include <stdexcept>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+namespace py = pybind11;
+
+typedef py::array_t<double, py::array::c_style | py::array::forcecast> darray;
+
+// require an array shaped (n) or (n, cols)
+static inline ssize_t check_rows( const darray &a, ssize_t cols,
+                                  const char *name )
+{
+    bool ok = (cols == 0) ? a.ndim() == 1
+        : (a.ndim() == 2 && a.shape(1) == cols);
+    if ( !ok ) {
+        throw std::invalid_argument( std::string(name)
+                                     + " has the wrong shape" );
+    }
+    return a.shape(0);
+}
@@ -0,0 +1,468 @@
+#include <math.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "coverage.hxx"
+
+static const double d2r = M_PI / 180.0;
+static const double r2d = 180.0 / M_PI;
+
+// cost of flying a connection through a no-fly polygon
+static const double nofly_penalty_sec = 1.0e6;
+
+// rotation from the local ned frame at lat/lon (radians) to ecef
+static Matrix3d ned2ecef_dcm( double lat, double lon ) {
+    double sin_lat = sin(lat), cos_lat = cos(lat);
+    double sin_lon = sin(lon), cos_lon = cos(lon);
+    Matrix3d C;
+    C << -sin_lat*cos_lon, -sin_lat*sin_lon,  cos_lat,
+         -sin_lon,          cos_lon,          0.0,
+         -cos_lat*cos_lon, -cos_lat*sin_lon, -sin_lat;
+    return C.transpose();
+}
+
+// u runs along the cut (transect) direction and v along the advance
+// direction, same as survey/area.py: cut = (-adv.y, adv.x) in
+// (east, north)
+void CoveragePlanner::to_local( const lonlat_t &p, double *u, double *v ) {
+    Vector3d ecef = lla2ecef( Vector3d(p.second * d2r, p.first * d2r, 0.0) );
+    Vector3d ned = ned2ecef.transpose() * (ecef - ref_ecef);
+    *u = -adv_n * ned(1) + adv_e * ned(0);
+    *v = adv_e * ned(1) + adv_n * ned(0);
+}
+
+CoveragePlanner::lonlat_t CoveragePlanner::to_lonlat( double u, double v ) {
+    double east = -adv_n * u + adv_e * v;
+    double north = adv_e * u + adv_n * v;
+    Vector3d lla = ecef2lla( ref_ecef + ned2ecef * Vector3d(north, east, 0.0) );
+    return lonlat_t( lla(1) * r2d, lla(0) * r2d );
+}
+
+void CoveragePlanner::add_ring( const vector<lonlat_t> &ring, int id,
+                                bool is_nofly )
+{
+    int n = ring.size();
+    if ( n < 3 ) {
+        return;
+    }
+    vector<double> u(n), v(n);
+    for ( int i = 0; i < n; i++ ) {
+        to_local( ring[i], &u[i], &v[i] );
+    }
+    if ( is_nofly ) {
+        nofly_ring_t r;
+        r.first = nofly.size();
+        r.last = r.first + n;
+        r.u_min = *std::min_element( u.begin(), u.end() );
+        r.u_max = *std::max_element( u.begin(), u.end() );
+        r.v_min = *std::min_element( v.begin(), v.end() );
+        r.v_max = *std::max_element( v.begin(), v.end() );
+        nofly_rings.push_back( r );
+    }
+    for ( int i = 0; i < n; i++ ) {
+        int j = (i + 1) % n;
+        edge_t e;
+        e.ring = id;
+        if ( v[i] <= v[j] ) {
+            e.v0 = v[i]; e.u0 = u[i]; e.v1 = v[j]; e.u1 = u[j];
+        } else {
+            e.v0 = v[j]; e.u0 = u[j]; e.v1 = v[i]; e.u1 = u[i];
+        }
+        if ( is_nofly ) {
+            nofly.push_back( e );
+        }
+        if ( e.v1 > e.v0 ) {
+            // horizontal edges never cross a scan line
+            edges.push_back( e );
+        }
+    }
+}
+
+void CoveragePlanner::start( const vector<lonlat_t> &area,
+                             const vector< vector<lonlat_t> > &holes,
+                             const vector< vector<lonlat_t> > &nofly_areas,
+                             double step, double extend, double advance_deg,
+                             double wind_north_mps, double wind_east_mps,
+                             double tas, double turn_radius )
+{
+    if ( area.size() < 3 ) {
+        throw std::invalid_argument("survey area needs at least 3 points");
+    }
+    if ( step < 1.0 ) {
+        throw std::invalid_argument("transect spacing too small");
+    }
+    step_m = step;
+    extend_m = extend;
+    tas_mps = tas > 1.0 ? tas : 1.0;
+    turn_radius_m = turn_radius;
+    adv_n = cos(advance_deg * d2r);
+    adv_e = sin(advance_deg * d2r);
+    wind_u = -adv_n * wind_east_mps + adv_e * wind_north_mps;
+    wind_v = adv_e * wind_east_mps + adv_n * wind_north_mps;
+
+    ref_lla = Vector3d( area[0].second * d2r, area[0].first * d2r, 0.0 );
+    ref_ecef = lla2ecef( ref_lla );
+    ned2ecef = ned2ecef_dcm( ref_lla(0), ref_lla(1) );
+
+    edges.clear();
+    nofly.clear();
+    nofly_rings.clear();
+    add_ring( area, 0, false );
+    int id = 1;
+    for ( size_t i = 0; i < holes.size(); i++ ) {
+        add_ring( holes[i], id++, false );
+    }
+    for ( size_t i = 0; i < nofly_areas.size(); i++ ) {
+        add_ring( nofly_areas[i], id++, true );
+    }
+    std::sort( edges.begin(), edges.end(),
+               []( const edge_t &a, const edge_t &b ) { return a.v0 < b.v0; } );
+
+    rings = id;
+
+    // the outer ring bounds the scan (the reference point is on it so
+    // the range includes 0)
+    double v_min = 0.0;
+    v_end = 0.0;
+    for ( size_t i = 0; i < edges.size(); i++ ) {
+        if ( edges[i].ring == 0 ) {
+            if ( edges[i].v0 < v_min ) { v_min = edges[i].v0; }
+            if ( edges[i].v1 > v_end ) { v_end = edges[i].v1; }
+        }
+    }
+
+    // transects are centered between band edges one step apart, the
+    // first band edge is at v_min
+    next_edge = 0;
+    active.clear();
+    prev_line.clear();
+    center_line.clear();
+    transects.clear();
+    ordered.clear();
+    v_next = v_min;
+    // just inside so edges that are nearly perpendicular to the
+    // transects at the start don't count
+    scan( v_next + 0.001 * step_m, &prev_line );
+    state = SLICE;
+}
+
+// intervals of the scan line at v that need coverage
+void CoveragePlanner::scan( double v, vector<interval_t> *result ) {
+    result->clear();
+    while ( next_edge < edges.size() && edges[next_edge].v0 <= v ) {
+        active.push_back( next_edge );
+        next_edge++;
+    }
+    vector<crossing_t> cross;
+    size_t keep = 0;
+    for ( size_t i = 0; i < active.size(); i++ ) {
+        const edge_t &e = edges[active[i]];
+        if ( e.v1 < v ) {
+            continue;           // finished, drop it
+        }
+        active[keep++] = active[i];
+        if ( v >= e.v0 && v < e.v1 ) {
+            crossing_t c;
+            c.u = e.u0 + (e.u1 - e.u0) * (v - e.v0) / (e.v1 - e.v0);
+            c.ring = e.ring;
+            cross.push_back( c );
+        }
+    }
+    active.resize( keep );
+    std::sort( cross.begin(), cross.end(),
+               []( const crossing_t &a, const crossing_t &b ) {
+                   return a.u < b.u; } );
+    // inside the outer ring and outside all the others.  Holes and
+    // no-fly areas may reach past the outer boundary or overlap each
+    // other, so track each ring on its own.
+    ring_inside.assign( rings, false );
+    int inner_count = 0;
+    bool was_inside = false;
+    interval_t seg;
+    for ( size_t i = 0; i < cross.size(); i++ ) {
+        int r = cross[i].ring;
+        ring_inside[r] = !ring_inside[r];
+        if ( r > 0 ) {
+            inner_count += ring_inside[r] ? 1 : -1;
+        }
+        bool inside = ring_inside[0] && inner_count == 0;
+        if ( inside && !was_inside ) {
+            seg.ua = cross[i].u;
+            seg.outer_a = r == 0;
+        } else if ( !inside && was_inside ) {
+            seg.ub = cross[i].u;
+            seg.outer_b = r == 0;
+            if ( seg.ub - seg.ua > 0.1 ) {
+                result->push_back( seg );
+            }
+        }
+        was_inside = inside;
+    }
+}
+
+static bool overlaps( const CoveragePlanner::interval_t &a,
+                      const CoveragePlanner::interval_t &b ) {
+    return a.ub >= b.ua && a.ua <= b.ub;
+}
+
+// stretch outer boundary ends so the swath covers the area along the
+// band edge as well (slanted boundaries).  A band edge interval that
+// spans several center intervals bridges a concave notch that starts
+// inside the band, widening across it would fly the notch twice.
+void CoveragePlanner::widen( interval_t *seg, const vector<interval_t> &band ) {
+    for ( size_t i = 0; i < band.size(); i++ ) {
+        const interval_t &b = band[i];
+        if ( !overlaps( b, *seg ) ) {
+            continue;
+        }
+        int spans = 0;
+        for ( size_t j = 0; j < center_line.size(); j++ ) {
+            if ( overlaps( b, center_line[j] ) ) {
+                spans++;
+            }
+        }
+        if ( spans > 1 ) {
+            continue;
+        }
+        if ( seg->outer_a && b.outer_a && b.ua < seg->ua ) {
+            seg->ua = b.ua;
+        }
+        if ( seg->outer_b && b.outer_b && b.ub > seg->ub ) {
+            seg->ub = b.ub;
+        }
+    }
+}
+
+// one transect: the band edge below was scanned already, scan the
+// center and the band edge above
+void CoveragePlanner::slice_step() {
+    if ( v_next >= v_end - 0.05 * step_m ) {
+        // done (a sliver this thin is covered by the sidelap)
+        state = ORDER;
+        return;
+    }
+    double v_center = v_next + 0.5 * step_m;
+    double v_top = v_next + step_m;
+    // the last band can be narrower than a step, slice it inside the
+    // area but still fly it one half step past the band edge
+    scan( std::min(v_center, 0.5 * (v_next + v_end)), &center_line );
+    vector<interval_t> top_line;
+    scan( v_top, &top_line );
+    for ( size_t i = 0; i < center_line.size(); i++ ) {
+        interval_t seg = center_line[i];
+        widen( &seg, prev_line );
+        widen( &seg, top_line );
+        transect_t t;
+        t.v = v_center;
+        t.ua = seg.ua - (seg.outer_a ? extend_m : 0.0);
+        t.ub = seg.ub + (seg.outer_b ? extend_m : 0.0);
+        transects.push_back( t );
+    }
+    prev_line.swap( top_line );
+    v_next = v_top;
+}
+
+// ground speed along (du, dv) in the wind
+double CoveragePlanner::ground_speed( double du, double dv ) {
+    double len = sqrt(du*du + dv*dv);
+    if ( len < 0.001 ) {
+        return tas_mps;
+    }
+    du /= len;
+    dv /= len;
+    double w_par = wind_u * du + wind_v * dv;
+    double w_perp = -wind_u * dv + wind_v * du;
+    double s = tas_mps * tas_mps - w_perp * w_perp;
+    if ( s <= 0.0 ) {
+        return 0.1;             // can't be flown, make it expensive
+    }
+    double gs = sqrt(s) + w_par;
+    return gs > 0.1 ? gs : 0.1;
+}
+
+// true if segment ab passes through segment cd, touching doesn't count
+// (transects often end right on a no-fly boundary)
+static bool segments_cross( double ax, double ay, double bx, double by,
+                            double cx, double cy, double dx, double dy )
+{
+    const double tol = 0.5;     // m
+    double ab = sqrt((bx - ax) * (bx - ax) + (by - ay) * (by - ay));
+    double cd = sqrt((dx - cx) * (dx - cx) + (dy - cy) * (dy - cy));
+    if ( ab < tol || cd < tol ) {
+        return false;
+    }
+    // distances of c, d from line ab and of a, b from line cd
+    double d1 = ((bx - ax) * (cy - ay) - (by - ay) * (cx - ax)) / ab;
+    double d2 = ((bx - ax) * (dy - ay) - (by - ay) * (dx - ax)) / ab;
+    double d3 = ((dx - cx) * (ay - cy) - (dy - cy) * (ax - cx)) / cd;
+    double d4 = ((dx - cx) * (by - cy) - (dy - cy) * (bx - cx)) / cd;
+    return ((d1 > tol && d2 < -tol) || (d1 < -tol && d2 > tol))
+        && ((d3 > tol && d4 < -tol) || (d3 < -tol && d4 > tol));
+}
+
+bool CoveragePlanner::crosses_nofly( double u0, double v0,
+                                     double u1, double v1 )
+{
+    // a connection between two points on a no-fly boundary can run
+    // through it without crossing an edge, so also check the midpoint
+    double um = 0.5 * (u0 + u1);
+    double vm = 0.5 * (v0 + v1);
+    for ( size_t r = 0; r < nofly_rings.size(); r++ ) {
+        const nofly_ring_t &ring = nofly_rings[r];
+        if ( std::max(u0, u1) < ring.u_min || std::min(u0, u1) > ring.u_max
+             || std::max(v0, v1) < ring.v_min
+             || std::min(v0, v1) > ring.v_max ) {
+            continue;           // nowhere near it
+        }
+        bool inside = false;
+        for ( size_t i = ring.first; i < ring.last; i++ ) {
+            const edge_t &e = nofly[i];
+            if ( segments_cross( u0, v0, u1, v1, e.u0, e.v0, e.u1, e.v1 ) ) {
+                return true;
+            }
+            if ( vm >= e.v0 && vm < e.v1 ) {
+                double u = e.u0 + (e.u1 - e.u0) * (vm - e.v0) / (e.v1 - e.v0);
+                if ( u > um ) {
+                    inside = !inside;
+                }
+            }
+        }
+        if ( inside ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// estimated time to connect from the current position and fly t
+// (without the no-fly penalty)
+double CoveragePlanner::cost( const transect_t &t, bool forward ) {
+    double su = forward ? t.ua : t.ub;
+    double eu = forward ? t.ub : t.ua;
+    int dir = forward ? 1 : -1;
+    double du = su - cur_u;
+    double dv = t.v - cur_v;
+    double dist = sqrt(du*du + dv*dv);
+    double time = dist / ground_speed( du, dv );
+    time += fabs(eu - su) / ground_speed( eu - su, 0.0 );
+    // turn from the last transect heading onto the connection and
+    // from the connection onto this transect
+    double h0 = cur_dir > 0 ? 0.0 : M_PI;
+    double h2 = dir > 0 ? 0.0 : M_PI;
+    double h1 = dist > 0.1 ? atan2(dv, du) : h2;
+    double a1 = fabs(remainder(h1 - h0, 2.0 * M_PI));
+    double a2 = fabs(remainder(h2 - h1, 2.0 * M_PI));
+    double turns = (a1 + a2) * turn_radius_m / tas_mps;
+    if ( dir != cur_dir && fabs(dv) < 2.0 * turn_radius_m ) {
+        // too close for a plain reversal, bulb out and back
+        turns += 2.0 * (2.0 * turn_radius_m - fabs(dv)) / tas_mps;
+    }
+    time += turns;
+    return time;
+}
+
+// pick the next transect
+void CoveragePlanner::order_step() {
+    int best = -1;
+    bool best_forward = true;
+    if ( ordered.empty() ) {
+        used.assign( transects.size(), false );
+        if ( transects.empty() ) {
+            state = DONE;
+            return;
+        }
+        // start with the first transect (lowest along the advance
+        // direction) flown in the faster direction
+        best = 0;
+        best_forward = ground_speed( 1.0, 0.0 ) >= ground_speed( -1.0, 0.0 );
+    } else {
+        // the no-fly check is the expensive part of the cost, only
+        // run it on the candidates (cheapest first) that can still
+        // beat the best so far once penalized
+        candidates.clear();
+        for ( size_t i = 0; i < transects.size(); i++ ) {
+            if ( used[i] ) {
+                continue;
+            }
+            for ( int f = 0; f < 2; f++ ) {
+                candidates.push_back(
+                    candidate_t( cost( transects[i], f == 0 ), 2 * i + f ) );
+            }
+        }
+        std::sort( candidates.begin(), candidates.end() );
+        double best_cost = 0.0;
+        for ( size_t k = 0; k < candidates.size(); k++ ) {
+            double c = candidates[k].first;
+            if ( best >= 0 && c >= best_cost ) {
+                break;
+            }
+            int i = candidates[k].second / 2;
+            bool forward = candidates[k].second % 2 == 0;
+            const transect_t &t = transects[i];
+            if ( crosses_nofly( cur_u, cur_v, forward ? t.ua : t.ub, t.v ) ) {
+                c += nofly_penalty_sec;
+            }
+            if ( best < 0 || c < best_cost ) {
+                best = i;
+                best_forward = forward;
+                best_cost = c;
+            }
+        }
+    }
+    used[best] = true;
+    transect_t t = transects[best];
+    if ( !best_forward ) {
+        std::swap( t.ua, t.ub );
+    }
+    ordered.push_back( t );
+    cur_u = t.ub;
+    cur_v = t.v;
+    cur_dir = best_forward ? 1 : -1;
+    if ( ordered.size() == transects.size() ) {
+        state = DONE;
+    }
+}
+
+bool CoveragePlanner::update( int budget ) {
+    for ( int i = 0; i < budget && state != DONE && state != IDLE; i++ ) {
+        if ( state == SLICE ) {
+            slice_step();
+        } else if ( state == ORDER ) {
+            order_step();
+        }
+    }
+    return state == DONE;
+}
+
+vector<CoveragePlanner::lonlat_t> CoveragePlanner::route() {
+    vector<lonlat_t> result;
+    if ( state != DONE ) {
+        return result;
+    }
+    for ( size_t i = 0; i < ordered.size(); i++ ) {
+        result.push_back( to_lonlat( ordered[i].ua, ordered[i].v ) );
+        result.push_back( to_lonlat( ordered[i].ub, ordered[i].v ) );
+    }
+    return result;
+}
+
+
+#ifdef HAVE_PYBIND11
+  PYBIND11_PLUGIN(coverage) {
+      py::module m("coverage", "survey coverage planner for python");
+      py::class_<CoveragePlanner>(m, "Planner")
+          .def(py::init<>())
+          .def("start", &CoveragePlanner::start, py::arg("area"),
+               py::arg("holes"), py::arg("nofly"), py::arg("step_m"),
+               py::arg("extend_m"), py::arg("advance_deg"),
+               py::arg("wind_north_mps") = 0.0,
+               py::arg("wind_east_mps") = 0.0,
+               py::arg("tas_mps") = 20.0, py::arg("turn_radius_m") = 50.0)
+          .def("update", &CoveragePlanner::update, py::arg("budget") = 16)
+          .def("done", &CoveragePlanner::done)
+          .def("transect_count", &CoveragePlanner::transect_count)
+          .def("route", &CoveragePlanner::route);
+      return m.ptr();
+  }
+#endif // HAVE_PYBIND11
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+using std::pair;
+using std::vector;
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+namespace py = pybind11;
+
+#include "../../src/filters/nav_common/nav_functions_double.hxx"
+
+// Survey coverage planner (see src/survey/survey.py.)
+//
+// The survey area is an outer polygon with optional holes (areas that
+// need no coverage) and no-fly polygons, all given as lists of
+// (lon_deg, lat_deg).  Transects run perpendicular to the advance
+// direction, spaced one sidelap step apart.
+//
+// Slicing is a sweep line over the polygon edges sorted by their
+// extent along the advance direction, so each scan line only looks at
+// the edges that actually span it.  Every scan line can produce
+// several transects on concave areas or around holes.  Transect ends
+// on the outer boundary are widened to cover the whole swath and
+// extended for turn room; ends on holes and no-fly polygons are not.
+//
+// Transects are then ordered greedily by estimated flight time from
+// the end of the previous one: the wind corrected time to fly the
+// connection and the transect itself, plus the time to turn (a
+// reversal closer than a turn diameter needs an extra bulb turn.)
+// Connections that cross a no-fly polygon are heavily penalized; the
+// crossing test only runs for the cheapest candidates and skips
+// polygons whose bounding box the connection misses.
+//
+// The work is split into steps: update() does a bounded number of
+// scan lines or ordering picks per call so planning never stalls a
+// frame of the main loop.
+
+class CoveragePlanner {
+
+public:
+
+    typedef pair<double, double> lonlat_t;
+
+    struct interval_t {
+        double ua, ub;
+        bool outer_a, outer_b;  // end lies on the outer boundary
+    };
+
+private:
+
+    struct edge_t {
+        double v0, v1;          // extent along the advance direction
+        double u0, u1;          // cut direction coordinate at v0, v1
+        int ring;               // 0 = outer, > 0 = hole or no-fly
+    };
+
+    struct crossing_t {
+        double u;
+        int ring;
+    };
+
+    // a no-fly polygon's edges in nofly[] and its bounding box
+    struct nofly_ring_t {
+        size_t first, last;
+        double u_min, u_max, v_min, v_max;
+    };
+
+    // (cost without the no-fly penalty, 2 * transect + reversed)
+    typedef pair<double, int> candidate_t;
+
+    struct transect_t {
+        double v;
+        double ua, ub;
+    };
+
+    enum { IDLE, SLICE, ORDER, DONE } state = IDLE;
+
+    // local frame
+    Vector3d ref_lla;
+    Vector3d ref_ecef;
+    Matrix3d ned2ecef;
+    double adv_n = 0.0, adv_e = 1.0;    // advance direction (unit)
+
+    // scan line parameters
+    double step_m = 50.0;
+    double extend_m = 50.0;
+    double v_next = 0.0, v_end = 0.0;
+
+    // wind (in the u/v frame) and turn model
+    double wind_u = 0.0, wind_v = 0.0;
+    double tas_mps = 20.0;
+    double turn_radius_m = 50.0;
+
+    vector<edge_t> edges;       // sorted by v0
+    size_t next_edge = 0;
+    vector<int> active;         // edges spanning the scan line
+    vector<edge_t> nofly;       // no-fly edges only (for connections)
+    vector<nofly_ring_t> nofly_rings;
+    int rings = 1;
+    vector<bool> ring_inside;
+
+    vector<interval_t> prev_line;       // band edge below the transects
+    vector<interval_t> center_line;
+    vector<transect_t> transects;
+
+    // ordering
+    vector<bool> used;
+    vector<candidate_t> candidates;
+    double cur_u = 0.0, cur_v = 0.0;
+    int cur_dir = 1;            // +1/-1 along u
+    vector<transect_t> ordered; // ua is the start, ub the end
+
+    void to_local( const lonlat_t &p, double *u, double *v );
+    lonlat_t to_lonlat( double u, double v );
+    void add_ring( const vector<lonlat_t> &ring, int id, bool is_nofly );
+    void scan( double v, vector<interval_t> *result );
+    void widen( interval_t *seg, const vector<interval_t> &band );
+    void slice_step();
+    double ground_speed( double du, double dv );
+    bool crosses_nofly( double u0, double v0, double u1, double v1 );
+    double cost( const transect_t &t, bool forward );
+    void order_step();
+
+public:
+
+    // step_m: transect spacing, extend_m: run out past the boundary,
+    // advance_deg: true course the transects advance along, wind_*:
+    // wind velocity (the direction the air moves), tas_mps and
+    // turn_radius_m: for the turn cost.
+    void start( const vector<lonlat_t> &area,
+                const vector< vector<lonlat_t> > &holes,
+                const vector< vector<lonlat_t> > &nofly_areas,
+                double step_m, double extend_m, double advance_deg,
+                double wind_north_mps, double wind_east_mps,
+                double tas_mps, double turn_radius_m );
+
+    // do up to budget units of work, returns true once the route is
+    // ready
+    bool update( int budget );
+
+    bool done() { return state == DONE; }
+
+    int transect_count() { return transects.size(); }
+
+    // the route as (lon_deg, lat_deg) pairs, two per transect
+    vector<lonlat_t> route();
+};
@@ -0,0 +1,89 @@
+#include <math.h>
+#include <string.h>
+
+#include "../../src/filters/nav_ekf15/EKF_15state.hxx"
+
+#include "ekf15.hxx"
+
+static const int nav_cols = 16;
+
+darray ekf15_replay( darray imu, darray gps ) {
+    ssize_t n = check_rows( imu, 10, "imu" );
+    ssize_t m = check_rows( gps, 7, "gps" );
+    darray result({n, (ssize_t)nav_cols});
+    const double *imu_in = imu.data();
+    const double *gps_in = gps.data();
+    double *out = result.mutable_data();
+    {
+        py::gil_scoped_release release;
+        EKF15 filter;
+        IMUdata imu_data;
+        GPSdata gps_data;
+        memset( &gps_data, 0, sizeof(gps_data) );
+        bool inited = false;
+        double last_gps_time = 0.0;
+        ssize_t g = 0;
+        for ( ssize_t i = 0; i < n; i++ ) {
+            const double *p = imu_in + i*10;
+            imu_data.time = p[0];
+            imu_data.p = p[1]; imu_data.q = p[2]; imu_data.r = p[3];
+            imu_data.ax = p[4]; imu_data.ay = p[5]; imu_data.az = p[6];
+            imu_data.hx = p[7]; imu_data.hy = p[8]; imu_data.hz = p[9];
+            imu_data.temp = 0.0;
+
+            // newest gps record at or before this imu record
+            bool have_gps = false;
+            while ( g < m && gps_in[g*7] <= p[0] ) {
+                g++;
+                have_gps = true;
+            }
+            if ( have_gps ) {
+                const double *q = gps_in + (g-1)*7;
+                gps_data.time = q[0];
+                gps_data.lat = q[1];
+                gps_data.lon = q[2];
+                gps_data.alt = q[3];
+                gps_data.vn = q[4]; gps_data.ve = q[5]; gps_data.vd = q[6];
+            }
+
+            double *row = out + i*nav_cols;
+            if ( inited ) {
+                filter.time_update( imu_data );
+                if ( gps_data.time > last_gps_time ) {
+                    last_gps_time = gps_data.time;
+                    filter.measurement_update( gps_data );
+                }
+            } else if ( g > 0 ) {
+                filter.init( imu_data, gps_data );
+                last_gps_time = gps_data.time;
+                inited = true;
+            } else {
+                row[0] = p[0];
+                for ( int j = 1; j < nav_cols; j++ ) {
+                    row[j] = NAN;
+                }
+                continue;
+            }
+
+            NAVdata nav = filter.get_nav();
+            row[0] = p[0];
+            row[1] = nav.lat * R2D;
+            row[2] = nav.lon * R2D;
+            row[3] = nav.alt;
+            row[4] = nav.vn; row[5] = nav.ve; row[6] = nav.vd;
+            row[7] = nav.phi; row[8] = nav.the; row[9] = nav.psi;
+            row[10] = nav.abx; row[11] = nav.aby; row[12] = nav.abz;
+            row[13] = nav.gbx; row[14] = nav.gby; row[15] = nav.gbz;
+        }
+    }
+    return result;
+}
+
+
+#ifdef HAVE_PYBIND11
+  PYBIND11_PLUGIN(ekf15) {
+      py::module m("ekf15", "15 state ekf replay for python");
+      m.def("replay", &ekf15_replay, py::arg("imu"), py::arg("gps"));
+      return m.ptr();
+  }
+#endif // HAVE_PYBIND11
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "arrays.hxx"
+
+// Replay the onboard 15 state ekf over a logged flight.
+//
+// imu: (n, 10) time, p, q, r (rad/s), ax, ay, az (m/s^2), hx, hy, hz
+// gps: (m, 7) time, lat_deg, lon_deg, alt_m, vn, ve, vd (m/s)
+//
+// The filter is driven the same way nav_ekf15_update() drives it:
+// it initializes on the first imu record with a gps fix at or before
+// it, then does a time update per imu record and a measurement update
+// whenever a newer gps record has arrived.  Returns (n, 16): time,
+// lat_deg, lon_deg, alt_m, vn, ve, vd, phi, the, psi (rad), abx, aby,
+// abz, gbx, gby, gbz.  Rows before the filter initializes are nan.
+darray ekf15_replay( darray imu, darray gps );
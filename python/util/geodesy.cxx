@@ -0,0 +1,118 @@
+#include <math.h>
+
+#include "../../src/filters/nav_common/nav_functions_double.hxx"
+
+#include "geodesy.hxx"
+
+static const double d2r = M_PI / 180.0;
+static const double r2d = 180.0 / M_PI;
+
+static Vector3d check_ref( darray ref_lla ) {
+    if ( ref_lla.ndim() != 1 || ref_lla.shape(0) != 3 ) {
+        throw std::invalid_argument("ref_lla must be (lat_deg, lon_deg, alt_m)");
+    }
+    const double *r = ref_lla.data();
+    return Vector3d( r[0] * d2r, r[1] * d2r, r[2] );
+}
+
+// rotation from ecef to the local ned frame at ref (radians)
+static Matrix3d ecef2ned_dcm( const Vector3d &ref ) {
+    double sin_lat = sin(ref(0)), cos_lat = cos(ref(0));
+    double sin_lon = sin(ref(1)), cos_lon = cos(ref(1));
+    Matrix3d C;
+    C << -sin_lat*cos_lon, -sin_lat*sin_lon,  cos_lat,
+         -sin_lon,          cos_lon,          0.0,
+         -cos_lat*cos_lon, -cos_lat*sin_lon, -sin_lat;
+    return C;
+}
+
+darray geo_lla2ecef( darray lla ) {
+    ssize_t n = check_rows( lla, 3, "lla" );
+    darray result({n, (ssize_t)3});
+    const double *in = lla.data();
+    double *out = result.mutable_data();
+    {
+        py::gil_scoped_release release;
+        for ( ssize_t i = 0; i < n; i++ ) {
+            const double *p = in + i*3;
+            Vector3d ecef = lla2ecef( Vector3d(p[0]*d2r, p[1]*d2r, p[2]) );
+            out[i*3+0] = ecef(0);
+            out[i*3+1] = ecef(1);
+            out[i*3+2] = ecef(2);
+        }
+    }
+    return result;
+}
+
+darray geo_ecef2lla( darray ecef ) {
+    ssize_t n = check_rows( ecef, 3, "ecef" );
+    darray result({n, (ssize_t)3});
+    const double *in = ecef.data();
+    double *out = result.mutable_data();
+    {
+        py::gil_scoped_release release;
+        for ( ssize_t i = 0; i < n; i++ ) {
+            const double *p = in + i*3;
+            Vector3d lla = ecef2lla( Vector3d(p[0], p[1], p[2]) );
+            out[i*3+0] = lla(0) * r2d;
+            out[i*3+1] = lla(1) * r2d;
+            out[i*3+2] = lla(2);
+        }
+    }
+    return result;
+}
+
+darray geo_lla2ned( darray lla, darray ref_lla ) {
+    ssize_t n = check_rows( lla, 3, "lla" );
+    Vector3d ref = check_ref( ref_lla );
+    darray result({n, (ssize_t)3});
+    const double *in = lla.data();
+    double *out = result.mutable_data();
+    {
+        py::gil_scoped_release release;
+        Vector3d ref_ecef = lla2ecef( ref );
+        Matrix3d C = ecef2ned_dcm( ref );
+        for ( ssize_t i = 0; i < n; i++ ) {
+            const double *p = in + i*3;
+            Vector3d ecef = lla2ecef( Vector3d(p[0]*d2r, p[1]*d2r, p[2]) );
+            Vector3d ned = C * (ecef - ref_ecef);
+            out[i*3+0] = ned(0);
+            out[i*3+1] = ned(1);
+            out[i*3+2] = ned(2);
+        }
+    }
+    return result;
+}
+
+darray geo_ned2lla( darray ned, darray ref_lla ) {
+    ssize_t n = check_rows( ned, 3, "ned" );
+    Vector3d ref = check_ref( ref_lla );
+    darray result({n, (ssize_t)3});
+    const double *in = ned.data();
+    double *out = result.mutable_data();
+    {
+        py::gil_scoped_release release;
+        Vector3d ref_ecef = lla2ecef( ref );
+        Matrix3d Ct = ecef2ned_dcm( ref ).transpose();
+        for ( ssize_t i = 0; i < n; i++ ) {
+            const double *p = in + i*3;
+            Vector3d lla = ecef2lla( ref_ecef + Ct * Vector3d(p[0], p[1], p[2]) );
+            out[i*3+0] = lla(0) * r2d;
+            out[i*3+1] = lla(1) * r2d;
+            out[i*3+2] = lla(2);
+        }
+    }
+    return result;
+}
+
+
+#ifdef HAVE_PYBIND11
+  PYBIND11_PLUGIN(geodesy) {
+      py::module m("geodesy", "bulk lla/ecef/ned conversions for python");
+      m.def("lla2ecef", &geo_lla2ecef);
+      m.def("ecef2lla", &geo_ecef2lla);
+      m.def("lla2ned", &geo_lla2ned);
+      m.def("ned2lla", &geo_ned2lla);
+      return m.ptr();
+  }
+#endif // HAVE_PYBIND11
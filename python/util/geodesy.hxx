@@ -0,0 +1,13 @@
+#pragma once
+
+#include "arrays.hxx"
+
+// Bulk position conversions built on the nav filter's own
+// nav_functions_double so the tools agree with the flight code.  All
+// arrays are (n, 3).  lla is (lat_deg, lon_deg, alt_m), ecef is in
+// meters, ned is meters north/east/down of ref_lla.
+
+darray geo_lla2ecef( darray lla );
+darray geo_ecef2lla( darray ecef );
+darray geo_lla2ned( darray lla, darray ref_lla );
+darray geo_ned2lla( darray ned, darray ref_lla );
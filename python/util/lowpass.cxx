@@ -0,0 +1,45 @@
+#include <math.h>
+
+#include "lowpass.hxx"
+
+darray lowpass_filter( darray time, darray value, double time_factor,
+                       double init )
+{
+    ssize_t n = check_rows( time, 0, "time" );
+    if ( check_rows( value, 0, "value" ) != n ) {
+        throw std::invalid_argument("time and value lengths differ");
+    }
+    darray result(n);
+    const double *t = time.data();
+    const double *v = value.data();
+    double *out = result.mutable_data();
+    {
+        py::gil_scoped_release release;
+        double filt = init;
+        if ( std::isnan(filt) ) {
+            filt = n > 0 ? v[0] : 0.0;
+        }
+        for ( ssize_t i = 0; i < n; i++ ) {
+            double wf = 1.0;
+            if ( time_factor > 0.0 ) {
+                double dt = i > 0 ? t[i] - t[i-1] : 0.0;
+                wf = dt / time_factor;
+            }
+            if ( wf < 0.0 ) { wf = 0.0; }
+            if ( wf > 1.0 ) { wf = 1.0; }
+            filt = (1.0 - wf) * filt + wf * v[i];
+            out[i] = filt;
+        }
+    }
+    return result;
+}
+
+
+#ifdef HAVE_PYBIND11
+  PYBIND11_PLUGIN(lowpass) {
+      py::module m("lowpass", "array low pass filter for python");
+      m.def("filter", &lowpass_filter, py::arg("time"), py::arg("value"),
+            py::arg("time_factor"), py::arg("init") = NAN);
+      return m.ptr();
+  }
+#endif // HAVE_PYBIND11
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "arrays.hxx"
+
+// run a whole time series through the same first order low pass
+// filter as tools/flight_report/lowpass.py.  The filter starts at
+// init (or the first sample if init is nan.)  Returns the filtered
+// series.
+darray lowpass_filter( darray time, darray value, double time_factor,
+                       double init );
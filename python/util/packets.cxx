@@ -0,0 +1,97 @@
+#include <vector>
+using std::vector;
+
+#include <string.h>
+
+#include "packets.hxx"
+
+static const uint8_t START_OF_MSG0 = 147;
+static const uint8_t START_OF_MSG1 = 224;
+
+larray packet_scan( barray buf ) {
+    if ( buf.ndim() != 1 ) {
+        throw std::invalid_argument("buf must be a 1d byte array");
+    }
+    ssize_t size = buf.shape(0);
+    const uint8_t *data = buf.data();
+    vector<int64_t> found;
+    {
+        py::gil_scoped_release release;
+        ssize_t i = 0;
+        while ( i + 6 <= size ) {
+            if ( data[i] != START_OF_MSG0 || data[i+1] != START_OF_MSG1 ) {
+                i++;
+                continue;
+            }
+            uint8_t id = data[i+2];
+            uint8_t len = data[i+3];
+            if ( i + 6 + len > size ) {
+                break;          // truncated at the end of the log
+            }
+            // simple 2-byte checksum over id, len and payload
+            uint8_t c0 = id;
+            uint8_t c1 = c0;
+            c0 += len;
+            c1 += c0;
+            const uint8_t *payload = data + i + 4;
+            for ( int j = 0; j < len; j++ ) {
+                c0 += payload[j];
+                c1 += c0;
+            }
+            if ( c0 != payload[len] || c1 != payload[len+1] ) {
+                i++;
+                continue;
+            }
+            found.push_back( i + 4 );
+            found.push_back( id );
+            found.push_back( len );
+            i += 6 + len;
+        }
+    }
+    ssize_t n = found.size() / 3;
+    larray result({n, (ssize_t)3});
+    if ( n > 0 ) {
+        memcpy( result.mutable_data(), found.data(),
+                found.size() * sizeof(int64_t) );
+    }
+    return result;
+}
+
+barray packet_payloads( barray buf, larray index, int id, int len ) {
+    if ( buf.ndim() != 1 || index.ndim() != 2 || index.shape(1) != 3 ) {
+        throw std::invalid_argument("expected a byte buffer and its packet_scan() index");
+    }
+    ssize_t size = buf.shape(0);
+    ssize_t rows = index.shape(0);
+    auto idx = index.unchecked<2>();
+    ssize_t n = 0;
+    for ( ssize_t i = 0; i < rows; i++ ) {
+        if ( idx(i, 1) == id && idx(i, 2) == len ) {
+            n++;
+        }
+    }
+    barray result({n, (ssize_t)len});
+    const uint8_t *data = buf.data();
+    uint8_t *out = result.mutable_data();
+    for ( ssize_t i = 0; i < rows; i++ ) {
+        if ( idx(i, 1) == id && idx(i, 2) == len ) {
+            if ( idx(i, 0) < 0 || idx(i, 0) + len > size ) {
+                throw std::out_of_range("packet index does not match buf");
+            }
+            memcpy( out, data + idx(i, 0), len );
+            out += len;
+        }
+    }
+    return result;
+}
+
+
+#ifdef HAVE_PYBIND11
+  PYBIND11_PLUGIN(packets) {
+      py::module m("packets", "bulk serial packet decoding for python");
+      m.def("scan", &packet_scan);
+      m.def("payloads", &packet_payloads, py::arg("buf"), py::arg("index"),
+            py::arg("id"), py::arg("len"));
+      return m.ptr();
+  }
+#endif // HAVE_PYBIND11
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "arrays.hxx"
+
+typedef py::array_t<uint8_t, py::array::c_style | py::array::forcecast> barray;
+typedef py::array_t<int64_t> larray;
+
+// Find every framed packet (147, 224, id, len, payload, ck0, ck1 as
+// written by the serial link and auraparser.log_msg()) in a raw log
+// buffer.  Packets with a bad checksum are skipped and the scan
+// resyncs on the next start byte.  Returns (n, 3): payload offset,
+// packet id, payload length.
+larray packet_scan( barray buf );
+
+// Gather the payloads of every packet with the given id and length
+// into an (n, len) byte array, ready to be viewed through a numpy
+// structured dtype.
+barray packet_payloads( barray buf, larray index, int id, int len );
@@ -0,0 +1,161 @@
+#include <math.h>
+
+#include "routegeo.hxx"
+
+static const double d2r = M_PI / 180.0;
+static const double r2d = 180.0 / M_PI;
+
+// legs shorter than this (a one waypoint route, or a waypoint repeated)
+// have no usable direction and are flown direct to the waypoint
+static const double min_leg_m = 0.01;
+
+static inline Vector3d surface_ecef( double lat_deg, double lon_deg ) {
+    return lla2ecef( Vector3d(lat_deg * d2r, lon_deg * d2r, 0.0) );
+}
+
+// rotate an ecef vector into north/east at lat/lon (radians)
+static inline void ecef2ne( const Vector3d &v, double lat, double lon,
+                            double *n, double *e )
+{
+    double sin_lat = sin(lat), cos_lat = cos(lat);
+    double sin_lon = sin(lon), cos_lon = cos(lon);
+    *n = -sin_lat*cos_lon*v(0) - sin_lat*sin_lon*v(1) + cos_lat*v(2);
+    *e = -sin_lon*v(0) + cos_lon*v(1);
+}
+
+static inline double course_deg( double n, double e ) {
+    double crs = atan2(e, n) * r2d;
+    if ( crs < 0.0 ) { crs += 360.0; }
+    return crs;
+}
+
+void RouteGeometry::set_waypoints( const vector<double> &lat_deg,
+                                   const vector<double> &lon_deg )
+{
+    if ( lat_deg.size() != lon_deg.size() ) {
+        throw std::invalid_argument("lat and lon lengths differ");
+    }
+    int n = lat_deg.size();
+    points.resize( n );
+    for ( int i = 0; i < n; i++ ) {
+        points[i].ecef = surface_ecef( lat_deg[i], lon_deg[i] );
+    }
+    double remaining = 0.0;
+    for ( int i = n - 1; i >= 0; i-- ) {
+        int prev = (i > 0) ? i - 1 : n - 1;
+        points[i].leg_ecef = points[i].ecef - points[prev].ecef;
+        if ( i < n - 1 ) {
+            points[i].leg_dist_m = (points[i+1].ecef - points[i].ecef).norm();
+        } else {
+            points[i].leg_dist_m = 0.0;
+        }
+        remaining += points[i].leg_dist_m;
+        points[i].remaining_m = remaining;
+    }
+}
+
+py::tuple RouteGeometry::leg( int index, double lat_deg, double lon_deg ) {
+    if ( index < 0 || index >= (int)points.size() ) {
+        throw std::out_of_range("waypoint index out of range");
+    }
+    const route_point_t &p = points[index];
+    double lat = lat_deg * d2r;
+    double lon = lon_deg * d2r;
+    Vector3d pos = lla2ecef( Vector3d(lat, lon, 0.0) );
+
+    double dn, de;
+    ecef2ne( p.ecef - pos, lat, lon, &dn, &de );
+    double direct_dist = sqrt(dn*dn + de*de);
+
+    double direct_crs = course_deg( dn, de );
+
+    double ln, le;
+    ecef2ne( p.leg_ecef, lat, lon, &ln, &le );
+    double leg_len = sqrt(ln*ln + le*le);
+    if ( leg_len < min_leg_m ) {
+        return py::make_tuple( direct_crs, direct_dist, direct_crs, 0.0,
+                               direct_dist );
+    }
+    ln /= leg_len;
+    le /= leg_len;
+    // sin() and cos() of (leg course - direct course) scaled by the
+    // direct distance
+    double xtrack = le*dn - ln*de;
+    double along = ln*dn + le*de;
+    return py::make_tuple( direct_crs, direct_dist, course_deg(ln, le),
+                           xtrack, along );
+}
+
+double RouteGeometry::leg_dist( int index ) {
+    if ( index < 0 || index >= (int)points.size() ) {
+        return 0.0;
+    }
+    return points[index].leg_dist_m;
+}
+
+double RouteGeometry::remaining( int index ) {
+    if ( index < 0 || index >= (int)points.size() ) {
+        return 0.0;
+    }
+    return points[index].remaining_m;
+}
+
+py::tuple course_dist( double lat1_deg, double lon1_deg,
+                       double lat2_deg, double lon2_deg )
+{
+    Vector3d v = surface_ecef( lat2_deg, lon2_deg )
+        - surface_ecef( lat1_deg, lon1_deg );
+    double n, e;
+    ecef2ne( v, lat1_deg * d2r, lon1_deg * d2r, &n, &e );
+    return py::make_tuple( course_deg(n, e), sqrt(n*n + e*e) );
+}
+
+// true heading to fly for a ground course, same as
+// windtri.wind_course().  If the course can't be flown the nose
+// points into the wind.
+static double wind_heading( double ws_kt, double tas_kt, double wd_deg,
+                            double crs_deg )
+{
+    if ( tas_kt <= 0.1 ) {
+        return 0.0;
+    }
+    double wd = wd_deg * d2r;
+    double crs = crs_deg * d2r;
+    double swc = (ws_kt/tas_kt)*sin(wd-crs);
+    double hd;
+    if ( fabs(swc) > 1.0 ) {
+        hd = wd + M_PI;
+    } else {
+        hd = crs + asin(swc);
+        if ( hd < 0.0 ) { hd += 2.0 * M_PI; }
+    }
+    if ( hd > 2.0 * M_PI ) { hd -= 2.0 * M_PI; }
+    return hd * r2d;
+}
+
+double wind_heading_error( double ws_kt, double tas_kt, double wd_deg,
+                           double current_crs_deg, double target_crs_deg )
+{
+    double hdg_error = wind_heading( ws_kt, tas_kt, wd_deg, current_crs_deg )
+        - wind_heading( ws_kt, tas_kt, wd_deg, target_crs_deg );
+    if ( hdg_error < -180.0 ) { hdg_error += 360.0; }
+    if ( hdg_error > 180.0 ) { hdg_error -= 360.0; }
+    return hdg_error;
+}
+
+
+#ifdef HAVE_PYBIND11
+  PYBIND11_PLUGIN(routegeo) {
+      py::module m("routegeo", "route following geometry for python");
+      py::class_<RouteGeometry>(m, "Route")
+          .def(py::init<>())
+          .def("set_waypoints", &RouteGeometry::set_waypoints)
+          .def("size", &RouteGeometry::size)
+          .def("leg", &RouteGeometry::leg)
+          .def("leg_dist", &RouteGeometry::leg_dist)
+          .def("remaining", &RouteGeometry::remaining);
+      m.def("course_dist", &course_dist);
+      m.def("wind_heading_error", &wind_heading_error);
+      return m.ptr();
+  }
+#endif // HAVE_PYBIND11
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+using std::vector;
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+namespace py = pybind11;
+
+#include "../../src/filters/nav_common/nav_functions_double.hxx"
+
+// Route following geometry for control/route.py and circle.py.
+//
+// The active route is held as one contiguous array of waypoints with
+// their ecef positions, the ecef vector of the leg leading into each
+// waypoint and the distance remaining to the end of the route, all
+// computed once when the route changes.  The per frame queries then
+// cost one lla to ecef conversion and a rotation into the local ned
+// frame at the current position, no matter how long the route is.
+// Distances are straight line (chord) distances on the ellipsoid
+// surface, which match geo_inverse() to well under a meter over the
+// leg lengths we fly.
+
+struct route_point_t {
+    Vector3d ecef;
+    Vector3d leg_ecef;		// from the previous waypoint to this one
+    double leg_dist_m;		// from this waypoint to the next
+    double remaining_m;		// from this waypoint to the end of the route
+};
+
+class RouteGeometry {
+
+private:
+
+    vector<route_point_t> points;
+
+public:
+
+    // lat/lon of each waypoint in degrees, the leg into waypoint 0
+    // starts at the last waypoint (routes loop.)
+    void set_waypoints( const vector<double> &lat_deg,
+                        const vector<double> &lon_deg );
+
+    int size() { return points.size(); }
+
+    // geometry of the leg into waypoint index from the given
+    // position: (direct_course_deg, direct_dist_m, leg_course_deg,
+    // xtrack_m, along_m) where along_m is the distance remaining to
+    // the waypoint projected onto the leg and xtrack_m is positive to
+    // the right of the leg.  A leg of (near) zero length, as in a one
+    // waypoint route, is flown direct: leg course = direct course,
+    // xtrack_m = 0 and along_m = direct_dist_m.
+    py::tuple leg( int index, double lat_deg, double lon_deg );
+
+    double leg_dist( int index );
+
+    // distance from waypoint index to the end of the route
+    double remaining( int index );
+};
+
+// (course_deg, dist_m) from point 1 to point 2
+py::tuple course_dist( double lat1_deg, double lon1_deg,
+                       double lat2_deg, double lon2_deg );
+
+// body heading difference that takes us from the current ground
+// course to the target ground course given the wind estimate (see
+// control/route.py.)
+double wind_heading_error( double ws_kt, double tas_kt, double wd_deg,
+                           double current_crs_deg, double target_crs_deg );
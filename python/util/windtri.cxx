@@ -47,11 +47,89 @@ py::tuple wind_course( double ws_kt, double tas_kt, double wd_deg,
     return py::make_tuple(hd_deg, gs_kt);
 }
 
+static const double mps2kt = 1.94384;
+static const double kt2mps = 1.0 / mps2kt;
+
+static inline double lowpass( double value, double input, double dt,
+                              double time_factor )
+{
+    double wf = time_factor > 0.0 ? dt / time_factor : 1.0;
+    if ( wf < 0.0 ) { wf = 0.0; }
+    if ( wf > 1.0 ) { wf = 1.0; }
+    return (1.0 - wf) * value + wf * input;
+}
+
+darray wind_estimate( darray time, darray airspeed_kt, darray yaw_rad,
+                      darray vn, darray ve, double wind_time_factor,
+                      double pitot_time_factor )
+{
+    ssize_t n = check_rows( time, 0, "time" );
+    if ( check_rows( airspeed_kt, 0, "airspeed_kt" ) != n
+         || check_rows( yaw_rad, 0, "yaw_rad" ) != n
+         || check_rows( vn, 0, "vn" ) != n
+         || check_rows( ve, 0, "ve" ) != n ) {
+        throw std::invalid_argument("input lengths differ");
+    }
+    darray result({n, (ssize_t)3});
+    const double *t = time.data();
+    const double *as = airspeed_kt.data();
+    const double *yaw = yaw_rad.data();
+    const double *gn = vn.data();
+    const double *ge = ve.data();
+    double *out = result.mutable_data();
+    {
+        py::gil_scoped_release release;
+        double filt_wn = 0.0, filt_we = 0.0, filt_ps = 1.0;
+        double last_time = 0.0;
+        double wind_deg = 0.0, wind_kt = 0.0;
+        for ( ssize_t i = 0; i < n; i++ ) {
+            if ( as[i] > 10.0 ) {
+                double dt = last_time > 0.0 ? t[i] - last_time : 0.0;
+                last_time = t[i];
+                if ( dt > 0.0 ) {
+                    // estimate body velocity
+                    double psi = 0.5*pi - yaw[i];
+                    double speed = as[i] * filt_ps * kt2mps;
+                    double ue = cos(psi) * speed;
+                    double un = sin(psi) * speed;
+
+                    // filtered wind velocity
+                    filt_wn = lowpass( filt_wn, un - gn[i], dt,
+                                       wind_time_factor );
+                    filt_we = lowpass( filt_we, ue - ge[i], dt,
+                                       wind_time_factor );
+
+                    // estimate pitot tube bias
+                    double true_e = filt_we + ge[i];
+                    double true_n = filt_wn + gn[i];
+                    double true_kt = sqrt(true_e*true_e + true_n*true_n)
+                        * mps2kt;
+                    double ps = true_kt / as[i];
+                    if ( ps < 0.75 ) { ps = 0.75; }
+                    if ( ps > 1.25 ) { ps = 1.25; }
+                    filt_ps = lowpass( filt_ps, ps, dt, pitot_time_factor );
+                }
+                wind_deg = 90 - atan2(filt_wn, filt_we) * r2d;
+                if ( wind_deg < 0 ) { wind_deg += 360.0; }
+                wind_kt = sqrt(filt_we*filt_we + filt_wn*filt_wn) * mps2kt;
+            }
+            out[i*3+0] = wind_deg;
+            out[i*3+1] = wind_kt;
+            out[i*3+2] = filt_ps;
+        }
+    }
+    return result;
+}
+
 
 #ifdef HAVE_PYBIND11
   PYBIND11_PLUGIN(windtri) {
       py::module m("windtri", "wind triangle calcs for python");
       m.def("wind_course", &wind_course);
+      m.def("estimate", &wind_estimate, py::arg("time"),
+            py::arg("airspeed_kt"), py::arg("yaw_rad"), py::arg("vn"),
+            py::arg("ve"), py::arg("wind_time_factor") = 60.0,
+            py::arg("pitot_time_factor") = 240.0);
       return m.ptr();
   }
 #endif // HAVE_PYBIND11
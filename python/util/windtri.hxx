@@ -1,7 +1,6 @@
 #pragma once
 
-#include <pybind11/pybind11.h>
-namespace py = pybind11;
+#include "arrays.hxx"
 
 // Given a wind speed estimate, true airspeed estimate, wind direction
 // estimate, and a desired course to fly, then compute a true heading to
@@ -10,3 +9,11 @@ namespace py = pybind11;
 
 py::tuple wind_course( double ws_kt, double tas_kt, double wd_deg,
                        double crs_deg );
+
+// Run the flight_report wind estimator (tools/flight_report/wind.py)
+// over a whole flight.  Inputs are per imu record: time, indicated
+// airspeed (kt), true heading (rad), and gps north/east velocity
+// (m/s).  Returns an (n, 3) array of wind_deg, wind_kt, pitot_scale.
+darray wind_estimate( darray time, darray airspeed_kt, darray yaw_rad,
+                      darray vn, darray ve, double wind_time_factor,
+                      double pitot_time_factor );
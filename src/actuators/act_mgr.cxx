@@ -15,10 +15,8 @@
 #include <stdio.h>
 #include <unistd.h>
 
-#include <sstream>
 #include <string>
 #include <vector>
-using std::ostringstream;
 using std::string;
 using std::vector;
 
@@ -28,12 +26,15 @@ using std::vector;
 #include "control/control.hxx"
 #include "include/globaldefs.h"
 #include "init/globals.hxx"
+#include "util/latency.hxx"
 #include "util/myprof.hxx"
 #include "util/timing.h"
 
 #include "act_fgfs.hxx"
+#include "excite.hxx"
 #include "sensors/APM2.hxx"
 #include "sensors/Aura3/Aura3.hxx"
+#include "sensors/sensor_mgr.hxx"
 
 #include "act_mgr.hxx"
 
@@ -47,14 +48,66 @@ static pyPropertyNode engine_node;
 static pyPropertyNode pilot_node;
 static pyPropertyNode act_node;
 static pyPropertyNode ap_node;
-static pyPropertyNode excite_node;
-static vector<pyPropertyNode> sections;
+static pyPropertyNode imu_node;
+static pyPropertyNode latency_node;
+
+// age of the imu sample behind each actuator command when it goes out
+static LatencyHistogram latency;
 
 static myprofile debug_act1;
 static myprofile debug_act2;
 
-static int remote_link_skip = 0;
-static int logging_skip = 0;
+
+static void pack_actuator( message::actuator_v3_t *act,
+			   pyPropertyNode *output )
+{
+    act->index = 0;  // always zero for now
+    act->timestamp_sec = act_node.getDouble("timestamp");
+    act->aileron = act_node.getDouble("aileron");
+    act->elevator = act_node.getDouble("elevator");
+    act->throttle = act_node.getDouble("throttle");
+    act->rudder = act_node.getDouble("rudder");
+    act->channel5 = act_node.getDouble("channel5");
+    act->flaps = act_node.getDouble("flaps");
+    act->channel7 = act_node.getDouble("channel7");
+    act->channel8 = act_node.getDouble("channel8");
+    act->status = 0;
+}
+
+// don't go anywhere until the acuator is configured.  this will also
+// force the APM2 (or Aura3) into binary mode as soon as it starts
+// seeing our binary config packets coming in.
+static void APM2_act_start( string output_path, pyPropertyNode *config ) {
+    APM2_act_init( config );
+    APM2_act_update();
+    while ( ! APM2_actuator_configured ) {
+	usleep(250000);
+	APM2_act_update();
+    }
+}
+
+static void Aura3_act_start( string output_path, pyPropertyNode *config ) {
+    Aura3_act_init( config );
+    Aura3_act_update();
+    while ( ! Aura3_actuator_configured ) {
+	usleep(250000);
+	Aura3_act_update();
+    }
+}
+
+// actuator output always counts as fresh data
+static const sensor_driver_t act_drivers[] = {
+    { "APM2", APM2_act_start, []() { APM2_act_update(); return true; },
+      APM2_act_close, NULL },
+    { "Aura3", Aura3_act_start, []() { Aura3_act_update(); return true; },
+      Aura3_act_close, NULL },
+    { "fgfs",
+      []( string output_path, pyPropertyNode *config ) { fgfs_act_init( config ); },
+      []() { fgfs_act_update(); return true; },
+      fgfs_act_close, NULL },
+};
+
+static SensorGroup<message::actuator_v3_t> actuators( pack_actuator );
 
 
 void Actuator_init() {
@@ -64,60 +117,17 @@ void Actuator_init() {
     // bind properties
     flight_node = pyGetNode("/controls/flight", true);
     engine_node = pyGetNode("/controls/engine", true);
-    excite_node = pyGetNode("/task/excite", true);
     pilot_node = pyGetNode("/sensors/pilot_input", true);
     act_node = pyGetNode("/actuators", true);
     ap_node = pyGetNode("/autopilot", true);
-    
-    pyPropertyNode remote_link_node = pyGetNode("/config/remote_link", true);
-    pyPropertyNode logging_node = pyGetNode("/config/logging", true);
-    remote_link_skip = remote_link_node.getDouble("actuator_skip");
-    logging_skip = logging_node.getDouble("actuator_skip");
-
-    // traverse configured modules
-    pyPropertyNode group_node = pyGetNode("/config/actuators", true);
-    vector<string> children = group_node.getChildren();
-    printf("Found %d actuator sections\n", (int)children.size());
-    for ( unsigned int i = 0; i < children.size(); i++ ) {
-	pyPropertyNode section = group_node.getChild(children[i].c_str());
-	sections.push_back(section);
-	string module = section.getString("module");
-	bool enabled = section.getBool("enable");
-	if ( !enabled ) {
-	    continue;
-	}
-	printf("actuator: %d = %s\n", i, module.c_str());
-	if ( module == "null" ) {
-	    // do nothing
-	} else if ( module == "APM2" ) {
-	    APM2_act_init( &section );
-	    // don't go anywhere until the acuator is configured.
-	    // this will also force the APM2 into binary mode as soon
-	    // as it starts seeing our binary config packets coming
-	    // in.
-	    APM2_act_update();
-	    while ( ! APM2_actuator_configured ) {
-		usleep(250000);
-		APM2_act_update();
-	    }
-	} else if ( module == "Aura3" ) {
-	    Aura3_act_init( &section );
-	    // don't go anywhere until the acuator is configured.
-	    // this will also force the Aura3 into binary mode as soon
-	    // as it starts seeing our binary config packets coming
-	    // in.
-	    Aura3_act_update();
-	    while ( ! Aura3_actuator_configured ) {
-		usleep(250000);
-		Aura3_act_update();
-	    }
-	} else if ( module == "fgfs" ) {
-	    fgfs_act_init( &section );
-	} else {
-	    printf("Unknown actuator = '%s' in config file\n",
-		   module.c_str());
-	}
-    }
+    imu_node = pyGetNode("/sensors/imu", true);
+    latency_node = pyGetNode("/status/actuator_latency", true);
+
+    excite_init();
+
+    actuators.init( "actuator", "/config/actuators", NULL, "module",
+		    "actuator_skip", act_drivers,
+		    sizeof(act_drivers) / sizeof(act_drivers[0]) );
 }
 
 
@@ -197,26 +207,9 @@ static void set_actuator_values() {
     double throttle = engine_node.getDouble("throttle");
     act_node.setDouble("throttle", throttle );
 
-    // add in excitation signals if excitation task is running
-    if ( excite_node.getBool("running") ) {
-        float signal = 0.0;
-        string target = "";
-        int n = excite_node.getLong("channels");
-        for ( int i = 0; i < n; i++ ) {
-            signal = excite_node.getDouble("signal", i);
-            target = excite_node.getString("target", i);
-            float act_val = act_node.getDouble(target.c_str());
-            act_val += signal;
-            if ( target == "throttle" ) {
-                if ( act_val < 0.0 ) { act_val = 0.0; }
-            } else {
-                if ( act_val < -1.0 ) { act_val = -1.0; }
-            }
-            if ( act_val > 1.0 ) { act_val = 1.0; }
-            act_node.setDouble(target.c_str(), act_val);
-        }
-    }
-    
+    // add in excitation signals if an experiment is running
+    excite_update( &act_node );
+
     static bool sas_throttle_override = false;
     if ( !sas_throttle_override ) {
 	if ( ap_node.getString("mode") == "sas" ) {
@@ -276,77 +269,32 @@ bool Actuator_update() {
     
     debug_act1.stop();
 
-    static int remote_link_count = 0;
-    static int logging_count = 0;
-
-    bool fresh_data = true; // always true
-
-    // traverse configured modules
-    for ( unsigned int i = 0; i < sections.size(); i++ ) {
-	string module = sections[i].getString("module");
-	bool enabled = sections[i].getBool("enable");
-	if ( !enabled ) {
-	    continue;
-	}
-	if ( module == "null" ) {
-	    // do nothing
-	} else if ( module == "APM2" ) {
-            debug_act2.start();
-	    APM2_act_update();
-            debug_act2.stop();
-	} else if ( module == "Aura3" ) {
-            debug_act2.start();
-	    Aura3_act_update();
-            debug_act2.stop();
-	} else if ( module == "fgfs" ) {
-	    fgfs_act_update();
-	} else {
-	    printf("Unknown actuator = '%s' in config file\n",
-		   module.c_str());
-	}
-	if ( fresh_data ) {
-	    bool send_remote_link = false;
-	    if ( remote_link_count < 0 ) {
-		send_remote_link = true;
-		remote_link_count = remote_link_skip;
-	    }
-	
-	    bool send_logging = false;
-	    if ( logging_count < 0 ) {
-		send_logging = true;
-		logging_count = logging_skip;
-	    }
-	
-	    if ( send_remote_link || send_logging ) {
-                message::actuator_v3_t act;
-                act.index = 0;  // always zero for now
-                act.timestamp_sec = act_node.getDouble("timestamp");
-                act.aileron = act_node.getDouble("aileron");
-                act.elevator = act_node.getDouble("elevator");
-                act.throttle = act_node.getDouble("throttle");
-                act.rudder = act_node.getDouble("rudder");
-                act.channel5 = act_node.getDouble("channel5");
-                act.flaps = act_node.getDouble("flaps");
-                act.channel7 = act_node.getDouble("channel7");
-                act.channel8 = act_node.getDouble("channel8");
-                act.status = 0;
-                act.pack();
-		if ( send_remote_link ) {
-		    remote_link->send_message( act.id, act.payload, act.len );
-		}
-		if ( send_logging ) {
-		    logging->log_message( act.id, act.payload, act.len );
-		}
-	    }
+    debug_act2.start();
+    // the command carries the timestamp of the imu sample it was
+    // computed from
+    double imu_time = imu_node.getDouble("timestamp");
+    act_node.setDouble( "imu_timestamp", imu_time );
+    actuators.update();
+    double age = get_Time() - imu_time;
+    debug_act2.stop();
+
+    latency.add( age );
+    act_node.setDouble( "latency_ms", age * 1000.0 );
+    static double publish_time = 0.0;
+    if ( imu_time >= publish_time + 1.0 ) {
+	publish_time = imu_time;
+	latency_node.setLong( "count", latency.get_count() );
+	latency_node.setDouble( "mean_ms", latency.get_mean_ms() );
+	latency_node.setDouble( "p50_ms", latency.percentile_ms(0.5) );
+	latency_node.setDouble( "p95_ms", latency.percentile_ms(0.95) );
+	latency_node.setDouble( "p99_ms", latency.percentile_ms(0.99) );
+	latency_node.setDouble( "max_ms", latency.get_max_ms() );
+	latency_node.setLen( "hist", LatencyHistogram::BINS, 0.0 );
+	for ( int i = 0; i < LatencyHistogram::BINS; i++ ) {
+	    latency_node.setDouble( "hist", i, latency.get_bin(i) );
 	}
     }
 
-
-    if ( fresh_data ) {
-        remote_link_count--;
-        logging_count--;
-    }
-
     // static int dcount = 0;
     // dcount++;
     // if ( dcount > 200 ) {
@@ -359,25 +307,11 @@ bool Actuator_update() {
 }
 
 
-void Actuators_close() {
-    // traverse configured modules
-    for ( unsigned int i = 0; i < sections.size(); i++ ) {
-	string module = sections[i].getString("module");
-	bool enabled = sections[i].getBool("enable");
-	if ( !enabled ) {
-	    continue;
-	}
-	if ( module == "null" ) {
-	    // do nothing
-	} else if ( module == "APM2" ) {
-	    APM2_act_close();
-	} else if ( module == "Aura3" ) {
-	    Aura3_act_close();
-	} else if ( module == "fgfs" ) {
-	    fgfs_act_close();
-	} else {
-	    printf("Unknown actuator = '%s' in config file\n",
-		   module.c_str());
-	}
-    }
+void Actuator_stats() {
+    latency.print("imu to actuator");
+}
+
+
+void Actuator_close() {
+    actuators.close();
 }
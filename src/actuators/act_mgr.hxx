@@ -13,4 +13,5 @@
 
 void Actuator_init();
 bool Actuator_update();
+void Actuator_stats();		// console latency summary
 void Actuator_close();
@@ -0,0 +1,251 @@
+//
+// excite.cxx - excitation signals for system identification
+//
+
+#include <math.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#include "excite.hxx"
+
+enum excite_type_t {
+    EXCITE_STEPS,		// pulse and doublets
+    EXCITE_CHIRP,
+    EXCITE_MULTISINE		// oms and multisine
+};
+
+// unit step patterns, one entry per unit of duration_sec
+static const float pulse[] = { 1 };
+static const float doublet[] = { 1, -1 };
+static const float doublet121[] = { 1, -1, -1, 1 };
+static const float doublet3211[] = { 1, 1, 1, -1, -1, 1, -1 };
+
+struct sine_t {
+    double freq_rps;
+    double phase_rad;
+    double amplitude;
+};
+
+struct excite_channel_t {
+    string target;
+    bool throttle;
+    double amplitude;
+    double freq_start;		// chirp
+    double k;			// chirp
+    vector<sine_t> sines;	// multisine
+};
+
+static pyPropertyNode excite_node;
+static pyPropertyNode imu_node;
+
+static bool running = false;
+static excite_type_t type;
+static const float *steps = NULL;
+static int units = 0;
+static double dur_sec = 0.0;
+static double start_time = 0.0;
+static vector<excite_channel_t> channels;
+
+
+void excite_init() {
+    excite_node = pyGetNode("/task/excite", true);
+    imu_node = pyGetNode("/sensors/imu", true);
+    excite_node.setBool("running", false);
+}
+
+static double clamp( double v, double min, double max ) {
+    if ( v < min ) { return min; }
+    if ( v > max ) { return max; }
+    return v;
+}
+
+// orthogonal multisine components for n channels: harmonics of the
+// experiment length between the frequency limits, dealt out in turn
+static void make_multisine( double min_rps, double max_rps ) {
+    int n = channels.size();
+    double base_rps = 2.0 * M_PI / dur_sec;
+    int k_min = ceil(min_rps / base_rps);
+    int k_max = floor(max_rps / base_rps);
+    if ( k_min < 1 ) { k_min = 1; }
+    for ( int k = k_min; k <= k_max; k++ ) {
+	sine_t s;
+	s.freq_rps = k * base_rps;
+	s.phase_rad = 0.0;
+	s.amplitude = 0.0;
+	channels[(k - k_min) % n].sines.push_back( s );
+    }
+    for ( int i = 0; i < n; i++ ) {
+	vector<sine_t> &sines = channels[i].sines;
+	int m = sines.size();
+	for ( int j = 0; j < m; j++ ) {
+	    // Schroeder phases
+	    sines[j].phase_rad = -M_PI * j * (j + 1) / m;
+	    sines[j].amplitude = channels[i].amplitude * sqrt(1.0 / m);
+	}
+    }
+}
+
+// read the experiment description, false if it isn't usable
+static bool excite_start() {
+    string name = excite_node.getString("type");
+    int n = excite_node.getLen("target");
+    if ( n <= 0 ) {
+	printf("excite: no target channels\n");
+	return false;
+    }
+    dur_sec = excite_node.getDouble("duration_sec");
+    if ( dur_sec < 0.01 ) {
+	printf("excite: bad duration %.3f\n", dur_sec);
+	return false;
+    }
+    channels.clear();
+    channels.resize( n );
+    for ( int i = 0; i < n; i++ ) {
+	channels[i].target = excite_node.getString("target", i);
+	channels[i].throttle = channels[i].target == "throttle";
+	channels[i].amplitude = excite_node.getDouble("amplitude", i);
+    }
+    if ( name == "pulse" ) {
+	type = EXCITE_STEPS;
+	steps = pulse;
+	units = sizeof(pulse) / sizeof(pulse[0]);
+    } else if ( name == "doublet" ) {
+	type = EXCITE_STEPS;
+	steps = doublet;
+	units = sizeof(doublet) / sizeof(doublet[0]);
+    } else if ( name == "doublet121" ) {
+	type = EXCITE_STEPS;
+	steps = doublet121;
+	units = sizeof(doublet121) / sizeof(doublet121[0]);
+    } else if ( name == "doublet3211" ) {
+	type = EXCITE_STEPS;
+	steps = doublet3211;
+	units = sizeof(doublet3211) / sizeof(doublet3211[0]);
+    } else if ( name == "chirp" ) {
+	type = EXCITE_CHIRP;
+	dur_sec = clamp(dur_sec, 1.0, 100.0);
+	for ( int i = 0; i < n; i++ ) {
+	    // rad/sec is hz*2*pi
+	    double f0 = excite_node.getDouble("freq_start_rad_sec", i);
+	    double f1 = excite_node.getDouble("freq_end_rad_sec", i);
+	    f0 = clamp(f0, 0.1, 100.0);
+	    f1 = clamp(f1, 0.1, 100.0);
+	    channels[i].freq_start = f0;
+	    channels[i].k = (f1 - f0) / (2.0 * dur_sec);
+	}
+    } else if ( name == "oms" ) {
+	type = EXCITE_MULTISINE;
+	dur_sec = clamp(dur_sec, 1.0, 100.0);
+	int total = excite_node.getLen("freq_rps");
+	int m = total / n;
+	if ( m <= 0 || excite_node.getLen("phase_rad") < total
+	     || excite_node.getLen("amplitude") < total )
+	{
+	    printf("excite: oms needs freq_rps, phase_rad, amplitude for every component\n");
+	    return false;
+	}
+	for ( int i = 0; i < n; i++ ) {
+	    for ( int j = m*i; j < m*i + m; j++ ) {
+		sine_t s;
+		s.freq_rps = excite_node.getDouble("freq_rps", j);
+		s.phase_rad = excite_node.getDouble("phase_rad", j);
+		s.amplitude = sqrt(1.0 / m) * excite_node.getDouble("amplitude", j);
+		channels[i].sines.push_back( s );
+	    }
+	}
+    } else if ( name == "multisine" ) {
+	type = EXCITE_MULTISINE;
+	dur_sec = clamp(dur_sec, 1.0, 100.0);
+	make_multisine( excite_node.getDouble("freq_min_rps"),
+			excite_node.getDouble("freq_max_rps") );
+	for ( int i = 0; i < n; i++ ) {
+	    if ( channels[i].sines.empty() ) {
+		printf("excite: frequency range too narrow for %d channels\n", n);
+		return false;
+	    }
+	}
+    } else {
+	printf("excite: unknown type '%s'\n", name.c_str());
+	return false;
+    }
+    if ( type == EXCITE_STEPS ) {
+	// duration_sec is one unit
+	dur_sec *= units;
+    }
+    excite_node.setLen("signal", n, 0.0);
+    return true;
+}
+
+static void excite_stop( const char *result ) {
+    running = false;
+    excite_node.setBool("running", false);
+    excite_node.setString("result", result);
+    for ( unsigned int i = 0; i < channels.size(); i++ ) {
+	excite_node.setDouble("signal", i, 0.0);
+    }
+}
+
+void excite_update( pyPropertyNode *act_node ) {
+    string command = excite_node.getString("command");
+    if ( command.length() ) {
+	excite_node.setString("command", "");
+	if ( command == "start" ) {
+	    if ( excite_start() ) {
+		start_time = imu_node.getDouble("timestamp");
+		running = true;
+		excite_node.setBool("running", true);
+		excite_node.setString("result", "");
+	    } else {
+		excite_stop("failed");
+	    }
+	} else if ( command == "abort" ) {
+	    if ( running ) {
+		excite_stop("aborted");
+	    }
+	} else {
+	    printf("excite: unknown command '%s'\n", command.c_str());
+	}
+    }
+
+    if ( !running ) {
+	return;
+    }
+
+    // the signal is a function of the sample time, not of when this
+    // frame happened to run
+    double t = imu_node.getDouble("timestamp") - start_time;
+    if ( t > dur_sec ) {
+	excite_node.setDouble("progress", 1.0);
+	excite_stop("completed");
+	return;
+    }
+    double progress = t / dur_sec;
+    excite_node.setDouble("progress", progress);
+
+    for ( unsigned int i = 0; i < channels.size(); i++ ) {
+	excite_channel_t *ch = &channels[i];
+	double signal = 0.0;
+	if ( type == EXCITE_STEPS ) {
+	    int unit = progress * units;
+	    if ( unit >= units ) { unit = units - 1; }
+	    signal = ch->amplitude * steps[unit];
+	} else if ( type == EXCITE_CHIRP ) {
+	    signal = ch->amplitude * sin(ch->freq_start*t + ch->k*t*t);
+	} else if ( type == EXCITE_MULTISINE ) {
+	    for ( unsigned int j = 0; j < ch->sines.size(); j++ ) {
+		const sine_t &s = ch->sines[j];
+		signal += s.amplitude * cos(s.freq_rps * t + s.phase_rad);
+	    }
+	}
+	excite_node.setDouble("signal", i, signal);
+
+	const char *target = ch->target.c_str();
+	double act_val = act_node->getDouble(target) + signal;
+	act_val = clamp(act_val, ch->throttle ? 0.0 : -1.0, 1.0);
+	act_node->setDouble(target, act_val);
+    }
+}
@@ -0,0 +1,33 @@
+//
+// excite.hxx - excitation signals for system identification
+//
+// The excite task (mission/task/excite.py) describes an experiment
+// under /task/excite and sets command = "start".  From then on the
+// signals are computed here, in the actuator path, at the timestamp
+// of the imu sample the frame was built from, and added to the
+// targeted actuator channels.  The task only watches "running" to see
+// when the experiment finishes.
+//
+// Experiment types (per channel target[i] and amplitude[i]):
+//
+//   pulse, doublet, doublet121, doublet3211: duration_sec is the
+//       length of one unit step
+//   chirp: freq_start_rad_sec[i] to freq_end_rad_sec[i] over
+//       duration_sec (linear sweep)
+//   oms: freq_rps[], phase_rad[] and amplitude[] list every component,
+//       channel i uses components [n*i, n*i+n)
+//   multisine: orthogonal multisines between freq_min_rps and
+//       freq_max_rps.  The harmonics of 1/duration_sec are dealt out
+//       to the channels in turn so no two channels share a frequency,
+//       each channel gets Schroeder phases for a low peak factor.
+//
+
+#pragma once
+
+#include <pyprops.hxx>
+
+void excite_init();
+
+// start/abort on command and add any running excitation to the
+// actuator outputs under act_node
+void excite_update( pyPropertyNode *act_node );
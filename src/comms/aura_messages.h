@@ -36,8 +36,10 @@ const uint8_t ap_status_v4_id = 30;
 const uint8_t ap_status_v5_id = 32;
 const uint8_t ap_status_v6_id = 33;
 const uint8_t ap_status_v7_id = 39;
+const uint8_t ap_status_v8_id = 46;
 const uint8_t system_health_v4_id = 19;
 const uint8_t system_health_v5_id = 41;
+const uint8_t system_health_v6_id = 45;
 const uint8_t payload_v2_id = 23;
 const uint8_t payload_v3_id = 42;
 const uint8_t event_v1_id = 27;
@@ -1769,6 +1771,120 @@ struct ap_status_v7_t {
     }
 };
 
+// Message: ap_status_v8 (id: 46)
+struct ap_status_v8_t {
+    // public fields
+    uint8_t index;
+    float timestamp_sec;
+    uint8_t flags;
+    float groundtrack_deg;
+    float roll_deg;
+    float altitude_msl_ft;
+    float altitude_ground_m;
+    float pitch_deg;
+    float airspeed_kt;
+    float flight_timer;
+    uint16_t target_waypoint_idx;
+    double wp_longitude_deg;
+    double wp_latitude_deg;
+    uint16_t wp_index;
+    uint16_t route_size;
+    uint8_t task_id;
+    uint16_t task_attribute;
+    uint8_t sequence_num;
+    uint16_t param_version;
+
+    // internal structure for packing
+    uint8_t payload[message_max_len];
+    #pragma pack(push, 1)
+    struct _compact_t {
+        uint8_t index;
+        float timestamp_sec;
+        uint8_t flags;
+        int16_t groundtrack_deg;
+        int16_t roll_deg;
+        uint16_t altitude_msl_ft;
+        uint16_t altitude_ground_m;
+        int16_t pitch_deg;
+        int16_t airspeed_kt;
+        uint16_t flight_timer;
+        uint16_t target_waypoint_idx;
+        double wp_longitude_deg;
+        double wp_latitude_deg;
+        uint16_t wp_index;
+        uint16_t route_size;
+        uint8_t task_id;
+        uint16_t task_attribute;
+        uint8_t sequence_num;
+        uint16_t param_version;
+    };
+    #pragma pack(pop)
+
+    // public info fields
+    static const uint8_t id = 46;
+    int len = 0;
+
+    bool pack() {
+        len = sizeof(_compact_t);
+        // size sanity check
+        int size = len;
+        if ( size > message_max_len ) {
+            return false;
+        }
+        // copy values
+        _compact_t *_buf = (_compact_t *)payload;
+        _buf->index = index;
+        _buf->timestamp_sec = timestamp_sec;
+        _buf->flags = flags;
+        _buf->groundtrack_deg = intround(groundtrack_deg * 10);
+        _buf->roll_deg = intround(roll_deg * 10);
+        _buf->altitude_msl_ft = uintround(altitude_msl_ft * 1);
+        _buf->altitude_ground_m = uintround(altitude_ground_m * 1);
+        _buf->pitch_deg = intround(pitch_deg * 10);
+        _buf->airspeed_kt = intround(airspeed_kt * 10);
+        _buf->flight_timer = uintround(flight_timer * 1);
+        _buf->target_waypoint_idx = target_waypoint_idx;
+        _buf->wp_longitude_deg = wp_longitude_deg;
+        _buf->wp_latitude_deg = wp_latitude_deg;
+        _buf->wp_index = wp_index;
+        _buf->route_size = route_size;
+        _buf->task_id = task_id;
+        _buf->task_attribute = task_attribute;
+        _buf->sequence_num = sequence_num;
+        _buf->param_version = param_version;
+        return true;
+    }
+
+    bool unpack(uint8_t *external_message, int message_size) {
+        if ( message_size > message_max_len ) {
+            return false;
+        }
+        memcpy(payload, external_message, message_size);
+        _compact_t *_buf = (_compact_t *)payload;
+        len = sizeof(_compact_t);
+        index = _buf->index;
+        timestamp_sec = _buf->timestamp_sec;
+        flags = _buf->flags;
+        groundtrack_deg = _buf->groundtrack_deg / (float)10;
+        roll_deg = _buf->roll_deg / (float)10;
+        altitude_msl_ft = _buf->altitude_msl_ft / (float)1;
+        altitude_ground_m = _buf->altitude_ground_m / (float)1;
+        pitch_deg = _buf->pitch_deg / (float)10;
+        airspeed_kt = _buf->airspeed_kt / (float)10;
+        flight_timer = _buf->flight_timer / (float)1;
+        target_waypoint_idx = _buf->target_waypoint_idx;
+        wp_longitude_deg = _buf->wp_longitude_deg;
+        wp_latitude_deg = _buf->wp_latitude_deg;
+        wp_index = _buf->wp_index;
+        route_size = _buf->route_size;
+        task_id = _buf->task_id;
+        task_attribute = _buf->task_attribute;
+        sequence_num = _buf->sequence_num;
+        param_version = _buf->param_version;
+        return true;
+    }
+};
+
 // Message: system_health_v4 (id: 19)
 struct system_health_v4_t {
     // public fields
@@ -1909,6 +2025,108 @@ struct system_health_v5_t {
     }
 };
 
+// Message: system_health_v6 (id: 45)
+struct system_health_v6_t {
+    // public fields
+    uint8_t index;
+    float timestamp_sec;
+    float system_load_avg;
+    float avionics_vcc;
+    float main_vcc;
+    float cell_vcc;
+    float main_amps;
+    float total_mah;
+    float flight_cpu_pct;
+    float process_cpu_pct;
+    uint16_t ctx_voluntary;
+    uint16_t ctx_involuntary;
+    uint16_t minor_faults;
+    uint16_t major_faults;
+    float rss_mb;
+    float disk_latency_ms;
+
+    // internal structure for packing
+    uint8_t payload[message_max_len];
+    #pragma pack(push, 1)
+    struct _compact_t {
+        uint8_t index;
+        float timestamp_sec;
+        uint16_t system_load_avg;
+        uint16_t avionics_vcc;
+        uint16_t main_vcc;
+        uint16_t cell_vcc;
+        uint16_t main_amps;
+        uint16_t total_mah;
+        uint16_t flight_cpu_pct;
+        uint16_t process_cpu_pct;
+        uint16_t ctx_voluntary;
+        uint16_t ctx_involuntary;
+        uint16_t minor_faults;
+        uint16_t major_faults;
+        uint16_t rss_mb;
+        uint16_t disk_latency_ms;
+    };
+    #pragma pack(pop)
+
+    // public info fields
+    static const uint8_t id = 45;
+    int len = 0;
+
+    bool pack() {
+        len = sizeof(_compact_t);
+        // size sanity check
+        int size = len;
+        if ( size > message_max_len ) {
+            return false;
+        }
+        // copy values
+        _compact_t *_buf = (_compact_t *)payload;
+        _buf->index = index;
+        _buf->timestamp_sec = timestamp_sec;
+        _buf->system_load_avg = uintround(system_load_avg * 100);
+        _buf->avionics_vcc = uintround(avionics_vcc * 1000);
+        _buf->main_vcc = uintround(main_vcc * 1000);
+        _buf->cell_vcc = uintround(cell_vcc * 1000);
+        _buf->main_amps = uintround(main_amps * 1000);
+        _buf->total_mah = uintround(total_mah * 10);
+        _buf->flight_cpu_pct = uintround(flight_cpu_pct * 100);
+        _buf->process_cpu_pct = uintround(process_cpu_pct * 100);
+        _buf->ctx_voluntary = ctx_voluntary;
+        _buf->ctx_involuntary = ctx_involuntary;
+        _buf->minor_faults = minor_faults;
+        _buf->major_faults = major_faults;
+        _buf->rss_mb = uintround(rss_mb * 10);
+        _buf->disk_latency_ms = uintround(disk_latency_ms * 100);
+        return true;
+    }
+
+    bool unpack(uint8_t *external_message, int message_size) {
+        if ( message_size > message_max_len ) {
+            return false;
+        }
+        memcpy(payload, external_message, message_size);
+        _compact_t *_buf = (_compact_t *)payload;
+        len = sizeof(_compact_t);
+        index = _buf->index;
+        timestamp_sec = _buf->timestamp_sec;
+        system_load_avg = _buf->system_load_avg / (float)100;
+        avionics_vcc = _buf->avionics_vcc / (float)1000;
+        main_vcc = _buf->main_vcc / (float)1000;
+        cell_vcc = _buf->cell_vcc / (float)1000;
+        main_amps = _buf->main_amps / (float)1000;
+        total_mah = _buf->total_mah / (float)10;
+        flight_cpu_pct = _buf->flight_cpu_pct / (float)100;
+        process_cpu_pct = _buf->process_cpu_pct / (float)100;
+        ctx_voluntary = _buf->ctx_voluntary;
+        ctx_involuntary = _buf->ctx_involuntary;
+        minor_faults = _buf->minor_faults;
+        major_faults = _buf->major_faults;
+        rss_mb = _buf->rss_mb / (float)10;
+        disk_latency_ms = _buf->disk_latency_ms / (float)100;
+        return true;
+    }
+};
+
 // Message: payload_v2 (id: 23)
 struct payload_v2_t {
     // public fields
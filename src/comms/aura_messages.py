@@ -20,8 +20,10 @@ ap_status_v4_id = 30
 ap_status_v5_id = 32
 ap_status_v6_id = 33
 ap_status_v7_id = 39
+ap_status_v8_id = 46
 system_health_v4_id = 19
 system_health_v5_id = 41
+system_health_v6_id = 45
 payload_v2_id = 23
 payload_v3_id = 42
 event_v1_id = 27
@@ -1248,6 +1250,87 @@ class ap_status_v7():
         self.airspeed_kt /= 10
         self.flight_timer /= 1
 
+# Message: ap_status_v8
+# Id: 46
+class ap_status_v8():
+    id = 46
+    _pack_string = "<BfBhhHHhhHHddHHBHBH"
+
+    def __init__(self, msg=None):
+        # public fields
+        self.index = 0
+        self.timestamp_sec = 0.0
+        self.flags = 0
+        self.groundtrack_deg = 0.0
+        self.roll_deg = 0.0
+        self.altitude_msl_ft = 0.0
+        self.altitude_ground_m = 0.0
+        self.pitch_deg = 0.0
+        self.airspeed_kt = 0.0
+        self.flight_timer = 0.0
+        self.target_waypoint_idx = 0
+        self.wp_longitude_deg = 0.0
+        self.wp_latitude_deg = 0.0
+        self.wp_index = 0
+        self.route_size = 0
+        self.task_id = 0
+        self.task_attribute = 0
+        self.sequence_num = 0
+        self.param_version = 0
+        # unpack if requested
+        if msg: self.unpack(msg)
+
+    def pack(self):
+        msg = struct.pack(self._pack_string,
+                          self.index,
+                          self.timestamp_sec,
+                          self.flags,
+                          int(round(self.groundtrack_deg * 10)),
+                          int(round(self.roll_deg * 10)),
+                          int(round(self.altitude_msl_ft * 1)),
+                          int(round(self.altitude_ground_m * 1)),
+                          int(round(self.pitch_deg * 10)),
+                          int(round(self.airspeed_kt * 10)),
+                          int(round(self.flight_timer * 1)),
+                          self.target_waypoint_idx,
+                          self.wp_longitude_deg,
+                          self.wp_latitude_deg,
+                          self.wp_index,
+                          self.route_size,
+                          self.task_id,
+                          self.task_attribute,
+                          self.sequence_num,
+                          self.param_version)
+        return msg
+
+    def unpack(self, msg):
+        (self.index,
+         self.timestamp_sec,
+         self.flags,
+         self.groundtrack_deg,
+         self.roll_deg,
+         self.altitude_msl_ft,
+         self.altitude_ground_m,
+         self.pitch_deg,
+         self.airspeed_kt,
+         self.flight_timer,
+         self.target_waypoint_idx,
+         self.wp_longitude_deg,
+         self.wp_latitude_deg,
+         self.wp_index,
+         self.route_size,
+         self.task_id,
+         self.task_attribute,
+         self.sequence_num,
+         self.param_version) = struct.unpack(self._pack_string, msg)
+        self.groundtrack_deg /= 10
+        self.roll_deg /= 10
+        self.altitude_msl_ft /= 1
+        self.altitude_ground_m /= 1
+        self.pitch_deg /= 10
+        self.airspeed_kt /= 10
+        self.flight_timer /= 1
+
 # Message: system_health_v4
 # Id: 19
 class system_health_v4():
@@ -1342,6 +1425,81 @@ class system_health_v5():
         self.main_amps /= 1000
         self.total_mah /= 10
 
+# Message: system_health_v6
+# Id: 45
+class system_health_v6():
+    id = 45
+    _pack_string = "<BfHHHHHHHHHHHHHH"
+
+    def __init__(self, msg=None):
+        # public fields
+        self.index = 0
+        self.timestamp_sec = 0.0
+        self.system_load_avg = 0.0
+        self.avionics_vcc = 0.0
+        self.main_vcc = 0.0
+        self.cell_vcc = 0.0
+        self.main_amps = 0.0
+        self.total_mah = 0.0
+        self.flight_cpu_pct = 0.0
+        self.process_cpu_pct = 0.0
+        self.ctx_voluntary = 0
+        self.ctx_involuntary = 0
+        self.minor_faults = 0
+        self.major_faults = 0
+        self.rss_mb = 0.0
+        self.disk_latency_ms = 0.0
+        # unpack if requested
+        if msg: self.unpack(msg)
+
+    def pack(self):
+        msg = struct.pack(self._pack_string,
+                          self.index,
+                          self.timestamp_sec,
+                          int(round(self.system_load_avg * 100)),
+                          int(round(self.avionics_vcc * 1000)),
+                          int(round(self.main_vcc * 1000)),
+                          int(round(self.cell_vcc * 1000)),
+                          int(round(self.main_amps * 1000)),
+                          int(round(self.total_mah * 10)),
+                          int(round(self.flight_cpu_pct * 100)),
+                          int(round(self.process_cpu_pct * 100)),
+                          self.ctx_voluntary,
+                          self.ctx_involuntary,
+                          self.minor_faults,
+                          self.major_faults,
+                          int(round(self.rss_mb * 10)),
+                          int(round(self.disk_latency_ms * 100)))
+        return msg
+
+    def unpack(self, msg):
+        (self.index,
+         self.timestamp_sec,
+         self.system_load_avg,
+         self.avionics_vcc,
+         self.main_vcc,
+         self.cell_vcc,
+         self.main_amps,
+         self.total_mah,
+         self.flight_cpu_pct,
+         self.process_cpu_pct,
+         self.ctx_voluntary,
+         self.ctx_involuntary,
+         self.minor_faults,
+         self.major_faults,
+         self.rss_mb,
+         self.disk_latency_ms) = struct.unpack(self._pack_string, msg)
+        self.system_load_avg /= 100
+        self.avionics_vcc /= 1000
+        self.main_vcc /= 1000
+        self.cell_vcc /= 1000
+        self.main_amps /= 1000
+        self.total_mah /= 10
+        self.flight_cpu_pct /= 100
+        self.process_cpu_pct /= 100
+        self.rss_mb /= 10
+        self.disk_latency_ms /= 100
+
 # Message: payload_v2
 # Id: 23
 class payload_v2():
@@ -0,0 +1,171 @@
+# link_codec.py - keyframe + delta compression for the high rate
+# telemetry messages on the remote link.
+#
+# Shared by both ends: remote_link.py encodes on the aircraft,
+# auraparser.py decodes on the ground and hands the rebuilt messages
+# to the normal unpackers (so logs and exports see plain messages.)
+#
+# Each field of a coded message type is quantized to a fixed point
+# grid (scale below.)  Per message type and index the sender keeps a
+# keyframe: every keyframe_interval messages (or when a delta
+# wouldn't be smaller) the plain message goes out as a keyframe,
+# anything in between goes out as the zigzag varint difference of
+# each quantized field from that keyframe.  Deltas are taken against
+# the keyframe and not the previous message, so a lost delta costs
+# only itself and a lost keyframe only the deltas until the next one.
+# The receiver drops deltas whose keyframe it doesn't have.
+#
+# Messages rebuilt from a delta carry the quantized values, not the
+# originals: a ground log of a coded stream holds plain keyframes
+# interleaved with messages rounded to the grid below (1 ms, 1e-4
+# rad/sec, 1e-7 deg, ...).  Fields round trip exactly only when they
+# were already on the grid.
+#
+# Wire format (inside the usual serial_parser packet framing):
+#
+#   keyframe (id 200): msg_id, index, key_seq, plain payload
+#   delta    (id 201 + type): index << 4 | key_seq & 0xf, one varint
+#                             per field after index
+#
+# Messages with an index of 16 or more go out plain.
+
+from comms import aura_messages
+
+keyframe_id = 200
+
+# field quantization (fixed point scale), fields in message order
+# after the index
+fields = {
+    aura_messages.imu_v4_id: (
+        aura_messages.imu_v4,
+        [ ('timestamp_sec', 1000),
+          ('p_rad_sec', 10000), ('q_rad_sec', 10000), ('r_rad_sec', 10000),
+          ('ax_mps_sec', 1000), ('ay_mps_sec', 1000), ('az_mps_sec', 1000),
+          ('hx', 1000), ('hy', 1000), ('hz', 1000),
+          ('temp_C', 10), ('status', 1) ] ),
+    aura_messages.filter_v4_id: (
+        aura_messages.filter_v4,
+        [ ('timestamp_sec', 1000),
+          ('latitude_deg', 10000000), ('longitude_deg', 10000000),
+          ('altitude_m', 100),
+          ('vn_ms', 100), ('ve_ms', 100), ('vd_ms', 100),
+          ('roll_deg', 10), ('pitch_deg', 10), ('yaw_deg', 10),
+          ('p_bias', 10000), ('q_bias', 10000), ('r_bias', 10000),
+          ('ax_bias', 1000), ('ay_bias', 1000), ('az_bias', 1000),
+          ('sequence_num', 1), ('status', 1) ] ),
+    aura_messages.actuator_v3_id: (
+        aura_messages.actuator_v3,
+        [ ('timestamp_sec', 1000),
+          ('aileron', 20000), ('elevator', 20000), ('throttle', 60000),
+          ('rudder', 20000), ('channel5', 20000), ('flaps', 20000),
+          ('channel7', 20000), ('channel8', 20000), ('status', 1) ] ),
+}
+
+# one delta packet id per coded message type
+delta_ids = {}
+delta_types = {}
+for i, msg_id in enumerate(sorted(fields)):
+    delta_ids[msg_id] = keyframe_id + 1 + i
+    delta_types[keyframe_id + 1 + i] = msg_id
+
+def put_varint(buf, value):
+    zz = (value << 1) if value >= 0 else ((-value << 1) - 1)
+    while zz >= 0x80:
+        buf.append((zz & 0x7f) | 0x80)
+        zz >>= 7
+    buf.append(zz)
+
+def get_varint(buf, pos):
+    zz = 0
+    shift = 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        zz |= (b & 0x7f) << shift
+        shift += 7
+        if not (b & 0x80):
+            break
+    value = (zz >> 1) if not (zz & 1) else -((zz + 1) >> 1)
+    return value, pos
+
+# both ends quantize the keyframe from the plain payload bytes, so they
+# agree on the reference exactly
+def quantize(msg_id, payload):
+    (msg_class, spec) = fields[msg_id]
+    msg = msg_class(payload)
+    return [ int(round(getattr(msg, name) * scale)) for (name, scale) in spec ]
+
+class encoder():
+    def __init__(self, keyframe_interval=10):
+        self.keyframe_interval = keyframe_interval
+        self.streams = {}       # (msg_id, index) -> [seq, count, ref]
+
+    # returns (packet id, payload) to send in place of the message
+    def encode(self, msg_id, payload):
+        if msg_id not in fields or payload[0] >= 16:
+            return msg_id, payload
+        index = payload[0]
+        key = (msg_id, index)
+        values = quantize(msg_id, payload)
+        stream = self.streams.get(key)
+        if stream is not None and stream[1] < self.keyframe_interval:
+            buf = bytearray([(index << 4) | (stream[0] & 0xf)])
+            for v, r in zip(values, stream[2]):
+                put_varint(buf, v - r)
+            if len(buf) < len(payload):
+                stream[1] += 1
+                return delta_ids[msg_id], buf
+        # keyframe
+        seq = 0 if stream is None else (stream[0] + 1) & 0xff
+        self.streams[key] = [seq, 0, values]
+        buf = bytearray([msg_id, index, seq])
+        buf.extend(payload)
+        return keyframe_id, buf
+
+    # the packet from encode() never went out: if it was a keyframe
+    # the next message has to be one too
+    def lost(self, pkt_id, payload):
+        if pkt_id == keyframe_id:
+            self.streams.pop((payload[0], payload[1]), None)
+
+class decoder():
+    def __init__(self):
+        self.refs = {}          # (msg_id, index) -> (seq, ref)
+        self.dropped = 0
+
+    # returns (msg_id, plain payload), or (-1, None) if a delta can't
+    # be rebuilt.  Anything that isn't a codec packet passes through.
+    def decode(self, pkt_id, payload):
+        if pkt_id == keyframe_id:
+            msg_id = payload[0]
+            if msg_id not in fields:
+                self.dropped += 1
+                return -1, None
+            plain = bytes(payload[3:])
+            self.refs[(msg_id, payload[1])] = (payload[2] & 0xf,
+                                                quantize(msg_id, plain))
+            return msg_id, plain
+        if pkt_id not in delta_types:
+            return pkt_id, payload
+        msg_id = delta_types[pkt_id]
+        index = payload[0] >> 4
+        ref = self.refs.get((msg_id, index))
+        if ref is None or ref[0] != payload[0] & 0xf:
+            self.dropped += 1
+            return -1, None
+        (msg_class, spec) = fields[msg_id]
+        msg = msg_class()
+        msg.index = index
+        pos = 1
+        try:
+            for (name, scale), r in zip(spec, ref[1]):
+                d, pos = get_varint(payload, pos)
+                if scale == 1:
+                    setattr(msg, name, r + d)
+                else:
+                    setattr(msg, name, (r + d) / scale)
+        except IndexError:
+            # short delta
+            self.dropped += 1
+            return -1, None
+        return msg_id, msg.pack()
@@ -660,6 +660,7 @@ def pack_ap_status_dict(index):
     row['timestamp'] = targets_node.getFloat('timestamp')
     row['master_switch'] = ap_node.getBool("master_switch")
     row['pilot_pass_through'] = ap_node.getBool("pilot_pass_through")
+    row['param_version'] = ap_node.getInt("param_version")
     row['groundtrack_deg'] = targets_node.getFloat('groundtrack_deg')
     row['roll_deg'] = targets_node.getFloat('roll_deg')
     row['altitude_msl_ft'] = targets_node.getFloat('altitude_msl_ft')
@@ -699,6 +700,7 @@ def pack_ap_status_csv(index):
     row['timestamp'] = '%.4f' % targets_node.getFloat('timestamp')
     row['master_switch'] = '%d' % ap_node.getBool("master_switch")
     row['pilot_pass_through'] = '%d' % ap_node.getBool("pilot_pass_through")
+    row['param_version'] = '%d' % ap_node.getInt("param_version")
     row['groundtrack_deg'] = '%.2f' % targets_node.getFloat('groundtrack_deg')
     row['roll_deg'] = '%.2f' % targets_node.getFloat('roll_deg')
     row['altitude_msl_ft'] = '%.2f' % targets_node.getFloat('altitude_msl_ft')
@@ -707,7 +709,7 @@ def pack_ap_status_csv(index):
     row['altitude_ground_m'] = '%.1f' % pos_node.getFloat("altitude_ground_m")
     row['tecs_target_tot'] = '%.4f' % tecs_node.getFloat("target_total")
     keys = ['timestamp', 'master_switch', 'pilot_pass_through',
-            'groundtrack_deg', 'roll_deg', 'altitude_msl_ft', 'pitch_deg',
+            'param_version', 'groundtrack_deg', 'roll_deg', 'altitude_msl_ft', 'pitch_deg',
             'airspeed_kt', 'altitude_ground_m',
             'tecs_target_tot']
     return row, keys
@@ -907,6 +909,64 @@ def unpack_ap_status_v7(buf):
 
     return index
 
+def unpack_ap_status_v8(buf):
+    ap = aura_messages.ap_status_v8(buf)
+
+    index = ap.index
+
+    wp_lon = ap.wp_longitude_deg
+    wp_lat = ap.wp_latitude_deg
+    wp_index = ap.wp_index
+    route_size = ap.route_size
+    task_id = ap.task_id
+    task_attrib = ap.task_attribute
+
+    targets_node.setFloat("timestamp", ap.timestamp_sec)
+    flags = ap.flags
+    ap_node.setBool("master_switch", flags & (1<<0))
+    ap_node.setBool("pilot_pass_through", flags & (1<<1))
+    ap_node.setInt("param_version", ap.param_version)
+    targets_node.setFloat("groundtrack_deg", ap.groundtrack_deg)
+    targets_node.setFloat("roll_deg", ap.roll_deg)
+    targets_node.setFloat("altitude_msl_ft", ap.altitude_msl_ft)
+    pos_node.setFloat("altitude_ground_m", ap.altitude_ground_m)
+    targets_node.setFloat("pitch_deg", ap.pitch_deg)
+    targets_node.setFloat("airspeed_kt", ap.airspeed_kt)
+    status_node.setFloat("flight_timer", ap.flight_timer)
+    status_node.setBool("onboard_flight_timer", True)
+    if route_size != active_node.getInt("route_size"):
+        # route size change, zero all the waypoint coordinates
+        for i in range(active_node.getInt("route_size")):
+            wp_node = active_node.getChild('wpt[%d]' % i, True)
+            wp_node.setFloat("longitude_deg", 0)
+            wp_node.setFloat("latitude_deg", 0)
+    route_node.setInt("target_waypoint_idx", ap.target_waypoint_idx)
+    if wp_index < route_size:
+        wp_node = active_node.getChild('wpt[%d]' % wp_index, True)
+        wp_node.setFloat("longitude_deg", wp_lon)
+        wp_node.setFloat("latitude_deg", wp_lat)
+    elif wp_index == 65534:
+        circle_node.setFloat("longitude_deg", wp_lon)
+        circle_node.setFloat("latitude_deg", wp_lat)
+        circle_node.setFloat("radius_m", task_attrib / 10.0)
+    elif wp_index == 65535:
+        home_node.setFloat("longitude_deg", wp_lon)
+        home_node.setFloat("latitude_deg", wp_lat)
+    if task_id == 1:
+        task_node.setString("current_task_id", "circle");
+    elif task_id == 2:
+        task_node.setString("current_task_id", "route");
+    elif task_id == 3:
+        task_node.setString("current_task_id", "land");
+    else:
+        task_node.setString("current_task_id", "unknown");
+                
+    active_node.setInt("route_size", route_size)
+    if ap.sequence_num >= 1:
+        remote_link_node.setInt("sequence_num", ap.sequence_num)
+
+    return index
+
 def pack_system_health_dict(index):
     row = dict()
     row['timestamp'] = status_node.getFloat('frame_time')
@@ -916,6 +976,14 @@ def pack_system_health_dict(index):
     row['cell_vcc'] = power_node.getFloat('cell_vcc')
     row['main_amps'] = power_node.getFloat('main_amps')
     row['total_mah'] = power_node.getFloat('total_mah')
+    row['flight_cpu_pct'] = status_node.getFloat('flight_cpu_pct')
+    row['process_cpu_pct'] = status_node.getFloat('process_cpu_pct')
+    row['ctx_voluntary'] = status_node.getFloat('ctx_voluntary')
+    row['ctx_involuntary'] = status_node.getFloat('ctx_involuntary')
+    row['minor_faults'] = status_node.getFloat('minor_faults')
+    row['major_faults'] = status_node.getFloat('major_faults')
+    row['rss_mb'] = status_node.getFloat('rss_mb')
+    row['disk_latency_ms'] = status_node.getFloat('disk_latency_ms')
     return row
 
 def pack_system_health_csv(index):
@@ -927,8 +995,18 @@ def pack_system_health_csv(index):
     row['cell_vcc'] = '%.2f' % power_node.getFloat('cell_vcc')
     row['main_amps'] = '%.2f' % power_node.getFloat('main_amps')
     row['total_mah'] = '%.0f' % power_node.getFloat('total_mah')
+    row['flight_cpu_pct'] = '%.1f' % status_node.getFloat('flight_cpu_pct')
+    row['process_cpu_pct'] = '%.1f' % status_node.getFloat('process_cpu_pct')
+    row['ctx_voluntary'] = '%.0f' % status_node.getFloat('ctx_voluntary')
+    row['ctx_involuntary'] = '%.0f' % status_node.getFloat('ctx_involuntary')
+    row['minor_faults'] = '%.0f' % status_node.getFloat('minor_faults')
+    row['major_faults'] = '%.0f' % status_node.getFloat('major_faults')
+    row['rss_mb'] = '%.1f' % status_node.getFloat('rss_mb')
+    row['disk_latency_ms'] = '%.2f' % status_node.getFloat('disk_latency_ms')
     keys = ['timestamp', 'system_load_avg', 'avionics_vcc', 'main_vcc',
-            'cell_vcc', 'main_amps', 'total_mah']
+            'cell_vcc', 'main_amps', 'total_mah', 'flight_cpu_pct',
+            'process_cpu_pct', 'ctx_voluntary', 'ctx_involuntary',
+            'minor_faults', 'major_faults', 'rss_mb', 'disk_latency_ms']
     return row, keys
 
 def unpack_system_health_v4(buf):
@@ -953,6 +1031,25 @@ def unpack_system_health_v5(buf):
     power_node.setInt("total_mah", health.total_mah)
     return health.index
 
+def unpack_system_health_v6(buf):
+    health = aura_messages.system_health_v6(buf)
+    status_node.setFloat("frame_time", health.timestamp_sec)
+    status_node.setFloat("system_load_avg", health.system_load_avg)
+    power_node.setFloat("avionics_vcc", health.avionics_vcc)
+    power_node.setFloat("main_vcc", health.main_vcc)
+    power_node.setFloat("cell_vcc", health.cell_vcc)
+    power_node.setFloat("main_amps", health.main_amps)
+    power_node.setInt("total_mah", health.total_mah)
+    status_node.setFloat("flight_cpu_pct", health.flight_cpu_pct)
+    status_node.setFloat("process_cpu_pct", health.process_cpu_pct)
+    status_node.setFloat("ctx_voluntary", health.ctx_voluntary)
+    status_node.setFloat("ctx_involuntary", health.ctx_involuntary)
+    status_node.setFloat("minor_faults", health.minor_faults)
+    status_node.setFloat("major_faults", health.major_faults)
+    status_node.setFloat("rss_mb", health.rss_mb)
+    status_node.setFloat("disk_latency_ms", health.disk_latency_ms)
+    return health.index
+
 def pack_payload_dict(index):
     row = dict()
     row['timestamp'] = payload_node.getFloat('timestamp')
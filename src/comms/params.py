@@ -0,0 +1,52 @@
+import re
+
+from props import getNode
+
+# The autopilot components reload their ParamSnapshot only when
+# /autopilot/param_version changes, so every write under
+# /config/autopilot has to go through here.
+
+def bump_version():
+    ap_node = getNode( '/autopilot', True )
+    ap_node.setInt( 'param_version', ap_node.getInt('param_version') + 1 )
+
+# set a property from a command string, guessing the type from the
+# text (int, float, bool, else string)
+def set_value(node_path, name, value):
+    if len(node_path) > 1:
+        node_path = node_path.rstrip('/')
+    node = getNode(node_path, True)
+    done = False
+    # test for int
+    if not done:
+        result = re.match('[-+]?\d+', value)
+        if result and result.group(0) == value:
+            print('int:', value)
+            node.setInt(name, int(value))
+            done = True
+    # test for float
+    if not done:
+        result = re.match('[-+]?\d*\.\d+', value)
+        if result and result.group(0) == value:
+            print('float:', value)
+            node.setFloat(name, float(value))
+            done = True
+    # test for bool
+    if not done:
+        if value == 'True' or value == 'true':
+            print('bool:', True)
+            node.setBool(name, True)
+            done = True
+    if not done:
+        if value == 'False' or value == 'false':
+            print('bool:', False)
+            node.setBool(name, False)
+            done = True
+    # fall back to string
+    if not done:
+        node.setString(name, value)
+
+    if node_path == '/config/autopilot' \
+       or node_path.startswith('/config/autopilot/'):
+        bump_version()
+    return node
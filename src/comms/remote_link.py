@@ -5,7 +5,9 @@ import props_json
 
 from comms import aura_messages
 import comms.events
+import comms.link_codec
 import comms.packer
+import comms.params
 import comms.serial_parser
 
 import survey.survey
@@ -23,6 +25,7 @@ remote_link_node = getNode('/comms/remote_link', True)
 remote_link_on = False    # link to remote operator station
 ser = None
 parser = None
+codec = None
 serial_buf = bytearray()
 max_serial_buffer = 256
 link_open = False
@@ -31,6 +34,7 @@ link_open = False
 def init():
     global ser
     global parser
+    global codec
     global link_open
     
     device = remote_link_config.getString('device')
@@ -50,6 +54,15 @@ def init():
     if not remote_link_config.getInt('write_bytes_per_frame'):
         remote_link_config.setInt('write_bytes_per_frame', 12)
 
+    # keyframe + delta coding of the high rate messages (the ground
+    # side must know it too: auralink decodes it)
+    if remote_link_config.getBool('codec'):
+        interval = remote_link_config.getInt('codec_keyframe_interval')
+        if interval < 1:
+            interval = 10
+        codec = comms.link_codec.encoder(interval)
+        print('remote link: message codec on, keyframe every', interval)
+
 # write as many bytes out of the serial_buf to the uart as the
 # driver will accept.
 def flush_serial():
@@ -86,20 +99,26 @@ def send_message( pkt_id, payload ):
         # remote serial link not available
         return False
 
+    if codec:
+        pkt_id, payload = codec.encode(pkt_id, payload)
     msg = comms.serial_parser.wrap_packet(pkt_id, payload)
     if len(serial_buf) + len(msg) <= max_serial_buffer:
         serial_buf.extend(msg)
         return True
     else:
+        if codec:
+            codec.lost(pkt_id, payload)
         if comms_node.getBool('display_on'):
             print('remote link serial buffer overflow, size:', len(serial_buf), 'add:', len(msg), 'limit:', max_serial_buffer)
         return False
 
 route_request = []
 survey_request = {}
+survey_ring = []
 def execute_command( command ):
     global route_request
     global survey_request
+    global survey_ring
 
     if command == '':
         # no valid tokens
@@ -137,10 +156,21 @@ def execute_command( command ):
         survey_request['forward_fov'] = float( tokens[5] )
         survey_request['lateral_fov'] = float( tokens[6] )
         survey_request['area'] = []
+        survey_request['holes'] = []
+        survey_request['nofly'] = []
+        survey_ring = survey_request['area']
+    elif tokens[0] == 'survey_hole' and len(tokens) == 1:
+        # following survey_cont points outline an area to leave out
+        survey_ring = []
+        survey_request['holes'].append( survey_ring )
+    elif tokens[0] == 'survey_nofly' and len(tokens) == 1:
+        # following survey_cont points outline an area not to fly over
+        survey_ring = []
+        survey_request['nofly'].append( survey_ring )
     elif tokens[0] == 'survey_cont' and len(tokens) > 2:
         for i in range(1, len(tokens), 2):
             wpt = ( float(tokens[i]), float(tokens[i+1]) )
-            survey_request['area'].append( wpt )            
+            survey_ring.append( wpt )
     elif tokens[0] == 'survey_end' and len(tokens) == 1:
         survey.survey.do_survey(survey_request)
     elif tokens[0] == 'task':
@@ -182,38 +212,9 @@ def execute_command( command ):
             node_path = '/'.join(parts[0:-1])
             if node_path == '':
                 node_path = '/'
-            node = getNode(node_path, True)
             name = parts[-1]
             value = ' '.join(tokens[2:])
-            done = False
-            # test for int
-            if not done:
-                result = re.match('[-+]?\d+', value)
-                if result and result.group(0) == value:
-                    print('int:', value)
-                    node.setInt(name, int(value))
-                    done = True
-            # test for float
-            if not done:
-                result = re.match('[-+]?\d*\.\d+', value)
-                if result and result.group(0) == value:
-                    print('float:', value)
-                    node.setFloat(name, float(value))
-                    done = True
-            # test for bool
-            if not done:
-                if value == 'True' or value == 'true':
-                    print('bool:', True)
-                    node.setBool(name, True)
-                    done = True
-            if not done:
-                if value == 'False' or value == 'false':
-                    print('bool:', False)
-                    node.setBool(name, False)
-                    done = True
-            # fall back to string
-            if not done:
-                node.setString(name, value)
+            comms.params.set_value(node_path, name, value)
         else:
             # expecting a full path name to set
             pass
@@ -264,7 +265,10 @@ def read_link_command():
 last_sequence_num = -1
 def command():
     global last_sequence_num
-    
+
+    # finish any survey planning in progress
+    survey.survey.update()
+
     sequence_num, command = read_link_command()
     if sequence_num < 0:
         return False
@@ -323,4 +327,8 @@ def decode_fcs_update(command):
     else:
         return False
 
+    # the autopilot components pick up the new values when they see
+    # the version change (and echo it back in ap_status)
+    comms.params.bump_version()
+
     return True
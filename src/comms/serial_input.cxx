@@ -0,0 +1,152 @@
+#include <errno.h>		// errno
+#include <string.h>		// memcmp(), strerror()
+#include <unistd.h>		// read(), usleep()
+#include <sys/ioctl.h>          // FIONREAD
+
+#include <atomic>
+
+#include "util/timing.h"
+
+#include "serial_input.hxx"
+
+static const char record_magic[] = "AURAREC1";
+
+// the replay clock seen through get_Time(), helper threads read it
+static std::atomic<double> replay_time(0.0);
+static bool replay_finished = false;
+
+static double get_replay_time() {
+    return replay_time.load( std::memory_order_relaxed );
+}
+
+SerialInput::SerialInput() {
+}
+
+SerialInput::~SerialInput() {
+}
+
+void SerialInput::attach( int fd ) {
+    this->fd = fd;
+    buf_len = buf_pos = 0;
+}
+
+bool SerialInput::record( const char *file_name ) {
+    record_fp = fopen( file_name, "w" );
+    if ( record_fp == NULL ) {
+        fprintf( stderr, "serial record: unable to open %s - %s\n",
+                 file_name, strerror(errno) );
+        return false;
+    }
+    fwrite( record_magic, 8, 1, record_fp );
+    printf("recording serial input to %s\n", file_name);
+    return true;
+}
+
+bool SerialInput::replay( const char *file_name, bool realtime ) {
+    replay_fp = fopen( file_name, "r" );
+    if ( replay_fp == NULL ) {
+        fprintf( stderr, "serial replay: unable to open %s - %s\n",
+                 file_name, strerror(errno) );
+        return false;
+    }
+    char magic[8];
+    if ( fread( magic, 8, 1, replay_fp ) != 1
+         || memcmp( magic, record_magic, 8 ) != 0 ) {
+        fprintf( stderr, "serial replay: %s is not a serial recording\n",
+                 file_name );
+        fclose( replay_fp );
+        replay_fp = NULL;
+        return false;
+    }
+    replay_realtime = realtime;
+    replay_start = -1.0;
+    replay_eof = false;
+    buf_len = buf_pos = 0;
+    replay_time.store( 0.0, std::memory_order_relaxed );
+    set_Time_source( get_replay_time );
+    printf("replaying serial input from %s (%s)\n", file_name,
+           realtime ? "real time" : "max speed");
+    return true;
+}
+
+// refill the buffer, returns the number of new bytes
+int SerialInput::fill() {
+    buf_len = buf_pos = 0;
+
+    if ( replay_fp != NULL ) {
+        if ( replay_eof ) {
+            return 0;
+        }
+        double stamp;
+        uint16_t len;
+        if ( fread( &stamp, sizeof(stamp), 1, replay_fp ) != 1
+             || fread( &len, sizeof(len), 1, replay_fp ) != 1
+             || len > sizeof(buf)
+             || fread( buf, len, 1, replay_fp ) != 1 ) {
+            // nothing downstream can make progress once the clock
+            // stops, so the end of the log is the end of the run.
+            printf("serial replay: end of recording at %.3f sec\n",
+                   replay_time.load());
+            replay_eof = true;
+            replay_finished = true;
+            return 0;
+        }
+        if ( replay_start < 0.0 ) {
+            replay_start = stamp;
+            replay_wall = get_RealTime();
+        }
+        if ( replay_realtime ) {
+            double wait = (stamp - replay_start)
+                - (get_RealTime() - replay_wall);
+            if ( wait > 0.0 ) {
+                usleep( (useconds_t)(wait * 1000000.0) );
+            }
+        }
+        replay_time.store( stamp, std::memory_order_relaxed );
+        buf_len = len;
+        return buf_len;
+    }
+
+    int len = ::read( fd, buf, sizeof(buf) );
+    if ( len <= 0 ) {
+        return len;
+    }
+    buf_len = len;
+    if ( record_fp != NULL ) {
+        double stamp = get_Time();
+        uint16_t rlen = len;
+        fwrite( &stamp, sizeof(stamp), 1, record_fp );
+        fwrite( &rlen, sizeof(rlen), 1, record_fp );
+        fwrite( buf, len, 1, record_fp );
+    }
+    return buf_len;
+}
+
+// bytes that can be read without blocking.  A replay only reports
+// what is left of the current chunk, so the drivers' skip-ahead logic
+// makes the same decisions on every run.
+int SerialInput::bytes_available() {
+    int avail = 0;
+    if ( replay_fp == NULL ) {
+        ioctl(fd, FIONREAD, &avail);
+    }
+    return avail + (buf_len - buf_pos);
+}
+
+bool serial_replay_finished() {
+    return replay_finished;
+}
+
+void SerialInput::close() {
+    if ( record_fp != NULL ) {
+        fclose( record_fp );
+        record_fp = NULL;
+    }
+    if ( replay_fp != NULL ) {
+        fclose( replay_fp );
+        replay_fp = NULL;
+        release_Time_source( get_replay_time );
+    }
+    fd = -1;
+    buf_len = buf_pos = 0;
+}
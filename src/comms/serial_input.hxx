@@ -0,0 +1,70 @@
+#pragma once
+
+// Buffered byte input for the serial sensor links with optional
+// record and replay.
+//
+// Live: bytes are read from the device fd in whatever chunk sizes the
+// tty hands back.  When recording, every chunk is appended to a log
+// file along with the get_Time() stamp it was read at.
+//
+// Replay: the chunks come back out of a recording instead of the
+// device, either as fast as the caller consumes them or paced to the
+// original wall clock.  get_Time() is driven by the recorded stamps so
+// the rest of the system sees the same clock it saw in flight and a
+// replay produces the same results every time.  At the end of the
+// recording read() returns 0 (as at eof) and serial_replay_finished()
+// tells the main loop to shut down.
+//
+// Log format: an 8 byte "AURAREC1" file header followed by records of
+// [double timestamp][uint16_t length][length bytes], little endian.
+
+#include <stdint.h>             // uint8_t, et. al.
+#include <stdio.h>              // FILE
+
+class SerialInput {
+
+private:
+
+    int fd = -1;
+
+    uint8_t buf[1024];
+    int buf_len = 0;
+    int buf_pos = 0;
+
+    FILE *record_fp = NULL;
+
+    FILE *replay_fp = NULL;
+    bool replay_realtime = false;
+    double replay_start = 0.0;  // first record stamp
+    double replay_wall = 0.0;   // wall clock when the replay started
+    bool replay_eof = false;
+
+    int fill();
+
+public:
+
+    SerialInput();
+    ~SerialInput();
+
+    void attach( int fd );
+    bool record( const char *file_name );
+    bool replay( const char *file_name, bool realtime );
+
+    bool replaying() { return replay_fp != NULL; }
+    bool eof() { return replay_eof; }
+
+    // same return convention as read(fd, c, 1)
+    inline int read( uint8_t *c ) {
+        if ( buf_pos >= buf_len && fill() <= 0 ) {
+            return 0;
+        }
+        *c = buf[buf_pos++];
+        return 1;
+    }
+
+    int bytes_available();
+    void close();
+};
+
+// a replay has reached the end of its recording
+bool serial_replay_finished();
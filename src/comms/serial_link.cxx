@@ -4,7 +4,6 @@
 #include <termios.h>		// tcgetattr() et. al.
 #include <unistd.h>		// tcgetattr() et. al.
 #include <string.h>		// memset(), strerror()
-#include <sys/ioctl.h>          // FIONREAD
 
 #include "serial_link.hxx"
 
@@ -83,9 +82,21 @@ bool SerialLink::open( int baud, const char *device_name ) {
 	return false;
     }
 
+    reader.attach( fd );
+
     return true;
 }
 
+// log everything read from the device (see serial_input.hxx)
+bool SerialLink::record( const char *file_name ) {
+    return reader.record( file_name );
+}
+
+// read from a recording in place of a device, writes are discarded
+bool SerialLink::open_replay( const char *file_name, bool realtime ) {
+    return reader.replay( file_name, realtime );
+}
+
 bool SerialLink::update() {
     int len;
     uint8_t input[2];
@@ -99,11 +110,11 @@ bool SerialLink::update() {
 
     if ( state == 0 ) {
         counter = 0;
-        len = read( fd, input, 1 );
+        len = reader.read( input );
         giveup_counter = 0;
         while ( len > 0 && input[0] != START_OF_MSG0 && giveup_counter < 100 ) {
             // printf("state0: len = %d val = %2X (%c)\n", len, input[0] , input[0]);
-            len = read( fd, input, 1 );
+            len = reader.read( input );
             giveup_counter++;
             // fprintf( stderr, "giveup_counter = %d\n", giveup_counter);
         }
@@ -113,7 +124,7 @@ bool SerialLink::update() {
         }
     }
     if ( state == 1 ) {
-        len = read( fd, input, 1 );
+        len = reader.read( input );
         if ( len > 0 ) {
             if ( input[0] == START_OF_MSG1 ) {
                 //fprintf( stderr, "read START_OF_MSG1\n");
@@ -127,7 +138,7 @@ bool SerialLink::update() {
         }
     }
     if ( state == 2 ) {
-        len = read( fd, input, 1 );
+        len = reader.read( input );
         if ( len > 0 ) {
             pkt_id = input[0];
             //fprintf( stderr, "pkt_id = %d\n", pkt_id );
@@ -135,7 +146,7 @@ bool SerialLink::update() {
         }
     }
     if ( state == 3 ) {
-        len = read( fd, input, 1 );
+        len = reader.read( input );
         if ( len > 0 ) {
             pkt_len = input[0];
             if ( pkt_len < 256 ) {
@@ -148,14 +159,14 @@ bool SerialLink::update() {
         }
     }
     if ( state == 4 ) {
-        len = read( fd, input, 1 );
+        len = reader.read( input );
         while ( len > 0 ) {
             payload[counter++] = input[0];
             // fprintf( stderr, "%02X ", input[0] );
             if ( counter >= pkt_len ) {
                 break;
             }
-            len = read( fd, input, 1 );
+            len = reader.read( input );
         }
 
         if ( counter >= pkt_len ) {
@@ -164,14 +175,14 @@ bool SerialLink::update() {
         }
     }
     if ( state == 5 ) {
-        len = read( fd, input, 1 );
+        len = reader.read( input );
         if ( len > 0 ) {
             cksum_lo = input[0];
             state++;
         }
     }
     if ( state == 6 ) {
-        len = read( fd, input, 1 );
+        len = reader.read( input );
         if ( len > 0 ) {
             cksum_hi = input[0];
             uint8_t cksum0, cksum1;
@@ -196,14 +207,16 @@ bool SerialLink::update() {
 }
 
 int SerialLink::bytes_available() {
-    int avail = 0;
-    ioctl(fd, FIONREAD, &avail);
-    return avail;
+    return reader.bytes_available();
 }
 
 bool SerialLink::write_packet(uint8_t packet_id, uint8_t *payload, uint8_t len) {
     uint8_t buf[2];
     uint8_t cksum0, cksum1;
+
+    if ( reader.replaying() ) {
+        return true;
+    }
     
     // start of message sync (2) bytes
     buf[0] = START_OF_MSG0;
@@ -235,7 +248,13 @@ bool SerialLink::write_packet(uint8_t packet_id, uint8_t *payload, uint8_t len)
 }
 
 bool SerialLink::close() {
+    reader.close();
+    if ( fd < 0 ) {
+        // replay, or already closed
+        return true;
+    }
     int result = ::close(fd);
+    fd = -1;
     if ( result < 0 ) {
         fprintf( stderr, "unable to close serial: %s\n", strerror(errno) );
 	return false;
@@ -2,12 +2,15 @@
 
 #include <stdint.h>             // uint8_t, et. al.
 
+#include "serial_input.hxx"
+
 class SerialLink {
 
 private:
 
     // port
     int fd = -1;
+    SerialInput reader;
 
     // parser
     int state = 0;
@@ -19,7 +22,6 @@ private:
     static const uint8_t START_OF_MSG1 = 224;
 
     int encode_baud( int baud );
-    void checksum( uint8_t hdr1, uint8_t hdr2, uint8_t *buf, uint8_t size, uint8_t *cksum0, uint8_t *cksum1 );
 
 public:
 
@@ -32,9 +34,14 @@ public:
     SerialLink();
     ~SerialLink();
 
+    static void checksum( uint8_t hdr1, uint8_t hdr2, uint8_t *buf, uint8_t size, uint8_t *cksum0, uint8_t *cksum1 );
+
     bool open( int baud, const char *device_name );
+    bool record( const char *file_name );
+    bool open_replay( const char *file_name, bool realtime );
     bool update();
     int bytes_available();
+    bool at_end() { return reader.eof(); } // replay ran out
     bool write_packet(uint8_t packet_id, uint8_t *payload, uint8_t len);
     bool close();
 };
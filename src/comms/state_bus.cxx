@@ -0,0 +1,120 @@
+// state_bus.cxx - vehicle state in POSIX shared memory
+
+#include <pyprops.hxx>
+
+#include <fcntl.h>
+#include <stddef.h>		// offsetof()
+#include <stdio.h>
+#include <string.h>		// strerror()
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <new>
+#include <string>
+using std::string;
+
+#include "state_bus.hxx"
+
+static_assert( offsetof(state_bus_segment_t, state) == 16,
+	       "state bus layout changed, update the readers" );
+
+state_bus_state_t state_bus;
+
+static state_bus_segment_t *segment = NULL;
+static string shm_name = "/aura_state";
+
+// property nodes
+static pyPropertyNode imu_node;
+static pyPropertyNode gps_node;
+static pyPropertyNode vel_node;
+static pyPropertyNode ap_node;
+static pyPropertyNode route_node;
+static pyPropertyNode status_node;
+
+bool state_bus_init() {
+    imu_node = pyGetNode("/sensors/imu", true);
+    gps_node = pyGetNode("/sensors/gps", true);
+    vel_node = pyGetNode("/velocity", true);
+    ap_node = pyGetNode("/autopilot", true);
+    route_node = pyGetNode("/task/route", true);
+    status_node = pyGetNode("/status", true);
+    memset( &state_bus, 0, sizeof(state_bus) );
+
+    pyPropertyNode config = pyGetNode("/config/state_bus", true);
+    if ( !config.getBool("enable") ) {
+	return true;
+    }
+    if ( config.hasChild("name") ) {
+	shm_name = config.getString("name");
+    }
+
+    int fd = shm_open( shm_name.c_str(), O_CREAT | O_RDWR, 0644 );
+    if ( fd < 0 ) {
+	printf("state bus: shm_open(%s) failed - %s\n", shm_name.c_str(),
+	       strerror(errno));
+	return false;
+    }
+    if ( ftruncate( fd, sizeof(state_bus_segment_t) ) < 0 ) {
+	printf("state bus: ftruncate failed - %s\n", strerror(errno));
+	close( fd );
+	return false;
+    }
+    void *p = mmap( NULL, sizeof(state_bus_segment_t),
+		    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+    if ( p == MAP_FAILED ) {
+	printf("state bus: mmap failed - %s\n", strerror(errno));
+	return false;
+    }
+    segment = (state_bus_segment_t *)p;
+
+    // readers that stayed mapped across a restart see an invalid
+    // magic until the header is filled in again
+    segment->magic = 0;
+    std::atomic_thread_fence( std::memory_order_release );
+    new ( &segment->state ) SeqLock<state_bus_state_t>();
+    segment->version = STATE_BUS_VERSION;
+    segment->size = sizeof(state_bus_state_t);
+    std::atomic_thread_fence( std::memory_order_release );
+    segment->magic = STATE_BUS_MAGIC;
+
+    printf("state bus: publishing to shm %s (version %d, %d bytes)\n",
+	   shm_name.c_str(), STATE_BUS_VERSION,
+	   (int)sizeof(state_bus_segment_t));
+    return true;
+}
+
+void state_bus_update() {
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    state_bus.monotonic_sec = ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+    clock_gettime( CLOCK_REALTIME, &ts );
+    state_bus.unix_sec = ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+    state_bus.frame++;
+    state_bus.imu_timestamp = imu_node.getDouble("timestamp");
+    state_bus.gps_unix_sec = gps_node.getDouble("unix_time_sec");
+    state_bus.airspeed_kt = vel_node.getDouble("airspeed_smoothed_kt");
+    // after the main loop's gps timeout check
+    state_bus.nav_valid = status_node.getString("navigation") == "valid";
+    state_bus.ap_flags = 0;
+    if ( ap_node.getBool("master_switch") ) {
+	state_bus.ap_flags |= (1 << 0);
+    }
+    if ( ap_node.getBool("pilot_pass_through") ) {
+	state_bus.ap_flags |= (1 << 1);
+    }
+    state_bus.target_waypoint_idx = route_node.getLong("target_waypoint_idx");
+
+    if ( segment != NULL ) {
+	segment->state.write( state_bus );
+    }
+}
+
+void state_bus_close() {
+    if ( segment != NULL ) {
+	munmap( segment, sizeof(state_bus_segment_t) );
+	segment = NULL;
+    }
+}
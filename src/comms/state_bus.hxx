@@ -0,0 +1,96 @@
+// state_bus.hxx - vehicle state in POSIX shared memory
+//
+// Once per frame the flight thread writes a fixed layout snapshot of
+// the vehicle state (attitude, position, velocity, time stamps and
+// autopilot mode) into a shared memory segment guarded by a sequence
+// lock.  Co-processes on the same board (camera trigger, geotagging,
+// payload computer, planner) map the segment read only and copy the
+// snapshot out with SeqLock::read(): no syscalls, no locks, and the
+// writer never waits on a reader.
+//
+// The layout is versioned.  Readers check magic and version (and may
+// use size to accept a longer struct from a newer writer) before
+// trusting anything else.  Fields are only ever appended, a change
+// to an existing field bumps the version.  The segment is left in
+// place when aura exits so readers can stay mapped across a restart;
+// a stale writer shows up as monotonic_sec no longer advancing.
+//
+// Byte layout for readers that don't use this header
+// (comms/state_bus.py):
+//
+//   0  uint32 magic    'AURS'
+//   4  uint32 version
+//   8  uint32 size     of state_bus_state_t
+//  12  uint32 (pad)
+//  16  uint32 seq      odd while a write is in progress
+//  24  state_bus_state_t
+//
+// Configured under /config/state_bus:
+//
+//   enable : create and write the segment (default off)
+//   name   : shm_open() name (default "/aura_state")
+
+#pragma once
+
+#include <stdint.h>
+
+#include "util/seqlock.hxx"
+
+#define STATE_BUS_MAGIC 0x53525541 // "AURS" little endian
+#define STATE_BUS_VERSION 1
+
+// version 1
+struct state_bus_state_t {
+    uint64_t frame;		// main loop frame counter
+    double monotonic_sec;	// CLOCK_MONOTONIC at write (same clock
+				// in every process on the board)
+    double unix_sec;		// CLOCK_REALTIME at write
+    double imu_timestamp;	// sensor time of the frame
+    double filter_timestamp;	// sensor time of the nav solution
+    double gps_unix_sec;	// time of the last gps fix
+
+    double latitude_deg;
+    double longitude_deg;
+    float altitude_m;		// msl
+    float altitude_agl_m;
+    float altitude_ground_m;
+
+    float vn_ms;
+    float ve_ms;
+    float vd_ms;
+    float groundspeed_ms;
+    float groundtrack_deg;
+    float airspeed_kt;
+
+    float roll_deg;
+    float pitch_deg;
+    float heading_deg;
+    float phi_dot_rad_sec;
+    float the_dot_rad_sec;
+    float psi_dot_rad_sec;
+
+    uint32_t nav_valid;		// 1 if the nav solution is valid
+    uint32_t ap_flags;		// bit 0: master switch (autopilot),
+				// bit 1: pilot pass through
+    int32_t target_waypoint_idx;
+};
+
+struct state_bus_segment_t {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t pad;
+    SeqLock<state_bus_state_t> state;
+};
+
+// the in process copy of the current frame's state.  filter_mgr
+// fills the nav solution into it (and republishes the property tree
+// from it), state_bus_update() adds the rest and publishes it.
+extern state_bus_state_t state_bus;
+
+bool state_bus_init();
+
+// flight thread, once per frame after the autopilot has run
+void state_bus_update();
+
+void state_bus_close();
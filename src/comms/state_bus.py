@@ -0,0 +1,72 @@
+# state_bus.py - read the vehicle state aura publishes in shared memory
+#
+# For co-processes on the flight computer (camera trigger, geotagging,
+# payload, planner).  The layout is described in state_bus.hxx.
+#
+#   bus = StateBus()
+#   state = bus.read()      # dict, or None if aura isn't publishing
+
+import mmap
+import os
+import struct
+
+MAGIC = 0x53525541
+VERSION = 1
+
+header_fmt = '<IIII'
+seq_fmt = '<I'
+seq_offset = 16
+state_offset = 24
+
+# version 1 fields, in order
+state_fmt = '<Q7d15fIIi'
+state_fields = [
+    'frame', 'monotonic_sec', 'unix_sec', 'imu_timestamp',
+    'filter_timestamp', 'gps_unix_sec', 'latitude_deg', 'longitude_deg',
+    'altitude_m', 'altitude_agl_m', 'altitude_ground_m',
+    'vn_ms', 've_ms', 'vd_ms', 'groundspeed_ms', 'groundtrack_deg',
+    'airspeed_kt',
+    'roll_deg', 'pitch_deg', 'heading_deg',
+    'phi_dot_rad_sec', 'the_dot_rad_sec', 'psi_dot_rad_sec',
+    'nav_valid', 'ap_flags', 'target_waypoint_idx'
+]
+state_size = struct.calcsize(state_fmt)
+
+class StateBus():
+    def __init__(self, name='/aura_state'):
+        self.name = name
+        self.shm = None
+
+    def open(self):
+        path = '/dev/shm/' + self.name.lstrip('/')
+        try:
+            fd = os.open(path, os.O_RDONLY)
+        except OSError:
+            return False
+        try:
+            size = os.fstat(fd).st_size
+            if size < state_offset + state_size:
+                return False
+            self.shm = mmap.mmap(fd, size, mmap.MAP_SHARED, mmap.PROT_READ)
+        finally:
+            os.close(fd)
+        return True
+
+    # returns the latest state as a dict (None if there is no
+    # compatible writer)
+    def read(self, retries=100):
+        if self.shm is None and not self.open():
+            return None
+        (magic, version, size, pad) = struct.unpack_from(header_fmt,
+                                                         self.shm, 0)
+        if magic != MAGIC or version != VERSION or size < state_size:
+            return None
+        for i in range(retries):
+            (s0,) = struct.unpack_from(seq_fmt, self.shm, seq_offset)
+            values = struct.unpack_from(state_fmt, self.shm, state_offset)
+            (s1,) = struct.unpack_from(seq_fmt, self.shm, seq_offset)
+            if s0 % 2 == 0 and s0 == s1:
+                if s0 == 0:
+                    return None     # nothing published yet
+                return dict(zip(state_fields, values))
+        return None
@@ -8,6 +8,8 @@ import re
 
 from props import getNode
 
+import comms.params
+
 #import commands
 
 class ChatHandler(asynchat.async_chat):
@@ -160,42 +162,12 @@ class ChatHandler(asynchat.async_chat):
                     tmppath = '/'.join(tmp[0:-1])
                     if tmppath == '':
                         tmppath = '/'
-                    node = getNode(tmppath, True)
                     name = tmp[-1]
                 else:
-                    node = getNode(self.path, True)
+                    tmppath = self.path
                     name = tokens[1]
                 value = ' '.join(tokens[2:])
-
-                done = False
-                # test for int
-                if not done:
-                    result = re.match('[-+]?\d+', value)
-                    if result and result.group(0) == value:
-                        print('int:', value)
-                        node.setInt(name, int(value))
-                        done = True
-                # test for float
-                if not done:
-                    result = re.match('[-+]?\d*\.\d+', value)
-                    if result and result.group(0) == value:
-                        print('float:', value)
-                        node.setFloat(name, float(value))
-                        done = True
-                # test for bool
-                if not done:
-                    if value == 'True' or value == 'true':
-                        print('bool:', True)
-                        node.setBool(name, True)
-                        done = True
-                if not done:
-                    if value == 'False' or value == 'false':
-                        print('bool:', False)
-                        node.setBool(name, False)
-                        done = True
-                # fall back to string
-                if not done:
-                    node.setString(name, value)
+                node = comms.params.set_value(tmppath, name, value)
 
                 if self.prompt:
                     # now fetch and write out the new value as confirmation
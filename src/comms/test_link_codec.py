@@ -0,0 +1,147 @@
+#!/usr/bin/python3
+
+# Round trip the remote link message codec through a lossy channel:
+#
+#   cd src
+#   python3 -m unittest comms.test_link_codec
+
+import math
+import unittest
+
+from comms import aura_messages
+from comms import link_codec
+
+def make_imu(i, index=0):
+    msg = aura_messages.imu_v4()
+    msg.index = index
+    msg.timestamp_sec = 10.0 + i * 0.01
+    msg.p_rad_sec = 0.1 * math.sin(i / 10.0)
+    msg.q_rad_sec = -0.05
+    msg.r_rad_sec = 0.02 * math.cos(i / 7.0)
+    msg.ax_mps_sec = 0.3
+    msg.ay_mps_sec = -0.1
+    msg.az_mps_sec = -9.81 + 0.01 * (i % 5)
+    msg.hx = 0.4
+    msg.hy = 0.1
+    msg.hz = 0.9
+    msg.temp_C = 31.5
+    msg.status = 0
+    return msg.pack()
+
+# the values a delta rebuilds: each field on its quantization grid
+def quantized(payload):
+    msg = aura_messages.imu_v4()
+    msg.index = payload[0]
+    (msg_class, spec) = link_codec.fields[aura_messages.imu_v4_id]
+    values = link_codec.quantize(aura_messages.imu_v4_id, payload)
+    for (name, scale), v in zip(spec, values):
+        setattr(msg, name, v if scale == 1 else v / scale)
+    return msg.pack()
+
+class LinkCodecTest(unittest.TestCase):
+    def setUp(self):
+        self.enc = link_codec.encoder(keyframe_interval=4)
+        self.dec = link_codec.decoder()
+
+    def send(self, payload, msg_id=aura_messages.imu_v4_id, drop=False):
+        pkt_id, buf = self.enc.encode(msg_id, payload)
+        if drop:
+            return pkt_id, None
+        return pkt_id, self.dec.decode(pkt_id, bytes(buf))
+
+    def test_round_trip(self):
+        for i in range(40):
+            payload = make_imu(i)
+            pkt_id, (msg_id, plain) = self.send(payload)
+            self.assertEqual(msg_id, aura_messages.imu_v4_id)
+            if pkt_id == link_codec.keyframe_id:
+                # keyframes carry the plain message
+                self.assertEqual(plain, payload)
+            else:
+                self.assertEqual(pkt_id,
+                                 link_codec.delta_ids[aura_messages.imu_v4_id])
+                self.assertEqual(plain, quantized(payload))
+        self.assertEqual(self.dec.dropped, 0)
+
+    def test_lost_keyframe(self):
+        # first keyframe and its deltas get through
+        for i in range(5):
+            self.send(make_imu(i))
+        # the next keyframe is lost on the air: its deltas are dropped
+        # (the receiver still holds the previous reference) until the
+        # keyframe after it
+        pkt_id, result = self.send(make_imu(5), drop=True)
+        self.assertEqual(pkt_id, link_codec.keyframe_id)
+        for i in range(6, 10):
+            pkt_id, (msg_id, plain) = self.send(make_imu(i))
+            self.assertNotEqual(pkt_id, link_codec.keyframe_id)
+            self.assertEqual(msg_id, -1)
+        self.assertEqual(self.dec.dropped, 4)
+        pkt_id, (msg_id, plain) = self.send(make_imu(10))
+        self.assertEqual(pkt_id, link_codec.keyframe_id)
+        self.assertEqual(plain, make_imu(10))
+        pkt_id, (msg_id, plain) = self.send(make_imu(11))
+        self.assertEqual(plain, quantized(make_imu(11)))
+
+    def test_key_seq_wrap(self):
+        # run the 8 bit keyframe sequence (4 bits on deltas) around
+        # more than once
+        seqs = []
+        for i in range(5 * 300):
+            pkt_id, (msg_id, plain) = self.send(make_imu(i))
+            self.assertNotEqual(msg_id, -1)
+            if pkt_id == link_codec.keyframe_id:
+                seqs.append(self.enc.streams[(msg_id, 0)][0])
+        self.assertEqual(seqs[:3], [0, 1, 2])
+        self.assertIn(255, seqs)
+        self.assertEqual(seqs[seqs.index(255) + 1], 0)
+        self.assertEqual(self.dec.dropped, 0)
+
+    def test_stale_key_seq(self):
+        # a delta whose 4 bit key_seq doesn't match is dropped
+        for i in range(4):
+            self.send(make_imu(i))
+        pkt_id, buf = self.enc.encode(aura_messages.imu_v4_id, make_imu(4))
+        self.assertNotEqual(pkt_id, link_codec.keyframe_id)
+        buf[0] = (buf[0] & 0xf0) | ((buf[0] + 1) & 0xf)
+        self.assertEqual(self.dec.decode(pkt_id, bytes(buf)), (-1, None))
+
+    def test_high_index_passthrough(self):
+        payload = make_imu(0, index=16)
+        for i in range(3):
+            pkt_id, (msg_id, plain) = self.send(payload)
+            self.assertEqual(pkt_id, aura_messages.imu_v4_id)
+            self.assertEqual(plain, payload)
+        # indices are separate streams below 16
+        pkt_id, result = self.send(make_imu(0, index=15))
+        self.assertEqual(pkt_id, link_codec.keyframe_id)
+        self.assertEqual(result[1], make_imu(0, index=15))
+
+    def test_uncoded_passthrough(self):
+        payload = bytes(range(10))
+        self.assertEqual(self.send(payload, msg_id=aura_messages.gps_v4_id),
+                         (aura_messages.gps_v4_id,
+                          (aura_messages.gps_v4_id, payload)))
+
+    def test_lost_after_overflow(self):
+        for i in range(5):
+            self.send(make_imu(i))
+        # the serial buffer was full: the keyframe never left, so the
+        # next message has to be a keyframe again
+        pkt_id, buf = self.enc.encode(aura_messages.imu_v4_id, make_imu(5))
+        self.assertEqual(pkt_id, link_codec.keyframe_id)
+        self.enc.lost(pkt_id, buf)
+        pkt_id, (msg_id, plain) = self.send(make_imu(6))
+        self.assertEqual(pkt_id, link_codec.keyframe_id)
+        self.assertEqual(plain, make_imu(6))
+        # a lost delta costs only itself
+        pkt_id, buf = self.enc.encode(aura_messages.imu_v4_id, make_imu(7))
+        self.assertNotEqual(pkt_id, link_codec.keyframe_id)
+        self.enc.lost(pkt_id, buf)
+        pkt_id, (msg_id, plain) = self.send(make_imu(8))
+        self.assertNotEqual(pkt_id, link_codec.keyframe_id)
+        self.assertEqual(plain, quantized(make_imu(8)))
+        self.assertEqual(self.dec.dropped, 0)
+
+if __name__ == '__main__':
+    unittest.main()
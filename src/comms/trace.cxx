@@ -0,0 +1,327 @@
+// trace.cxx - lock-free event/trace rings
+
+#include <pyprops.hxx>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>	// SYS_gettid
+#include <unistd.h>		// usleep()
+
+#include <atomic>
+#include <string>
+using std::string;
+
+#include "init/globals.hxx"
+#include "init/runtime.hxx"
+#include "util/timing.h"
+
+#include "trace.hxx"
+
+static const int max_events = 256;
+static const int max_threads = 8;
+static const int ring_size = 2048;	// records, power of 2
+static const int outbox_size = 64;	// messages, power of 2
+static const int message_len = 128;
+static const int drain_usec = 50000;
+
+struct trace_record_t {
+    double time;
+    double args[3];
+    uint16_t id;
+    uint8_t type;
+};
+
+struct trace_ring_t {
+    std::atomic<uint32_t> head;	// next write, owned by the thread
+    std::atomic<uint32_t> tail;	// next read, owned by the drain
+    std::atomic<uint32_t> dropped;
+    std::atomic<bool> ready;	// tid is filled in
+    long tid;
+    std::atomic<const char *> name;
+    trace_record_t records[ring_size];
+};
+
+struct trace_def_t {
+    const char *category;
+    const char *name;
+    const char *format;
+};
+
+struct trace_message_t {
+    int id;
+    char text[message_len];
+};
+
+bool trace_on = false;
+
+static trace_def_t defs[max_events];
+static std::atomic<int> event_count(0);
+
+static trace_ring_t rings[max_threads];
+static std::atomic<int> ring_count(0);	// claimed, may exceed max_threads
+static thread_local trace_ring_t *my_ring = NULL;
+static thread_local bool my_ring_denied = false;	// all rings taken
+
+// formatted messages, drain thread -> flight thread
+static trace_message_t outbox[outbox_size];
+static std::atomic<uint32_t> outbox_head(0);
+static std::atomic<uint32_t> outbox_tail(0);
+
+static FILE *fexport = NULL;
+static bool first_export = true;
+static pthread_t drain_thread;
+static bool drain_running = false;
+static std::atomic<bool> drain_stop(false);
+
+static pyPropertyNode trace_node;
+static uint32_t last_dropped = 0;
+
+int trace_register( const char *category, const char *name,
+                    const char *format )
+{
+    int id = event_count.load( std::memory_order_relaxed );
+    if ( id >= max_events ) {
+	printf("trace: too many events, %s/%s not registered\n",
+	       category, name);
+	return -1;
+    }
+    defs[id].category = category;
+    defs[id].name = name;
+    defs[id].format = format;
+    event_count.store( id + 1, std::memory_order_release );
+    return id;
+}
+
+// rings are claimed in count order but may be filled in out of
+// order, the drain skips any that aren't published as ready yet
+static trace_ring_t *claim_ring() {
+    int n = ring_count.fetch_add( 1 );
+    if ( n >= max_threads ) {
+	return NULL;
+    }
+    trace_ring_t *ring = &rings[n];
+    ring->tid = syscall( SYS_gettid );
+    ring->ready.store( true, std::memory_order_release );
+    return ring;
+}
+
+static trace_ring_t *get_my_ring() {
+    if ( my_ring == NULL && !my_ring_denied ) {
+	my_ring = claim_ring();
+	my_ring_denied = (my_ring == NULL);
+    }
+    return my_ring;
+}
+
+static int claimed_rings() {
+    int threads = ring_count.load( std::memory_order_acquire );
+    return threads < max_threads ? threads : max_threads;
+}
+
+void trace_thread_name( const char *name ) {
+    trace_ring_t *ring = get_my_ring();
+    if ( ring != NULL ) {
+	ring->name.store( name, std::memory_order_release );
+    }
+}
+
+void trace_record( int id, trace_type_t type, double a0, double a1,
+                   double a2 )
+{
+    if ( id < 0 || (!trace_on && defs[id].format == NULL) ) {
+	return;
+    }
+    if ( get_my_ring() == NULL ) {
+	return;
+    }
+    uint32_t head = my_ring->head.load( std::memory_order_relaxed );
+    uint32_t tail = my_ring->tail.load( std::memory_order_acquire );
+    if ( head - tail >= (uint32_t)ring_size ) {
+	my_ring->dropped.fetch_add( 1, std::memory_order_relaxed );
+	return;
+    }
+    trace_record_t *r = &my_ring->records[head & (ring_size - 1)];
+    r->time = get_HostTime();	// real durations, even on a virtual clock
+    r->args[0] = a0;
+    r->args[1] = a1;
+    r->args[2] = a2;
+    r->id = id;
+    r->type = type;
+    my_ring->head.store( head + 1, std::memory_order_release );
+}
+
+// write s as a quoted json string
+static void export_string( const char *s ) {
+    fputc( '"', fexport );
+    for ( ; *s != 0; s++ ) {
+	unsigned char c = *s;
+	if ( c == '"' || c == '\\' ) {
+	    fputc( '\\', fexport );
+	    fputc( c, fexport );
+	} else if ( c < 0x20 ) {
+	    fprintf( fexport, "\\u%04x", c );
+	} else {
+	    fputc( c, fexport );
+	}
+    }
+    fputc( '"', fexport );
+}
+
+static void export_record( const trace_ring_t *ring, const trace_record_t *r ) {
+    static const char phase[] = { 'B', 'E', 'i', 'C' };
+    const trace_def_t *def = &defs[r->id];
+    fprintf( fexport, "%s{\"name\":", first_export ? "" : ",\n" );
+    export_string( def->name );
+    fprintf( fexport, ",\"cat\":" );
+    export_string( def->category );
+    fprintf( fexport, ",\"ph\":\"%c\",\"ts\":%.1f,\"pid\":1,\"tid\":%ld",
+	     phase[r->type], r->time * 1000000.0, ring->tid );
+    first_export = false;
+    if ( r->type == TRACE_COUNTER ) {
+	fprintf( fexport, ",\"args\":{\"value\":%g}", r->args[0] );
+    } else if ( r->type == TRACE_INSTANT ) {
+	fprintf( fexport, ",\"s\":\"t\",\"args\":{\"a0\":%g,\"a1\":%g,\"a2\":%g}",
+		 r->args[0], r->args[1], r->args[2] );
+    }
+    fprintf( fexport, "}" );
+}
+
+static void export_thread_name( const trace_ring_t *ring, const char *name ) {
+    fprintf( fexport, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+	     "\"tid\":%ld,\"args\":{\"name\":",
+	     first_export ? "" : ",\n", ring->tid );
+    export_string( name );
+    fprintf( fexport, "}}" );
+    first_export = false;
+}
+
+static void post_message( const trace_record_t *r ) {
+    uint32_t head = outbox_head.load( std::memory_order_relaxed );
+    uint32_t tail = outbox_tail.load( std::memory_order_acquire );
+    if ( head - tail >= (uint32_t)outbox_size ) {
+	return;			// flight thread isn't keeping up
+    }
+    trace_message_t *m = &outbox[head & (outbox_size - 1)];
+    m->id = r->id;
+    snprintf( m->text, message_len, defs[r->id].format,
+	      r->args[0], r->args[1], r->args[2] );
+    outbox_head.store( head + 1, std::memory_order_release );
+}
+
+static void drain() {
+    static bool named[max_threads];
+    int threads = claimed_rings();
+    for ( int i = 0; i < threads; i++ ) {
+	trace_ring_t *ring = &rings[i];
+	if ( !ring->ready.load( std::memory_order_acquire ) ) {
+	    continue;
+	}
+	const char *name = ring->name.load( std::memory_order_acquire );
+	if ( fexport != NULL && !named[i] && name != NULL ) {
+	    export_thread_name( ring, name );
+	    named[i] = true;
+	}
+	uint32_t tail = ring->tail.load( std::memory_order_relaxed );
+	uint32_t head = ring->head.load( std::memory_order_acquire );
+	while ( tail != head ) {
+	    const trace_record_t *r = &ring->records[tail & (ring_size - 1)];
+	    if ( fexport != NULL ) {
+		export_record( ring, r );
+	    }
+	    if ( r->type == TRACE_INSTANT && defs[r->id].format != NULL ) {
+		post_message( r );
+	    }
+	    tail++;
+	}
+	ring->tail.store( tail, std::memory_order_release );
+    }
+    if ( fexport != NULL ) {
+	fflush( fexport );
+    }
+}
+
+static void *drain_main( void *arg ) {
+    runtime_helper_thread_init( "trace" );
+    while ( !drain_stop.load() ) {
+	usleep( drain_usec );
+	drain();
+    }
+    drain();
+    return NULL;
+}
+
+bool trace_init() {
+    trace_node = pyGetNode("/status/trace", true);
+
+    pyPropertyNode config = pyGetNode("/config/trace", true);
+    if ( !config.getBool("enable") ) {
+	return true;
+    }
+    string file = "trace.json";
+    if ( config.hasChild("file") ) {
+	file = config.getString("file");
+    } else {
+	pyPropertyNode logging_node = pyGetNode("/config/logging", true);
+	string flight_dir = logging_node.getString("flight_dir");
+	if ( flight_dir != "" ) {
+	    file = flight_dir + "/trace.json";
+	}
+    }
+    fexport = fopen( file.c_str(), "w" );
+    if ( fexport == NULL ) {
+	printf("trace: unable to open %s\n", file.c_str());
+	return false;
+    }
+    // json array format, the closing bracket is optional so a trace
+    // cut short by a power off still loads.
+    fprintf( fexport, "[\n" );
+    printf("trace: recording to %s\n", file.c_str());
+    trace_on = true;
+    return true;
+}
+
+bool trace_start() {
+    int result = pthread_create( &drain_thread, NULL, drain_main, NULL );
+    if ( result != 0 ) {
+	printf("trace: unable to start drain thread - %s\n", strerror(result));
+	return false;
+    }
+    drain_running = true;
+    return true;
+}
+
+void trace_update() {
+    uint32_t tail = outbox_tail.load( std::memory_order_relaxed );
+    uint32_t head = outbox_head.load( std::memory_order_acquire );
+    while ( tail != head ) {
+	trace_message_t *m = &outbox[tail & (outbox_size - 1)];
+	events->log( defs[m->id].category, m->text );
+	tail++;
+    }
+    outbox_tail.store( tail, std::memory_order_release );
+
+    uint32_t dropped = 0;
+    int threads = claimed_rings();
+    for ( int i = 0; i < threads; i++ ) {
+	dropped += rings[i].dropped.load( std::memory_order_relaxed );
+    }
+    if ( dropped != last_dropped ) {
+	last_dropped = dropped;
+	trace_node.setLong( "dropped", dropped );
+    }
+}
+
+void trace_close() {
+    if ( drain_running ) {
+	drain_stop.store( true );
+	pthread_join( drain_thread, NULL );
+	drain_running = false;
+    }
+    trace_on = false;
+    if ( fexport != NULL ) {
+	fprintf( fexport, "\n]\n" );
+	fclose( fexport );
+	fexport = NULL;
+    }
+}
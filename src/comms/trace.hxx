@@ -0,0 +1,66 @@
+// trace.hxx - lock-free event/trace rings
+//
+// Each thread that records gets its own single producer ring of
+// fixed size binary records (time stamp, event id, up to three
+// numeric args.)  Recording never formats, allocates or blocks, a
+// full ring just counts the drop.  A background thread drains the
+// rings, writes a Chrome trace (chrome://tracing, ui.perfetto.dev)
+// when tracing is enabled, and formats the events registered with a
+// message format for the event log (forwarded on the flight thread
+// by trace_update().)
+
+#pragma once
+
+#include <stdint.h>
+
+enum trace_type_t {
+    TRACE_BEGIN = 0,
+    TRACE_END = 1,
+    TRACE_INSTANT = 2,
+    TRACE_COUNTER = 3
+};
+
+// Register an event, returns its id (-1 when the event table is
+// full, recording with it does nothing.)  If format is given the event
+// is also an event log message: format is printf style and consumes
+// the event args as doubles (i.e. "%.0f".)  Message events are
+// recorded even when tracing is off.  Registration is cheap and
+// safe from static initializers, but not from more than one thread
+// at a time.
+int trace_register( const char *category, const char *name,
+                    const char *format = NULL );
+
+// name the calling thread in the exported trace
+void trace_thread_name( const char *name );
+
+void trace_record( int id, trace_type_t type, double a0, double a1,
+                   double a2 );
+
+extern bool trace_on;
+
+inline void trace_begin( int id ) {
+    if ( trace_on ) trace_record( id, TRACE_BEGIN, 0.0, 0.0, 0.0 );
+}
+inline void trace_end( int id ) {
+    if ( trace_on ) trace_record( id, TRACE_END, 0.0, 0.0, 0.0 );
+}
+inline void trace_counter( int id, double value ) {
+    if ( trace_on ) trace_record( id, TRACE_COUNTER, value, 0.0, 0.0 );
+}
+inline void trace_event( int id, double a0 = 0.0, double a1 = 0.0,
+                         double a2 = 0.0 ) {
+    trace_record( id, TRACE_INSTANT, a0, a1, a2 );
+}
+
+// read /config/trace and open the export file
+bool trace_init();
+
+// start the background thread (after runtime_init() so it lands on
+// the helper cpus.)
+bool trace_start();
+
+// flight thread: forward formatted messages to the event log
+void trace_update();
+
+// flush and close the export file
+void trace_close();
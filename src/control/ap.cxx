@@ -47,6 +47,8 @@ void AuraAutopilot::init() {
 	printf("configuration.  See earlier errors for details.\n" );
 	exit(-1);
     }
+    ap_node = pyGetNode( "/autopilot", true );
+    param_version = ap_node.getLong("param_version");
 }
 
 
@@ -134,6 +136,13 @@ inline void SG_NORMALIZE_RANGE( T &val, const T min, const T max ) {
  */
 
 void AuraAutopilot::update( double dt ) {
+    long version = ap_node.getLong("param_version");
+    if ( version != param_version ) {
+	for ( unsigned int i = 0; i < components.size(); ++i ) {
+	    components[i]->load_params();
+	}
+	param_version = version;
+    }
     for ( unsigned int i = 0; i < components.size(); ++i ) {
         components[i]->update( dt );
     }
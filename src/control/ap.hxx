@@ -40,7 +40,7 @@ class AuraAutopilot {
 
 public:
 
-    AuraAutopilot() {}
+    AuraAutopilot(): param_version(0) {}
     ~AuraAutopilot() {}
 
     void init();
@@ -49,6 +49,9 @@ public:
 
     bool build();
 
+    // version of the tuning parameters in use (echoed in ap_status)
+    inline long get_param_version() { return param_version; }
+
 protected:
 
     typedef vector<APComponent *> comp_list;
@@ -57,4 +60,9 @@ private:
 
     bool serviceable;
     comp_list components;
+
+    // tuning updates bump /autopilot/param_version, the components
+    // reload their parameters once per new version
+    pyPropertyNode ap_node;
+    long param_version;
 };
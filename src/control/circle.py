@@ -1,7 +1,7 @@
 import math
 
 from props import getNode
-from auracore import wgs84
+from auracore import routegeo
 
 import comms.events
 
@@ -55,8 +55,8 @@ def update(dt):
 
     # compute course and distance to center of target circle
     # fixme: should reverse this and direction sense to match 'land.py' and make more sense
-    (course_deg, rev_deg, dist_m) = \
-        wgs84.geo_inverse( pos_lat, pos_lon, center_lat, center_lon )
+    (course_deg, dist_m) = \
+        routegeo.course_dist( pos_lat, pos_lon, center_lat, center_lon )
 
     # compute ideal ground course to be on the circle perimeter if at
     # ideal radius
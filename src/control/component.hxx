@@ -23,12 +23,50 @@
 
 #include <pyprops.hxx>
 
+#include <atomic>
 #include <string>
 #include <vector>
 
 using std::vector;
 using std::string;
 
+/**
+ * Double buffered tuning parameters.  The update step reads the
+ * active copy only, a reload fills the other copy and then flips the
+ * active index, so a component never runs with half of an update.
+ * T must be a plain struct.
+ */
+
+template <class T>
+class ParamSnapshot {
+
+private:
+
+    T buf[2];
+    std::atomic<int> active;
+
+public:
+
+    ParamSnapshot(): buf(), active(0) {}
+
+    inline const T &get() const {
+	return buf[active.load(std::memory_order_acquire)];
+    }
+
+    // the inactive copy, starts out as a copy of the active one
+    T &begin_update() {
+	int a = active.load(std::memory_order_relaxed);
+	buf[1 - a] = buf[a];
+	return buf[1 - a];
+    }
+
+    void commit() {
+	int a = active.load(std::memory_order_relaxed);
+	active.store(1 - a, std::memory_order_release);
+    }
+};
+
+
 /**
  * Base class for other autopilot components
  */
@@ -68,6 +106,11 @@ public:
 
     virtual void reset() = 0;
     virtual void update( double dt ) = 0;
+
+    // copy the tuning parameters out of the config tree.  Called once
+    // at build time and again whenever a tuning update arrives (see
+    // AuraAutopilot::update()), update() never reads the config tree.
+    virtual void load_params() {}
     
     inline string get_name() { return component_node.getString("name"); }
 };
@@ -37,6 +37,7 @@ using std::string;
 #include "comms/display.hxx"
 #include "comms/logging.hxx"
 #include "comms/remote_link.hxx"
+#include "comms/trace.hxx"
 #include "include/globaldefs.h"
 #include "init/globals.hxx"
 #include <pymodule.hxx>
@@ -73,6 +74,8 @@ static pyPropertyNode pos_node;
 static int remote_link_skip = 0;
 static int logging_skip = 0;
 
+static int reset_event = trace_register("controls", "reset", "global reset called");
+
 static void bind_properties() {
     status_node = pyGetNode( "/status", true );
     ap_node = pyGetNode( "/autopilot", true );
@@ -119,7 +122,7 @@ void control_init() {
 // component a chance to update it's state to reset for current conditions,
 // eliminate transients, etc.
 void control_reset() {
-    events->log("controls", "global reset called");
+    trace_event( reset_event );
     ap.reset();
 }
 
@@ -197,7 +200,8 @@ void control_update(double dt)
     }
 	
     if ( send_remote_link || send_logging ) {
-        message::ap_status_v7_t ap;
+        long param_version = ap.get_param_version();
+        message::ap_status_v8_t ap;
         ap.index = 0;     // always 0 for now
         ap.timestamp_sec = status_node.getDouble("frame_time");
         // status flags (up to 8 could be supported)
@@ -266,6 +270,7 @@ void control_update(double dt)
         }
         ap.task_attribute = task_attr;
         ap.sequence_num = remote_link_node.getLong("sequence_num");
+        ap.param_version = param_version;
         ap.pack();
 	if ( send_remote_link ) {
 	    remote_link->send_message( ap.id, ap.payload, ap.len );
@@ -78,15 +78,9 @@ AuraDigitalFilter::AuraDigitalFilter( string config_path )
 	    filterType = noiseSpike;
 	}
     }
-    if ( component_node.hasChild("filter_time") ) {
-	Tf = component_node.getDouble("filter_time");
-    }
     if ( component_node.hasChild("samples") ) {
 	samples = component_node.getLong("samples");
     }
-    if ( component_node.hasChild("max_rate_of_change") ) {
-	rateOfChange = component_node.getDouble("max_rate_of_change");
-    }
 
     // output
     node = component_node.getChild( "output", true );
@@ -113,6 +107,22 @@ AuraDigitalFilter::AuraDigitalFilter( string config_path )
 
     output.resize(2, 0.0);
     input.resize(samples + 1, 0.0);
+
+    load_params();
+}
+
+void AuraDigitalFilter::load_params() {
+    dig_filter_params_t &p = params.begin_update();
+    p.Tf = 0.0;
+    if ( component_node.hasChild("filter_time") ) {
+	p.Tf = component_node.getDouble("filter_time");
+    }
+    p.rateOfChange = 0.0;
+    if ( component_node.hasChild("max_rate_of_change") ) {
+	p.rateOfChange = component_node.getDouble("max_rate_of_change");
+    }
+    p.debug = component_node.getBool("debug");
+    params.commit();
 }
 
 void AuraDigitalFilter::reset() {
@@ -132,6 +142,9 @@ void AuraDigitalFilter::update(double dt)
     input.push_front( input_node.getDouble(input_attr.c_str()) );
     input.resize(samples + 1, 0.0);
 
+    const dig_filter_params_t &p = params.get();
+    double Tf = p.Tf;
+
     if ( enabled && dt > 0.0 ) {
         /*
          * Exponential filter
@@ -172,7 +185,7 @@ void AuraDigitalFilter::update(double dt)
         }
         else if (filterType == noiseSpike)
         {
-            double maxChange = rateOfChange * dt;
+            double maxChange = p.rateOfChange * dt;
 
             if ((output[0] - input[0]) > maxChange)
             {
@@ -192,7 +205,7 @@ void AuraDigitalFilter::update(double dt)
 	    }
 	    output.resize(1);
         }
-        if ( component_node.getBool("debug") ) {
+        if ( p.debug ) {
             printf("input: %.3f\toutput: %.3f\n", input[0], output[0]);
         }
     }
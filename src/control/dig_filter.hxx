@@ -40,23 +40,27 @@ using std::deque;
  *
  */
 
+struct dig_filter_params_t {
+    double Tf;            // Filter time [s]
+    double rateOfChange;  // The maximum allowable rate of change [1/s]
+    bool debug;
+};
+
 class AuraDigitalFilter : public APComponent
 {
 private:
-    double Tf;            // Filter time [s]
+    ParamSnapshot<dig_filter_params_t> params;
     unsigned int samples; // Number of input samples to average
-    double rateOfChange;  // The maximum allowable rate of change [1/s]
     deque <double> output;
     deque <double> input;
     enum filterTypes { exponential, doubleExponential, movingAverage, noiseSpike };
     filterTypes filterType;
 
-    bool debug;
-
 public:
     AuraDigitalFilter( string config_path );
     ~AuraDigitalFilter() {}
 
     void reset();
     void update(double dt);
+    void load_params();
 };
@@ -199,6 +199,15 @@ AuraDTSS::AuraDTSS( string config_path ):
 
     // config
     config_node = component_node.getChild( "config", true );
+    load_params();
+}
+
+
+// the state space matrices and output limits are fixed at build time
+void AuraDTSS::load_params() {
+    dtss_params_t &p = params.begin_update();
+    p.debug = component_node.getBool("debug");
+    params.commit();
 }
 
 
@@ -217,7 +226,7 @@ void AuraDTSS::update( double dt ) {
         }
     }
 
-    bool debug = component_node.getBool("debug");
+    bool debug = params.get().debug;
     if ( debug ) printf("Updating %s\n", get_name().c_str());
 
     // construct the M matrix
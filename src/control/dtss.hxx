@@ -35,10 +35,16 @@ typedef Matrix<double, Dynamic, Dynamic> MatrixXd;
 typedef Matrix<double, Dynamic, 1> VectorXd;
 
 
+struct dtss_params_t {
+    bool debug;
+};
+
 class AuraDTSS : public APComponent {
 
 private:
 
+    ParamSnapshot<dtss_params_t> params;
+
     unsigned int nx, nz, nu;
     bool do_reset;
 
@@ -64,4 +70,5 @@ public:
 
     void reset();
     void update( double dt );
+    void load_params();
 };
@@ -111,6 +111,20 @@ AuraPID::AuraPID( string config_path ):
  
     // config
     config_node = component_node.getChild( "config", true );
+    load_params();
+}
+
+
+void AuraPID::load_params() {
+    pid_params_t &p = params.begin_update();
+    p.Kp = config_node.getDouble("Kp");
+    p.Ti = config_node.getDouble("Ti");
+    p.Td = config_node.getDouble("Td");
+    p.u_trim = config_node.getDouble("u_trim");
+    p.u_min = config_node.getDouble("u_min");
+    p.u_max = config_node.getDouble("u_max");
+    p.debug = component_node.getBool("debug");
+    params.commit();
 }
 
 
@@ -129,7 +143,8 @@ void AuraPID::update( double dt ) {
         }
     }
 
-    bool debug = component_node.getBool("debug");
+    const pid_params_t &p = params.get();
+    bool debug = p.debug;
     if ( debug ) printf("Updating %s\n", get_name().c_str());
     y_n = input_node.getDouble(input_attr.c_str());
 
@@ -145,13 +160,13 @@ void AuraPID::update( double dt ) {
     if ( debug ) printf("input = %.3f reference = %.3f error = %.3f\n",
 			y_n, r_n, error);
 
-    double u_trim = config_node.getDouble("u_trim");
-    double u_min = config_node.getDouble("u_min");
-    double u_max = config_node.getDouble("u_max");
+    double u_trim = p.u_trim;
+    double u_min = p.u_min;
+    double u_max = p.u_max;
 
-    double Kp = config_node.getDouble("Kp");
-    double Ti = config_node.getDouble("Ti");
-    double Td = config_node.getDouble("Td");
+    double Kp = p.Kp;
+    double Ti = p.Ti;
+    double Td = p.Td;
     double Ki = 0.0;
     if ( Ti > 0.0001 ) {
 	Ki = Kp / Ti;
@@ -175,8 +190,6 @@ void AuraPID::update( double dt ) {
         if ( Ti > 0.0001 ) {
             double u_n = output_node[0].getDouble(output_attr[0].c_str());
             // and clip
-            double u_min = config_node.getDouble("u_min");
-            double u_max = config_node.getDouble("u_max");
             if ( u_n < u_min ) { u_n = u_min; }
             if ( u_n > u_max ) { u_n = u_max; }
             iterm = u_n - pterm;
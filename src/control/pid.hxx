@@ -28,10 +28,18 @@ using std::string;
 #include "component.hxx"
 
 
+struct pid_params_t {
+    double Kp, Ti, Td;
+    double u_trim, u_min, u_max;
+    bool debug;
+};
+
 class AuraPID : public APComponent {
 
 private:
 
+    ParamSnapshot<pid_params_t> params;
+
     bool do_reset;
     
     bool proportional;		// proportional component data
@@ -50,6 +58,7 @@ public:
 
     void reset();
     void update( double dt );
+    void load_params();
 };
 
 
@@ -123,6 +123,22 @@ AuraPIDVel::AuraPIDVel( string config_path ):
 	// create with default value
 	config_node.setDouble( "alpha", 0.1 );
     }
+    load_params();
+}
+
+
+void AuraPIDVel::load_params() {
+    pid_vel_params_t &p = params.begin_update();
+    p.Kp = config_node.getDouble("Kp");
+    p.Ti = config_node.getDouble("Ti");
+    p.Td = config_node.getDouble("Td");
+    p.beta = config_node.getDouble("beta");
+    p.gamma = config_node.getDouble("gamma");
+    p.alpha = config_node.getDouble("alpha");
+    p.u_min = config_node.getDouble("u_min");
+    p.u_max = config_node.getDouble("u_max");
+    p.debug = component_node.getBool("debug");
+    params.commit();
 }
 
 
@@ -208,7 +224,8 @@ void AuraPIDVel::update( double dt ) {
         }
     }
 
-    bool debug = component_node.getBool("debug");
+    const pid_vel_params_t &p = params.get();
+    bool debug = p.debug;
 
     if ( Ts > 0.0) {
         if ( debug ) printf("Updating %s Ts = %.2f", get_name().c_str(), Ts );
@@ -226,7 +243,7 @@ void AuraPIDVel::update( double dt ) {
         if ( debug ) printf("  input = %.3f ref = %.3f\n", y_n, r_n );
 
         // Calculates proportional error:
-        ep_n = config_node.getDouble("beta") * (r_n - y_n);
+        ep_n = p.beta * (r_n - y_n);
         if ( debug ) {
 	    printf( "  ep_n = %.3f", ep_n);
 	    printf( "  ep_n_1 = %.3f", ep_n_1);
@@ -237,13 +254,13 @@ void AuraPIDVel::update( double dt ) {
         if ( debug ) printf( " e_n = %.3f", e_n);
 
         // Calculates derivate error:
-        ed_n = config_node.getDouble("gamma") * r_n - y_n;
+        ed_n = p.gamma * r_n - y_n;
         if ( debug ) printf(" ed_n = %.3f", ed_n);
 
-	double Td = config_node.getDouble("Td");
+	double Td = p.Td;
         if ( Td > 0.0 ) {
             // Calculates filter time:
-            Tf = config_node.getDouble("alpha") * Td;
+            Tf = p.alpha * Td;
             if ( debug ) printf(" Tf = %.3f", Tf);
 
             // Filters the derivate error:
@@ -255,8 +272,8 @@ void AuraPIDVel::update( double dt ) {
         }
 
         // Calculates the incremental output:
-	double Ti = config_node.getDouble("Ti");
-	double Kp = config_node.getDouble("Kp");
+	double Ti = p.Ti;
+	double Kp = p.Kp;
         if ( Ti > 0.0 ) {
             delta_u_n = Kp * ( (ep_n - ep_n_1)
                                + ((Ts/Ti) * e_n)
@@ -272,8 +289,8 @@ void AuraPIDVel::update( double dt ) {
         }
 
         // Integrator anti-windup logic:
-	double u_min = config_node.getDouble("u_min");
-	double u_max = config_node.getDouble("u_max");
+	double u_min = p.u_min;
+	double u_max = p.u_max;
         if ( delta_u_n > (u_max - u_n_1) ) {
             delta_u_n = u_max - u_n_1;
             if ( debug ) printf(" max saturation\n");
@@ -305,8 +322,8 @@ void AuraPIDVel::update( double dt ) {
 	// pull output value from the corresponding property tree value
 	u_n = output_node[0].getDouble(output_attr[0].c_str());
 	// and clip
-	double u_min = config_node.getDouble("u_min");
-	double u_max = config_node.getDouble("u_max");
+	double u_min = p.u_min;
+	double u_max = p.u_max;
  	if ( u_n < u_min ) { u_n = u_min; }
 	if ( u_n > u_max ) { u_n = u_max; }
 	u_n_1 = u_n;
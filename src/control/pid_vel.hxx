@@ -27,10 +27,19 @@ using std::string;
 #include "component.hxx"
 
 
+struct pid_vel_params_t {
+    double Kp, Ti, Td;
+    double beta, gamma, alpha;
+    double u_min, u_max;
+    bool debug;
+};
+
 class AuraPIDVel : public APComponent {
 
 private:
 
+    ParamSnapshot<pid_vel_params_t> params;
+
     // Previous state tracking values
     double ep_n_1;              // ep[n-1]  (prop error)
     double edf_n_1;             // edf[n-1] (derivative error)
@@ -47,6 +56,8 @@ public:
 
     void reset();
     void update( double dt );
+    void load_params();
+    const pid_vel_params_t &get_params() const { return params.get(); }
 };
 
 
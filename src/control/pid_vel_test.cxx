@@ -0,0 +1,66 @@
+// build a velocity form pid from a config subtree and check the
+// parameters it loads, including the config defaults it creates.
+//
+//   pid_vel_test [python_path]
+//
+// The python property system must be importable from python_path.
+
+#include <python_sys.hxx>
+#include <pyprops.hxx>
+
+#include <math.h>
+#include <stdio.h>
+
+#include "pid_vel.hxx"
+
+static int failures = 0;
+
+static void check( const char *name, double value, double expect ) {
+    bool ok = fabs(value - expect) <= 1e-9;
+    printf("%-8s %10.4f (expect %.4f) %s\n", name, value, expect,
+	   ok ? "ok" : "FAIL");
+    if ( !ok ) {
+	failures++;
+    }
+}
+
+int main( int argc, char **argv ) {
+    AuraPythonInit( argc, argv, argc > 1 ? argv[1] : "." );
+    PyObject *pModule = PyImport_ImportModule("props");
+    if ( pModule == NULL ) {
+	PyErr_Clear();
+	printf("skipped: python props module not found\n");
+	return 0;
+    }
+    Py_DECREF( pModule );
+    pyPropsInit();
+
+    pyPropertyNode config_node
+	= pyGetNode("/config/autopilot/test_pid_vel/config", true);
+    config_node.setDouble( "Kp", 0.5 );
+    config_node.setDouble( "Ti", 2.0 );
+    config_node.setDouble( "Td", 0.1 );
+    config_node.setDouble( "gamma", 0.25 );
+    config_node.setDouble( "alpha", 0.2 );
+    config_node.setDouble( "u_min", -1.0 );
+    config_node.setDouble( "u_max", 1.0 );
+
+    AuraPIDVel pid( "/config/autopilot/test_pid_vel" );
+    const pid_vel_params_t &p = pid.get_params();
+    check( "Kp", p.Kp, 0.5 );
+    check( "Ti", p.Ti, 2.0 );
+    check( "Td", p.Td, 0.1 );
+    check( "beta", p.beta, 1.0 );	// created default
+    check( "gamma", p.gamma, 0.25 );
+    check( "alpha", p.alpha, 0.2 );
+    check( "u_min", p.u_min, -1.0 );
+    check( "u_max", p.u_max, 1.0 );
+
+    // a config write followed by a reload
+    config_node.setDouble( "beta", 0.8 );
+    pid.load_params();
+    check( "beta", pid.get_params().beta, 0.8 );
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -1,8 +1,7 @@
 import math
 
 from props import getNode
-from auracore import wgs84
-from auracore import windtri
+from auracore import routegeo
 
 import comms.events
 import control.waypoint as waypoint
@@ -27,6 +26,7 @@ wind_node = getNode('/filters/wind', True)
 
 active_route = []        # actual routes
 standby_route = []
+geometry = routegeo.Route() # precomputed legs of the active route
 current_wp = 0
 acquired = False
 
@@ -99,6 +99,16 @@ def build_str(request):
     print('Loaded %d waypoints' % len(standby_route))
     return True
 
+# rebuild the leg geometry after the active route changes
+def sync_geometry():
+    global dist_valid
+    
+    geometry.set_waypoints([wp.lat_deg for wp in active_route],
+                           [wp.lon_deg for wp in active_route])
+    for i, wp in enumerate(active_route):
+        wp.leg_dist_m = geometry.leg_dist(i)
+    dist_valid = len(active_route) > 0
+
 # swap active and standby routes
 def swap():
     global active_route
@@ -109,6 +119,7 @@ def swap():
     active_route = standby_route
     standby_route = tmp
     current_wp = 0     # make sure we start at beginning
+    sync_geometry()
 
 def get_current_wp():
     if current_wp >= 0 and current_wp < len(active_route):
@@ -135,11 +146,9 @@ def increment_current_wp():
 
 def dribble(reset=False):
     global wp_counter
-    global dist_valid
     
     if reset:
         wp_counter = 0
-        dist_valid = False
         
     # dribble active route into the active_node tree (one waypoint
     # per interation to keep the load consistent and light.)
@@ -148,20 +157,11 @@ def dribble(reset=False):
     if route_size > 0:
         if wp_counter >= route_size:
             wp_counter = 0
-            dist_valid = True
         wp = active_route[wp_counter]
         wp_str = 'wpt[%d]' % wp_counter
         wp_node = active_route_node.getChild(wp_str, True)
         wp_node.setFloat("longitude_deg", wp.lon_deg)
         wp_node.setFloat("latitude_deg", wp.lat_deg)
-
-        if wp_counter < route_size - 1:
-            # compute leg course and distance
-            next = active_route[wp_counter+1]
-            (leg_course, rev_course, leg_dist) = \
-                wgs84.geo_inverse( wp.lat_deg, wp.lon_deg,
-                                   next.lat_deg, next.lon_deg )
-            wp.leg_dist_m = leg_dist
         wp_counter += 1
 
 def reposition(force=False):
@@ -180,6 +180,7 @@ def reposition(force=False):
             if wp.mode == 'relative':
                 wp.update_relative_pos(home_lon, home_lat, home_az)
                 print('WPT:', wp.hdg_deg, wp.dist_m, wp.lat_deg, wp.lon_deg)
+        sync_geometry()
         if comms_node.getBool('display_on'):
             print("ROUTE pattern updated: %.6f %.6f (course = %.1f)" % \
                   (home_lon, home_lat, home_az))
@@ -188,10 +189,7 @@ def reposition(force=False):
         last_az = home_az
 
 def get_remaining_distance_from_next_waypoint():
-    result = 0
-    for wp in active_route[current_wp:] :
-        result += wp.leg_dist_m
-    return result
+    return geometry.remaining(current_wp)
 
 # Given wind speed, wind direction, and true airspeed (from the
 # property tree), as well as a current ground course, and a target
@@ -212,36 +210,13 @@ def wind_heading_error( current_crs_deg, target_crs_deg ):
     ws_kt = wind_node.getFloat("wind_speed_kt")
     tas_kt = wind_node.getFloat("true_airspeed_kt")
     wd_deg = wind_node.getFloat("wind_dir_deg")
-    (est_cur_hdg_deg, gs1_kt) = windtri.wind_course( ws_kt, tas_kt, wd_deg,
-                                                     current_crs_deg )
-    (est_nav_hdg_deg, gs2_kt) = windtri.wind_course( ws_kt, tas_kt, wd_deg,
-		                                     target_crs_deg )
-    # print('est cur body:', est_cur_hdg_deg, 'est nav body:', est_nav_hdg_deg)
-    if est_cur_hdg_deg != None and est_nav_hdg_deg != None:
-        # life is good
-        # print ' cur:', est_cur_hdg_deg, 'gs1:', gs1_kt
-        # print ' nav:', est_nav_hdg_deg, 'gs2:', gs2_kt
-        hdg_error = est_cur_hdg_deg - est_nav_hdg_deg
-    else:
-	# Yikes, course cannot be flown, wind too strong!  Compute a
-	# heading error relative to the wind 'from' direction.  This
-	# will cause the aircraft to point it's nose into the wind and
-	# kite.  This minimizes a bad situation and gives the operator
-	# maximum time to take corrective action.  But hurry and do
-	# something!
-        
-        # point to next waypoint (probably less good than pointing into
-        # the wind.)
-        # hdg_error = orient_node.getFloat('heading_deg') - target_crs_deg
-
-        # point to wind (will probably slide laterally due to some
-        # inevitable assymetries in bank angle verus turn rate):
-        hdg_error = orient_node.getFloat('heading_deg') - wd_deg
-
-    if hdg_error < -180: hdg_error += 360
-    if hdg_error > 180: hdg_error -= 360
-    # print ' body err:', hdg_error
-    return hdg_error
+    # if the target course cannot be flown (wind too strong!) the
+    # heading error points the aircraft's nose into the wind so it
+    # kites.  This minimizes a bad situation and gives the operator
+    # maximum time to take corrective action.  But hurry and do
+    # something!
+    return routegeo.wind_heading_error( ws_kt, tas_kt, wd_deg,
+                                        current_crs_deg, target_crs_deg )
 
 def update(dt):
     global current_wp
@@ -296,33 +271,20 @@ def update(dt):
             tas_kt = wind_node.getFloat("true_airspeed_kt")
             tas_mps = tas_kt * kt2mps
 
-            prev = get_previous_wp()
-            wp = get_current_wp()
-
-            # compute direct-to course and distance
+            # direct-to course and distance, leg (previous waypoint
+            # to current waypoint) course, cross-track error and
+            # distance remaining along the leg
             pos_lon = pos_node.getFloat("longitude_deg")
             pos_lat = pos_node.getFloat("latitude_deg")
-            (direct_course, rev_course, direct_dist) = \
-                wgs84.geo_inverse( pos_lat, pos_lon, wp.lat_deg, wp.lon_deg )
-            #print pos_lat, pos_lon, ":", wp.lat_deg, wp.lon_deg
+            (direct_course, direct_dist, leg_course, xtrack_m, dist_m) = \
+                geometry.leg(current_wp, pos_lat, pos_lon)
             #print ' course to:', direct_course, 'dist:', direct_dist
 
-            # compute leg course and distance
-            (leg_course, rev_course, leg_dist) = \
-                wgs84.geo_inverse( prev.lat_deg, prev.lon_deg,
-                                   wp.lat_deg, wp.lon_deg )
-            #print prev.lat_deg, prev.lon_deg, " ", wp.lat_deg, wp.lon_deg
-            #print ' leg course:', leg_course, 'dist:', leg_dist
-
             # difference between ideal (leg) course and direct course
             angle = leg_course - direct_course
             if angle < -180.0: angle += 360.0
             elif angle > 180.0: angle -= 360.0
 
-            # compute cross-track error
-            angle_rad = angle * d2r
-            xtrack_m = math.sin(angle_rad) * direct_dist
-            dist_m = math.cos(angle_rad) * direct_dist
             # print 'direct_dist = %.1f angle = %.1f dist_m = %.1f\n' % (direct_dist, angle, dist_m)
             route_node.setFloat( 'xtrack_dist_m', xtrack_m )
             route_node.setFloat( 'projected_dist_m', dist_m )
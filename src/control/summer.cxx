@@ -103,6 +103,15 @@ AuraSummer::AuraSummer ( string config_path )
     
     // config
     config_node = component_node.getChild( "config", true );
+    load_params();
+}
+
+void AuraSummer::load_params() {
+    summer_params_t &p = params.begin_update();
+    p.u_min = config_node.getDouble("u_min");
+    p.u_max = config_node.getDouble("u_max");
+    p.debug = component_node.getBool("debug");
+    params.commit();
 }
 
 void AuraSummer::reset() {
@@ -120,7 +129,8 @@ void AuraSummer::update( double dt ) {
     }
 
     if ( enabled ) {
-	bool debug = component_node.getBool("debug");
+	const summer_params_t &p = params.get();
+	bool debug = p.debug;
 	if ( debug ) printf("Updating %s\n", get_name().c_str());
 	double sum = 0.0;
 	for ( unsigned int i = 0; i < input_node.size(); i++ ) {
@@ -128,10 +138,8 @@ void AuraSummer::update( double dt ) {
 	    sum += val;
 	    if (debug) printf("  %s = %.3f\n", input_attr[i].c_str(), val);
 	}
-	double u_min = config_node.getDouble("u_min");
-	double u_max = config_node.getDouble("u_max");
-	if ( sum < u_min ) { sum = u_min; }
-	if ( sum > u_max ) { sum = u_max; }
+	if ( sum < p.u_min ) { sum = p.u_min; }
+	if ( sum > p.u_max ) { sum = p.u_max; }
 	if (debug) printf("  sum = %.3f\n", sum);
 	for ( unsigned int i = 0; i < output_node.size(); i++ ) {
 	    output_node[i].setDouble( output_attr[i].c_str(), sum );
@@ -25,16 +25,21 @@ using std::string;
 #include "component.hxx"
 
 
+struct summer_params_t {
+    double u_min, u_max;
+    bool debug;
+};
+
 class AuraSummer : public APComponent {
 
 private:
+
+    ParamSnapshot<summer_params_t> params;
+
     // support multiple input nodes
     vector <pyPropertyNode> input_node;
     vector <string> input_attr;
 
-    // debug flag
-    bool debug_node;
-
 public:
 
     AuraSummer( string config_path );
@@ -42,4 +47,5 @@ public:
 
     void reset();
     void update( double dt );
+    void load_params();
 };
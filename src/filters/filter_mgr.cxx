@@ -11,21 +11,35 @@
 
 #include <pyprops.hxx>
 
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>		// sched_yield()
 #include <stdio.h>
+#include <string.h>		// strerror()
+
+#include <atomic>
 #include <string>
 #include <sstream>
+#include <vector>
 using std::string;
 using std::ostringstream;
+using std::vector;
 
 #include "comms/aura_messages.h"
 #include "comms/remote_link.hxx"
 #include "comms/logging.hxx"
+#include "comms/state_bus.hxx"
 #include "filters/nav_ekf15/aura_interface.hxx"
 #include "filters/nav_ekf15_mag/aura_interface.hxx"
 #include "include/globaldefs.h"
+#include "comms/trace.hxx"
 #include "init/globals.hxx"
+#include "init/runtime.hxx"
+#include "sensors/cal_learn.hxx"
 #include "util/myprof.hxx"
 
+#include "nav_common/constants.hxx"
+
 #include "ground.hxx"
 #include "wind.hxx"
 
@@ -46,16 +60,116 @@ static pyPropertyNode vel_node;
 static pyPropertyNode pos_filter_node;
 static pyPropertyNode pos_pressure_node;
 static pyPropertyNode pos_combined_node;
-static pyPropertyNode filter_node;
+static pyPropertyNode filter_node;	// the selected filter's output
 static pyPropertyNode filter_group_node;
 static pyPropertyNode remote_link_node;
 static pyPropertyNode status_node;
-static vector<pyPropertyNode> sections;
-static vector<pyPropertyNode> outputs;
+
+enum filter_module_t {
+    FILTER_NULL,
+    FILTER_EKF15,
+    FILTER_EKF15_MAG
+};
+
+struct filter_t {
+    int index;			// config section and output index
+    filter_module_t module;
+    pyPropertyNode output;
+    bool fresh;			// step() result, written by the worker
+    bool valid;
+    double gps_score;		// smoothed disagreement with the gps
+    double crosscheck;		// disagreement with the selected filter
+};
+
+static vector<filter_t> filters;
+
+// filters[1..n-1] each get a worker thread when running in parallel,
+// filters[0] runs on the main thread
+struct filter_worker_t {
+    pthread_t thread;
+    unsigned int filter;
+    std::atomic<unsigned long> done_frame;
+};
+
+static bool parallel = false;
+static vector<filter_worker_t *> workers;
+static pthread_mutex_t work_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static unsigned long work_frame = 0; // guarded by work_mutex
+static bool work_stop = false;	     // guarded by work_mutex
+
+// cross check
+static unsigned int selected = 0;
+static double att_tol_deg = 5.0;
+static double pos_tol_m = 25.0;
+static double vel_tol_mps = 2.0;
+static double persist_sec = 2.0;
+static double disagree_sec = 0.0;
+static double last_gps_time = 0.0;
+static long switches = 0;
+static int switch_event = trace_register("filter", "switch", "Nav filter switch: %.0f -> %.0f (crosscheck %.2f)");
 
 static int remote_link_skip = 0;
 static int logging_skip = 0;
 
+
+static void filter_begin( filter_t *f ) {
+    if ( f->module == FILTER_EKF15 ) {
+	nav_ekf15_begin();
+    } else if ( f->module == FILTER_EKF15_MAG ) {
+	nav_ekf15_mag_begin();
+    }
+}
+
+// no property access, may run on a worker thread
+static bool filter_step( filter_t *f ) {
+    if ( f->module == FILTER_EKF15 ) {
+	return nav_ekf15_step();
+    } else if ( f->module == FILTER_EKF15_MAG ) {
+	return nav_ekf15_mag_step();
+    }
+    return false;
+}
+
+static void filter_end( filter_t *f ) {
+    if ( f->module == FILTER_EKF15 ) {
+	nav_ekf15_end();
+    } else if ( f->module == FILTER_EKF15_MAG ) {
+	nav_ekf15_mag_end();
+    }
+}
+
+static void filter_reset( filter_t *f ) {
+    if ( f->module == FILTER_EKF15 ) {
+	nav_ekf15_reset();
+    } else if ( f->module == FILTER_EKF15_MAG ) {
+	nav_ekf15_mag_reset();
+    }
+}
+
+static void *worker_main( void *arg ) {
+    filter_worker_t *w = (filter_worker_t *)arg;
+    runtime_worker_thread_init( "filter", w->filter - 1 );
+    trace_thread_name( "filter" );
+    unsigned long seen = 0;
+    while ( true ) {
+	pthread_mutex_lock( &work_mutex );
+	while ( work_frame == seen && !work_stop ) {
+	    pthread_cond_wait( &work_cond, &work_mutex );
+	}
+	bool stop = work_stop;
+	seen = work_frame;
+	pthread_mutex_unlock( &work_mutex );
+	if ( stop ) {
+	    break;
+	}
+	filter_t *f = &filters[w->filter];
+	f->fresh = filter_step( f );
+	w->done_frame.store( seen, std::memory_order_release );
+    }
+    return NULL;
+}
+
 void Filter_init() {
     // initialize imu property nodes
     imu_node = pyGetNode("/sensors/imu", true);
@@ -63,7 +177,6 @@ void Filter_init() {
     pos_node = pyGetNode("/position", true);
     orient_node = pyGetNode("/orientation", true);
     vel_node = pyGetNode("/velocity", true);
-    filter_node = pyGetNode("/filters/filter", true);
     filter_group_node = pyGetNode("/filters", true);
     pos_filter_node = pyGetNode("/position/filter", true);
     pos_pressure_node = pyGetNode("/position/pressure", true);
@@ -82,7 +195,6 @@ void Filter_init() {
     printf("Found %d filter sections\n", (int)children.size());
     for ( unsigned int i = 0; i < children.size(); i++ ) {
 	pyPropertyNode section = group_node.getChild(children[i].c_str());
-	sections.push_back(section);
 	string module = section.getString("module");
 	bool enabled = section.getBool("enable");
 	if ( !enabled ) {
@@ -90,19 +202,66 @@ void Filter_init() {
 	}
 	ostringstream output_path;
 	output_path << "/filters/filter" << '[' << i << ']';
-        pyPropertyNode output_node = pyGetNode(output_path.str(), true);
-        outputs.push_back(output_node);
+	filter_t f;
+	f.index = i;
+	f.module = FILTER_NULL;
+	f.output = pyGetNode(output_path.str(), true);
+	f.fresh = false;
+	f.valid = false;
+	f.gps_score = 0.0;
+	f.crosscheck = 0.0;
 	printf("filter: %d = %s\n", i, module.c_str());
 	if ( module == "null" ) {
 	    // do nothing
 	} else if ( module == "nav-ekf15" ) {
-	    nav_ekf15_init( output_path.str(), &section );
+	    f.module = FILTER_EKF15;
 	} else if ( module == "nav-ekf15-mag" ) {
-	    nav_ekf15_mag_init( output_path.str(), &section );
+	    f.module = FILTER_EKF15_MAG;
 	} else {
 	    printf("Unknown filter = '%s' in config file\n",
 		   module.c_str());
 	}
+	// each module keeps its state in file statics, so a second
+	// instance would share (and race on) the first one's filter
+	bool duplicate = false;
+	for ( unsigned int j = 0; j < filters.size(); j++ ) {
+	    if ( f.module != FILTER_NULL && filters[j].module == f.module ) {
+		duplicate = true;
+	    }
+	}
+	if ( duplicate ) {
+	    printf("filter: %d = %s is already running, skipping\n",
+		   i, module.c_str());
+	    continue;
+	}
+	if ( f.module == FILTER_EKF15 ) {
+	    nav_ekf15_init( output_path.str(), &section );
+	} else if ( f.module == FILTER_EKF15_MAG ) {
+	    nav_ekf15_mag_init( output_path.str(), &section );
+	}
+	filters.push_back(f);
+    }
+
+    pyPropertyNode config_node = pyGetNode("/config", true);
+    parallel = config_node.getBool("filter_parallel");
+    pyPropertyNode check_node = pyGetNode("/config/filter_crosscheck", true);
+    if ( check_node.hasChild("att_tol_deg") ) {
+	att_tol_deg = check_node.getDouble("att_tol_deg");
+    }
+    if ( check_node.hasChild("pos_tol_m") ) {
+	pos_tol_m = check_node.getDouble("pos_tol_m");
+    }
+    if ( check_node.hasChild("vel_tol_mps") ) {
+	vel_tol_mps = check_node.getDouble("vel_tol_mps");
+    }
+    if ( check_node.hasChild("persist_sec") ) {
+	persist_sec = check_node.getDouble("persist_sec");
+    }
+    if ( filters.size() ) {
+	filter_node = filters[0].output;
+	filter_group_node.setLong("selected", filters[0].index);
+    } else {
+	filter_node = pyGetNode("/filters/filter", true);
     }
 
     // initialize ground estimator
@@ -110,6 +269,136 @@ void Filter_init() {
     
     // initialize wind estimator
     init_wind();
+
+    // imu temperature bias learning (if configured)
+    cal_learn_init();
+}
+
+
+// start the worker threads (after runtime_init() so they get the
+// flight loop priority and the worker cpus.)
+bool Filter_start() {
+    if ( !parallel || filters.size() < 2 || workers.size() ) {
+	return true;
+    }
+    for ( unsigned int i = 1; i < filters.size(); i++ ) {
+	filter_worker_t *w = new filter_worker_t;
+	w->filter = i;
+	w->done_frame.store( 0 );
+	int result = pthread_create( &w->thread, NULL, worker_main, w );
+	if ( result != 0 ) {
+	    printf("filter: unable to start worker thread - %s\n",
+		   strerror(result));
+	    delete w;
+	    return false;
+	}
+	workers.push_back( w );
+    }
+    printf("filter: %d worker threads\n", (int)workers.size());
+    return true;
+}
+
+
+static double angle_diff_deg( double a, double b ) {
+    double d = fmod( a - b, 360.0 );
+    if ( d > 180.0 ) { d -= 360.0; }
+    if ( d < -180.0 ) { d += 360.0; }
+    return fabs(d);
+}
+
+// largest of the position, velocity (and attitude) differences between
+// two solutions, each scaled by its tolerance, so > 1 means the two
+// disagree.
+static double nav_distance( pyPropertyNode *a, pyPropertyNode *b,
+			    bool attitude )
+{
+    double lat = a->getDouble("latitude_deg") * D2R;
+    double dn = (a->getDouble("latitude_deg") - b->getDouble("latitude_deg"))
+	* D2R * EARTH_RADIUS;
+    double de = (a->getDouble("longitude_deg") - b->getDouble("longitude_deg"))
+	* D2R * EARTH_RADIUS * cos(lat);
+    double dvn = a->getDouble("vn_ms") - b->getDouble("vn_ms");
+    double dve = a->getDouble("ve_ms") - b->getDouble("ve_ms");
+    double dvd = a->getDouble("vd_ms") - b->getDouble("vd_ms");
+    double result = sqrt(dn*dn + de*de) / pos_tol_m;
+    double vel = sqrt(dvn*dvn + dve*dve + dvd*dvd) / vel_tol_mps;
+    if ( vel > result ) { result = vel; }
+    if ( attitude ) {
+	const char *names[] = { "roll_deg", "pitch_deg", "heading_deg" };
+	for ( int i = 0; i < 3; i++ ) {
+	    double att = angle_diff_deg( a->getDouble(names[i]),
+					 b->getDouble(names[i]) ) / att_tol_deg;
+	    if ( att > result ) { result = att; }
+	}
+    }
+    return result;
+}
+
+// Compare every filter to the selected one.  If they disagree for
+// longer than persist_sec (or the selected filter is no longer valid)
+// hand over to the valid filter that has been tracking the gps best.
+// With only two filters the disagreement alone can't say which one is
+// wrong, the gps score breaks the tie.
+static void crosscheck_update( double dt ) {
+    if ( filters.size() < 2 ) {
+	return;
+    }
+    bool fresh_gps = false;
+    double gps_time = gps_node.getDouble("timestamp");
+    if ( gps_time > last_gps_time ) {
+	last_gps_time = gps_time;
+	fresh_gps = true;
+    }
+
+    filter_t *sel = &filters[selected];
+    double worst = 0.0;
+    for ( unsigned int i = 0; i < filters.size(); i++ ) {
+	filters[i].valid = filters[i].output.getString("navigation") == "valid";
+    }
+    for ( unsigned int i = 0; i < filters.size(); i++ ) {
+	filter_t *f = &filters[i];
+	if ( f->valid && fresh_gps ) {
+	    double d = nav_distance( &f->output, &gps_node, false );
+	    f->gps_score += 0.1 * (d - f->gps_score);
+	}
+	f->crosscheck = 0.0;
+	if ( i != selected && f->valid && sel->valid ) {
+	    f->crosscheck = nav_distance( &sel->output, &f->output, true );
+	    if ( f->crosscheck > worst ) { worst = f->crosscheck; }
+	}
+	f->output.setDouble( "crosscheck", f->crosscheck );
+	f->output.setDouble( "gps_score", f->gps_score );
+    }
+    if ( worst > 1.0 ) {
+	disagree_sec += dt;
+    } else {
+	disagree_sec = 0.0;
+    }
+
+    if ( !sel->valid || disagree_sec > persist_sec ) {
+	int best = -1;
+	for ( unsigned int i = 0; i < filters.size(); i++ ) {
+	    if ( filters[i].valid && (best < 0 || filters[i].gps_score < filters[best].gps_score) ) {
+		best = i;
+	    }
+	}
+	// a valid selection only gives way to a clearly better one
+	if ( best >= 0 && best != (int)selected
+	     && (!sel->valid || filters[best].gps_score + 0.25 < sel->gps_score) )
+	{
+	    printf("filter: switching from filter[%d] to filter[%d]\n",
+		   sel->index, filters[best].index);
+	    trace_event( switch_event, sel->index, filters[best].index, worst );
+	    selected = best;
+	    filter_node = filters[best].output;
+	    switches++;
+	    disagree_sec = 0.0;
+	}
+    }
+
+    filter_group_node.setLong( "selected", filters[selected].index );
+    filter_group_node.setDouble( "crosscheck", worst );
+    filter_group_node.setLong( "switches", switches );
 }
 
 
@@ -133,6 +422,9 @@ static void update_euler_rates() {
 	orient_node.setDouble("phi_dot_rad_sec", phi_dot);
 	orient_node.setDouble("the_dot_rad_sec", the_dot);
 	orient_node.setDouble("psi_dot_rad_sec", psi_dot);
+	state_bus.phi_dot_rad_sec = phi_dot;
+	state_bus.the_dot_rad_sec = the_dot;
+	state_bus.psi_dot_rad_sec = psi_dot;
 	/* printf("dt=%.3f q=%.3f q(ned)=%.3f phi(dot)=%.3f\n",
 	   dt,imu_node.getDouble("q_rad_sec"), dq/dt, phi_dot);  */
 	/* printf("%.3f %.3f %.3f %.3f\n",
@@ -141,28 +433,39 @@ static void update_euler_rates() {
 }
 
 
+// the selected filter's solution goes into the state bus frame once
+// and the property tree is republished from there
 static void publish_values() {
-    orient_node.setDouble( "roll_deg", filter_node.getDouble("roll_deg") );
-    orient_node.setDouble( "pitch_deg", filter_node.getDouble("pitch_deg") );
-    orient_node.setDouble( "heading_deg", filter_node.getDouble("heading_deg") );
-    pos_node.setDouble( "latitude_deg", filter_node.getDouble("latitude_deg") );
-    pos_node.setDouble( "longitude_deg", filter_node.getDouble("longitude_deg") );
+    state_bus.filter_timestamp = filter_node.getDouble("timestamp");
+    state_bus.roll_deg = filter_node.getDouble("roll_deg");
+    state_bus.pitch_deg = filter_node.getDouble("pitch_deg");
+    state_bus.heading_deg = filter_node.getDouble("heading_deg");
+    state_bus.latitude_deg = filter_node.getDouble("latitude_deg");
+    state_bus.longitude_deg = filter_node.getDouble("longitude_deg");
+    state_bus.vn_ms = filter_node.getDouble("vn_ms");
+    state_bus.ve_ms = filter_node.getDouble("ve_ms");
+    state_bus.vd_ms = filter_node.getDouble("vd_ms");
+
+    orient_node.setDouble( "roll_deg", state_bus.roll_deg );
+    orient_node.setDouble( "pitch_deg", state_bus.pitch_deg );
+    orient_node.setDouble( "heading_deg", state_bus.heading_deg );
+    pos_node.setDouble( "latitude_deg", state_bus.latitude_deg );
+    pos_node.setDouble( "longitude_deg", state_bus.longitude_deg );
     pos_filter_node.setDouble("altitude_m", filter_node.getDouble("altitude_m"));
     pos_filter_node.setDouble("altitude_ft", filter_node.getDouble("altitude_ft"));
-    vel_node.setDouble( "vn_ms", filter_node.getDouble("vn_ms") );
-    vel_node.setDouble( "ve_ms", filter_node.getDouble("ve_ms") );
-    vel_node.setDouble( "vd_ms", filter_node.getDouble("vd_ms") );
-    filter_group_node.setDouble( "timestamp",
-				 filter_node.getDouble("timestamp") );
+    vel_node.setDouble( "vn_ms", state_bus.vn_ms );
+    vel_node.setDouble( "ve_ms", state_bus.ve_ms );
+    vel_node.setDouble( "vd_ms", state_bus.vd_ms );
+    filter_group_node.setDouble( "timestamp", state_bus.filter_timestamp );
     status_node.setString( "navigation",
 			   filter_node.getString("navigation") );
     bool use_filter = true;
     bool use_gps = !use_filter;
     if ( use_filter ) {
-	orient_node.setDouble( "groundtrack_deg",
-			       filter_node.getDouble("groundtrack_deg") );
-	vel_node.setDouble( "groundspeed_ms",
-			    filter_node.getDouble("groundspeed_ms") );
+	state_bus.groundtrack_deg = filter_node.getDouble("groundtrack_deg");
+	state_bus.groundspeed_ms = filter_node.getDouble("groundspeed_ms");
+	orient_node.setDouble( "groundtrack_deg", state_bus.groundtrack_deg );
+	vel_node.setDouble( "groundspeed_ms", state_bus.groundspeed_ms );
     } else if ( use_gps ) {
 	const double R2D = 57.295779513082323;
 	double vn = gps_node.getDouble("vn_ms");
@@ -205,16 +508,16 @@ static void publish_values() {
 
     // the following block favor the filter based altitude which can
     // be adversely affected (significantly) by gps altitude errors.
-    pos_node.setDouble( "altitude_m",
-			pos_filter_node.getDouble("altitude_m") );
+    state_bus.altitude_m = pos_filter_node.getDouble("altitude_m");
+    state_bus.altitude_agl_m = pos_filter_node.getDouble("altitude_agl_m");
+    state_bus.altitude_ground_m = pos_filter_node.getDouble("altitude_ground_m");
+    pos_node.setDouble( "altitude_m", state_bus.altitude_m );
     pos_node.setDouble( "altitude_ft",
 			pos_filter_node.getDouble("altitude_ft") );
-    pos_node.setDouble( "altitude_agl_m",
-			pos_filter_node.getDouble("altitude_agl_m") );
+    pos_node.setDouble( "altitude_agl_m", state_bus.altitude_agl_m );
     pos_node.setDouble( "altitude_agl_ft",
 			pos_filter_node.getDouble("altitude_agl_ft") );
-    pos_node.setDouble( "altitude_ground_m",
-			pos_filter_node.getDouble("altitude_ground_m") );
+    pos_node.setDouble( "altitude_ground_m", state_bus.altitude_ground_m );
 }
 
 bool Filter_update() {
@@ -247,69 +550,86 @@ bool Filter_update() {
         filter_group_node.setString( "command", "" );
     }
 
-    // traverse configured modules
-    for ( unsigned int i = 0; i < sections.size(); i++ ) {
-	string module = sections[i].getString("module");
-	bool enabled = sections[i].getBool("enable");
-	if ( !enabled ) {
-	    continue;
-	}
-	if ( module == "null" ) {
-	    // do nothing
-	} else if ( module == "nav-ekf15" ) {
-            if ( do_reset ) {
-                nav_ekf15_reset();
-            }
-	    fresh_filter_data = nav_ekf15_update();
-	} else if ( module == "nav-ekf15-mag" ) {
-            if ( do_reset ) {
-                nav_ekf15_mag_reset();
-            }
-	    fresh_filter_data = nav_ekf15_mag_update();
-	}
-	if ( fresh_filter_data ) {
-	    if ( i == 0 ) {
-		// only for primary filter
-		update_euler_rates();
-		update_ground(imu_dt);
-		update_wind(imu_dt);
-		publish_values();
-	    }
+    if ( do_reset ) {
+	for ( unsigned int i = 0; i < filters.size(); i++ ) {
+	    filter_reset( &filters[i] );
 	}
+    }
 
-	bool send_remote_link = false;
-	if ( remote_link_count < 0 ) {
-	    send_remote_link = true;
-	    remote_link_count = remote_link_skip;
+    // every filter sees the same sensor inputs for this frame
+    for ( unsigned int i = 0; i < filters.size(); i++ ) {
+	filter_begin( &filters[i] );
+    }
+    if ( workers.size() ) {
+	pthread_mutex_lock( &work_mutex );
+	unsigned long frame = ++work_frame;
+	pthread_cond_broadcast( &work_cond );
+	pthread_mutex_unlock( &work_mutex );
+	filters[0].fresh = filter_step( &filters[0] );
+	for ( unsigned int i = 0; i < workers.size(); i++ ) {
+	    while ( workers[i]->done_frame.load(std::memory_order_acquire) != frame ) {
+		sched_yield();
+	    }
 	}
-	
-	bool send_logging = false;
-	if ( logging_count < 0 ) {
-	    send_logging = true;
-	    logging_count = logging_skip;
+    } else {
+	for ( unsigned int i = 0; i < filters.size(); i++ ) {
+	    filters[i].fresh = filter_step( &filters[i] );
 	}
-	
+    }
+    for ( unsigned int i = 0; i < filters.size(); i++ ) {
+	filter_end( &filters[i] );
+    }
+
+    crosscheck_update( imu_dt );
+
+    if ( filters.size() ) {
+	fresh_filter_data = filters[selected].fresh;
+    }
+    if ( fresh_filter_data ) {
+	update_euler_rates();
+	update_ground(imu_dt);
+	update_wind(imu_dt);
+	publish_values();
+	cal_learn_update(&filter_node, imu_dt);
+    }
+
+    bool send_remote_link = false;
+    if ( remote_link_count < 0 ) {
+	send_remote_link = true;
+	remote_link_count = remote_link_skip;
+    }
+
+    bool send_logging = false;
+    if ( logging_count < 0 ) {
+	send_logging = true;
+	logging_count = logging_skip;
+    }
+
+    for ( unsigned int i = 0; i < filters.size(); i++ ) {
 	if ( send_remote_link || send_logging ) {
+	    pyPropertyNode *output = &filters[i].output;
             message::filter_v4_t nav;
-            nav.index = i;
-            nav.timestamp_sec = outputs[i].getDouble("timestamp");
-            nav.latitude_deg = outputs[i].getDouble("latitude_deg");
-            nav.longitude_deg = outputs[i].getDouble("longitude_deg");
-            nav.altitude_m = outputs[i].getDouble("altitude_m");
-            nav.vn_ms = outputs[i].getDouble("vn_ms");
-            nav.ve_ms = outputs[i].getDouble("ve_ms");
-            nav.vd_ms = outputs[i].getDouble("vd_ms");
-            nav.roll_deg = outputs[i].getDouble("roll_deg");
-            nav.pitch_deg = outputs[i].getDouble("pitch_deg");
-            nav.yaw_deg = outputs[i].getDouble("heading_deg");
-            nav.p_bias = outputs[i].getDouble("p_bias");
-            nav.q_bias = outputs[i].getDouble("q_bias");
-            nav.r_bias = outputs[i].getDouble("r_bias");
-            nav.ax_bias = outputs[i].getDouble("ax_bias");
-            nav.ay_bias = outputs[i].getDouble("ay_bias");
-            nav.az_bias = outputs[i].getDouble("az_bias");
+            nav.index = filters[i].index;
+            nav.timestamp_sec = output->getDouble("timestamp");
+            nav.latitude_deg = output->getDouble("latitude_deg");
+            nav.longitude_deg = output->getDouble("longitude_deg");
+            nav.altitude_m = output->getDouble("altitude_m");
+            nav.vn_ms = output->getDouble("vn_ms");
+            nav.ve_ms = output->getDouble("ve_ms");
+            nav.vd_ms = output->getDouble("vd_ms");
+            nav.roll_deg = output->getDouble("roll_deg");
+            nav.pitch_deg = output->getDouble("pitch_deg");
+            nav.yaw_deg = output->getDouble("heading_deg");
+            nav.p_bias = output->getDouble("p_bias");
+            nav.q_bias = output->getDouble("q_bias");
+            nav.r_bias = output->getDouble("r_bias");
+            nav.ax_bias = output->getDouble("ax_bias");
+            nav.ay_bias = output->getDouble("ay_bias");
+            nav.az_bias = output->getDouble("az_bias");
             nav.sequence_num = remote_link_node.getLong("sequence_num");
-            nav.status = 0;
+	    // bit 0: in use, bit 1: disagrees with the one in use
+            nav.status = (i == selected ? 1 : 0)
+		| (filters[i].crosscheck > 1.0 ? 2 : 0);
             nav.pack();
 	    if ( send_remote_link ) {
 		remote_link->send_message( nav.id, nav.payload, nav.len );
@@ -340,18 +660,24 @@ bool Filter_update() {
 
 
 void Filter_close() {
-    // traverse configured modules
-    for ( unsigned int i = 0; i < sections.size(); i++ ) {
-	string module = sections[i].getString("module");
-	bool enabled = sections[i].getBool("enable");
-	if ( !enabled ) {
-	    continue;
+    cal_learn_close();
+
+    if ( workers.size() ) {
+	pthread_mutex_lock( &work_mutex );
+	work_stop = true;
+	pthread_cond_broadcast( &work_cond );
+	pthread_mutex_unlock( &work_mutex );
+	for ( unsigned int i = 0; i < workers.size(); i++ ) {
+	    pthread_join( workers[i]->thread, NULL );
+	    delete workers[i];
 	}
-	if ( module == "null" ) {
-	    // do nothing
-	} else if ( module == "nav-ekf15" ) {
+	workers.clear();
+    }
+
+    for ( unsigned int i = 0; i < filters.size(); i++ ) {
+	if ( filters[i].module == FILTER_EKF15 ) {
 	    nav_ekf15_close();
-	} else if ( module == "nav-ekf15-mag" ) {
+	} else if ( filters[i].module == FILTER_EKF15_MAG ) {
 	    nav_ekf15_mag_close();
 	}
     }
@@ -11,6 +11,20 @@
 
 #pragma once
 
+// Every enabled section under /config/filters runs each frame on the
+// same imu/gps inputs.  With /config/filter_parallel set the extra
+// filters run on worker threads (see runtime worker_cpus) while the
+// first one runs on the main thread, so a redundant filter costs
+// about one filter's time.
+//
+// The filters are cross checked against the one in use (position,
+// velocity and attitude differences scaled by the tolerances under
+// /config/filter_crosscheck: att_tol_deg, pos_tol_m, vel_tol_mps.)
+// A disagreement that lasts persist_sec, or the filter in use going
+// invalid, hands over to the valid filter closest to the gps.  The
+// filter in use is published as /filters/selected.
+
 void Filter_init();
+bool Filter_start();
 bool Filter_update();
 void Filter_close();
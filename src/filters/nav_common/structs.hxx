@@ -27,6 +27,8 @@ struct GPSdata {
     float alt;                  // meter
     float vn, ve, vd;		// m/sec
     int sats;
+    float tov;			// time of validity on the imu clock
+				// (seconds, 0 if unknown)
 };
 
 struct Airdata {
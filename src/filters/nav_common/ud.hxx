@@ -0,0 +1,121 @@
+/*! \file ud.hxx
+ *	\brief UD factorized covariance kernels
+ *
+ *	\details Covariance kept as P = U*D*U' with U unit upper
+ *	triangular and D diagonal.  The time update is Thornton's
+ *	modified weighted Gram-Schmidt and the measurement update is
+ *	Bierman's scalar update, one (uncorrelated) measurement row at a
+ *	time.  Neither ever forms P, both keep D positive by
+ *	construction, and so neither needs symmetrizing.  That is what
+ *	lets the filters run their covariance in single precision.
+ *
+ *	Written in plain fixed size Eigen row/column operations so the
+ *	inner loops vectorize (NEON on the arm boards).
+ */
+
+#pragma once
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+// factor a symmetric positive definite P into U and D
+template<int N>
+void ud_factor( const Matrix<float,N,N> &P,
+		Matrix<float,N,N> *U, Matrix<float,N,1> *D )
+{
+    U->setIdentity();
+    for ( int j = N - 1; j >= 0; j-- ) {
+	float d = P(j,j);
+	for ( int k = j + 1; k < N; k++ ) {
+	    d -= (*U)(j,k) * (*U)(j,k) * (*D)(k);
+	}
+	(*D)(j) = d;
+	float dinv = ( d > 0.0f ) ? 1.0f / d : 0.0f;
+	for ( int i = 0; i < j; i++ ) {
+	    float s = P(i,j);
+	    for ( int k = j + 1; k < N; k++ ) {
+		s -= (*U)(i,k) * (*U)(j,k) * (*D)(k);
+	    }
+	    (*U)(i,j) = s * dinv;
+	}
+    }
+}
+
+// diagonal of P = U*D*U'
+template<int N>
+Matrix<float,N,1> ud_diagonal( const Matrix<float,N,N> &U,
+			       const Matrix<float,N,1> &D )
+{
+    Matrix<float,N,1> p;
+    for ( int i = 0; i < N; i++ ) {
+	p(i) = U.row(i).tail(N - i).cwiseAbs2().dot( D.tail(N - i) );
+    }
+    return p;
+}
+
+// P = PHI*P*PHI' + G*diag(q)*G'
+//
+// The rows of W = [ PHI*U | G ] are orthogonalized against the
+// weights [ D | q ], last row first.  Cost is about N^2 * (N + M)
+// multiply-adds, in line with the dense PHI*P*PHI'.
+template<int N, int M>
+void ud_time_update( const Matrix<float,N,N> &PHI,
+		     const Matrix<float,N,M> &G,
+		     const Matrix<float,M,1> &q,
+		     Matrix<float,N,N> *U, Matrix<float,N,1> *D )
+{
+    Matrix<float,N,N+M> W;
+    W.template leftCols<N>().noalias() = PHI * (*U);
+    W.template rightCols<M>() = G;
+    Matrix<float,1,N+M> Dw;
+    Dw.template leftCols<N>() = D->transpose();
+    Dw.template rightCols<M>() = q.transpose();
+
+    U->setIdentity();
+    for ( int j = N - 1; j >= 0; j-- ) {
+	Matrix<float,1,N+M> c = W.row(j).cwiseProduct( Dw );
+	float d = c.dot( W.row(j) );
+	(*D)(j) = d;
+	if ( d <= 0.0f ) {
+	    // nothing left in this direction
+	    continue;
+	}
+	c /= d;
+	for ( int i = 0; i < j; i++ ) {
+	    float u = W.row(i).dot( c );
+	    (*U)(i,j) = u;
+	    W.row(i) -= u * W.row(j);
+	}
+    }
+}
+
+// scalar measurement z = h*x + v, var(v) = r
+//
+// Updates U and D and adds the correction to the error state x
+// (which the caller starts at zero for each batch of rows.)  The
+// residual is taken against x, so the rows of one measurement can be
+// processed one after the other.
+template<int N>
+void ud_measurement_update( const Matrix<float,1,N> &h, float z, float r,
+			    Matrix<float,N,N> *U, Matrix<float,N,1> *D,
+			    Matrix<float,N,1> *x )
+{
+    Matrix<float,N,1> f = U->transpose() * h.transpose();
+    Matrix<float,N,1> v = D->cwiseProduct( f );
+    Matrix<float,N,1> b;
+    float alpha = r;
+    for ( int j = 0; j < N; j++ ) {
+	float alpha_prev = alpha;
+	alpha += f(j) * v(j);
+	(*D)(j) *= alpha_prev / alpha;
+	float lambda = -f(j) / alpha_prev;
+	for ( int i = 0; i < j; i++ ) {
+	    float u = (*U)(i,j);
+	    (*U)(i,j) = u + lambda * b(i);
+	    b(i) += u * v(j);
+	}
+	b(j) = v(j);
+    }
+    float innov = z - h.dot( *x );
+    *x += b * (innov / alpha);
+}
@@ -20,6 +20,7 @@ using std::endl;
 #include <stdio.h>
 
 #include "../nav_common/nav_functions_float.hxx"
+#include "../nav_common/ud.hxx"
 #include "EKF_15state.hxx"
 
 const float P_P_INIT = 10.0;
@@ -97,6 +98,9 @@ void EKF15::init(IMUdata imu, GPSdata gps) {
     P(6,6) = P_A_INIT*P_A_INIT; 	P(7,7) = P_A_INIT*P_A_INIT; 	      P(8,8) = P_HDG_INIT*P_HDG_INIT;
     P(9,9) = P_AB_INIT*P_AB_INIT; 	P(10,10) = P_AB_INIT*P_AB_INIT;       P(11,11) = P_AB_INIT*P_AB_INIT;
     P(12,12) = P_GB_INIT*P_GB_INIT; 	P(13,13) = P_GB_INIT*P_GB_INIT;       P(14,14) = P_GB_INIT*P_GB_INIT;
+    if ( ud ) {
+        ud_factor<15>(P, &U, &D);
+    }
 	
     // ... R
     R.setZero();
@@ -150,6 +154,9 @@ void EKF15::init(IMUdata imu, GPSdata gps) {
 	
     nav.time = imu.time;
     nav.err_type = data_valid;
+
+    history_count = 0;
+    replay_steps = 0;
 }
 
 // Main get_nav filter function
@@ -274,14 +281,21 @@ void EKF15::time_update(IMUdata imu) {
     G(9,6) = 1.0; 	    G(10,7) = 1.0; 	    G(11,8) = 1.0;
     G(12,9) = 1.0; 	    G(13,10) = 1.0; 	    G(14,11) = 1.0;
 
-    // Discrete Process Noise
-    Qw = G * Rw * G.transpose() * imu_dt;		// Qw = dt*G*Rw*G'
-    Q = PHI * Qw;					// Q = (I+F*dt)*Qw
-    Q = (Q + Q.transpose()) * 0.5;			// Q = 0.5*(Q+Q')
-	
-    // Covariance Time Update
-    P = PHI * P * PHI.transpose() + Q;			// P = PHI*P*PHI' + Q
-    P = (P + P.transpose()) * 0.5;			// P = 0.5*(P+P')
+    if ( ud ) {
+        // Covariance Time Update, factored: P = PHI*P*PHI' + G*Rw*G'*dt
+        Vector12f q = Rw.diagonal() * imu_dt;
+        ud_time_update<15,12>(PHI, G, q, &U, &D);
+        P.diagonal() = ud_diagonal<15>(U, D);
+    } else {
+        // Discrete Process Noise
+        Qw = G * Rw * G.transpose() * imu_dt;		// Qw = dt*G*Rw*G'
+        Q = PHI * Qw;					// Q = (I+F*dt)*Qw
+        Q = (Q + Q.transpose()) * 0.5;			// Q = 0.5*(Q+Q')
+
+        // Covariance Time Update
+        P = PHI * P * PHI.transpose() + Q;		// P = PHI*P*PHI' + Q
+        P = (P + P.transpose()) * 0.5;			// P = 0.5*(P+P')
+    }
 	
     nav.Pp0 = P(0,0);     nav.Pp1 = P(1,1);     nav.Pp2 = P(2,2);
     nav.Pv0 = P(3,3);     nav.Pv1 = P(4,4);     nav.Pv2 = P(5,5);
@@ -289,10 +303,88 @@ void EKF15::time_update(IMUdata imu) {
     nav.Pabx = P(9,9);    nav.Paby = P(10,10);  nav.Pabz = P(11,11);
     nav.Pgbx = P(12,12);  nav.Pgby = P(13,13);  nav.Pgbz = P(14,14);
 
+    if ( latency_comp ) {
+        history_head = (history_head + 1) % history_size;
+        if ( history_count < history_size ) {
+            history_count++;
+        }
+        save_state( &history[history_head] );
+    }
+
     // ==================  DONE TU  ===================
 }
 
+void EKF15::save_state(snapshot_t *s) {
+    s->imu = imu_last;
+    s->nav = nav;
+    s->quat = quat;
+    if ( ud ) {
+        s->U = U;
+        s->D = D;
+    } else {
+        s->P = P;
+    }
+}
+
+void EKF15::restore_state(const snapshot_t *s) {
+    imu_last = s->imu;
+    nav = s->nav;
+    quat = s->quat;
+    if ( ud ) {
+        U = s->U;
+        D = s->D;
+        P.diagonal() = ud_diagonal<15>(U, D);
+    } else {
+        P = s->P;
+    }
+}
+
 void EKF15::measurement_update(GPSdata gps) {
+    replay_steps = 0;
+    replay_short_sec = 0.0;
+    if ( !latency_comp || gps.tov <= 0.0 || history_count == 0 ) {
+        fuse_gps(gps);
+        if ( latency_comp && history_count > 0 ) {
+            save_state( &history[history_head] );
+        }
+        return;
+    }
+
+    // newest stored state at or before the time of validity (the
+    // oldest one if the fix is older than the whole ring)
+    int back = 0;
+    int slot = history_head;
+    while ( back < history_count - 1 && history[slot].imu.time > gps.tov ) {
+        slot = (slot + history_size - 1) % history_size;
+        back++;
+    }
+    if ( history_count == history_size && history[slot].imu.time > gps.tov ) {
+        replay_short_sec = history[slot].imu.time - gps.tov;
+    }
+    if ( back == 0 ) {
+        // keep the head in step so a later roll back starts from the
+        // fused state
+        fuse_gps(gps);
+        save_state( &history[history_head] );
+        return;
+    }
+
+    // roll back, update, and re-propagate over the same imu samples.
+    // time_update() rewrites the ring as it goes, so a later fix that
+    // rolls back into this span starts from the corrected states.
+    restore_state( &history[slot] );
+    fuse_gps(gps);
+    save_state( &history[slot] );
+    history_head = slot;
+    history_count -= back;
+    for ( int i = 0; i < back; i++ ) {
+        IMUdata imu = history[(slot + 1 + i) % history_size].imu;
+        time_update(imu);
+    }
+    replay_steps = back;
+}
+
+void EKF15::fuse_gps(GPSdata gps) {
     // ==================  GPS Update  ===================
 		
     // Position, converted to NED
@@ -320,17 +412,28 @@ void EKF15::measurement_update(GPSdata gps) {
     y(4) = gps.ve - nav.ve;
     y(5) = gps.vd - nav.vd;
 		
-    // Kalman Gain
-    // K = P*H'*inv(H*P*H'+R)
-    K = P * H.transpose() * (H * P * H.transpose() + R).inverse();
-		
-    // Covariance Update
-    ImKH = I15 - K * H;	                // ImKH = I - K*H
-		
-    KRKt = K * R * K.transpose();		// KRKt = K*R*K'
-		
-    P = ImKH * P * ImKH.transpose() + KRKt;	// P = ImKH*P*ImKH' + KRKt
-		
+    if ( ud ) {
+        // R is diagonal, so one row at a time (Bierman) is exact
+        x.setZero();
+        for ( int i = 0; i < 6; i++ ) {
+            ud_measurement_update<15>(H.row(i), y(i), R(i,i), &U, &D, &x);
+        }
+        P.diagonal() = ud_diagonal<15>(U, D);
+    } else {
+        // Kalman Gain
+        // K = P*H'*inv(H*P*H'+R)
+        K = P * H.transpose() * (H * P * H.transpose() + R).inverse();
+
+        // Covariance Update
+        ImKH = I15 - K * H;	                // ImKH = I - K*H
+
+        KRKt = K * R * K.transpose();		// KRKt = K*R*K'
+
+        P = ImKH * P * ImKH.transpose() + KRKt;	// P = ImKH*P*ImKH' + KRKt
+
+        x = K * y;
+    }
+
     nav.Pp0 = P(0,0);     nav.Pp1 = P(1,1);     nav.Pp2 = P(2,2);
     nav.Pv0 = P(3,3);     nav.Pv1 = P(4,4);     nav.Pv2 = P(5,5);
     nav.Pa0 = P(6,6);     nav.Pa1 = P(7,7);     nav.Pa2 = P(8,8);
@@ -338,7 +441,6 @@ void EKF15::measurement_update(GPSdata gps) {
     nav.Pgbx = P(12,12);  nav.Pgby = P(13,13);  nav.Pgbz = P(14,14);
 		
     // State Update
-    x = K * y;
     double denom = fabs(1.0 - (ECC2 * sin(nav.lat) * sin(nav.lat)));
     double denom_sqrt = sqrt(denom);
     double Re = EarthRadius / denom_sqrt;
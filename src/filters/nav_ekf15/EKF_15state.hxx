@@ -36,13 +36,21 @@ typedef Matrix<float,6,15> Matrix6x15f;
 typedef Matrix<float,15,6> Matrix15x6f;
 typedef Matrix<float,15,12> Matrix15x12f;
 typedef Matrix<float,6,1> Vector6f;
+typedef Matrix<float,12,1> Vector12f;
 typedef Matrix<float,15,1> Vector15f;
 
 class EKF15 {
 
 public:
 
-    EKF15() {
+    EKF15():
+	ud(false),
+	latency_comp(false),
+	history_head(0),
+	history_count(0),
+	replay_steps(0),
+	replay_short_sec(0.0)
+    {
 	default_config();
     }
     ~EKF15() {}
@@ -52,6 +60,25 @@ public:
     NAVconfig get_config();
     void default_config();
 
+    // keep the covariance factored as U*D*U' (float safe, no
+    // symmetrizing needed) instead of a dense P.  Set before init().
+    void set_ud_covariance(bool enable) { ud = enable; }
+
+    // fuse each gps fix at its time of validity (gps.tov) instead of
+    // the current imu time: roll back to the stored state at tov,
+    // update, and re-run the time updates since.
+    void set_gps_latency_comp(bool enable) { latency_comp = enable; }
+
+    // time updates re-run by the last measurement_update(), at most
+    // history_size - 1
+    int get_replay_steps() { return replay_steps; }
+
+    // how much older than the oldest stored state the last fix's tov
+    // was, once the ring is full (0 when it reached back far enough.)
+    // Anything above zero means the gps latency is deeper than the
+    // ring.
+    double get_replay_shortfall() { return replay_short_sec; }
+
     // main interface
     void init(IMUdata imu, GPSdata gps);
     void time_update(IMUdata imu);
@@ -73,8 +100,36 @@ private:
     Vector3d pos_ins_ecef, pos_gps, pos_gps_ecef;
     Vector3f grav, f_b, om_ib, /*nr,*/ pos_ins_ned, pos_gps_ned, dx, mag_ned;
 
+    // UD mode: P = U*D*U', and only the diagonal of P is kept up to
+    // date (for the nav.P* outputs)
+    bool ud;
+    Matrix15f U;
+    Vector15f D;
+
     Quaternionf quat;
 
+    // gps latency compensation: the imu sample and the resulting
+    // filter state of the most recent time updates, in a fixed ring
+    // (32 samples is 320ms at 100hz.)
+    struct snapshot_t {
+	IMUdata imu;
+	NAVdata nav;
+	Quaternionf quat;
+	Matrix15f P;		// dense mode
+	Matrix15f U;		// UD mode
+	Vector15f D;
+    };
+    static const int history_size = 32;
+    snapshot_t history[history_size];
+    bool latency_comp;
+    int history_head;		// newest
+    int history_count;
+    int replay_steps;
+    double replay_short_sec;
+    void fuse_gps(GPSdata gps);
+    void save_state(snapshot_t *s);
+    void restore_state(const snapshot_t *s);
+
     IMUdata imu_last;
     NAVconfig config;
     NAVdata nav;
@@ -6,10 +6,13 @@
 #include <pyprops.hxx>
 
 #include <math.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "include/globaldefs.h"
 #include "sensors/gps_mgr.hxx"
+#include "util/myprof.hxx"
+#include "util/timing.h"
 
 #include "../nav_common/constants.hxx"
 
@@ -33,6 +36,14 @@ static pyPropertyNode filter_node;
 
 // when false will trigger a nav init if gps is alive and settled
 static bool nav_inited = false;
+static bool gps_ready = false;
+static double last_gps_time = 0.0;
+
+// gps latency compensation
+static bool latency_comp = false;
+static double gps_latency_sec = 0.0; // for gps drivers without a tov
+static double gps_update_sec = 0.0;  // run time of the last fix (step)
+static bool replay_short_warned = false;
 
 // update the imu_data and gps_data structures with most recent sensor
 // data prior to calling the filter init or update routines
@@ -55,6 +66,13 @@ static void props2umn(void) {
     gps_data.vn = gps_node.getDouble("vn_ms");
     gps_data.ve = gps_node.getDouble("ve_ms");
     gps_data.vd = gps_node.getDouble("vd_ms");
+    gps_data.tov = 0.0;
+    if ( latency_comp ) {
+	gps_data.tov = gps_node.getDouble("tov_timestamp");
+	if ( gps_data.tov <= 0.0 && gps_latency_sec > 0.0 ) {
+	    gps_data.tov = gps_data.time - gps_latency_sec;
+	}
+    }
 }
 
 // update the property tree values from the nav_data structure
@@ -108,6 +126,23 @@ void nav_ekf15_init( string output_path, pyPropertyNode *config ) {
     filter_node = pyGetNode(output_path, true);
     filter_node.setString( "navigation", "invalid" );
 
+    // covariance: "dense" (default) or "ud" (factored, float safe)
+    if ( config->getString("covariance") == "ud" ) {
+	printf("%s: UD factored covariance\n", output_path.c_str());
+	filter.set_ud_covariance( true );
+    }
+
+    // fuse the gps at its time of validity: the driver's
+    // tov_timestamp, or timestamp - gps_latency_sec without one
+    if ( config->getBool("gps_latency_comp") ) {
+	latency_comp = true;
+	if ( config->hasChild("gps_latency_sec") ) {
+	    gps_latency_sec = config->getDouble("gps_latency_sec");
+	}
+	printf("%s: gps latency compensation\n", output_path.c_str());
+	filter.set_gps_latency_comp( true );
+    }
+
 #if 0
     // set tuning value for specific gps and imu noise characteristics
     cov_gps_hpos_node = config.getChild("cov-gps-hpos", 0, true);
@@ -128,31 +163,59 @@ void nav_ekf15_reset() {
     nav_inited = false;
 }
 
-bool nav_ekf15_update() {
-    static double last_gps_time = 0.0;
-
+void nav_ekf15_begin() {
     // fill in the UMN structures
     props2umn();
+    gps_ready = GPS_age() < 1.0 && gps_node.getBool("settle");
+}
 
+bool nav_ekf15_step() {
     if ( nav_inited ) {
 	filter.time_update( imu_data );
         if ( gps_data.time > last_gps_time ) {
             last_gps_time = gps_data.time;
+            double start = get_HostTime();
             filter.measurement_update( gps_data );
+            gps_update_sec = get_HostTime() - start;
         }
         nav_data = filter.get_nav();
     } else {
-	if ( GPS_age() < 1.0 && gps_node.getBool("settle") ) {
+	if ( gps_ready ) {
 	    filter.init( imu_data, gps_data );
             nav_data = filter.get_nav();
 	    nav_inited = true;
 	}
     }
+    return nav_inited;
+}
 
+void nav_ekf15_end() {
     // copy the nav_data results back to the property tree
     umn2props();
 
-    return nav_inited;
+    // step() may have run on a worker thread, so the profiler sees
+    // the gps update (with any replay) from here
+    if ( gps_update_sec > 0.0 ) {
+	filter_gps_prof.add( gps_update_sec );
+	filter_node.setLong( "gps_replay_steps", filter.get_replay_steps() );
+	// the fix was older than the replay history: the latency (or
+	// the driver's tov) doesn't fit, the update lands late
+	double short_sec = filter.get_replay_shortfall();
+	filter_node.setDouble( "gps_replay_short_sec", short_sec );
+	if ( short_sec > 0.0 && !replay_short_warned ) {
+	    printf("ekf15: gps tov %.3f sec older than the replay history\n",
+		   short_sec);
+	    replay_short_warned = true;
+	}
+	gps_update_sec = 0.0;
+    }
+}
+
+bool nav_ekf15_update() {
+    nav_ekf15_begin();
+    bool result = nav_ekf15_step();
+    nav_ekf15_end();
+    return result;
 }
 
 
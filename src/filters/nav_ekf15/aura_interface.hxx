@@ -12,5 +12,16 @@ using std::string;
 
 void nav_ekf15_init( string output_path, pyPropertyNode *config );
 void nav_ekf15_reset();
+
+// The update is split so the filter math can run off the main thread:
+// begin() copies the sensor inputs out of the property tree, step()
+// runs the filter on that copy without touching any properties, and
+// end() publishes the result.  begin() and end() must be called from
+// the main thread.
+void nav_ekf15_begin();
+bool nav_ekf15_step();
+void nav_ekf15_end();
+
+// begin(), step() and end() in one call
 bool nav_ekf15_update();
 void nav_ekf15_close();
@@ -0,0 +1,389 @@
+// ekf15_ud_test.cxx -- run the dense and the UD factored covariance
+//                      versions of the 15 state ekf side by side and
+//                      check that they agree, then check the gps
+//                      latency replay reaches back as far as the
+//                      latency
+//
+// usage: ekf15_ud_test [flight_dir]
+//
+// flight_dir is the output of tools/auralink/auraexport_csv.py for a
+// recorded flight (imu.csv and gps.csv are used.)  Without one a
+// synthetic level flight is generated.  Exits non-zero if the two
+// solutions drift apart or either one goes non-finite.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+using std::map;
+using std::string;
+using std::vector;
+
+#include "../nav_common/constants.hxx"
+#include "EKF_15state.hxx"
+
+// divergence tolerances
+static const double att_tol_deg = 0.5;
+static const double hdg_tol_deg = 2.0;	// barely observable in straight flight
+static const double pos_tol_m = 2.0;
+static const double vel_tol_mps = 0.2;
+static const double sigma_tol = 0.1; // relative, on sqrt(P(i,i))
+
+struct record_t {
+    bool is_gps;
+    IMUdata imu;
+    GPSdata gps;
+};
+
+// read an exported csv file into rows of named columns
+static bool read_csv( string file, vector< map<string, double> > *rows ) {
+    FILE *fp = fopen( file.c_str(), "r" );
+    if ( fp == NULL ) {
+	printf("cannot open %s\n", file.c_str());
+	return false;
+    }
+    char line[4096];
+    vector<string> names;
+    if ( fgets( line, sizeof(line), fp ) != NULL ) {
+	for ( char *tok = strtok( line, ",\r\n" ); tok != NULL;
+	      tok = strtok( NULL, ",\r\n" ) )
+	{
+	    names.push_back( tok );
+	}
+    }
+    while ( fgets( line, sizeof(line), fp ) != NULL ) {
+	map<string, double> row;
+	char *p = line;
+	for ( unsigned int i = 0; i < names.size(); i++ ) {
+	    char *end;
+	    row[names[i]] = strtod( p, &end );
+	    p = strchr( end, ',' );
+	    if ( p == NULL ) {
+		break;
+	    }
+	    p++;
+	}
+	rows->push_back( row );
+    }
+    fclose( fp );
+    return true;
+}
+
+// merge the imu and gps records in time order
+static bool load_flight( string dir, vector<record_t> *records ) {
+    vector< map<string, double> > imu_rows, gps_rows;
+    if ( !read_csv( dir + "/imu.csv", &imu_rows )
+	 || !read_csv( dir + "/gps.csv", &gps_rows ) ) {
+	return false;
+    }
+    unsigned int j = 0;
+    for ( unsigned int i = 0; i < imu_rows.size(); i++ ) {
+	map<string, double> &r = imu_rows[i];
+	while ( j < gps_rows.size() && gps_rows[j]["timestamp"] <= r["timestamp"] ) {
+	    map<string, double> &g = gps_rows[j++];
+	    if ( g["fix_type"] < 3 ) {
+		continue;
+	    }
+	    record_t rec;
+	    memset( &rec, 0, sizeof(rec) );
+	    rec.is_gps = true;
+	    rec.gps.time = g["timestamp"];
+	    rec.gps.lat = g["latitude_deg"];
+	    rec.gps.lon = g["longitude_deg"];
+	    rec.gps.alt = g["altitude_m"];
+	    rec.gps.vn = g["vn_ms"];
+	    rec.gps.ve = g["ve_ms"];
+	    rec.gps.vd = g["vd_ms"];
+	    records->push_back( rec );
+	}
+	record_t rec;
+	memset( &rec, 0, sizeof(rec) );
+	rec.is_gps = false;
+	rec.imu.time = r["timestamp"];
+	rec.imu.p = r["p_rad_sec"];
+	rec.imu.q = r["q_rad_sec"];
+	rec.imu.r = r["r_rad_sec"];
+	rec.imu.ax = r["ax_mps_sec"];
+	rec.imu.ay = r["ay_mps_sec"];
+	rec.imu.az = r["az_mps_sec"];
+	rec.imu.hx = r["hx"];
+	rec.imu.hy = r["hy"];
+	rec.imu.hz = r["hz"];
+	records->push_back( rec );
+    }
+    return true;
+}
+
+static double noise( double sigma ) {
+    // sum of uniforms, close enough to gaussian here
+    double sum = 0.0;
+    for ( int i = 0; i < 12; i++ ) {
+	sum += drand48();
+    }
+    return (sum - 6.0) * sigma;
+}
+
+// 10 minutes of 100hz imu and 5hz gps, level flight north at 20 m/s
+// with a small gyro and accel bias
+static void synthetic_flight( vector<record_t> *records ) {
+    srand48( 1 );
+    double lat = 45.0;
+    double lon = -93.0;
+    for ( int i = 0; i < 60000; i++ ) {
+	double t = i * 0.01;
+	if ( i % 20 == 0 ) {
+	    record_t rec;
+	    memset( &rec, 0, sizeof(rec) );
+	    rec.is_gps = true;
+	    rec.gps.time = t;
+	    rec.gps.lat = lat + (20.0 * t + noise(2.0)) / 6378137.0 * R2D;
+	    rec.gps.lon = lon + noise(2.0) / (6378137.0 * cos(lat * D2R)) * R2D;
+	    rec.gps.alt = 300.0 + noise(4.0);
+	    rec.gps.vn = 20.0 + noise(0.3);
+	    rec.gps.ve = noise(0.3);
+	    rec.gps.vd = noise(0.5);
+	    records->push_back( rec );
+	}
+	record_t rec;
+	memset( &rec, 0, sizeof(rec) );
+	rec.is_gps = false;
+	rec.imu.time = t;
+	rec.imu.p = 0.002 + noise(0.00175);
+	rec.imu.q = -0.001 + noise(0.00175);
+	rec.imu.r = 0.001 + noise(0.00175);
+	rec.imu.ax = 0.05 + noise(0.05);
+	rec.imu.ay = noise(0.05);
+	rec.imu.az = -g + noise(0.05);
+	rec.imu.hx = 0.35;
+	rec.imu.hy = 0.0;
+	rec.imu.hz = 0.9;
+	records->push_back( rec );
+    }
+}
+
+static double angle_diff( double a, double b ) {
+    double d = a - b;
+    while ( d > M_PI ) { d -= 2.0 * M_PI; }
+    while ( d < -M_PI ) { d += 2.0 * M_PI; }
+    return fabs( d );
+}
+
+// deliver each fix latency_sec late (with its tov set), returns the
+// largest replay and shortfall seen
+static void replay_depth( const vector<record_t> &records, double latency_sec,
+			  int *max_steps, double *max_short ) {
+    EKF15 filter;
+    filter.set_gps_latency_comp( true );
+    vector<GPSdata> pending;
+    bool inited = false;
+    *max_steps = 0;
+    *max_short = 0.0;
+    for ( unsigned int i = 0; i < records.size() && i < 6000; i++ ) {
+	const record_t &rec = records[i];
+	if ( rec.is_gps ) {
+	    GPSdata gps = rec.gps;
+	    gps.tov = gps.time;
+	    gps.time += latency_sec;
+	    pending.push_back( gps );
+	    continue;
+	}
+	if ( !inited ) {
+	    if ( !pending.empty() ) {
+		filter.init( rec.imu, pending[0] );
+		pending.clear();
+		inited = true;
+	    }
+	    continue;
+	}
+	filter.time_update( rec.imu );
+	while ( !pending.empty() && pending[0].time <= rec.imu.time + 0.0001 ) {
+	    filter.measurement_update( pending[0] );
+	    pending.erase( pending.begin() );
+	    *max_steps = std::max( *max_steps, filter.get_replay_steps() );
+	    *max_short = std::max( *max_short, filter.get_replay_shortfall() );
+	}
+    }
+}
+
+// a fix fused at the newest stored state and then a late fix rolling
+// back to that same state has to match fusing both in place
+static double rollback_after_fuse( const vector<record_t> &records ) {
+    EKF15 comp, plain;
+    comp.set_gps_latency_comp( true );
+    bool inited = false;
+    int imu_count = 0;
+    double imu_time = 0.0;
+    GPSdata late;
+    int late_at = -1;
+    for ( unsigned int i = 0; i < records.size(); i++ ) {
+	const record_t &rec = records[i];
+	if ( rec.is_gps ) {
+	    if ( !inited ) {
+		continue;
+	    }
+	    if ( late_at < 0 && imu_count > 200 ) {
+		// on time: fused at the head of the ring
+		GPSdata gps = rec.gps;
+		gps.tov = imu_time;
+		comp.measurement_update( gps );
+		plain.measurement_update( gps );
+		// the same fix again, delivered 10 samples late
+		late = gps;
+		plain.measurement_update( late );
+		late_at = imu_count + 10;
+	    }
+	    continue;
+	}
+	if ( !inited ) {
+	    for ( unsigned int j = i + 1; j < records.size(); j++ ) {
+		if ( records[j].is_gps ) {
+		    comp.init( rec.imu, records[j].gps );
+		    plain.init( rec.imu, records[j].gps );
+		    inited = true;
+		    break;
+		}
+	    }
+	    continue;
+	}
+	comp.time_update( rec.imu );
+	plain.time_update( rec.imu );
+	imu_time = rec.imu.time;
+	imu_count++;
+	if ( imu_count == late_at ) {
+	    comp.measurement_update( late );
+	    NAVdata a = comp.get_nav();
+	    NAVdata b = plain.get_nav();
+	    double dn = (a.lat - b.lat) * 6378137.0;
+	    double de = (a.lon - b.lon) * 6378137.0 * cos(a.lat);
+	    return sqrt( dn*dn + de*de + (a.alt - b.alt)*(a.alt - b.alt) );
+	}
+    }
+    return 1.0e9;
+}
+
+int main( int argc, char **argv ) {
+    vector<record_t> records;
+    if ( argc > 1 ) {
+	if ( !load_flight( argv[1], &records ) ) {
+	    return 1;
+	}
+    } else {
+	synthetic_flight( &records );
+    }
+    printf("%d records\n", (int)records.size());
+
+    EKF15 dense, ud;
+    ud.set_ud_covariance( true );
+
+    bool inited = false;
+    bool have_imu = false;
+    IMUdata imu;
+    double max_att = 0.0, max_hdg = 0.0, max_pos = 0.0, max_vel = 0.0, max_sigma = 0.0;
+    int updates = 0;
+    for ( unsigned int i = 0; i < records.size(); i++ ) {
+	record_t &rec = records[i];
+	if ( !rec.is_gps ) {
+	    imu = rec.imu;
+	    have_imu = true;
+	    if ( inited ) {
+		dense.time_update( imu );
+		ud.time_update( imu );
+	    }
+	    continue;
+	}
+	if ( !have_imu ) {
+	    continue;
+	}
+	if ( !inited ) {
+	    dense.init( imu, rec.gps );
+	    ud.init( imu, rec.gps );
+	    inited = true;
+	    continue;
+	}
+	dense.measurement_update( rec.gps );
+	ud.measurement_update( rec.gps );
+	updates++;
+
+	NAVdata a = dense.get_nav();
+	NAVdata b = ud.get_nav();
+	double att = R2D * std::max( angle_diff(a.phi, b.phi),
+				     angle_diff(a.the, b.the) );
+	double hdg = R2D * angle_diff(a.psi, b.psi);
+	double dn = (a.lat - b.lat) * 6378137.0;
+	double de = (a.lon - b.lon) * 6378137.0 * cos(a.lat);
+	double pos = sqrt( dn*dn + de*de + (a.alt - b.alt)*(a.alt - b.alt) );
+	double dvn = a.vn - b.vn, dve = a.ve - b.ve, dvd = a.vd - b.vd;
+	double vel = sqrt( dvn*dvn + dve*dve + dvd*dvd );
+	float pa[15] = { a.Pp0, a.Pp1, a.Pp2, a.Pv0, a.Pv1, a.Pv2,
+			 a.Pa0, a.Pa1, a.Pa2, a.Pabx, a.Paby, a.Pabz,
+			 a.Pgbx, a.Pgby, a.Pgbz };
+	float pb[15] = { b.Pp0, b.Pp1, b.Pp2, b.Pv0, b.Pv1, b.Pv2,
+			 b.Pa0, b.Pa1, b.Pa2, b.Pabx, b.Paby, b.Pabz,
+			 b.Pgbx, b.Pgby, b.Pgbz };
+	double sigma = 0.0;
+	for ( int j = 0; j < 15; j++ ) {
+	    if ( !(pb[j] > 0.0) ) {
+		sigma = 1.0e9;	// lost positive definiteness (or nan)
+		break;
+	    }
+	    double s = fabs( sqrt(pb[j]) / sqrt(fabs(pa[j])) - 1.0 );
+	    if ( s > sigma ) { sigma = s; }
+	}
+	if ( !(att == att) || !(hdg == hdg) || !(pos == pos) || !(vel == vel) ) {
+	    printf("non-finite solution at t = %.2f\n", rec.gps.time);
+	    return 1;
+	}
+	if ( att > max_att ) { max_att = att; }
+	if ( hdg > max_hdg ) { max_hdg = hdg; }
+	if ( pos > max_pos ) { max_pos = pos; }
+	if ( vel > max_vel ) { max_vel = vel; }
+	if ( sigma > max_sigma ) { max_sigma = sigma; }
+    }
+
+    printf("%d gps updates\n", updates);
+    printf("max difference: att %.4f deg  hdg %.4f deg  pos %.3f m  vel %.4f m/s  sigma %.4f\n",
+	   max_att, max_hdg, max_pos, max_vel, max_sigma);
+    if ( updates == 0 ) {
+	printf("FAIL: no gps updates\n");
+	return 1;
+    }
+    if ( max_att > att_tol_deg || max_hdg > hdg_tol_deg || max_pos > pos_tol_m
+	 || max_vel > vel_tol_mps || max_sigma > sigma_tol ) {
+	printf("FAIL: dense and UD solutions diverged\n");
+	return 1;
+    }
+
+    // 150ms fits the 32 sample (320ms at 100hz) ring, 500ms doesn't
+    // and has to say so
+    if ( argc <= 1 ) {
+	int steps;
+	double short_sec;
+	replay_depth( records, 0.15, &steps, &short_sec );
+	printf("150ms latency: replay %d steps, short %.3f sec\n", steps,
+	       short_sec);
+	if ( steps < 14 || steps > 16 || short_sec > 0.0 ) {
+	    printf("FAIL: replay depth doesn't match the gps latency\n");
+	    return 1;
+	}
+	replay_depth( records, 0.5, &steps, &short_sec );
+	printf("500ms latency: replay %d steps, short %.3f sec\n", steps,
+	       short_sec);
+	if ( short_sec < 0.15 ) {
+	    printf("FAIL: replay shortfall not reported\n");
+	    return 1;
+	}
+	double pos = rollback_after_fuse( records );
+	printf("roll back over a fused state: pos %.6f m\n", pos);
+	if ( pos > 1.0e-6 ) {
+	    printf("FAIL: roll back lost the earlier fix\n");
+	    return 1;
+	}
+    }
+    printf("pass\n");
+    return 0;
+}
@@ -22,6 +22,7 @@ using std::endl;
 #include "../nav_common/constants.hxx"
 #include "../nav_common/coremag.h"
 #include "../nav_common/nav_functions_float.hxx"
+#include "../nav_common/ud.hxx"
 
 #include "EKF_15state.hxx"
 
@@ -100,6 +101,9 @@ void EKF15_mag::init(IMUdata imu, GPSdata gps) {
     P(6,6) = P_A_INIT*P_A_INIT; 	P(7,7) = P_A_INIT*P_A_INIT; 	      P(8,8) = P_HDG_INIT*P_HDG_INIT;
     P(9,9) = P_AB_INIT*P_AB_INIT; 	P(10,10) = P_AB_INIT*P_AB_INIT;       P(11,11) = P_AB_INIT*P_AB_INIT;
     P(12,12) = P_GB_INIT*P_GB_INIT; 	P(13,13) = P_GB_INIT*P_GB_INIT;       P(14,14) = P_GB_INIT*P_GB_INIT;
+    if ( ud ) {
+        ud_factor<15>(P, &U, &D);
+    }
 	
     // ... R
     R.setZero();
@@ -294,14 +298,21 @@ void EKF15_mag::time_update(IMUdata imu) {
     G(9,6) = 1.0; 	    G(10,7) = 1.0; 	    G(11,8) = 1.0;
     G(12,9) = 1.0; 	    G(13,10) = 1.0; 	    G(14,11) = 1.0;
 
-    // Discrete Process Noise
-    Qw = G * Rw * G.transpose() * imu_dt;		// Qw = dt*G*Rw*G'
-    Q = PHI * Qw;					// Q = (I+F*dt)*Qw
-    Q = (Q + Q.transpose()) * 0.5;			// Q = 0.5*(Q+Q')
-	
-    // Covariance Time Update
-    P = PHI * P * PHI.transpose() + Q;			// P = PHI*P*PHI' + Q
-    P = (P + P.transpose()) * 0.5;			// P = 0.5*(P+P')
+    if ( ud ) {
+        // Covariance Time Update, factored: P = PHI*P*PHI' + G*Rw*G'*dt
+        Vector12f q = Rw.diagonal() * imu_dt;
+        ud_time_update<15,12>(PHI, G, q, &U, &D);
+        P.diagonal() = ud_diagonal<15>(U, D);
+    } else {
+        // Discrete Process Noise
+        Qw = G * Rw * G.transpose() * imu_dt;		// Qw = dt*G*Rw*G'
+        Q = PHI * Qw;					// Q = (I+F*dt)*Qw
+        Q = (Q + Q.transpose()) * 0.5;			// Q = 0.5*(Q+Q')
+
+        // Covariance Time Update
+        P = PHI * P * PHI.transpose() + Q;		// P = PHI*P*PHI' + Q
+        P = (P + P.transpose()) * 0.5;			// P = 0.5*(P+P')
+    }
 	
     nav.Pp0 = P(0,0);     nav.Pp1 = P(1,1);     nav.Pp2 = P(2,2);
     nav.Pv0 = P(3,3);     nav.Pv1 = P(4,4);     nav.Pv2 = P(5,5);
@@ -374,17 +385,28 @@ void EKF15_mag::measurement_update(IMUdata imu, GPSdata gps) {
     y(7) = mag_error(1);
     y(8) = mag_error(2);
 	
-    // Kalman Gain
-    // K = P*H'*inv(H*P*H'+R)
-    K = P * H.transpose() * (H * P * H.transpose() + R).inverse();
-		
-    // Covariance Update
-    ImKH = I15 - K * H;	                // ImKH = I - K*H
-		
-    KRKt = K * R * K.transpose();		// KRKt = K*R*K'
-		
-    P = ImKH * P * ImKH.transpose() + KRKt;	// P = ImKH*P*ImKH' + KRKt
-		
+    if ( ud ) {
+        // R is diagonal, so one row at a time (Bierman) is exact
+        x.setZero();
+        for ( int i = 0; i < 9; i++ ) {
+            ud_measurement_update<15>(H.row(i), y(i), R(i,i), &U, &D, &x);
+        }
+        P.diagonal() = ud_diagonal<15>(U, D);
+    } else {
+        // Kalman Gain
+        // K = P*H'*inv(H*P*H'+R)
+        K = P * H.transpose() * (H * P * H.transpose() + R).inverse();
+
+        // Covariance Update
+        ImKH = I15 - K * H;	                // ImKH = I - K*H
+
+        KRKt = K * R * K.transpose();		// KRKt = K*R*K'
+
+        P = ImKH * P * ImKH.transpose() + KRKt;	// P = ImKH*P*ImKH' + KRKt
+
+        x = K * y;
+    }
+
     nav.Pp0 = P(0,0);     nav.Pp1 = P(1,1);     nav.Pp2 = P(2,2);
     nav.Pv0 = P(3,3);     nav.Pv1 = P(4,4);     nav.Pv2 = P(5,5);
     nav.Pa0 = P(6,6);     nav.Pa1 = P(7,7);     nav.Pa2 = P(8,8);
@@ -392,7 +414,6 @@ void EKF15_mag::measurement_update(IMUdata imu, GPSdata gps) {
     nav.Pgbx = P(12,12);  nav.Pgby = P(13,13);  nav.Pgbz = P(14,14);
 		
     // State Update
-    x = K * y;
     double denom = fabs(1.0 - (ECC2 * sin(nav.lat) * sin(nav.lat)));
     double denom_sqrt = sqrt(denom);
     double Re = EarthRadius / denom_sqrt;
@@ -35,13 +35,16 @@ typedef Matrix<float,9,15>  Matrix9x15f;
 typedef Matrix<float,15,9>  Matrix15x9f;
 typedef Matrix<float,15,12> Matrix15x12f;
 typedef Matrix<float,9,1>   Vector9f;
+typedef Matrix<float,12,1>  Vector12f;
 typedef Matrix<float,15,1>  Vector15f;
 
 class EKF15_mag {
 
 public:
 
-    EKF15_mag() {
+    EKF15_mag():
+	ud(false)
+    {
 	default_config();
     }
     ~EKF15_mag() {}
@@ -51,6 +54,10 @@ public:
     NAVconfig get_config();
     void default_config();
 
+    // keep the covariance factored as U*D*U' (float safe, no
+    // symmetrizing needed) instead of a dense P.  Set before init().
+    void set_ud_covariance(bool enable) { ud = enable; }
+
     // main interface
     void init(IMUdata imu, GPSdata gps);
     void time_update(IMUdata imu);
@@ -72,6 +79,12 @@ private:
     Vector3d pos_ins_ecef, pos_gps, pos_gps_ecef;
     Vector3f grav, f_b, om_ib, pos_ins_ned, pos_gps_ned, dx, mag_ned;
 
+    // UD mode: P = U*D*U', and only the diagonal of P is kept up to
+    // date (for the nav.P* outputs)
+    bool ud;
+    Matrix15f U;
+    Vector15f D;
+
     Quaternionf quat;
     float tprev;
 
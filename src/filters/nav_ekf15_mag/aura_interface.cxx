@@ -6,6 +6,7 @@
 #include <pyprops.hxx>
 
 #include <math.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "include/globaldefs.h"
@@ -33,6 +34,8 @@ static pyPropertyNode filter_node;
 
 // when false will trigger a nav init if gps is alive and settled
 static bool nav_inited = false;
+static bool gps_ready = false;
+static double last_gps_time = 0.0;
 
 // update the imu_data and gps_data structures with most recent sensor
 // data prior to calling the filter init or update routines
@@ -108,6 +111,12 @@ void nav_ekf15_mag_init( string output_path, pyPropertyNode *config ) {
     filter_node = pyGetNode(output_path, true);
     filter_node.setString( "navigation", "invalid" );
 
+    // covariance: "dense" (default) or "ud" (factored, float safe)
+    if ( config->getString("covariance") == "ud" ) {
+	printf("%s: UD factored covariance\n", output_path.c_str());
+	filter.set_ud_covariance( true );
+    }
+
 #if 0
     // set tuning value for specific gps and imu noise characteristics
     cov_gps_hpos_node = config.getChild("cov-gps-hpos", 0, true);
@@ -130,12 +139,13 @@ void nav_ekf15_mag_reset() {
 }
 
 
-bool nav_ekf15_mag_update() {
-    static double last_gps_time = 0.0;
-
+void nav_ekf15_mag_begin() {
     // fill in the UMN structures
     props2umn();
+    gps_ready = GPS_age() < 1.0 && gps_node.getBool("settle");
+}
 
+bool nav_ekf15_mag_step() {
     if ( nav_inited ) {
 	filter.time_update( imu_data );
         if ( gps_data.time > last_gps_time ) {
@@ -144,17 +154,25 @@ bool nav_ekf15_mag_update() {
         }
         nav_data = filter.get_nav();
     } else {
-	if ( GPS_age() < 1.0 && gps_node.getBool("settle") ) {
+	if ( gps_ready ) {
 	    filter.init( imu_data, gps_data );
             nav_data = filter.get_nav();
 	    nav_inited = true;
 	}
     }
+    return nav_inited;
+}
 
+void nav_ekf15_mag_end() {
     // copy the nav_data results back to the property tree
     umn2props();
+}
 
-    return nav_inited;
+bool nav_ekf15_mag_update() {
+    nav_ekf15_mag_begin();
+    bool result = nav_ekf15_mag_step();
+    nav_ekf15_mag_end();
+    return result;
 }
 
 
@@ -12,5 +12,10 @@ using std::string;
 
 void nav_ekf15_mag_init( string output_path, pyPropertyNode *config );
 void nav_ekf15_mag_reset();
+
+// split update, same contract as nav_ekf15_begin/step/end()
+void nav_ekf15_mag_begin();
+bool nav_ekf15_mag_step();
+void nav_ekf15_mag_end();
 bool nav_ekf15_mag_update();
 void nav_ekf15_mag_close();
@@ -4,6 +4,7 @@
 #include <pyprops.hxx>
 
 #include <stdio.h>
+#include <string.h>		// memset()
 
 #include "include/globaldefs.h"
 
@@ -14,7 +15,7 @@
 #include "util/timing.h"
 
 #include "health.hxx"
-#include "loadavg.hxx"
+#include "sysmon.hxx"
 
 
 static pyPropertyNode remote_link_node;
@@ -24,7 +25,7 @@ static pyPropertyNode power_node;
 
 
 bool health_init() {
-    loadavg_init();
+    sysmon_init();
 
     // initialize comm nodes
     remote_link_node = pyGetNode("/config/remote_link", true);
@@ -36,10 +37,39 @@ bool health_init() {
 }
 
 
-bool health_update() {
-    loadavg_update();
+static uint16_t clamp16( float value ) {
+    if ( value < 0.0 ) { return 0; }
+    if ( value > 65535.0 ) { return 65535; }
+    return value + 0.5;
+}
 
-    message::system_health_v5_t health;
+// keep a value inside the range of a uint16 packed at the given scale
+// (pack() would wrap it)
+static float clamp_scaled16( float value, float scale ) {
+    float max_value = 65535.0 / scale;
+    if ( value < 0.0 ) { return 0.0; }
+    if ( value > max_value ) { return max_value; }
+    return value;
+}
+
+bool health_update() {
+    // latest /proc sample from the sysmon thread (cheap, never blocks)
+    sysmon_snapshot_t sys;
+    if ( sysmon_get( &sys ) ) {
+	status_node.setDouble( "system_load_avg", sys.load_avg );
+	status_node.setDouble( "flight_cpu_pct", sys.flight_cpu_pct );
+	status_node.setDouble( "process_cpu_pct", sys.process_cpu_pct );
+	status_node.setDouble( "ctx_voluntary", sys.ctx_voluntary );
+	status_node.setDouble( "ctx_involuntary", sys.ctx_involuntary );
+	status_node.setDouble( "minor_faults", sys.minor_faults );
+	status_node.setDouble( "major_faults", sys.major_faults );
+	status_node.setDouble( "rss_mb", sys.rss_mb );
+	status_node.setDouble( "disk_latency_ms", sys.disk_latency_ms );
+    } else {
+	memset( &sys, 0, sizeof(sys) );
+    }
+
+    message::system_health_v6_t health;
     health.index = 0;
     health.timestamp_sec = status_node.getDouble("frame_time");
     health.system_load_avg = status_node.getDouble("system_load_avg");
@@ -48,6 +78,14 @@ bool health_update() {
     health.cell_vcc = power_node.getDouble("cell_vcc");
     health.main_amps = power_node.getDouble("main_amps");
     health.total_mah = power_node.getDouble("total_mah");
+    health.flight_cpu_pct = sys.flight_cpu_pct;
+    health.process_cpu_pct = sys.process_cpu_pct;
+    health.ctx_voluntary = clamp16( sys.ctx_voluntary );
+    health.ctx_involuntary = clamp16( sys.ctx_involuntary );
+    health.minor_faults = clamp16( sys.minor_faults );
+    health.major_faults = clamp16( sys.major_faults );
+    health.rss_mb = sys.rss_mb;
+    health.disk_latency_ms = clamp_scaled16( sys.disk_latency_ms, 100.0 );
     health.pack();
     remote_link->send_message( health.id, health.payload, health.len );
     logging->log_message( health.id, health.payload, health.len );
@@ -1,6 +0,0 @@
-// cpu load average module
-
-#pragma once
-
-bool loadavg_init();
-bool loadavg_update();
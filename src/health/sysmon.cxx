@@ -0,0 +1,238 @@
+// system monitor: samples /proc from a helper thread so the flight
+// loop never opens, reads or parses a /proc file itself.
+//
+// All files are opened once at init and re-read with pread() at
+// offset 0 into fixed buffers, the sampler thread never touches the
+// property tree (the python interpreter is not thread safe) and
+// publishes through a seqlock.
+
+#include <pyprops.hxx>
+
+#include <fcntl.h>		// open()
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>		// strtoul()
+#include <string.h>
+#include <sys/syscall.h>	// SYS_gettid
+#include <time.h>		// clock_gettime()
+#include <unistd.h>		// pread(), sysconf()
+
+#include <string>
+using std::string;
+
+#include "init/runtime.hxx"
+#include "util/seqlock.hxx"
+
+#include "sysmon.hxx"
+
+static const double sample_interval = 0.5; // sec
+
+static int loadavg_fd = -1;
+static int proc_stat_fd = -1;	// /proc/self/stat
+static int thread_stat_fd = -1;	// /proc/self/task/<flight tid>/stat
+static int thread_status_fd = -1; // .../status (context switches)
+static int diskstats_fd = -1;
+static char disk_name[32];
+static double clock_ticks = 100.0;
+static double page_mb = 4096.0 / (1024.0 * 1024.0);
+
+static SeqLock<sysmon_snapshot_t> latest;
+
+// counters from the previous sample, rates are computed from these
+struct counters_t {
+    double time;
+    unsigned long flight_ticks;
+    unsigned long process_ticks;
+    unsigned long ctx_voluntary;
+    unsigned long ctx_involuntary;
+    unsigned long minor_faults;
+    unsigned long major_faults;
+    unsigned long disk_ios;
+    unsigned long disk_ms;
+};
+
+// rates are per wall clock second, independent of get_Time() (which
+// may be running from a replay log.)
+static double monotonic_sec() {
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+// read a whole (small) /proc file, returns the length or -1
+static int read_proc( int fd, char *buf, int size ) {
+    if ( fd < 0 ) {
+	return -1;
+    }
+    int len = pread( fd, buf, size - 1, 0 );
+    if ( len < 0 ) {
+	return -1;
+    }
+    buf[len] = 0;
+    return len;
+}
+
+// skip to field number 'field' (1 based, as in proc(5)) of a stat
+// line.  The command name (field 2) may contain spaces so counting
+// starts after the closing paren.
+static const char *stat_field( const char *buf, int field ) {
+    const char *p = strrchr( buf, ')' );
+    if ( p == NULL ) {
+	return NULL;
+    }
+    p++;
+    for ( int i = 3; i < field; i++ ) {
+	while ( *p == ' ' ) p++;
+	while ( *p && *p != ' ' ) p++;
+    }
+    return p;
+}
+
+static unsigned long status_value( const char *buf, const char *key ) {
+    const char *p = strstr( buf, key );
+    if ( p == NULL ) {
+	return 0;
+    }
+    return strtoul( p + strlen(key), NULL, 10 );
+}
+
+static void sample( counters_t *c, sysmon_snapshot_t *snap ) {
+    char buf[4096];
+
+    if ( read_proc( loadavg_fd, buf, sizeof(buf) ) > 0 ) {
+	snap->load_avg = strtod( buf, NULL );
+    }
+
+    // flight thread: utime (14) + stime (15)
+    if ( read_proc( thread_stat_fd, buf, sizeof(buf) ) > 0 ) {
+	const char *p = stat_field( buf, 14 );
+	if ( p != NULL ) {
+	    char *end;
+	    c->flight_ticks = strtoul( p, &end, 10 );
+	    c->flight_ticks += strtoul( end, NULL, 10 );
+	}
+    }
+    if ( read_proc( thread_status_fd, buf, sizeof(buf) ) > 0 ) {
+	c->ctx_voluntary = status_value( buf, "\nvoluntary_ctxt_switches:" );
+	c->ctx_involuntary = status_value( buf, "nonvoluntary_ctxt_switches:" );
+    }
+
+    // process: minflt (10), majflt (12), utime (14), stime (15), rss (24)
+    if ( read_proc( proc_stat_fd, buf, sizeof(buf) ) > 0 ) {
+	const char *p = stat_field( buf, 10 );
+	if ( p != NULL ) {
+	    char *end;
+	    c->minor_faults = strtoul( p, &end, 10 );
+	    strtoul( end, &end, 10 );		// cminflt
+	    c->major_faults = strtoul( end, &end, 10 );
+	    strtoul( end, &end, 10 );		// cmajflt
+	    c->process_ticks = strtoul( end, &end, 10 );
+	    c->process_ticks += strtoul( end, &end, 10 );
+	    for ( int i = 16; i < 24; i++ ) {
+		strtol( end, &end, 10 );
+	    }
+	    snap->rss_mb = strtol( end, NULL, 10 ) * page_mb;
+	}
+    }
+
+    // disk: reads completed (4) and ms reading (7), writes completed
+    // (8) and ms writing (11) of the log device
+    if ( disk_name[0] && read_proc( diskstats_fd, buf, sizeof(buf) ) > 0 ) {
+	const char *p = strstr( buf, disk_name );
+	if ( p != NULL ) {
+	    char *end = (char *)p + strlen(disk_name);
+	    unsigned long v[8];
+	    for ( int i = 0; i < 8; i++ ) {
+		v[i] = strtoul( end, &end, 10 );
+	    }
+	    c->disk_ios = v[0] + v[4];
+	    c->disk_ms = v[3] + v[7];
+	}
+    }
+}
+
+static void *sysmon_thread( void *arg ) {
+    runtime_helper_thread_init( "sysmon" );
+
+    counters_t last;
+    memset( &last, 0, sizeof(last) );
+    sysmon_snapshot_t snap;
+    memset( &snap, 0, sizeof(snap) );
+    last.time = monotonic_sec();
+    sample( &last, &snap );
+
+    while ( true ) {
+	usleep( sample_interval * 1000000 );
+	counters_t c = last;
+	c.time = monotonic_sec();
+	sample( &c, &snap );
+	double dt = c.time - last.time;
+	if ( dt <= 0.0 ) {
+	    continue;
+	}
+	double tick_pct = 100.0 / (clock_ticks * dt);
+	snap.flight_cpu_pct = (c.flight_ticks - last.flight_ticks) * tick_pct;
+	snap.process_cpu_pct = (c.process_ticks - last.process_ticks) * tick_pct;
+	snap.ctx_voluntary = (c.ctx_voluntary - last.ctx_voluntary) / dt;
+	snap.ctx_involuntary = (c.ctx_involuntary - last.ctx_involuntary) / dt;
+	snap.minor_faults = (c.minor_faults - last.minor_faults) / dt;
+	snap.major_faults = (c.major_faults - last.major_faults) / dt;
+	unsigned long ios = c.disk_ios - last.disk_ios;
+	if ( ios > 0 ) {
+	    snap.disk_latency_ms = (double)(c.disk_ms - last.disk_ms) / ios;
+	} else {
+	    snap.disk_latency_ms = 0.0;
+	}
+	latest.write( snap );
+	last = c;
+    }
+
+    return NULL;
+}
+
+bool sysmon_init() {
+    pyPropertyNode config = pyGetNode("/config/health", true);
+    string disk = "mmcblk0";
+    if ( config.hasChild("disk") ) {
+	disk = config.getString("disk");
+    }
+    // match the name as a whole field of the diskstats line
+    snprintf( disk_name, sizeof(disk_name), " %s ", disk.c_str() );
+
+    long ticks = sysconf( _SC_CLK_TCK );
+    if ( ticks > 0 ) {
+	clock_ticks = ticks;
+    }
+    page_mb = sysconf( _SC_PAGESIZE ) / (1024.0 * 1024.0);
+
+    char path[64];
+    long tid = syscall( SYS_gettid );
+    loadavg_fd = open( "/proc/loadavg", O_RDONLY );
+    proc_stat_fd = open( "/proc/self/stat", O_RDONLY );
+    snprintf( path, sizeof(path), "/proc/self/task/%ld/stat", tid );
+    thread_stat_fd = open( path, O_RDONLY );
+    snprintf( path, sizeof(path), "/proc/self/task/%ld/status", tid );
+    thread_status_fd = open( path, O_RDONLY );
+    diskstats_fd = open( "/proc/diskstats", O_RDONLY );
+    if ( loadavg_fd < 0 || proc_stat_fd < 0 || thread_stat_fd < 0 ) {
+	printf("sysmon: unable to open /proc, system health will be incomplete\n");
+	return false;
+    }
+    return true;
+}
+
+bool sysmon_start() {
+    pthread_t thread;
+    int result = pthread_create( &thread, NULL, sysmon_thread, NULL );
+    if ( result != 0 ) {
+	printf("sysmon: unable to start sampler thread - %s\n",
+	       strerror(result));
+	return false;
+    }
+    pthread_detach( thread );
+    return true;
+}
+
+bool sysmon_get( sysmon_snapshot_t *snap ) {
+    return latest.read( snap ) > 0;
+}
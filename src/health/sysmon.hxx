@@ -0,0 +1,29 @@
+// system monitor: samples /proc from a helper thread so the flight
+// loop never opens, reads or parses a /proc file itself.
+
+#pragma once
+
+#include <stdint.h>
+
+struct sysmon_snapshot_t {
+    float load_avg;		// 1 minute load average
+    float flight_cpu_pct;	// flight thread cpu use
+    float process_cpu_pct;	// all threads, can exceed 100 (multi core)
+    float ctx_voluntary;	// flight thread context switches / sec
+    float ctx_involuntary;
+    float minor_faults;		// process page faults / sec
+    float major_faults;
+    float rss_mb;		// resident set size
+    float disk_latency_ms;	// mean completion time of log disk io
+};
+
+// call from the flight thread (it records the calling thread as the
+// one to watch.)  Opens the /proc files.
+bool sysmon_init();
+
+// start the sampler thread.  Call after runtime_init() so the thread
+// is moved off the flight cpu.
+bool sysmon_start();
+
+// copy out the latest snapshot, false if nothing has been sampled yet
+bool sysmon_get( sysmon_snapshot_t *snap );
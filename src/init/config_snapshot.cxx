@@ -0,0 +1,294 @@
+//
+// config_snapshot.cxx - compiled image of the loaded configuration
+//
+
+#include <pyprops.hxx>
+#include <marshal.h>
+
+#include <dirent.h>		// opendir()
+#include <fcntl.h>		// open()
+#include <stdio.h>
+#include <string.h>		// memcmp()
+#include <sys/mman.h>		// mmap()
+#include <sys/stat.h>		// stat()
+#include <unistd.h>		// close()
+
+#include "config_snapshot.hxx"
+
+static const char snapshot_magic[] = "AURACFG1";
+
+struct snapshot_header_t {
+    char magic[8];
+    int64_t newest_mtime_ns;	// newest file under the config root
+    uint32_t file_count;	// number of files under the config root
+    uint32_t data_len;		// marshal data that follows
+};
+
+// scan the config tree so any edit, added or removed file
+// invalidates the snapshot.
+static void scan_config( const string &path, const struct stat *skip,
+			 int64_t *newest, uint32_t *count )
+{
+    DIR *dir = opendir( path.c_str() );
+    if ( dir == NULL ) {
+	return;
+    }
+    struct dirent *entry;
+    while ( (entry = readdir(dir)) != NULL ) {
+	if ( entry->d_name[0] == '.' ) {
+	    continue;
+	}
+	string file = path + "/" + entry->d_name;
+	struct stat st;
+	if ( stat( file.c_str(), &st ) != 0 ) {
+	    continue;
+	}
+	if ( st.st_dev == skip->st_dev && st.st_ino == skip->st_ino ) {
+	    // the snapshot itself may live in the config tree
+	    continue;
+	}
+	if ( S_ISDIR(st.st_mode) ) {
+	    scan_config( file, skip, newest, count );
+	} else {
+	    int64_t mtime = (int64_t)st.st_mtim.tv_sec * 1000000000
+		+ st.st_mtim.tv_nsec;
+	    if ( mtime > *newest ) {
+		*newest = mtime;
+	    }
+	    (*count)++;
+	}
+    }
+    closedir( dir );
+}
+
+// property nodes become plain dicts (their attributes), lists and
+// leaf values are kept as is.
+static PyObject *node_to_plain( PyObject *obj, PyTypeObject *node_type ) {
+    if ( Py_TYPE(obj) == node_type ) {
+	PyObject *attrs = PyObject_GetAttrString( obj, "__dict__" );
+	if ( attrs == NULL ) {
+	    return NULL;
+	}
+	PyObject *result = PyDict_New();
+	PyObject *key, *value;
+	Py_ssize_t pos = 0;
+	while ( PyDict_Next(attrs, &pos, &key, &value) ) {
+	    PyObject *plain = node_to_plain( value, node_type );
+	    if ( plain == NULL ) {
+		Py_DECREF( result );
+		Py_DECREF( attrs );
+		return NULL;
+	    }
+	    PyDict_SetItem( result, key, plain );
+	    Py_DECREF( plain );
+	}
+	Py_DECREF( attrs );
+	return result;
+    } else if ( PyList_Check(obj) ) {
+	Py_ssize_t len = PyList_Size( obj );
+	PyObject *result = PyList_New( len );
+	for ( Py_ssize_t i = 0; i < len; i++ ) {
+	    PyObject *plain = node_to_plain( PyList_GetItem(obj, i), node_type );
+	    if ( plain == NULL ) {
+		Py_DECREF( result );
+		return NULL;
+	    }
+	    PyList_SetItem( result, i, plain ); // steals plain
+	}
+	return result;
+    }
+    Py_INCREF( obj );
+    return obj;
+}
+
+static PyObject *plain_to_node( PyObject *obj, PyTypeObject *node_type ) {
+    if ( PyDict_Check(obj) ) {
+	PyObject *node = PyObject_CallObject( (PyObject *)node_type, NULL );
+	if ( node == NULL ) {
+	    return NULL;
+	}
+	PyObject *key, *value;
+	Py_ssize_t pos = 0;
+	while ( PyDict_Next(obj, &pos, &key, &value) ) {
+	    PyObject *child = plain_to_node( value, node_type );
+	    if ( child == NULL ) {
+		Py_DECREF( node );
+		return NULL;
+	    }
+	    PyObject_SetAttr( node, key, child );
+	    Py_DECREF( child );
+	}
+	return node;
+    } else if ( PyList_Check(obj) ) {
+	Py_ssize_t len = PyList_Size( obj );
+	PyObject *result = PyList_New( len );
+	for ( Py_ssize_t i = 0; i < len; i++ ) {
+	    PyObject *child = plain_to_node( PyList_GetItem(obj, i), node_type );
+	    if ( child == NULL ) {
+		Py_DECREF( result );
+		return NULL;
+	    }
+	    PyList_SetItem( result, i, child ); // steals child
+	}
+	return result;
+    }
+    Py_INCREF( obj );
+    return obj;
+}
+
+// copy the attributes of src into dst.  Nodes that already exist
+// (i.e. /status and /comms are created before the config loads) are
+// merged into rather than replaced, so pyPropertyNode handles taken
+// before the load stay attached to the tree.
+static bool merge_node( PyObject *dst, PyObject *src, PyTypeObject *node_type ) {
+    PyObject *attrs = PyObject_GetAttrString( src, "__dict__" );
+    if ( attrs == NULL ) {
+	return false;
+    }
+    bool result = true;
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    while ( result && PyDict_Next(attrs, &pos, &key, &value) ) {
+	PyObject *old = PyObject_GetAttr( dst, key );
+	if ( old == NULL ) {
+	    PyErr_Clear();
+	}
+	if ( old != NULL && Py_TYPE(old) == node_type
+	     && Py_TYPE(value) == node_type ) {
+	    result = merge_node( old, value, node_type );
+	} else {
+	    result = PyObject_SetAttr( dst, key, value ) == 0;
+	}
+	Py_XDECREF( old );
+    }
+    Py_DECREF( attrs );
+    return result;
+}
+
+// drop every value under node but keep the (possibly referenced)
+// child nodes themselves, so a fallback load starts from a clean tree
+static void clear_node( PyObject *node, PyTypeObject *node_type ) {
+    PyObject *attrs = PyObject_GetAttrString( node, "__dict__" );
+    if ( attrs == NULL ) {
+	PyErr_Clear();
+	return;
+    }
+    PyObject *keys = PyDict_Keys( attrs );
+    for ( Py_ssize_t i = 0; keys != NULL && i < PyList_Size(keys); i++ ) {
+	PyObject *key = PyList_GetItem( keys, i );
+	PyObject *value = PyDict_GetItem( attrs, key );
+	if ( value != NULL && Py_TYPE(value) == node_type ) {
+	    clear_node( value, node_type );
+	} else {
+	    PyDict_DelItem( attrs, key );
+	}
+    }
+    Py_XDECREF( keys );
+    Py_DECREF( attrs );
+}
+
+bool config_snapshot_load( const string &file, const string &config_root ) {
+    int fd = open( file.c_str(), O_RDONLY );
+    if ( fd < 0 ) {
+	return false;
+    }
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 || st.st_size < (off_t)sizeof(snapshot_header_t) ) {
+	close( fd );
+	return false;
+    }
+    void *image = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if ( image == MAP_FAILED ) {
+	return false;
+    }
+
+    bool result = false;
+    snapshot_header_t *header = (snapshot_header_t *)image;
+    int64_t newest = 0;
+    uint32_t count = 0;
+    scan_config( config_root, &st, &newest, &count );
+    if ( memcmp( header->magic, snapshot_magic, 8 ) != 0 ) {
+	printf("config snapshot: %s has a bad header\n", file.c_str());
+    } else if ( header->newest_mtime_ns != newest
+		|| header->file_count != count ) {
+	printf("config snapshot: %s is out of date\n", file.c_str());
+    } else if ( sizeof(snapshot_header_t) + header->data_len
+		> (size_t)st.st_size ) {
+	printf("config snapshot: %s is truncated\n", file.c_str());
+    } else {
+	PyObject *tree = PyMarshal_ReadObjectFromString(
+	    (const char *)image + sizeof(snapshot_header_t), header->data_len );
+	if ( PyErr_Occurred() ) PyErr_Print();
+	pyPropertyNode root = pyGetNode("/", true);
+	if ( tree != NULL && PyDict_Check(tree) && root.pObj != NULL ) {
+	    PyTypeObject *node_type = Py_TYPE(root.pObj);
+	    // build the whole image off to the side first, a bad image
+	    // then never touches the live tree
+	    PyObject *image_root = plain_to_node( tree, node_type );
+	    if ( image_root == NULL ) {
+		if ( PyErr_Occurred() ) PyErr_Print();
+	    } else {
+		result = merge_node( root.pObj, image_root, node_type );
+		if ( !result ) {
+		    if ( PyErr_Occurred() ) PyErr_Print();
+		    printf("config snapshot: %s only partly loaded\n",
+			   file.c_str());
+		    clear_node( root.pObj, node_type );
+		}
+		Py_DECREF( image_root );
+	    }
+	}
+	Py_XDECREF( tree );
+    }
+
+    munmap( image, st.st_size );
+    return result;
+}
+
+bool config_snapshot_save( const string &file, const string &config_root ) {
+    pyPropertyNode root = pyGetNode("/", true);
+    if ( root.pObj == NULL ) {
+	return false;
+    }
+    PyObject *tree = node_to_plain( root.pObj, Py_TYPE(root.pObj) );
+    PyObject *data = NULL;
+    if ( tree != NULL ) {
+	data = PyMarshal_WriteObjectToString( tree, Py_MARSHAL_VERSION );
+	Py_DECREF( tree );
+    }
+    if ( data == NULL ) {
+	if ( PyErr_Occurred() ) PyErr_Print();
+	printf("config snapshot: unable to serialize the property tree\n");
+	return false;
+    }
+
+    snapshot_header_t header;
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, snapshot_magic, 8 );
+    struct stat st;
+    memset( &st, 0, sizeof(st) );
+    stat( file.c_str(), &st );
+    scan_config( config_root, &st, &header.newest_mtime_ns,
+		 &header.file_count );
+    header.data_len = PyBytes_Size( data );
+
+    // write to the side and rename so a reboot mid-write never
+    // leaves a half written snapshot behind
+    string tmp_file = file + ".tmp";
+    bool result = false;
+    FILE *fp = fopen( tmp_file.c_str(), "w" );
+    if ( fp != NULL ) {
+	result = fwrite( &header, sizeof(header), 1, fp ) == 1
+	    && fwrite( PyBytes_AsString(data), header.data_len, 1, fp ) == 1;
+	result = (fclose( fp ) == 0) && result;
+	if ( result ) {
+	    result = rename( tmp_file.c_str(), file.c_str() ) == 0;
+	}
+    }
+    Py_DECREF( data );
+    if ( !result ) {
+	printf("config snapshot: unable to write %s\n", file.c_str());
+    }
+    return result;
+}
@@ -0,0 +1,23 @@
+//
+// config_snapshot.hxx - compiled image of the loaded configuration
+//
+// Loading main.json resolves a whole tree of include files through
+// the python json loader.  After a good load the resolved property
+// tree can be saved as a single marshal image.  On the next boot the
+// image is mmap()ed and unpacked straight into the property tree,
+// provided nothing under the config root has been touched since
+// (newest mtime and file count are recorded in the image header.)
+//
+
+#pragma once
+
+#include <string>
+using std::string;
+
+// returns false if the snapshot is missing or stale, the caller
+// should then load the json config as usual.  The image is unpacked
+// in full before anything is merged into the tree; if the merge
+// itself fails the tree's values are cleared (nodes kept) first.
+bool config_snapshot_load( const string &file, const string &config_root );
+
+bool config_snapshot_save( const string &file, const string &config_root );
@@ -0,0 +1,207 @@
+//
+// runtime.cxx - real-time runtime setup for the flight loop
+//
+
+#include <pyprops.hxx>
+
+#include <alloca.h>		// alloca()
+#include <errno.h>		// errno
+#include <malloc.h>		// mallopt()
+#include <pthread.h>
+#include <sched.h>		// sched_setscheduler(), sched_setaffinity()
+#include <stdio.h>
+#include <stdlib.h>		// malloc()
+#include <string.h>		// memset(), strerror()
+#include <sys/mman.h>		// mlockall()
+#include <sys/resource.h>	// getrusage()
+
+#include <vector>
+using std::vector;
+
+#include "runtime.hxx"
+
+static pyPropertyNode runtime_node;
+
+static bool enabled = false;
+static cpu_set_t helper_set;
+static bool have_helper_cpus = false;
+static vector<int> worker_cpus;
+static long last_faults = 0;
+static long total_faults = 0;
+static long fault_frames = 0;
+
+static long thread_page_faults() {
+    struct rusage usage;
+    getrusage( RUSAGE_THREAD, &usage );
+    return usage.ru_minflt + usage.ru_majflt;
+}
+
+// touch a block of stack so it is mapped (and locked) before the
+// flight loop needs it.  The block is sized to kb and sits right below
+// this frame, so it covers the kb of stack the caller will grow into.
+// Each page is written and read back (the sum is only there so the
+// block is used.)
+static int prefault_stack( int kb ) {
+    const int max_kb = 1024;
+    if ( kb > max_kb ) {
+	kb = max_kb;
+    }
+    if ( kb <= 0 ) {
+	return 0;
+    }
+    size_t size = (size_t)kb * 1024;
+    volatile unsigned char *stack = (volatile unsigned char *)alloca( size );
+    int sum = 0;
+    for ( size_t i = 0; i < size; i += 4096 ) {
+	stack[i] = 0;
+	sum += stack[i];
+    }
+    return sum;
+}
+
+// grow the heap, touch it and give it back to malloc.  With trimming
+// and mmap() disabled the memory stays mapped for later allocations.
+static void prefault_heap( int kb ) {
+    mallopt( M_TRIM_THRESHOLD, -1 );
+    mallopt( M_MMAP_MAX, 0 );
+    size_t size = (size_t)kb * 1024;
+    char *heap = (char *)malloc( size );
+    if ( heap == NULL ) {
+	printf("runtime: unable to prefault %d kb of heap\n", kb);
+	return;
+    }
+    memset( heap, 0, size );
+    free( heap );
+}
+
+void runtime_init() {
+    runtime_node = pyGetNode("/status/runtime", true);
+
+    pyPropertyNode config = pyGetNode("/config/runtime", true);
+    if ( !config.getBool("enable") ) {
+	return;
+    }
+    enabled = true;
+
+    int flight_cpu = -1;
+    if ( config.hasChild("flight_cpu") ) {
+	flight_cpu = config.getLong("flight_cpu");
+    }
+    if ( flight_cpu >= 0 ) {
+	cpu_set_t set;
+	CPU_ZERO( &set );
+	CPU_SET( flight_cpu, &set );
+	if ( sched_setaffinity( 0, sizeof(set), &set ) != 0 ) {
+	    printf("runtime: unable to pin flight loop to cpu %d - %s\n",
+		   flight_cpu, strerror(errno));
+	} else {
+	    printf("runtime: flight loop pinned to cpu %d\n", flight_cpu);
+	}
+    }
+
+    CPU_ZERO( &helper_set );
+    int count = config.getLen("helper_cpus");
+    for ( int i = 0; i < count; i++ ) {
+	CPU_SET( config.getLong("helper_cpus", i), &helper_set );
+	have_helper_cpus = true;
+    }
+
+    count = config.getLen("worker_cpus");
+    for ( int i = 0; i < count; i++ ) {
+	worker_cpus.push_back( config.getLong("worker_cpus", i) );
+    }
+
+    if ( config.getBool("lock_memory") ) {
+	if ( mlockall( MCL_CURRENT | MCL_FUTURE ) != 0 ) {
+	    printf("runtime: mlockall() failed - %s\n", strerror(errno));
+	} else {
+	    printf("runtime: memory locked\n");
+	}
+    }
+    if ( config.hasChild("prefault_stack_kb") ) {
+	prefault_stack( config.getLong("prefault_stack_kb") );
+    }
+    if ( config.hasChild("prefault_heap_kb") ) {
+	prefault_heap( config.getLong("prefault_heap_kb") );
+    }
+
+    int priority = 0;
+    if ( config.hasChild("priority") ) {
+	priority = config.getLong("priority");
+    }
+    if ( priority > 0 ) {
+	struct sched_param param;
+	memset( &param, 0, sizeof(param) );
+	param.sched_priority = priority;
+	if ( sched_setscheduler( 0, SCHED_FIFO, &param ) != 0 ) {
+	    printf("runtime: unable to set SCHED_FIFO priority %d - %s\n",
+		   priority, strerror(errno));
+	} else {
+	    printf("runtime: flight loop SCHED_FIFO priority %d\n", priority);
+	}
+    }
+
+    last_faults = thread_page_faults();
+}
+
+void runtime_update() {
+    if ( !enabled ) {
+	return;
+    }
+    long faults = thread_page_faults();
+    long frame_faults = faults - last_faults;
+    last_faults = faults;
+    if ( frame_faults > 0 ) {
+	total_faults += frame_faults;
+	fault_frames++;
+	runtime_node.setLong("page_faults_total", total_faults);
+	runtime_node.setLong("page_fault_frames", fault_frames);
+    }
+    runtime_node.setLong("page_faults", frame_faults);
+}
+
+// threads inherit the flight loop's core and SCHED_FIFO policy, so
+// move them back to the normal scheduler on the helper cores.
+bool runtime_helper_thread_init( const char *name ) {
+    if ( !enabled ) {
+	return true;
+    }
+    struct sched_param param;
+    memset( &param, 0, sizeof(param) );
+    pthread_setschedparam( pthread_self(), SCHED_OTHER, &param );
+    if ( !have_helper_cpus ) {
+	return true;
+    }
+    int result = pthread_setaffinity_np( pthread_self(), sizeof(helper_set),
+					 &helper_set );
+    if ( result != 0 ) {
+	printf("runtime: unable to place %s thread on helper cpus - %s\n",
+	       name, strerror(result));
+	return false;
+    }
+    return true;
+}
+
+// workers keep the flight loop's policy and priority (they are part of
+// the frame) but need a core of their own to be of any use.
+bool runtime_worker_thread_init( const char *name, int index ) {
+    if ( !enabled ) {
+	return true;
+    }
+    cpu_set_t set;
+    if ( !worker_cpus.empty() ) {
+	CPU_ZERO( &set );
+	CPU_SET( worker_cpus[index % worker_cpus.size()], &set );
+    } else if ( have_helper_cpus ) {
+	set = helper_set;
+    } else {
+	return true;
+    }
+    int result = pthread_setaffinity_np( pthread_self(), sizeof(set), &set );
+    if ( result != 0 ) {
+	printf("runtime: unable to place %s worker %d - %s\n",
+	       name, index, strerror(result));
+	return false;
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+//
+// runtime.hxx - real-time runtime setup for the flight loop
+//
+// Configured under /config/runtime:
+//
+//   enable        : turn the runtime mode on (default off)
+//   flight_cpu    : core the main loop is pinned to (-1 = don't pin)
+//   priority      : SCHED_FIFO priority of the main loop (0 = leave
+//                   the normal scheduler in place)
+//   helper_cpus   : list of cores for helper threads
+//   worker_cpus   : list of cores for flight loop worker threads (the
+//                   helper cores if not given)
+//   lock_memory   : mlockall() the process once init is finished
+//   prefault_stack_kb, prefault_heap_kb : memory to touch up front so
+//                   the flight loop doesn't take the faults later
+//
+// Page faults taken by the flight loop are reported every frame under
+// /status/runtime.
+//
+
+#pragma once
+
+// call after all the modules are initialized, just before the main
+// loop starts (so everything allocated during init gets locked.)
+void runtime_init();
+
+// call once per frame from the main loop
+void runtime_update();
+
+// call from any helper thread to move it off the flight core
+bool runtime_helper_thread_init( const char *name );
+
+// call from a thread that does part of the flight loop's work (keeps
+// the real-time priority, moves to worker_cpus[index])
+bool runtime_worker_thread_init( const char *name, int index );
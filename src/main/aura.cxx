@@ -29,16 +29,26 @@ using std::string;
 #include "comms/display.hxx"
 #include "comms/logging.hxx"
 #include "comms/remote_link.hxx"
+#include "comms/serial_input.hxx"
+#include "comms/state_bus.hxx"
+#include "comms/trace.hxx"
 #include "control/cas.hxx"
 #include "control/control.hxx"
 #include "filters/filter_mgr.hxx"
 #include "health/health.hxx"
+#include "health/sysmon.hxx"
+#include "init/config_snapshot.hxx"
 #include "init/globals.hxx"
+#include "init/runtime.hxx"
 #include "payload/payload_mgr.hxx"
 #include "sensors/airdata_mgr.hxx"
+#include "sensors/bus_poll.hxx"
 #include "sensors/imu_mgr.hxx"
+#include "sensors/cal_learn.hxx"
+#include "sensors/mag_learn.hxx"
 #include "sensors/gps_mgr.hxx"
 #include "sensors/pilot_mgr.hxx"
+#include "sensors/sensor_mgr.hxx"
 #include "util/myprof.hxx"
 #include "util/netSocket.h"	// netInit()
 #include "util/sg_path.hxx"
@@ -48,6 +58,7 @@ using std::string;
 // update() routine
 #include "sensors/APM2.hxx"
 #include "sensors/Aura3/Aura3.hxx"
+#include "sensors/bus_sensors.hxx"
 #include "sensors/FGFS.hxx"
 
 // sync modes
@@ -55,6 +66,7 @@ enum SyncMode {
     SYNC_NONE,
     SYNC_APM2,
     SYNC_AURA3,
+    SYNC_BUS,
     SYNC_FGFS
 };
 
@@ -67,6 +79,7 @@ static const int HEARTBEAT_HZ = 100;  // master clock rate
 static SyncMode sync_source = SYNC_NONE;   // main loop sync source
     
 static bool enable_mission = true;    // mission mgr module enabled/disabled
+static bool actuator_fast_path = false; // send sensor messages after the actuators
 static bool enable_cas     = false;   // cas module enabled/disabled
 static bool enable_pointing = false;  // pan/tilt pointing module
 static double gps_timeout_sec = 9.0;  // nav algorithm gps timeout
@@ -83,6 +96,7 @@ void usage(char *progname)
 {
     printf("\n%s --option1 on/off --option2 on/off --option3 ... \n", progname);
     printf("--config path        : path to location of configuration file tree\n");
+    printf("--snapshot file      : boot from (and refresh) a compiled config snapshot\n");
     printf("--remote-link on/off : remote link enable or disabled\n");
     printf("--display on/off     : dump periodic data to display\n");	
     printf("--help               : display this help messages\n\n");
@@ -108,6 +122,8 @@ void main_work_loop()
 	dt = APM2_update();
     } else if ( sync_source == SYNC_AURA3 ) {
 	dt = Aura3_update();
+    } else if ( sync_source == SYNC_BUS ) {
+	dt = bus_update();
     } else if ( sync_source == SYNC_FGFS ) {
 	dt = FGFS_update();
     }
@@ -173,6 +189,15 @@ void main_work_loop()
 
     Actuator_update();
 
+    if ( actuator_fast_path ) {
+	// the actuator command is out, now send the sensor messages
+	// that were held back
+	sensor_messages_flush();
+    }
+
+    // publish this frame's vehicle state to local co-processes
+    state_bus_update();
+
     //
     // External Command section
     //
@@ -226,12 +251,14 @@ void main_work_loop()
 	gps_prof.stats();
 	air_prof.stats();
 	filter_prof.stats();
+	filter_gps_prof.stats();
 	mission_prof.stats();
 	control_prof.stats();
 	health_prof.stats();
 	datalog_prof.stats();
 	sync_prof.stats();
 	main_prof.stats();
+	Actuator_stats();
     }
 
     // flush of logging stream (update at full rate)
@@ -241,6 +268,9 @@ void main_work_loop()
 	datalog_prof.stop();
     }
 
+    // forward any trace messages to the event log
+    trace_update();
+
     //
     // Remote telemetry section
     //
@@ -248,6 +278,8 @@ void main_work_loop()
     // dribble pending bytes down the serial port
     remote_link->flush_serial();
 
+    runtime_update();
+
     main_prof.stop();
 }
 
@@ -263,10 +295,14 @@ int main( int argc, char **argv )
     // and python module path on command line
     string root = "./config";
     string python_path = "";
+    string snapshot = "";
     for ( iarg = 1; iarg < argc; iarg++ ) {
 	if ( !strcmp(argv[iarg], "--config" )  ) {
 	    ++iarg;
 	    root = argv[iarg];
+	} else if ( !strcmp(argv[iarg], "--snapshot" )  ) {
+	    ++iarg;
+	    snapshot = argv[iarg];
 	} else if ( !strcmp(argv[iarg], "--python_path" )  ) {
 	    ++iarg;
 	    python_path = argv[iarg];
@@ -295,6 +331,7 @@ int main( int argc, char **argv )
     air_prof.set_name("airdata");
     pilot_prof.set_name("pilot");
     filter_prof.set_name("filter");
+    filter_gps_prof.set_name("filter gps update");
     mission_prof.set_name("mission");
     control_prof.set_name("control");
     health_prof.set_name("health");
@@ -309,6 +346,7 @@ int main( int argc, char **argv )
     imu_prof.enable();
     gps_prof.enable();
     filter_prof.enable();
+    filter_gps_prof.enable();
     control_prof.enable();
     air_prof.enable();
     datalog_prof.enable();
@@ -322,11 +360,24 @@ int main( int argc, char **argv )
     SGPath master( root );
     master.append( "main.json" );
     pyPropertyNode props = pyGetNode("/", true);
-    bool result = readJSON( master.c_str(), &props);
+    bool result = false;
+    if ( snapshot.length() && config_snapshot_load( snapshot, root ) ) {
+        // the snapshot was made from a tree that was already shown,
+        // skip the (slow) pretty print.
+        result = true;
+        printf("Loaded configuration snapshot %s\n", snapshot.c_str());
+    } else {
+        result = readJSON( master.c_str(), &props);
+        if ( result ) {
+            printf("Loaded configuration from %s\n", master.c_str());
+            //writeJSON( "debug.json", &props);
+            props.pretty_print();
+            if ( snapshot.length() ) {
+                config_snapshot_save( snapshot, root );
+            }
+        }
+    }
     if ( result ) {
-        printf("Loaded configuration from %s\n", master.c_str());
-        //writeJSON( "debug.json", &props);
-        props.pretty_print();
         pyPropertyNode config_node = pyGetNode("/config");
         config_node.setString("root-path", root.c_str());
     } else {
@@ -357,6 +408,12 @@ int main( int argc, char **argv )
     }
     printf("gps timeout = %.1f\n", gps_timeout_sec);
 
+    if ( p.hasChild("actuator_fast_path") ) {
+	actuator_fast_path = p.getBool("actuator_fast_path");
+    }
+    sensor_messages_defer( actuator_fast_path );
+    printf("actuator fast path = %d\n", actuator_fast_path);
+
     p = pyGetNode("/config/mission", true);
     if ( p.hasChild("enable") ) {
 	enable_mission = p.getBool("enable");
@@ -370,6 +427,8 @@ int main( int argc, char **argv )
 	    sync_source = SYNC_APM2;
         } else if ( source == "Aura3" ) {
 	    sync_source = SYNC_AURA3;
+	} else if ( source == "bus" ) {
+	    sync_source = SYNC_BUS;
 	} else if ( source == "fgfs" ) {
 	    sync_source = SYNC_FGFS;
 	}
@@ -393,6 +452,9 @@ int main( int argc, char **argv )
         } else if ( !strcmp(argv[iarg], "--python_path" )  ) {
    	    // considered earlier in first pass
             ++iarg;
+        } else if ( !strcmp(argv[iarg], "--snapshot" )  ) {
+   	    // considered earlier in first pass
+            ++iarg;
         } else if ( !strcmp(argv[iarg], "--help") ) {
             usage(argv[0]);
         } else {
@@ -416,6 +478,9 @@ int main( int argc, char **argv )
     // Initialize communication with pilot input sensor
     PilotInput_init();
 
+    // shared memory vehicle state for co-processes (if configured)
+    state_bus_init();
+
     // Initialize any defined filter modules
     Filter_init();
 
@@ -447,9 +512,27 @@ int main( int argc, char **argv )
     // log the master config tree
     logging->write_configs();
     
+    // frame tracing (if configured)
+    trace_thread_name("flight");
+    trace_init();
+
+    // real-time scheduling and memory locking (if configured)
+    runtime_init();
+
+    // start the /proc sampler, trace drain and i2c/spi sensor polling
+    // (after runtime_init() so they land on the helper cpus)
+    sysmon_start();
+    trace_start();
+    bus_start();
+    mag_learn_start();
+    cal_learn_start();
+
+    // nav filter workers (if configured)
+    Filter_start();
+
     printf("Everything inited ... ready to run\n");
 
-    while ( true ) {
+    while ( !serial_replay_finished() ) {
 	main_work_loop();
     }
 
@@ -465,6 +548,8 @@ int main( int argc, char **argv )
     payload_mgr.close();
     control_close();
     Actuator_close();
+    state_bus_close();
+    trace_close();
     logging->close();
 }
 
@@ -2,24 +2,31 @@ from props import getNode
 
 import comms.events
 
-import mission.task.is_airborne
-import mission.task.camera
-import mission.task.circle
-import mission.task.excite
-import mission.task.flaps_mgr
-import mission.task.home_mgr
-import mission.task.idle
-import mission.task.land2
-import mission.task.land3
-import mission.task.launch
-import mission.task.lost_link
-import mission.task.mode_mgr
-import mission.task.parametric
-import mission.task.preflight
-import mission.task.calibrate
-import mission.task.route
-import mission.task.switches
-import mission.task.throttle_safety
+import importlib
+
+# task name -> (module, class).  Task modules are imported the first
+# time the config asks for them so startup doesn't pay for the ones
+# that aren't used (some pull in numpy.)
+task_classes = {
+    'is_airborne': ('mission.task.is_airborne', 'IsAirborne'),
+    'camera': ('mission.task.camera', 'Camera'),
+    'circle': ('mission.task.circle', 'Circle'),
+    'excite': ('mission.task.excite', 'Excite'),
+    'flaps_manager': ('mission.task.flaps_mgr', 'FlapsMgr'),
+    'home_manager': ('mission.task.home_mgr', 'HomeMgr'),
+    'idle': ('mission.task.idle', 'Idle'),
+    'land': ('mission.task.land2', 'Land'),
+    'land3': ('mission.task.land3', 'Land'),
+    'launch': ('mission.task.launch', 'Launch'),
+    'lost_link': ('mission.task.lost_link', 'LostLink'),
+    'mode_manager': ('mission.task.mode_mgr', 'ModeMgr'),
+    'parametric': ('mission.task.parametric', 'Parametric'),
+    'preflight': ('mission.task.preflight', 'Preflight'),
+    'calibrate': ('mission.task.calibrate', 'Calibrate'),
+    'route': ('mission.task.route', 'Route'),
+    'switches': ('mission.task.switches', 'Switches'),
+    'throttle_safety': ('mission.task.throttle_safety', 'ThrottleSafety'),
+}
 
 class MissionMgr:
     def __init__(self):
@@ -39,42 +46,10 @@ class MissionMgr:
         result = None
         task_name = config_node.name
         print("  make_task():", task_name)
-        if task_name == 'is_airborne':
-            result = mission.task.is_airborne.IsAirborne(config_node)
-        elif task_name == 'camera':
-            result = mission.task.camera.Camera(config_node)
-        elif task_name == 'circle':
-            result = mission.task.circle.Circle(config_node)
-        elif task_name == 'excite':
-            result = mission.task.excite.Excite(config_node)
-        elif task_name == 'flaps_manager':
-            result = mission.task.flaps_mgr.FlapsMgr(config_node)
-        elif task_name == 'home_manager':
-            result = mission.task.home_mgr.HomeMgr(config_node)
-        elif task_name == 'idle':
-            result = mission.task.idle.Idle(config_node)
-        elif task_name == 'land':
-            result = mission.task.land2.Land(config_node)
-        elif task_name == 'land3':
-            result = mission.task.land3.Land(config_node)
-        elif task_name == 'launch':
-            result = mission.task.launch.Launch(config_node)
-        elif task_name == 'lost_link':
-            result = mission.task.lost_link.LostLink(config_node)
-        elif task_name == 'mode_manager':
-            result = mission.task.mode_mgr.ModeMgr(config_node)
-        elif task_name == 'parametric':
-            result = mission.task.parametric.Parametric(config_node)
-        elif task_name == 'preflight':
-            result = mission.task.preflight.Preflight(config_node)
-        elif task_name == 'calibrate':
-            result = mission.task.calibrate.Calibrate(config_node)
-        elif task_name == 'route':
-            result = mission.task.route.Route(config_node)
-        elif task_name == 'switches':
-            result = mission.task.switches.Switches(config_node)
-        elif task_name == 'throttle_safety':
-            result = mission.task.throttle_safety.ThrottleSafety(config_node)
+        if task_name in task_classes:
+            (module_name, class_name) = task_classes[task_name]
+            module = importlib.import_module(module_name)
+            result = getattr(module, class_name)(config_node)
         else:
             print("mission_mgr: unknown task name:", task_name)
         return result
@@ -1,5 +1,3 @@
-import math
-
 from props import getNode
 
 import comms.events
@@ -11,6 +9,7 @@ class Chirp(Task):
         self.imu_node = getNode("/sensors/imu", True)
         self.chirp_node = getNode("/task/chirp", True)
         self.signal_node = getNode("/controls/signal", True)
+        self.excite_node = getNode("/task/excite", True)
         self.name = config_node.getString("name")
         self.nickname = config_node.getString("nickname")
         self.start_time = 0.0
@@ -67,9 +66,23 @@ class Chirp(Task):
             self.dur_sec = self.chirp_node.getFloat("duration_sec")
             self.amplitude = self.chirp_node.getFloat("amplitude")
             self.start_time = self.imu_node.getFloat("timestamp")
-            self.k = (self.freq_end - self.freq_start) / (2 * self.dur_sec)
+            # the sweep is generated in the actuator path
+            # (actuators/excite.cxx)
+            inject = self.signal_node.getString("inject")
+            self.excite_node.setString("type", "chirp")
+            self.excite_node.setInt("channels", 1)
+            self.excite_node.setLen("target", 1, "")
+            self.excite_node.setStringEnum("target", 0, inject)
+            self.excite_node.setFloat("duration_sec", self.dur_sec)
+            self.excite_node.setLen("amplitude", 1, 0.0)
+            self.excite_node.setFloatEnum("amplitude", 0, self.amplitude)
+            self.excite_node.setLen("freq_start_rad_sec", 1, 0.0)
+            self.excite_node.setFloatEnum("freq_start_rad_sec", 0, self.freq_start)
+            self.excite_node.setLen("freq_end_rad_sec", 1, 0.0)
+            self.excite_node.setFloatEnum("freq_end_rad_sec", 0, self.freq_end)
+            self.excite_node.setString("command", "start")
             self.running = True
-            comms.events.log("chirp", self.signal_node.getString("inject"))
+            comms.events.log("chirp", inject)
             comms.events.log("chirp", "start freq %.2f rad/sec" % self.freq_start)
             comms.events.log("chirp", "amplitude %.2f" % self.amplitude)
 
@@ -77,19 +90,18 @@ class Chirp(Task):
             if self.running:
                 # only log an event if the abort happens when the
                 # chirp is running
+                self.excite_node.setString("command", "abort")
                 comms.events.log("chirp", "aborted by operator")
             self.running = False
-            
+
         cur_time = self.imu_node.getFloat("timestamp")
         if cur_time > self.start_time + self.dur_sec and self.running:
             comms.events.log("chirp", "end freq %.2f rad/sec" % self.freq_end)
             self.running = False
 
         if self.running:
-            t = cur_time - self.start_time
-            chirp = self.amplitude * math.sin(self.freq_start*t + self.k*t*t)
-            self.signal_node.setFloat("value", chirp)
-            self.signal_node.setFloat("progress", t)
+            self.signal_node.setFloat("value", self.excite_node.getFloatEnum("signal", 0))
+            self.signal_node.setFloat("progress", cur_time - self.start_time)
         else:
             self.signal_node.setFloat("value", 0.0)
             self.signal_node.setFloat("progress", 0.0)
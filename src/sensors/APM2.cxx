@@ -24,9 +24,14 @@ using namespace Eigen;
 
 #include "comms/display.hxx"
 #include "comms/logging.hxx"
+#include "comms/serial_input.hxx"
+#include "comms/trace.hxx"
 #include "init/globals.hxx"
+#include "sensors/cal_learn.hxx"
 #include "sensors/cal_temp.hxx"
-#include "util/butter.hxx"
+#include "sensors/imu_filter.hxx"
+#include "sensors/mag_learn.hxx"
+#include "util/biquad.hxx"
 #include "util/linearfit.hxx"
 #include "util/lowpass.hxx"
 #include "util/timing.h"
@@ -89,6 +94,7 @@ using namespace Eigen;
 static pyPropertyNode apm2_node;
 static pyPropertyNode power_node;
 static pyPropertyNode imu_node;
+static imu_filter_t *imu_filter = NULL;
 static pyPropertyNode gps_node;
 static pyPropertyNode pilot_node;
 static pyPropertyNode act_node;
@@ -105,8 +111,12 @@ static bool actuator_inited = false;
 bool APM2_actuator_configured = false; // externally visible
 
 static int fd = -1;
+static SerialInput reader;
 static string device_name = "/dev/ttyS0";
 static int baud = 230400;
+static string record_file = "";       // log the raw link to this file
+static string replay_file = "";       // read a recorded link instead
+static bool replay_realtime = false;
 static float volt_div_ratio = 100; // a nonsense value
 static int battery_cells = 4;
 static float extern_amp_offset = 0.0;
@@ -133,7 +143,14 @@ static LinearFitFilter imu_offset(200.0, 0.01);
 // 2nd order filter, 100hz sample rate expected, 3rd field is cutoff freq.
 // higher freq value == noisier, a value near 1 hz should work well
 // for airspeed.
-static ButterworthFilter pitot_filter(2, 100, 0.8);
+static ButterworthLowpass<2> pitot_filter(100, 0.8);
+
+// event log messages
+static int rollover_event = trace_register("APM2", "rollover", "micros() rolled over");
+static int serial_event = trace_register("APM2", "info", "Serial Number = %.0f");
+static int firmware_event = trace_register("APM2", "info", "Firmware Revision = %.0f");
+static int master_hz_event = trace_register("APM2", "info", "Master Hz = %.0f");
+static int baud_event = trace_register("APM2", "info", "Baud Rate = %.0f");
 
 static struct gps_sensors_t {
     double timestamp;
@@ -171,6 +188,7 @@ static AuraCalTemp ax_cal;
 static AuraCalTemp ay_cal;
 static AuraCalTemp az_cal;
 static Matrix4d mag_cal;
+static AuraMagLearn mag_learn;
 
 static uint32_t pilot_packet_counter = 0;
 static uint32_t imu_packet_counter = 0;
@@ -190,6 +208,14 @@ static const float MPU6000_accel_scale = g / _accel_lsb_per_dps;
 static const float MPU6000_temp_scale = 0.02;
 
 
+// writes are dropped while replaying (there is no device)
+static void APM2_write( uint8_t *buf, int size ) {
+    if ( fd < 0 ) {
+	return;
+    }
+    /* len = */ write( fd, buf, size );
+}
+
 static void APM2_cksum( uint8_t hdr1, uint8_t hdr2, uint8_t *buf, uint8_t size, uint8_t *cksum0, uint8_t *cksum1 )
 {
     uint8_t c0 = 0;
@@ -220,24 +246,24 @@ bool APM2_request_baud( uint32_t baud ) {
 
     // start of message sync bytes
     buf[0] = START_OF_MSG0; buf[1] = START_OF_MSG1, buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // packet id (1 byte)
     buf[0] = BAUD_PACKET_ID;
     // packet length (1 byte)
     buf[1] = size;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // actuator data
     *(uint32_t *)buf = baud;
   
     // write packet
-    /* len = */ write( fd, buf, size );
+    APM2_write( buf, size );
   
     // check sum (2 bytes)
     APM2_cksum( BAUD_PACKET_ID, size, buf, size, &cksum0, &cksum1 );
     buf[0] = cksum0; buf[1] = cksum1; buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     return true;
 }
@@ -251,18 +277,18 @@ static bool APM2_act_write_eeprom() {
 
     // start of message sync bytes
     buf[0] = START_OF_MSG0; buf[1] = START_OF_MSG1, buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // packet id (1 byte)
     buf[0] = WRITE_EEPROM_PACKET_ID;
     // packet length (1 byte)
     buf[1] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // check sum (2 bytes)
     APM2_cksum( WRITE_EEPROM_PACKET_ID, size, buf, size, &cksum0, &cksum1 );
     buf[0] = cksum0; buf[1] = cksum1; buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     return true;
 }
@@ -276,13 +302,13 @@ static bool APM2_act_set_serial_number( uint16_t serial_number ) {
     
     // start of message sync bytes
     buf[0] = START_OF_MSG0; buf[1] = START_OF_MSG1, buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // packet id (1 byte)
     buf[0] = SERIAL_NUMBER_PACKET_ID;
     // packet length (1 byte)
     buf[1] = 2;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // actuator data
     uint8_t hi = serial_number / 256;
@@ -291,12 +317,12 @@ static bool APM2_act_set_serial_number( uint16_t serial_number ) {
     buf[size++] = hi;
   
     // write packet
-    /* len = */ write( fd, buf, size );
+    APM2_write( buf, size );
   
     // check sum (2 bytes)
     APM2_cksum( SERIAL_NUMBER_PACKET_ID, size, buf, size, &cksum0, &cksum1 );
     buf[0] = cksum0; buf[1] = cksum1; buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     return true;
 }
@@ -310,13 +336,13 @@ static bool APM2_act_set_pwm_rates( uint16_t rates[NUM_ACTUATORS] ) {
 
     // start of message sync bytes
     buf[0] = START_OF_MSG0; buf[1] = START_OF_MSG1, buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // packet id (1 byte)
     buf[0] = PWM_RATE_PACKET_ID;
     // packet length (1 byte)
     buf[1] = NUM_ACTUATORS * 2;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // actuator data
     for ( int i = 0; i < NUM_ACTUATORS; i++ ) {
@@ -328,12 +354,12 @@ static bool APM2_act_set_pwm_rates( uint16_t rates[NUM_ACTUATORS] ) {
     }
   
     // write packet
-    /* len = */ write( fd, buf, size );
+    APM2_write( buf, size );
   
     // check sum (2 bytes)
     APM2_cksum( PWM_RATE_PACKET_ID, size, buf, size, &cksum0, &cksum1 );
     buf[0] = cksum0; buf[1] = cksum1; buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     return true;
 }
@@ -348,13 +374,13 @@ static bool APM2_act_gain_mode( int channel, float gain)
 
     // start of message sync bytes
     buf[0] = START_OF_MSG0; buf[1] = START_OF_MSG1, buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // packet id (1 byte)
     buf[0] = ACT_GAIN_PACKET_ID;
     // packet length (1 byte)
     buf[1] = 3;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     buf[size++] = (uint8_t)channel;
 
@@ -369,12 +395,12 @@ static bool APM2_act_gain_mode( int channel, float gain)
     buf[size++] = hi;
     
     // write packet
-    /* len = */ write( fd, buf, size );
+    APM2_write( buf, size );
   
     // check sum (2 bytes)
     APM2_cksum( ACT_GAIN_PACKET_ID, size, buf, size, &cksum0, &cksum1 );
     buf[0] = cksum0; buf[1] = cksum1; buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     return true;
 }
@@ -390,13 +416,13 @@ static bool APM2_act_mix_mode( int mode_id, bool enable,
 
     // start of message sync bytes
     buf[0] = START_OF_MSG0; buf[1] = START_OF_MSG1, buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // packet id (1 byte)
     buf[0] = MIX_MODE_PACKET_ID;
     // packet length (1 byte)
     buf[1] = 6;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     buf[size++] = mode_id;
     buf[size++] = enable;
@@ -419,12 +445,12 @@ static bool APM2_act_mix_mode( int mode_id, bool enable,
     buf[size++] = hi;
     
     // write packet
-    /* len = */ write( fd, buf, size );
+    APM2_write( buf, size );
   
     // check sum (2 bytes)
     APM2_cksum( MIX_MODE_PACKET_ID, size, buf, size, &cksum0, &cksum1 );
     buf[0] = cksum0; buf[1] = cksum1; buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     return true;
 }
@@ -439,13 +465,13 @@ static bool APM2_act_sas_mode( int mode_id, bool enable, float gain)
 
     // start of message sync bytes
     buf[0] = START_OF_MSG0; buf[1] = START_OF_MSG1, buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // packet id (1 byte)
     buf[0] = SAS_MODE_PACKET_ID;
     // packet length (1 byte)
     buf[1] = 4;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     buf[size++] = mode_id;
     buf[size++] = enable;
@@ -461,12 +487,12 @@ static bool APM2_act_sas_mode( int mode_id, bool enable, float gain)
     buf[size++] = hi;
     
     // write packet
-    /* len = */ write( fd, buf, size );
+    APM2_write( buf, size );
   
     // check sum (2 bytes)
     APM2_cksum( SAS_MODE_PACKET_ID, size, buf, size, &cksum0, &cksum1 );
     buf[0] = cksum0; buf[1] = cksum1; buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     return true;
 }
@@ -478,6 +504,7 @@ static void bind_imu_output( string output_node ) {
 	return;
     }
     imu_node = pyGetNode(output_node, true);
+    imu_filter = IMU_filter_bind( output_node );
     imu_inited = true;
 }
 
@@ -570,11 +597,10 @@ static bool APM2_open_device( int baud_bits ) {
     // Enable non-blocking IO (one more time for good measure)
     // fcntl(fd, F_SETFL, O_NONBLOCK);
 
-    // bind main apm2 property nodes here for lack of a better place..
-    apm2_node = pyGetNode("/sensors/APM2", true);
-    power_node = pyGetNode("/sensors/power", true);
-    analog_node = pyGetNode("/sensors/APM2/raw_analog", true);
-    analog_node.setLen("channel", NUM_ANALOG_INPUTS, 0.0);
+    reader.attach( fd );
+    if ( record_file.length() && !reader.record( record_file.c_str() ) ) {
+	return false;
+    }
 
     return true;
 }
@@ -599,6 +625,13 @@ static bool APM2_open() {
     if ( apm2_config.hasChild("baud") ) {
        baud = apm2_config.getLong("baud");
     }
+    if ( apm2_config.hasChild("record") ) {
+	record_file = apm2_config.getString("record");
+    }
+    if ( apm2_config.hasChild("replay") ) {
+	replay_file = apm2_config.getString("replay");
+	replay_realtime = apm2_config.getBool("replay_realtime");
+    }
     if ( apm2_config.hasChild("volt_divider_ratio") ) {
 	volt_div_ratio = apm2_config.getDouble("volt_divider_ratio");
     }
@@ -629,12 +662,27 @@ static bool APM2_open() {
 	printf("unsupported baud rate = %d\n", baud);
     }
 
-    if ( ! APM2_open_device( baud_bits ) ) {
+    bool result = false;
+    if ( replay_file.length() ) {
+	// no device: APM2_write() drops the writes
+	result = reader.replay( replay_file.c_str(), replay_realtime );
+    } else {
+	result = APM2_open_device( baud_bits );
+    }
+    if ( !result ) {
 	printf("device open failed ...\n");
 	return false;
     }
 
-    sleep(1);
+    // bind main apm2 property nodes here for lack of a better place..
+    apm2_node = pyGetNode("/sensors/APM2", true);
+    power_node = pyGetNode("/sensors/power", true);
+    analog_node = pyGetNode("/sensors/APM2/raw_analog", true);
+    analog_node.setLen("channel", NUM_ANALOG_INPUTS, 0.0);
+
+    if ( !replay_file.length() ) {
+	sleep(1);
+    }
     
     master_opened = true;
 
@@ -668,6 +716,7 @@ bool APM2_imu_init( string output_path, pyPropertyNode *config ) {
     
     if ( config->hasChild("calibration") ) {
 	pyPropertyNode cal = config->getChild("calibration");
+	cal_learn_overlay( &cal );
 	double min_temp = 27.0;
 	double max_temp = 27.0;
 	if ( cal.hasChild("min_temp_C") ) {
@@ -707,6 +756,7 @@ bool APM2_imu_init( string output_path, pyPropertyNode *config ) {
 	} else {
 	    mag_cal.setIdentity();
 	}
+	mag_learn.init( mag_cal );
 	
 	// save the imu calibration parameters with the data file so that
 	// later the original raw sensor values can be derived.
@@ -856,7 +906,7 @@ static bool APM2_imu_update_internal() {
 	double imu_remote_sec = (double)imu_micros / 1000000.0;
 	double diff = imu_timestamp - imu_remote_sec;
 	if ( last_imu_micros > imu_micros ) {
-	    events->log("APM2", "micros() rolled over\n");
+	    trace_event( rollover_event );
 	    imu_offset.reset();
 	}
 	imu_offset.update(imu_remote_sec, diff);
@@ -869,20 +919,19 @@ static bool APM2_imu_update_internal() {
 	imu_node.setDouble( "timestamp", imu_remote_sec + fit_diff );
 	imu_node.setLong( "imu_micros", imu_micros );
 	imu_node.setDouble( "imu_sec", (double)imu_micros / 1000000.0 );
-	imu_node.setDouble( "p_rad_sec", p_raw );
-	imu_node.setDouble( "q_rad_sec", q_raw );
-	imu_node.setDouble( "r_rad_sec", r_raw );
-	imu_node.setDouble( "ax_mps_sec", ax_cal.calibrate(ax_raw, temp_C) );
-	imu_node.setDouble( "ay_mps_sec", ay_cal.calibrate(ay_raw, temp_C) );
-	imu_node.setDouble( "az_mps_sec", az_cal.calibrate(az_raw, temp_C) );
 	imu_node.setLong( "hx_raw", hx );
 	imu_node.setLong( "hy_raw", hy );
 	imu_node.setLong( "hz_raw", hz );
+	mag_learn.sample( hx, hy, hz );
+	mag_learn.update( &mag_cal );
 	Vector4d hs((double)hx, (double)hy, (double)hz, 1.0);
 	Vector4d hc = mag_cal * hs;
-	imu_node.setDouble( "hx", hc(0) );
-	imu_node.setDouble( "hy", hc(1) );
-	imu_node.setDouble( "hz", hc(2) );
+	float x[9] = { (float)p_raw, (float)q_raw, (float)r_raw,
+		       (float)ax_cal.calibrate(ax_raw, temp_C),
+		       (float)ay_cal.calibrate(ay_raw, temp_C),
+		       (float)az_cal.calibrate(az_raw, temp_C),
+		       (float)hc(0), (float)hc(1), (float)hc(2) };
+	IMU_publish( imu_filter, &imu_node, x );
 	imu_node.setDouble( "temp_C", temp_C );
     }
 
@@ -1096,15 +1145,10 @@ static bool APM2_parse( uint8_t pkt_id, uint8_t pkt_len,
 	    if ( first_time ) {
 		// log the data to events.txt
 		first_time = false;
-		char buf[128];
-		snprintf( buf, 32, "Serial Number = %d", serial_num );
-		events->log("APM2", buf );
-		snprintf( buf, 32, "Firmware Revision = %d", firmware_rev );
-		events->log("APM2", buf );
-		snprintf( buf, 32, "Master Hz = %d", master_hz );
-		events->log("APM2", buf );
-		snprintf( buf, 32, "Baud Rate = %d", baud_rate );
-		events->log("APM2", buf );
+		trace_event( serial_event, serial_num );
+		trace_event( firmware_event, firmware_rev );
+		trace_event( master_hz_event, master_hz );
+		trace_event( baud_event, baud_rate );
 	    }
 	} else {
 	    if ( display_on ) {
@@ -1154,11 +1198,11 @@ static int APM2_read() {
     if ( state == 0 ) {
 	counter = 0;
 	cksum_A = cksum_B = 0;
-	len = read( fd, input, 1 );
+	len = reader.read( input );
 	giveup_counter = 0;
 	while ( len > 0 && input[0] != START_OF_MSG0 && giveup_counter < 100 ) {
 	    // fprintf( stderr, "state0: len = %d val = %2X (%c)\n", len, input[0] , input[0]);
-	    len = read( fd, input, 1 );
+	    len = reader.read( input );
 	    giveup_counter++;
 	    // fprintf( stderr, "giveup_counter = %d\n", giveup_counter);
 	}
@@ -1168,7 +1212,7 @@ static int APM2_read() {
 	}
     }
     if ( state == 1 ) {
-	len = read( fd, input, 1 );
+	len = reader.read( input );
 	if ( len > 0 ) {
 	    if ( input[0] == START_OF_MSG1 ) {
 		//fprintf( stderr, "read START_OF_MSG1\n");
@@ -1181,7 +1225,7 @@ static int APM2_read() {
 	}
     }
     if ( state == 2 ) {
-	len = read( fd, input, 1 );
+	len = reader.read( input );
 	if ( len > 0 ) {
 	    pkt_id = input[0];
 	    cksum_A += input[0];
@@ -1191,7 +1235,7 @@ static int APM2_read() {
 	}
     }
     if ( state == 3 ) {
-	len = read( fd, input, 1 );
+	len = reader.read( input );
 	if ( len > 0 ) {
 	    pkt_len = input[0];
 	    if ( pkt_len < 256 ) {
@@ -1205,7 +1249,7 @@ static int APM2_read() {
 	}
     }
     if ( state == 4 ) {
-	len = read( fd, input, 1 );
+	len = reader.read( input );
 	while ( len > 0 ) {
 	    payload[counter++] = input[0];
 	    // fprintf( stderr, "%02X ", input[0] );
@@ -1214,7 +1258,7 @@ static int APM2_read() {
 	    if ( counter >= pkt_len ) {
 		break;
 	    }
-	    len = read( fd, input, 1 );
+	    len = reader.read( input );
 	}
 
 	if ( counter >= pkt_len ) {
@@ -1223,14 +1267,14 @@ static int APM2_read() {
 	}
     }
     if ( state == 5 ) {
-	len = read( fd, input, 1 );
+	len = reader.read( input );
 	if ( len > 0 ) {
 	    cksum_lo = input[0];
 	    state++;
 	}
     }
     if ( state == 6 ) {
-	len = read( fd, input, 1 );
+	len = reader.read( input );
 	if ( len > 0 ) {
 	    cksum_hi = input[0];
 	    if ( cksum_A == cksum_lo && cksum_B == cksum_hi ) {
@@ -1540,13 +1584,13 @@ static bool APM2_act_write() {
 
     // start of message sync bytes
     buf[0] = START_OF_MSG0; buf[1] = START_OF_MSG1, buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // packet id (1 byte)
     buf[0] = FLIGHT_COMMAND_PACKET_ID;
     // packet length (1 byte)
     buf[1] = 2 * NUM_ACTUATORS;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     // actuator data
     if ( NUM_ACTUATORS == 8 ) {
@@ -1603,12 +1647,12 @@ static bool APM2_act_write() {
     }
 
     // write packet
-    /* len = */ write( fd, buf, size );
+    APM2_write( buf, size );
   
     // check sum (2 bytes)
     APM2_cksum( FLIGHT_COMMAND_PACKET_ID, size, buf, size, &cksum0, &cksum1 );
     buf[0] = cksum0; buf[1] = cksum1; buf[2] = 0;
-    /* len = */ write( fd, buf, 2 );
+    APM2_write( buf, 2 );
 
     return true;
 }
@@ -1624,12 +1668,10 @@ double APM2_update() {
     // reading the uart buffer is our signal to run an interation of
     // the main loop.
     double last_time = imu_node.getDouble( "timestamp" );
-    int bytes_available = 0;
-    while ( true ) {
+    while ( !reader.eof() ) {
         int pkt_id = APM2_read();
         if ( pkt_id == IMU_PACKET_ID ) {
-            ioctl(fd, FIONREAD, &bytes_available);
-	    if ( bytes_available < 64 ) {
+	    if ( reader.bytes_available() < 64 ) {
 		break;
             }
         }
@@ -1869,7 +1911,11 @@ bool APM2_act_update() {
 
 
 void APM2_close() {
-    close(fd);
+    reader.close();
+    if ( fd >= 0 ) {
+	close(fd);
+	fd = -1;
+    }
 
     master_opened = false;
 }
@@ -16,9 +16,13 @@ using namespace Eigen;
 #include "comms/display.hxx"
 #include "comms/logging.hxx"
 #include "comms/serial_link.hxx"
+#include "comms/trace.hxx"
 #include "init/globals.hxx"
+#include "sensors/cal_learn.hxx"
 #include "sensors/cal_temp.hxx"
-#include "util/butter.hxx"
+#include "sensors/imu_filter.hxx"
+#include "sensors/mag_learn.hxx"
+#include "util/biquad.hxx"
 #include "util/linearfit.hxx"
 #include "util/lowpass.hxx"
 #include "util/timing.h"
@@ -33,6 +37,7 @@ using namespace Eigen;
 static pyPropertyNode aura3_node;
 static pyPropertyNode power_node;
 static pyPropertyNode imu_node;
+static imu_filter_t *imu_filter = NULL;
 static pyPropertyNode gps_node;
 static pyPropertyNode pilot_node;
 static pyPropertyNode act_node;
@@ -52,6 +57,9 @@ bool Aura3_actuator_configured = false; // externally visible
 static SerialLink serial;
 static string device_name = "/dev/ttyS4";
 static int baud = 500000;
+static string record_file = "";       // log the raw link to this file
+static string replay_file = "";       // read a recorded link instead
+static bool replay_realtime = false;
 
 static float volt_div_ratio = 100; // a nonsense value
 static int battery_cells = 4;
@@ -74,7 +82,14 @@ static LinearFitFilter imu_offset(200.0, 0.01);
 // 2nd order filter, 100hz sample rate expected, 3rd field is cutoff freq.
 // higher freq value == noisier, a value near 1 hz should work well
 // for airspeed.
-static ButterworthFilter pitot_filter(2, 100, 0.8);
+static ButterworthLowpass<2> pitot_filter(100, 0.8);
+
+// event log messages
+static int rollover_event = trace_register("Aura3", "rollover", "micros() rolled over");
+static int serial_event = trace_register("Aura3", "info", "Serial Number = %.0f");
+static int firmware_event = trace_register("Aura3", "info", "Firmware Revision = %.0f");
+static int master_hz_event = trace_register("Aura3", "info", "Master Hz = %.0f");
+static int baud_event = trace_register("Aura3", "info", "Baud Rate = %.0f");
 
 static uint32_t parse_errors = 0;
 static uint32_t skipped_frames = 0;
@@ -104,6 +119,7 @@ static AuraCalTemp ax_cal;
 static AuraCalTemp ay_cal;
 static AuraCalTemp az_cal;
 static Matrix4d mag_cal;
+static AuraMagLearn mag_learn;
 
 static uint32_t pilot_packet_counter = 0;
 static uint32_t imu_packet_counter = 0;
@@ -174,7 +190,7 @@ static bool Aura3_imu_update_internal() {
 	double imu_remote_sec = (double)imu_micros / 1000000.0;
 	double diff = imu_timestamp - imu_remote_sec;
 	if ( last_imu_micros > imu_micros ) {
-	    events->log("Aura3", "micros() rolled over\n");
+	    trace_event( rollover_event );
 	    imu_offset.reset();
 	}
 	imu_offset.update(imu_remote_sec, diff);
@@ -187,20 +203,19 @@ static bool Aura3_imu_update_internal() {
 	imu_node.setDouble( "timestamp", imu_remote_sec + fit_diff );
 	imu_node.setLong( "imu_micros", imu_micros );
 	imu_node.setDouble( "imu_sec", (double)imu_micros / 1000000.0 );
-	imu_node.setDouble( "p_rad_sec", p_raw );
-	imu_node.setDouble( "q_rad_sec", q_raw );
-	imu_node.setDouble( "r_rad_sec", r_raw );
-	imu_node.setDouble( "ax_mps_sec", ax_cal.calibrate(ax_raw, temp_C) );
-	imu_node.setDouble( "ay_mps_sec", ay_cal.calibrate(ay_raw, temp_C) );
-	imu_node.setDouble( "az_mps_sec", az_cal.calibrate(az_raw, temp_C) );
 	imu_node.setDouble( "hx_raw", hx_raw );
 	imu_node.setDouble( "hy_raw", hy_raw );
 	imu_node.setDouble( "hz_raw", hz_raw );
+	mag_learn.sample( hx_raw, hy_raw, hz_raw );
+	mag_learn.update( &mag_cal );
 	Vector4d hs((double)hx_raw, (double)hy_raw, (double)hz_raw, 1.0);
 	Vector4d hc = mag_cal * hs;
-	imu_node.setDouble( "hx", hc(0) );
-	imu_node.setDouble( "hy", hc(1) );
-	imu_node.setDouble( "hz", hc(2) );
+	float x[9] = { (float)p_raw, (float)q_raw, (float)r_raw,
+		       (float)ax_cal.calibrate(ax_raw, temp_C),
+		       (float)ay_cal.calibrate(ay_raw, temp_C),
+		       (float)az_cal.calibrate(az_raw, temp_C),
+		       (float)hc(0), (float)hc(1), (float)hc(2) };
+	IMU_publish( imu_filter, &imu_node, x );
 	imu_node.setDouble( "temp_C", temp_C );
     }
 
@@ -364,15 +379,10 @@ static bool Aura3_parse( uint8_t pkt_id, uint8_t pkt_len,
 	    if ( first_time ) {
 		// log the data to events.txt
 		first_time = false;
-		char buf[128];
-		snprintf( buf, 32, "Serial Number = %d", msg.serial_number );
-		events->log("Aura3", buf );
-		snprintf( buf, 32, "Firmware Revision = %d", msg.firmware_rev );
-		events->log("Aura3", buf );
-		snprintf( buf, 32, "Master Hz = %d", msg.master_hz );
-		events->log("Aura3", buf );
-		snprintf( buf, 32, "Baud Rate = %d", msg.baud );
-		events->log("Aura3", buf );
+		trace_event( serial_event, msg.serial_number );
+		trace_event( firmware_event, msg.firmware_rev );
+		trace_event( master_hz_event, msg.master_hz );
+		trace_event( baud_event, msg.baud );
 	    }
 	} else {
 	    if ( display_on ) {
@@ -467,6 +477,7 @@ static void bind_imu_output( string output_node ) {
 	return;
     }
     imu_node = pyGetNode(output_node, true);
+    imu_filter = IMU_filter_bind( output_node );
     imu_inited = true;
 }
 
@@ -513,12 +524,19 @@ static void bind_pilot_controls( string output_path ) {
 
 // send our configured init strings to configure gpsd the way we prefer
 static bool Aura3_open_device( int baud ) {
-    if ( display_on ) {
-	printf("Aura3 Sensor Head on %s @ %d baud\n", device_name.c_str(),
-	       baud);
+    bool result = false;
+    if ( replay_file.length() ) {
+	result = serial.open_replay( replay_file.c_str(), replay_realtime );
+    } else {
+	if ( display_on ) {
+	    printf("Aura3 Sensor Head on %s @ %d baud\n", device_name.c_str(),
+		   baud);
+	}
+	result = serial.open( baud, device_name.c_str() );
+	if ( result && record_file.length() ) {
+	    result = serial.record( record_file.c_str() );
+	}
     }
-
-    bool result = serial.open( baud, device_name.c_str() );
     if ( !result ) {
         fprintf( stderr, "Error opening serial link to Aura3 device, cannot continue.\n" );
 	return false;
@@ -551,6 +569,13 @@ static bool Aura3_open() {
     if ( aura3_config.hasChild("baud") ) {
        baud = aura3_config.getLong("baud");
     }
+    if ( aura3_config.hasChild("record") ) {
+	record_file = aura3_config.getString("record");
+    }
+    if ( aura3_config.hasChild("replay") ) {
+	replay_file = aura3_config.getString("replay");
+	replay_realtime = aura3_config.getBool("replay_realtime");
+    }
     if ( aura3_config.hasChild("volt_divider_ratio") ) {
 	volt_div_ratio = aura3_config.getDouble("volt_divider_ratio");
     }
@@ -569,7 +594,9 @@ static bool Aura3_open() {
 	return false;
     }
 
-    sleep(1);
+    if ( !replay_file.length() ) {
+	sleep(1);
+    }
     
     master_opened = true;
 
@@ -599,6 +626,7 @@ bool Aura3_imu_init( string output_path, pyPropertyNode *config ) {
 
     if ( config->hasChild("calibration") ) {
 	pyPropertyNode cal = config->getChild("calibration");
+	cal_learn_overlay( &cal );
 	double min_temp = 27.0;
 	double max_temp = 27.0;
 	if ( cal.hasChild("min_temp_C") ) {
@@ -638,6 +666,7 @@ bool Aura3_imu_init( string output_path, pyPropertyNode *config ) {
 	} else {
 	    mag_cal.setIdentity();
 	}
+	mag_learn.init( mag_cal );
 	
 	// save the imu calibration parameters with the data file so that
 	// later the original raw sensor values can be derived.
@@ -1077,7 +1106,7 @@ double Aura3_update() {
     // the main loop.
     double last_time = imu_node.getDouble( "timestamp" );
 
-    while ( true ) {
+    while ( !serial.at_end() ) {
         if ( serial.update() ) {
             Aura3_parse( serial.pkt_id, serial.pkt_len, serial.payload );
             if ( serial.pkt_id == message::imu_raw_id ) {
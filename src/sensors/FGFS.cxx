@@ -19,6 +19,7 @@ using std::endl;
 #include "filters/nav_common/nav_functions_float.hxx"
 #include "util/netSocket.h"
 #include "util/timing.h"
+#include "imu_filter.hxx"
 
 #include "FGFS.hxx"
 
@@ -29,8 +30,12 @@ static netSocket sock_gps;
 static int port_imu = 0;
 static int port_gps = 0;
 
+// lockstep: run on the simulator's clock, see FGFS.hxx
+static bool lockstep = false;
+
 // property nodes
 static pyPropertyNode imu_node;
+static imu_filter_t *imu_filter = NULL;
 static pyPropertyNode gps_node;
 static pyPropertyNode airdata_node;
 static pyPropertyNode act_node;
@@ -50,6 +55,7 @@ static void bind_imu_input( pyPropertyNode *config ) {
     if ( config->hasChild("port") ) {
 	port_imu = config->getLong("port");
     }
+    lockstep = config->getBool("lockstep");
 }
 
 
@@ -64,6 +70,7 @@ static void bind_gps_input( pyPropertyNode *config ) {
 // initialize imu output property nodes 
 static void bind_imu_output( string output_path ) {
     imu_node = pyGetNode(output_path, true);
+    imu_filter = IMU_filter_bind( output_path );
     act_node = pyGetNode("/actuators", true);
     config_specs_node = pyGetNode("/config/specs", true);
     power_node = pyGetNode("/sensors/power", true);
@@ -192,7 +199,7 @@ static bool fgfs_imu_sync_update() {
 	}
 
 	uint8_t *buf = packet_buf;
-	/*double time = *(double *)buf;*/ buf += 8;
+	double time = *(double *)buf; buf += 8;
 	float p = *(float *)buf; buf += 4;
 	float q = *(float *)buf; buf += 4;
 	float r = *(float *)buf; buf += 4;
@@ -227,17 +234,15 @@ static bool fgfs_imu_sync_update() {
         mag_body.normalize();
         // cout << "mag vector (body): " << mag_body(0) << " " << mag_body(1) << " " << mag_body(2) << endl;
 
+	if ( lockstep ) {
+	    // every get_Time() stamp this frame is simulator time
+	    set_Time_virtual( time );
+	}
 	double cur_time = get_Time();
 	imu_node.setDouble( "timestamp", cur_time );
-	imu_node.setDouble( "p_rad_sec", ngv(0) );
-	imu_node.setDouble( "q_rad_sec", ngv(1) );
-	imu_node.setDouble( "r_rad_sec", ngv(2) );
-	imu_node.setDouble( "ax_mps_sec", nav(0) );
-	imu_node.setDouble( "ay_mps_sec", nav(1) );
-	imu_node.setDouble( "az_mps_sec", nav(2) );
-	imu_node.setDouble( "hx", mag_body(0) );
-	imu_node.setDouble( "hy", mag_body(1) );
-	imu_node.setDouble( "hz", mag_body(2) );
+	float x[9] = { ngv(0), ngv(1), ngv(2), nav(0), nav(1), nav(2),
+		       mag_body(0), mag_body(1), mag_body(2) };
+	IMU_publish( imu_filter, &imu_node, x );
 	imu_node.setDouble( "roll_truth", roll_truth );
 	imu_node.setDouble( "pitch_truth", pitch_truth );
 	imu_node.setDouble( "yaw_truth", yaw_truth );
@@ -387,18 +392,29 @@ bool fgfs_pilot_update() {
 }
 
 
+// back to the system clock once the simulator goes away, whichever
+// fgfs driver is closed first
+static void lockstep_close() {
+    if ( lockstep ) {
+	set_Time_source( NULL );
+	lockstep = false;
+    }
+}
+
 void fgfs_imu_close() {
     sock_imu.close();
+    lockstep_close();
 }
 
 void fgfs_airdata_close() {
-    // no op
+    lockstep_close();
 }
 
 void fgfs_gps_close() {
     sock_gps.close();
+    lockstep_close();
 }
 
 void fgfs_pilot_close() {
-    // no op
+    lockstep_close();
 }
@@ -3,6 +3,24 @@
 // DESCRIPTION: aquire live sensor data from an running copy of Flightgear
 //
 
+// Lockstep (set lockstep: true in the fgfs imu config section):
+// aura runs on the simulator's clock instead of the host's.  The time
+// field of each imu packet becomes get_Time() for the frame it starts,
+// so every time stamp, timeout and rate downstream follows the
+// simulator.  The simulator drives the loop one frame at a time:
+//
+//   1. send the gps packet (if one is due) then the imu packet for
+//      time t
+//   2. wait for the actuator packet (fgfs actuator module) stamped t,
+//      that is the autopilot's output for the frame
+//   3. step the model by dt using those actuator values, t += dt
+//
+// aura never waits on the host clock in between, so a mission runs as
+// fast as the two sides can compute, and the same inputs give the
+// same flight.  Helpers that hand results back asynchronously (i.e.
+// mag_learn) should be disabled for runs that need to reproduce
+// exactly.
+
 #pragma once
 
 // function prototypes
@@ -0,0 +1,424 @@
+/**
+ * \file: bus_poll.cxx
+ *
+ * Polling engine for sensors attached directly to linux i2c-dev and
+ * spidev busses.
+ *
+ */
+
+#include <errno.h>		// errno
+#include <fcntl.h>		// open()
+#include <linux/i2c.h>		// i2c_msg
+#include <linux/i2c-dev.h>	// I2C_RDWR
+#include <linux/spi/spidev.h>	// SPI_IOC_MESSAGE()
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>		// memset(), strerror()
+#include <sys/ioctl.h>
+#include <time.h>		// clock_gettime()
+#include <unistd.h>		// usleep()
+
+#include <atomic>
+#include <map>
+#include <vector>
+using std::map;
+using std::vector;
+
+#include "init/runtime.hxx"
+#include "util/timing.h"
+
+#include "bus_poll.hxx"
+
+static const int queue_size = 256;	// samples, power of 2
+static const int max_batch = bus_max_reads * 16;
+static const int max_read_len = bus_max_read_len;
+
+static vector<bus_device_t> devices;
+static map<string, BusBackend *> busses;
+
+// failed transfers per device, counted on the polling thread and
+// read from the flight thread
+static std::atomic<uint32_t> device_errors[bus_max_devices];
+
+// single producer (polling thread) / single consumer (flight thread)
+static bus_sample_t queue[queue_size];
+static std::atomic<uint32_t> queue_head(0);
+static std::atomic<uint32_t> queue_tail(0);
+static std::atomic<uint32_t> dropped(0);
+
+// wakes the flight thread when a poll pass queued new samples
+static pthread_mutex_t sample_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sample_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_t poll_thread;
+static bool poll_running = false;
+static std::atomic<bool> poll_stop(false);
+
+
+// linux i2c-dev: each read is a register address write followed by
+// a repeated start read, all of them in one I2C_RDWR ioctl.
+class I2CBus: public BusBackend {
+
+private:
+
+    int fd;
+    uint8_t regs[max_batch];
+    struct i2c_msg msgs[2 * max_batch];
+
+public:
+
+    I2CBus( int _fd ): fd(_fd) {}
+
+    bool write_reg( uint8_t addr, uint8_t reg, uint8_t value ) {
+	uint8_t buf[2] = { reg, value };
+	struct i2c_msg msg = { addr, 0, 2, buf };
+	struct i2c_rdwr_ioctl_data data = { &msg, 1 };
+	return ioctl( fd, I2C_RDWR, &data ) == 1;
+    }
+
+    bool transfer( bus_read_t *reads, int count ) {
+	if ( count > max_batch ) {
+	    return false;
+	}
+	int n = 0;
+	for ( int i = 0; i < count; i++ ) {
+	    if ( reads[i].len <= 0 || reads[i].len > max_read_len ) {
+		return false;
+	    }
+	    if ( reads[i].reg >= 0 ) {
+		regs[i] = reads[i].reg;
+		msgs[n].addr = reads[i].addr;
+		msgs[n].flags = 0;
+		msgs[n].len = 1;
+		msgs[n].buf = &regs[i];
+		n++;
+	    }
+	    msgs[n].addr = reads[i].addr;
+	    msgs[n].flags = I2C_M_RD;
+	    msgs[n].len = reads[i].len;
+	    msgs[n].buf = reads[i].buf;
+	    n++;
+	}
+	// the kernel caps the messages per ioctl
+	int start = 0;
+	while ( start < n ) {
+	    int chunk = n - start;
+	    if ( chunk > I2C_RDWR_IOCTL_MAX_MSGS ) {
+		chunk = I2C_RDWR_IOCTL_MAX_MSGS;
+		// keep a register write together with its read
+		if ( !(msgs[start + chunk - 1].flags & I2C_M_RD) ) {
+		    chunk--;
+		}
+	    }
+	    struct i2c_rdwr_ioctl_data data = { &msgs[start], (uint32_t)chunk };
+	    if ( ioctl( fd, I2C_RDWR, &data ) != chunk ) {
+		return false;
+	    }
+	    start += chunk;
+	}
+	return true;
+    }
+};
+
+
+// linux spidev: each read is one chip select cycle (register address
+// with the read bit set, then the data), all of them in one
+// SPI_IOC_MESSAGE ioctl.
+class SPIBus: public BusBackend {
+
+private:
+
+    int fd;
+    uint8_t tx[max_batch][max_read_len + 1];
+    uint8_t rx[max_batch][max_read_len + 1];
+    struct spi_ioc_transfer xfers[max_batch];
+
+public:
+
+    SPIBus( int _fd ): fd(_fd) {}
+
+    bool write_reg( uint8_t addr, uint8_t reg, uint8_t value ) {
+	uint8_t buf[2] = { (uint8_t)(reg & 0x7f), value };
+	struct spi_ioc_transfer xfer;
+	memset( &xfer, 0, sizeof(xfer) );
+	xfer.tx_buf = (unsigned long)buf;
+	xfer.len = 2;
+	return ioctl( fd, SPI_IOC_MESSAGE(1), &xfer ) >= 0;
+    }
+
+    bool transfer( bus_read_t *reads, int count ) {
+	if ( count > max_batch ) {
+	    return false;
+	}
+	for ( int i = 0; i < count; i++ ) {
+	    if ( reads[i].len <= 0 || reads[i].len > max_read_len ) {
+		return false;
+	    }
+	}
+	memset( xfers, 0, sizeof(xfers[0]) * count );
+	for ( int i = 0; i < count; i++ ) {
+	    int len = reads[i].len;
+	    int offset = 0;
+	    if ( reads[i].reg >= 0 ) {
+		memset( tx[i], 0, len + 1 );
+		tx[i][0] = reads[i].reg | 0x80;
+		offset = 1;
+	    }
+	    xfers[i].tx_buf = (unsigned long)tx[i];
+	    xfers[i].rx_buf = (unsigned long)rx[i];
+	    xfers[i].len = len + offset;
+	    xfers[i].cs_change = (i < count - 1);
+	}
+	if ( ioctl( fd, SPI_IOC_MESSAGE(count), xfers ) < 0 ) {
+	    return false;
+	}
+	for ( int i = 0; i < count; i++ ) {
+	    int offset = reads[i].reg >= 0 ? 1 : 0;
+	    memcpy( reads[i].buf, rx[i] + offset, reads[i].len );
+	}
+	return true;
+    }
+};
+
+
+FakeBus::FakeBus() {
+    memset( regs, 0, sizeof(regs) );
+    transfers = 0;
+    reads = 0;
+}
+
+bool FakeBus::write_reg( uint8_t addr, uint8_t reg, uint8_t value ) {
+    regs[addr & 0x7f][reg] = value;
+    return true;
+}
+
+bool FakeBus::transfer( bus_read_t *r, int count ) {
+    transfers++;
+    for ( int i = 0; i < count; i++ ) {
+	int reg = r[i].reg >= 0 ? r[i].reg : 0;
+	for ( int j = 0; j < r[i].len; j++ ) {
+	    r[i].buf[j] = regs[r[i].addr & 0x7f][(reg + j) & 0xff];
+	}
+	reads++;
+    }
+    return true;
+}
+
+
+BusBackend *bus_open( const string &device, int spi_hz ) {
+    map<string, BusBackend *>::iterator it = busses.find( device );
+    if ( it != busses.end() ) {
+	return it->second;
+    }
+
+    BusBackend *bus = NULL;
+    if ( device == "fake" ) {
+	bus = new FakeBus;
+    } else {
+	int fd = open( device.c_str(), O_RDWR );
+	if ( fd < 0 ) {
+	    printf("bus: unable to open %s - %s\n", device.c_str(),
+		   strerror(errno));
+	    return NULL;
+	}
+	if ( device.find("spidev") != string::npos ) {
+	    uint8_t mode = SPI_MODE_3;
+	    uint8_t bits = 8;
+	    uint32_t speed = spi_hz;
+	    if ( ioctl( fd, SPI_IOC_WR_MODE, &mode ) < 0
+		 || ioctl( fd, SPI_IOC_WR_BITS_PER_WORD, &bits ) < 0
+		 || ioctl( fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed ) < 0 ) {
+		printf("bus: unable to configure %s - %s\n", device.c_str(),
+		       strerror(errno));
+		close( fd );
+		return NULL;
+	    }
+	    bus = new SPIBus( fd );
+	} else {
+	    bus = new I2CBus( fd );
+	}
+    }
+    busses[device] = bus;
+    return bus;
+}
+
+int bus_add_device( const bus_device_t &device ) {
+    if ( devices.size() >= (unsigned int)bus_max_devices ) {
+	printf("bus: more than %d devices\n", bus_max_devices);
+	return -1;
+    }
+    if ( device.nreads < 1 || device.nreads > bus_max_reads ) {
+	printf("bus: device needs 1-%d reads\n", bus_max_reads);
+	return -1;
+    }
+    for ( int i = 0; i < device.nreads; i++ ) {
+	if ( device.reads[i].len <= 0 || device.reads[i].len > max_read_len ) {
+	    printf("bus: read of %d bytes (max %d)\n", device.reads[i].len,
+		   max_read_len);
+	    return -1;
+	}
+    }
+    devices.push_back( device );
+    devices.back().next_time = 0.0;
+    device_errors[devices.size() - 1].store( 0 );
+    return devices.size() - 1;
+}
+
+static void push_sample( const bus_sample_t &sample ) {
+    uint32_t head = queue_head.load( std::memory_order_relaxed );
+    uint32_t tail = queue_tail.load( std::memory_order_acquire );
+    if ( head - tail >= (uint32_t)queue_size ) {
+	dropped.fetch_add( 1, std::memory_order_relaxed );
+	return;
+    }
+    queue[head & (queue_size - 1)] = sample;
+    queue_head.store( head + 1, std::memory_order_release );
+}
+
+// read every device that is due, one batched transfer per bus
+double bus_poll_once( double now ) {
+    bus_read_t batch[max_batch];
+    int owner[max_batch];
+    double next = now + 1.0;
+
+    for ( map<string, BusBackend *>::iterator it = busses.begin();
+	  it != busses.end(); ++it ) {
+	BusBackend *bus = it->second;
+	int count = 0;
+	for ( unsigned int i = 0; i < devices.size(); i++ ) {
+	    bus_device_t *dev = &devices[i];
+	    if ( dev->bus != bus || dev->next_time > now
+		 || count + dev->nreads > max_batch ) {
+		continue;
+	    }
+	    for ( int j = 0; j < dev->nreads; j++ ) {
+		batch[count] = dev->reads[j];
+		owner[count] = i;
+		count++;
+	    }
+	}
+	if ( count == 0 ) {
+	    continue;
+	}
+	uint32_t queued = queue_head.load( std::memory_order_relaxed );
+	bool ok = bus->transfer( batch, count );
+	double stamp = get_Time();
+	int last = -1;
+	for ( int k = 0; k < count; k++ ) {
+	    if ( owner[k] == last ) {
+		continue;
+	    }
+	    last = owner[k];
+	    bus_device_t *dev = &devices[last];
+	    // hold the rate without drifting, but don't try to catch
+	    // up after a stall
+	    dev->next_time += 1.0 / dev->rate_hz;
+	    if ( dev->next_time < now ) {
+		dev->next_time = now + 1.0 / dev->rate_hz;
+	    }
+	    if ( !ok ) {
+		device_errors[last].fetch_add( 1, std::memory_order_relaxed );
+		continue;
+	    }
+	    bus_sample_t sample;
+	    memset( &sample, 0, sizeof(sample) );
+	    sample.timestamp = stamp;
+	    sample.device = last;
+	    if ( dev->decode( dev, &sample ) ) {
+		push_sample( sample );
+	    }
+	}
+	if ( queue_head.load( std::memory_order_relaxed ) != queued ) {
+	    pthread_mutex_lock( &sample_mutex );
+	    pthread_cond_broadcast( &sample_cond );
+	    pthread_mutex_unlock( &sample_mutex );
+	}
+    }
+
+    for ( unsigned int i = 0; i < devices.size(); i++ ) {
+	if ( devices[i].next_time < next ) {
+	    next = devices[i].next_time;
+	}
+    }
+    return next;
+}
+
+static void *poll_main( void *arg ) {
+    runtime_helper_thread_init( "bus" );
+    while ( !poll_stop.load() ) {
+	double now = get_Time();
+	double next = bus_poll_once( now );
+	double wait = next - get_Time();
+	if ( wait > 0.0 ) {
+	    usleep( wait * 1000000 );
+	}
+    }
+    return NULL;
+}
+
+bool bus_start() {
+    if ( poll_running || devices.empty() ) {
+	return true;
+    }
+    int result = pthread_create( &poll_thread, NULL, poll_main, NULL );
+    if ( result != 0 ) {
+	printf("bus: unable to start polling thread - %s\n", strerror(result));
+	return false;
+    }
+    poll_running = true;
+    return true;
+}
+
+bool bus_pop( bus_sample_t *sample ) {
+    uint32_t tail = queue_tail.load( std::memory_order_relaxed );
+    uint32_t head = queue_head.load( std::memory_order_acquire );
+    if ( tail == head ) {
+	return false;
+    }
+    *sample = queue[tail & (queue_size - 1)];
+    queue_tail.store( tail + 1, std::memory_order_release );
+    return true;
+}
+
+static bool queue_empty() {
+    return queue_tail.load( std::memory_order_relaxed )
+	== queue_head.load( std::memory_order_acquire );
+}
+
+bool bus_wait( double timeout_sec ) {
+    if ( !queue_empty() ) {
+	return true;
+    }
+    struct timespec deadline;
+    clock_gettime( CLOCK_REALTIME, &deadline );
+    long nsec = deadline.tv_nsec + (long)(timeout_sec * 1000000000.0);
+    deadline.tv_sec += nsec / 1000000000;
+    deadline.tv_nsec = nsec % 1000000000;
+    pthread_mutex_lock( &sample_mutex );
+    int result = 0;
+    while ( queue_empty() && result == 0 ) {
+	result = pthread_cond_timedwait( &sample_cond, &sample_mutex,
+					 &deadline );
+    }
+    pthread_mutex_unlock( &sample_mutex );
+    return !queue_empty();
+}
+
+uint32_t bus_dropped() {
+    return dropped.load( std::memory_order_relaxed );
+}
+
+uint32_t bus_errors( int handle ) {
+    if ( handle < 0 || handle >= bus_max_devices ) {
+	return 0;
+    }
+    return device_errors[handle].load( std::memory_order_relaxed );
+}
+
+void bus_stop() {
+    if ( poll_running ) {
+	poll_stop.store( true );
+	pthread_join( poll_thread, NULL );
+	poll_running = false;
+    }
+}
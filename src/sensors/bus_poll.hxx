@@ -0,0 +1,112 @@
+/**
+ * \file: bus_poll.hxx
+ *
+ * Polling engine for sensors attached directly to linux i2c-dev and
+ * spidev busses.
+ *
+ * Devices are registered with the register blocks they need read and
+ * a rate.  A helper thread wakes up when the next device is due,
+ * collects every due read on a bus into one batched transfer
+ * (I2C_RDWR or SPI_IOC_MESSAGE), decodes the results and pushes them
+ * into a single sample queue that the flight thread drains.
+ *
+ * A "fake" bus backend serves reads from an in memory register map
+ * so the engine and the device decoders can be run without hardware.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+using std::string;
+
+// one register block read (reg < 0 is a plain read with no register
+// address written first, i.e. the MS4525DO)
+struct bus_read_t {
+    uint8_t addr;		// i2c address (unused on spi)
+    int reg;
+    int len;
+    uint8_t *buf;
+};
+
+struct bus_sample_t {
+    double timestamp;
+    int device;			// bus_add_device() handle
+    float values[12];
+};
+
+class BusBackend {
+
+public:
+
+    virtual ~BusBackend() {}
+
+    virtual bool write_reg( uint8_t addr, uint8_t reg, uint8_t value ) = 0;
+
+    // perform all the reads as one batched transfer
+    virtual bool transfer( bus_read_t *reads, int count ) = 0;
+};
+
+// in memory register map, for testing
+class FakeBus: public BusBackend {
+
+public:
+
+    uint8_t regs[128][256];	// [addr][reg], plain reads start at 0
+    int transfers;		// batched transfers performed
+    int reads;			// individual reads performed
+
+    FakeBus();
+    bool write_reg( uint8_t addr, uint8_t reg, uint8_t value );
+    bool transfer( bus_read_t *reads, int count );
+};
+
+// "/dev/i2c-N", "/dev/spidevB.C" or "fake".  Opening the same bus
+// twice returns the same backend so devices on it are batched
+// together.  spi_hz only applies to spidev busses.
+BusBackend *bus_open( const string &device, int spi_hz = 1000000 );
+
+const int bus_max_reads = 4;
+const int bus_max_read_len = 64;
+const int bus_max_devices = 16;
+
+struct bus_device_t {
+    BusBackend *bus;
+    double rate_hz;
+    bus_read_t reads[bus_max_reads];
+    int nreads;
+    // fill in sample->values from the read buffers, return false to
+    // drop the sample (i.e. sensor reports stale data.)  Runs on the
+    // polling thread.
+    bool (*decode)( bus_device_t *dev, bus_sample_t *sample );
+    void *context;
+    double next_time;		// (polling thread)
+};
+
+// register a device before bus_start(), returns its handle or -1
+// (too many devices, or reads longer than bus_max_read_len)
+int bus_add_device( const bus_device_t &device );
+
+// start the polling thread
+bool bus_start();
+
+// one polling pass on the calling thread at time now, returns the
+// time the next device is due.  The polling thread calls this in a
+// loop, tests can call it directly instead of starting the thread.
+double bus_poll_once( double now );
+
+// flight thread: block until a sample is queued, false on timeout
+bool bus_wait( double timeout_sec );
+
+// flight thread: pop the oldest sample, false when the queue is empty
+bool bus_pop( bus_sample_t *sample );
+
+// samples lost because the flight thread fell behind
+uint32_t bus_dropped();
+
+// failed transfers for a device
+uint32_t bus_errors( int handle );
+
+// stop the polling thread
+void bus_stop();
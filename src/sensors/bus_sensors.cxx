@@ -0,0 +1,588 @@
+/**
+ * \file: bus_sensors.cxx
+ *
+ * Sensors read through the i2c/spi polling engine.  Setup happens on
+ * the flight thread before the polling thread starts, the decoders
+ * run on the polling thread and everything that touches the property
+ * tree runs on the flight thread.
+ *
+ */
+
+#include <pyprops.hxx>
+
+#include <math.h>		// sqrt()
+#include <stdio.h>
+#include <string.h>		// memset()
+#include <unistd.h>		// usleep()
+
+#include "include/globaldefs.h"
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+#include "comms/display.hxx"
+#include "comms/logging.hxx"
+#include "sensors/cal_learn.hxx"
+#include "sensors/cal_temp.hxx"
+#include "sensors/imu_filter.hxx"
+#include "sensors/mag_learn.hxx"
+#include "util/strutils.hxx"
+#include "util/timing.h"
+
+#include "bus_sensors.hxx"
+
+
+// register blocks and decoder state, one per device instance
+struct mpu9250_t {
+    // accel, temp, gyro, then the AK8963 block (HXL..HZH, ST2) copied
+    // in by the internal i2c master
+    uint8_t data[21];
+    bool mag_found;
+    float mag_adj[3];		// fuse rom sensitivity adjustment
+};
+
+struct bmp280_t {
+    uint8_t data[6];
+    // calibration constants
+    uint16_t T1;
+    int16_t T2, T3;
+    uint16_t P1;
+    int16_t P2, P3, P4, P5, P6, P7, P8, P9;
+};
+
+struct ms4525do_t {
+    uint8_t data[4];
+    double range_psi;
+};
+
+// property nodes
+static pyPropertyNode imu_node;
+static imu_filter_t *imu_filter = NULL;
+static pyPropertyNode airdata_node;
+
+static int imu_handle = -1;
+static int baro_handle = -1;
+static int pitot_handle = -1;
+
+// newest sample per device, drained from the queue by whichever
+// manager runs first each frame
+static const int max_devices = bus_max_devices;
+static bus_sample_t latest[max_devices];
+static bool fresh[max_devices];
+
+static bool imu_synced = false;	// bus_update() already published
+static float mag_last[3] = { 0.0, 0.0, 0.0 };
+
+// chip axes to body (NED) axes.  Default is the mpu9250 mounted flat,
+// component side up, x forward: the chip z axis points up so y and z
+// flip.
+static Matrix3f orientation = Vector3f(1.0, -1.0, -1.0).asDiagonal();
+static AuraCalTemp ax_cal;
+static AuraCalTemp ay_cal;
+static AuraCalTemp az_cal;
+static Matrix4d mag_cal = Matrix4d::Identity();
+static AuraMagLearn mag_learn;
+static double last_bias_update = 0.0;
+
+static bool airspeed_inited = false;
+static double airspeed_zero_start_time = 0.0;
+static double diff_sum = 0.0;
+static int diff_count = 0;
+static float diff_offset = 0.0;
+
+
+static inline int16_t be16( const uint8_t *p ) {
+    return (int16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint16_t le16( const uint8_t *p ) {
+    return p[0] | (p[1] << 8);
+}
+
+
+// MPU9250: accel, temp and gyro in one 14 byte block followed by
+// the AK8963 magnetometer through the external sensor registers
+static bool mpu9250_decode( bus_device_t *dev, bus_sample_t *sample ) {
+    const float accel_scale = 9.80665 / 4096.0; // +/- 8g
+    const float gyro_scale = 2000.0 / 32768.0 * SGD_DEGREES_TO_RADIANS;
+    const float mag_scale = 0.15;		 // uT, 16 bit output
+    const mpu9250_t *m = (mpu9250_t *)dev->context;
+    const uint8_t *p = m->data;
+    sample->values[0] = be16(p + 0) * accel_scale;
+    sample->values[1] = be16(p + 2) * accel_scale;
+    sample->values[2] = be16(p + 4) * accel_scale;
+    sample->values[3] = be16(p + 8) * gyro_scale;
+    sample->values[4] = be16(p + 10) * gyro_scale;
+    sample->values[5] = be16(p + 12) * gyro_scale;
+    sample->values[6] = be16(p + 6) / 333.87 + 21.0;
+    // the AK8963 axes are x/y swapped and z flipped relative to the
+    // accel/gyro, st2 bit 3 flags a magnetic overflow
+    if ( m->mag_found && !(p[20] & 0x08) ) {
+	float mx = (int16_t)le16(p + 14) * m->mag_adj[0] * mag_scale;
+	float my = (int16_t)le16(p + 16) * m->mag_adj[1] * mag_scale;
+	float mz = (int16_t)le16(p + 18) * m->mag_adj[2] * mag_scale;
+	sample->values[7] = my;
+	sample->values[8] = mx;
+	sample->values[9] = -mz;
+	sample->values[10] = 1.0;
+    }
+    return true;
+}
+
+// write an AK8963 register through i2c slave 0 of the MPU9250
+static bool ak8963_write( BusBackend *bus, uint8_t addr, uint8_t reg,
+			  uint8_t value ) {
+    bool result = bus->write_reg( addr, 0x25, 0x0C ) // slv0 addr (write)
+	&& bus->write_reg( addr, 0x26, reg )
+	&& bus->write_reg( addr, 0x63, value )	     // slv0 data out
+	&& bus->write_reg( addr, 0x27, 0x81 );	     // enable, 1 byte
+    usleep( 10000 );
+    return result && bus->write_reg( addr, 0x27, 0x00 );
+}
+
+// read AK8963 registers through i2c slave 0 (ext_sens_data_00 on)
+static bool ak8963_read( BusBackend *bus, uint8_t addr, uint8_t reg,
+			 int len, uint8_t *buf ) {
+    bool result = bus->write_reg( addr, 0x25, 0x8C ) // slv0 addr (read)
+	&& bus->write_reg( addr, 0x26, reg )
+	&& bus->write_reg( addr, 0x27, 0x80 | len );
+    usleep( 10000 );
+    bus_read_t read = { addr, 0x49, len, buf };
+    return result && bus->transfer( &read, 1 )
+	&& bus->write_reg( addr, 0x27, 0x00 );
+}
+
+static bool ak8963_setup( BusBackend *bus, uint8_t addr, mpu9250_t *m ) {
+    uint8_t who = 0;
+    uint8_t asa[3];
+    if ( !ak8963_write( bus, addr, 0x0B, 0x01 )		// soft reset
+	 || !ak8963_read( bus, addr, 0x00, 1, &who ) || who != 0x48 ) {
+	return false;
+    }
+    if ( !ak8963_write( bus, addr, 0x0A, 0x0F )		// fuse rom access
+	 || !ak8963_read( bus, addr, 0x10, 3, asa )
+	 || !ak8963_write( bus, addr, 0x0A, 0x00 )	// power down
+	 || !ak8963_write( bus, addr, 0x0A, 0x16 ) ) {	// 16 bit, 100hz
+	return false;
+    }
+    for ( int i = 0; i < 3; i++ ) {
+	m->mag_adj[i] = (asa[i] - 128) / 256.0 + 1.0;
+    }
+    // from here on copy HXL..ST2 into ext_sens_data every sample
+    return bus->write_reg( addr, 0x25, 0x8C )
+	&& bus->write_reg( addr, 0x26, 0x03 )
+	&& bus->write_reg( addr, 0x27, 0x87 );
+}
+
+bool mpu9250_setup( bus_device_t *dev, bool spi ) {
+    uint8_t addr = dev->reads[0].addr;
+    mpu9250_t *m = new mpu9250_t;
+    memset( m, 0, sizeof(*m) );
+    bool result = dev->bus->write_reg( addr, 0x6B, 0x01 ) // pll clock
+	&& dev->bus->write_reg( addr, 0x1A, 0x03 )	   // 41hz dlpf
+	&& dev->bus->write_reg( addr, 0x1B, 0x18 )	   // 2000 dps
+	&& dev->bus->write_reg( addr, 0x1C, 0x10 )	   // 8g
+	// i2c master on for the AK8963 (and the i2c slave interface
+	// off on spi)
+	&& dev->bus->write_reg( addr, 0x6A, spi ? 0x30 : 0x20 )
+	&& dev->bus->write_reg( addr, 0x24, 0x0D );	   // 400khz master
+    if ( result ) {
+	m->mag_found = ak8963_setup( dev->bus, addr, m );
+	if ( !m->mag_found ) {
+	    printf("mpu9250: no AK8963 magnetometer found, mag disabled\n");
+	}
+    }
+    dev->reads[0].reg = 0x3B;
+    dev->reads[0].len = sizeof(m->data);
+    dev->reads[0].buf = m->data;
+    dev->nreads = 1;
+    dev->decode = mpu9250_decode;
+    dev->context = m;
+    return result;
+}
+
+
+// BMP280: floating point compensation from the datasheet
+static bool bmp280_decode( bus_device_t *dev, bus_sample_t *sample ) {
+    const bmp280_t *c = (bmp280_t *)dev->context;
+    const uint8_t *p = c->data;
+    int32_t adc_P = (p[0] << 12) | (p[1] << 4) | (p[2] >> 4);
+    int32_t adc_T = (p[3] << 12) | (p[4] << 4) | (p[5] >> 4);
+
+    double var1 = (adc_T / 16384.0 - c->T1 / 1024.0) * c->T2;
+    double var2 = (adc_T / 131072.0 - c->T1 / 8192.0)
+	* (adc_T / 131072.0 - c->T1 / 8192.0) * c->T3;
+    double t_fine = var1 + var2;
+
+    var1 = t_fine / 2.0 - 64000.0;
+    var2 = var1 * var1 * c->P6 / 32768.0;
+    var2 = var2 + var1 * c->P5 * 2.0;
+    var2 = var2 / 4.0 + c->P4 * 65536.0;
+    var1 = (c->P3 * var1 * var1 / 524288.0 + c->P2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * c->P1;
+    if ( var1 == 0.0 ) {
+	return false;
+    }
+    double pa = 1048576.0 - adc_P;
+    pa = (pa - var2 / 4096.0) * 6250.0 / var1;
+    var1 = c->P9 * pa * pa / 2147483648.0;
+    var2 = pa * c->P8 / 32768.0;
+    pa = pa + (var1 + var2 + c->P7) / 16.0;
+
+    sample->values[0] = pa / 100.0;
+    sample->values[1] = t_fine / 5120.0;
+    return true;
+}
+
+bool bmp280_setup( bus_device_t *dev ) {
+    uint8_t addr = dev->reads[0].addr;
+    uint8_t calib[24];
+    bus_read_t read = { addr, 0x88, sizeof(calib), calib };
+    if ( !dev->bus->transfer( &read, 1 ) ) {
+	return false;
+    }
+    bmp280_t *b = new bmp280_t;
+    memset( b, 0, sizeof(*b) );
+    b->T1 = le16(calib + 0);
+    b->T2 = le16(calib + 2);
+    b->T3 = le16(calib + 4);
+    b->P1 = le16(calib + 6);
+    b->P2 = le16(calib + 8);
+    b->P3 = le16(calib + 10);
+    b->P4 = le16(calib + 12);
+    b->P5 = le16(calib + 14);
+    b->P6 = le16(calib + 16);
+    b->P7 = le16(calib + 18);
+    b->P8 = le16(calib + 20);
+    b->P9 = le16(calib + 22);
+    // x16 pressure, x2 temp oversampling, normal mode, iir 16
+    bool result = dev->bus->write_reg( addr, 0xF4, 0x57 )
+	&& dev->bus->write_reg( addr, 0xF5, 0x10 );
+    dev->reads[0].reg = 0xF7;
+    dev->reads[0].len = sizeof(b->data);
+    dev->reads[0].buf = b->data;
+    dev->nreads = 1;
+    dev->decode = bmp280_decode;
+    dev->context = b;
+    return result;
+}
+
+
+// MS4525DO (type A output): 2 status bits, 14 bit pressure, 11 bit
+// temperature
+static bool ms4525do_decode( bus_device_t *dev, bus_sample_t *sample ) {
+    const ms4525do_t *m = (ms4525do_t *)dev->context;
+    const uint8_t *p = m->data;
+    int status = p[0] >> 6;
+    if ( status == 2 ) {
+	// stale data, nothing new since the last read
+	return false;
+    }
+    int bridge = ((p[0] & 0x3f) << 8) | p[1];
+    int temp = (p[2] << 3) | (p[3] >> 5);
+    double range = m->range_psi;
+    double psi = (bridge - 0.1 * 16383) * (2.0 * range) / (0.8 * 16383)
+	- range;
+    sample->values[0] = psi * 6894.757;
+    sample->values[1] = temp * 200.0 / 2047.0 - 50.0;
+    sample->values[2] = status;
+    return true;
+}
+
+bool ms4525do_setup( bus_device_t *dev, double range_psi ) {
+    ms4525do_t *m = new ms4525do_t;
+    memset( m, 0, sizeof(*m) );
+    m->range_psi = range_psi;
+    dev->reads[0].reg = -1;
+    dev->reads[0].len = sizeof(m->data);
+    dev->reads[0].buf = m->data;
+    dev->nreads = 1;
+    dev->decode = ms4525do_decode;
+    dev->context = m;
+    return true;
+}
+
+
+// open the bus and register one device described by config
+static int add_device( pyPropertyNode *config, const char *what ) {
+    string device = config->getString("device");
+    string bus_name = config->getString("bus");
+    int spi_hz = 1000000;
+    if ( config->hasChild("spi_hz") ) {
+	spi_hz = config->getLong("spi_hz");
+    }
+    bus_device_t dev;
+    memset( &dev, 0, sizeof(dev) );
+    dev.bus = bus_open( bus_name, spi_hz );
+    if ( dev.bus == NULL ) {
+	return -1;
+    }
+    dev.rate_hz = 50.0;
+    if ( config->hasChild("rate_hz") ) {
+	dev.rate_hz = config->getDouble("rate_hz");
+    }
+    bool spi = bus_name.find("spidev") != string::npos;
+    bool result = false;
+    if ( device == "mpu9250" ) {
+	dev.reads[0].addr = 0x68;
+    } else if ( device == "bmp280" ) {
+	dev.reads[0].addr = 0x76;
+    } else if ( device == "ms4525do" ) {
+	dev.reads[0].addr = 0x28;
+    }
+    if ( config->hasChild("address") ) {
+	dev.reads[0].addr = config->getLong("address");
+    }
+    if ( device == "mpu9250" ) {
+	result = mpu9250_setup( &dev, spi );
+    } else if ( device == "bmp280" ) {
+	result = bmp280_setup( &dev );
+    } else if ( device == "ms4525do" ) {
+	double range_psi = 1.0;
+	if ( config->hasChild("range_psi") ) {
+	    range_psi = config->getDouble("range_psi");
+	}
+	result = ms4525do_setup( &dev, range_psi );
+    } else {
+	printf("bus %s: unknown device '%s'\n", what, device.c_str());
+	return -1;
+    }
+    if ( !result ) {
+	printf("bus %s: unable to set up %s on %s\n", what, device.c_str(),
+	       bus_name.c_str());
+	return -1;
+    }
+    if ( display_on ) {
+	printf("bus %s: %s on %s @ %.0f hz\n", what, device.c_str(),
+	       bus_name.c_str(), dev.rate_hz);
+    }
+    int handle = bus_add_device( dev );
+    if ( handle < 0 ) {
+	printf("bus %s: unable to add %s\n", what, device.c_str());
+    }
+    return handle;
+}
+
+static void drain() {
+    bus_sample_t sample;
+    while ( bus_pop( &sample ) ) {
+	if ( sample.device >= 0 && sample.device < max_devices ) {
+	    latest[sample.device] = sample;
+	    fresh[sample.device] = true;
+	}
+    }
+}
+
+
+void bus_imu_init( string output_path, pyPropertyNode *config ) {
+    imu_node = pyGetNode(output_path, true);
+    imu_filter = IMU_filter_bind( output_path );
+
+    if ( config->hasChild("orientation") ) {
+	int len = config->getLen("orientation");
+	if ( len == 9 ) {
+	    for ( int i = 0; i < len; i++ ) {
+		orientation(i / 3, i % 3) = config->getDouble("orientation", i);
+	    }
+	} else {
+	    printf("WARNING: imu orientation improper matrix size\n");
+	}
+    } else {
+	printf("Note: no imu orientation defined, default is chip z up, x forward\n");
+    }
+
+    if ( config->hasChild("calibration") ) {
+	pyPropertyNode cal = config->getChild("calibration");
+	cal_learn_overlay( &cal );
+	double min_temp = 27.0;
+	double max_temp = 27.0;
+	if ( cal.hasChild("min_temp_C") ) {
+	    min_temp = cal.getDouble("min_temp_C");
+	}
+	if ( cal.hasChild("max_temp_C") ) {
+	    max_temp = cal.getDouble("max_temp_C");
+	}
+
+	pyPropertyNode ax_node = cal.getChild("ax");
+	ax_cal.init( &ax_node, min_temp, max_temp );
+	pyPropertyNode ay_node = cal.getChild("ay");
+	ay_cal.init( &ay_node, min_temp, max_temp );
+	pyPropertyNode az_node = cal.getChild("az");
+	az_cal.init( &az_node, min_temp, max_temp );
+
+	if ( cal.hasChild("mag_affine") ) {
+	    string tokens_str = cal.getString("mag_affine");
+	    vector<string> tokens = split(tokens_str);
+	    if ( tokens.size() == 16 ) {
+		for ( unsigned int i = 0; i < 16; i++ ) {
+		    mag_cal(i / 4, i % 4) = atof(tokens[i].c_str());
+		}
+	    } else {
+		printf("ERROR: wrong number of elements for mag_cal affine matrix!\n");
+		mag_cal.setIdentity();
+	    }
+	}
+	mag_learn.init( mag_cal );
+
+	// save the imu calibration parameters with the data file so that
+	// later the original raw sensor values can be derived.
+	write_imu_calibration( &cal );
+    }
+
+    imu_handle = add_device( config, "imu" );
+}
+
+static bool imu_publish() {
+    drain();
+    if ( imu_handle < 0 || !fresh[imu_handle] ) {
+	return false;
+    }
+    fresh[imu_handle] = false;
+    const bus_sample_t *s = &latest[imu_handle];
+    float temp_C = s->values[6];
+    Vector3f accel = orientation
+	* Vector3f(s->values[0], s->values[1], s->values[2]);
+    Vector3f gyro = orientation
+	* Vector3f(s->values[3], s->values[4], s->values[5]);
+    // hold the last good mag reading through overflows (or zeros
+    // with no AK8963), mag_valid says whether this sample had one
+    bool mag_valid = s->values[10] > 0.5;
+    if ( mag_valid ) {
+	Vector3f mag = orientation
+	    * Vector3f(s->values[7], s->values[8], s->values[9]);
+	mag_last[0] = mag(0);
+	mag_last[1] = mag(1);
+	mag_last[2] = mag(2);
+	mag_learn.sample( mag(0), mag(1), mag(2) );
+    }
+
+    if ( s->timestamp > last_bias_update + 5.0 ) {
+	imu_node.setDouble( "ax_bias", ax_cal.get_bias( temp_C ) );
+	imu_node.setDouble( "ay_bias", ay_cal.get_bias( temp_C ) );
+	imu_node.setDouble( "az_bias", az_cal.get_bias( temp_C ) );
+	last_bias_update = s->timestamp;
+    }
+
+    imu_node.setDouble( "timestamp", s->timestamp );
+    imu_node.setDouble( "hx_raw", mag_last[0] );
+    imu_node.setDouble( "hy_raw", mag_last[1] );
+    imu_node.setDouble( "hz_raw", mag_last[2] );
+    mag_learn.update( &mag_cal );
+    Vector4d hs((double)mag_last[0], (double)mag_last[1],
+		(double)mag_last[2], 1.0);
+    Vector4d hc = mag_cal * hs;
+    float x[9] = { gyro(0), gyro(1), gyro(2),
+		   ax_cal.calibrate(accel(0), temp_C),
+		   ay_cal.calibrate(accel(1), temp_C),
+		   az_cal.calibrate(accel(2), temp_C),
+		   (float)hc(0), (float)hc(1), (float)hc(2) };
+    IMU_publish( imu_filter, &imu_node, x );
+    imu_node.setBool( "mag_valid", mag_valid );
+    imu_node.setDouble( "temp_C", temp_C );
+    return true;
+}
+
+// Main loop sync: block until the polling thread delivers an imu
+// sample and publish it.  Returns the dt between imu samples.
+double bus_update() {
+    double last_time = imu_node.getDouble( "timestamp" );
+    while ( !imu_publish() ) {
+	if ( imu_handle < 0 || !bus_wait( 0.1 ) ) {
+	    return 0.0;
+	}
+    }
+    imu_synced = true;
+    return imu_node.getDouble( "timestamp" ) - last_time;
+}
+
+bool bus_imu_update() {
+    if ( imu_synced ) {
+	// bus_update() published this frame's sample
+	imu_synced = false;
+	return true;
+    }
+    return imu_publish();
+}
+
+void bus_imu_close() {
+    bus_stop();
+}
+
+
+void bus_airdata_init( string output_path, pyPropertyNode *config ) {
+    airdata_node = pyGetNode(output_path, true);
+    if ( config->hasChild("baro") ) {
+	pyPropertyNode baro = config->getChild("baro");
+	baro_handle = add_device( &baro, "baro" );
+    }
+    if ( config->hasChild("pitot") ) {
+	pyPropertyNode pitot = config->getChild("pitot");
+	pitot_handle = add_device( &pitot, "pitot" );
+    }
+}
+
+bool bus_airdata_update() {
+    drain();
+    bool fresh_data = false;
+    if ( baro_handle >= 0 && fresh[baro_handle] ) {
+	fresh[baro_handle] = false;
+	const bus_sample_t *s = &latest[baro_handle];
+	airdata_node.setDouble( "timestamp", s->timestamp );
+	airdata_node.setDouble( "pressure_mbar", s->values[0] );
+	airdata_node.setDouble( "temp_C", s->values[1] );
+	fresh_data = true;
+    }
+    if ( pitot_handle >= 0 && fresh[pitot_handle] ) {
+	fresh[pitot_handle] = false;
+	const bus_sample_t *s = &latest[pitot_handle];
+	double diff_pa = s->values[0];
+	if ( ! airspeed_inited ) {
+	    if ( airspeed_zero_start_time > 0 ) {
+		diff_sum += diff_pa;
+		diff_count++;
+		diff_offset = diff_sum / diff_count;
+	    } else {
+		airspeed_zero_start_time = get_Time();
+		diff_sum = 0.0;
+		diff_count = 0;
+	    }
+	    if ( get_Time() > airspeed_zero_start_time + 10.0 ) {
+		airspeed_inited = true;
+	    }
+	}
+	diff_pa -= diff_offset;
+	if ( diff_pa < 0.0 ) { diff_pa = 0.0; }
+	float airspeed_mps = sqrt( 2*diff_pa / 1.225 );
+	if ( baro_handle < 0 ) {
+	    airdata_node.setDouble( "timestamp", s->timestamp );
+	}
+	airdata_node.setDouble( "diff_pa", s->values[0] );
+	airdata_node.setDouble( "airspeed_mps", airspeed_mps );
+	airdata_node.setDouble( "airspeed_kt", airspeed_mps * SG_MPS_TO_KT );
+	airdata_node.setLong( "status", (int)s->values[2] );
+	fresh_data = true;
+    }
+    if ( fresh_data ) {
+	uint32_t errors = bus_dropped();
+	if ( baro_handle >= 0 ) {
+	    errors += bus_errors( baro_handle );
+	}
+	if ( pitot_handle >= 0 ) {
+	    errors += bus_errors( pitot_handle );
+	}
+	airdata_node.setLong( "error_count", errors );
+    }
+    return fresh_data;
+}
+
+// force an airspeed zero calibration (ideally with the aircraft on
+// the ground with the pitot tube perpendicular to the prevailing
+// wind.)
+void bus_airdata_zero_airspeed() {
+    airspeed_inited = false;
+    airspeed_zero_start_time = 0.0;
+}
+
+void bus_airdata_close() {
+    bus_stop();
+}
@@ -0,0 +1,54 @@
+/**
+ * \file: bus_sensors.hxx
+ *
+ * Sensors read through the i2c/spi polling engine (bus_poll.hxx):
+ * MPU9250 imu, BMP280 barometer and MS4525DO differential pressure.
+ *
+ * imu section (source = "bus"):
+ *   device  : "mpu9250"
+ *   bus     : "/dev/spidevB.C", "/dev/i2c-N" or "fake"
+ *   address : i2c address (default 0x68)
+ *   rate_hz : poll rate (default 200)
+ *   spi_hz  : spi clock (default 1000000)
+ *   orientation : 9 element row major chip to body rotation (default
+ *                 diag(1, -1, -1), chip flat and component side up
+ *                 with x forward)
+ *   calibration : temperature bias/scale fits and mag_affine, same
+ *                 layout as the APM2 and Aura3 drivers
+ *
+ * The AK8963 magnetometer inside the MPU9250 is read through its
+ * internal i2c master, /sensors/imu/mag_valid is false when it is
+ * missing or overflowed.
+ *
+ * airdata section (source = "bus") with a "baro" and/or a "pitot"
+ * child, each configured as above with device "bmp280" (default
+ * address 0x76) or "ms4525do" (default address 0x28, plus range_psi.)
+ *
+ */
+
+#pragma once
+
+#include <pyprops.hxx>
+
+#include <string>
+using std::string;
+
+#include "bus_poll.hxx"
+
+// main loop sync (imu source = "bus"): wait for the next imu sample,
+// returns the dt between imu samples
+double bus_update();
+
+void bus_imu_init( string output_path, pyPropertyNode *config );
+bool bus_imu_update();
+void bus_imu_close();
+
+void bus_airdata_init( string output_path, pyPropertyNode *config );
+bool bus_airdata_update();
+void bus_airdata_zero_airspeed();
+void bus_airdata_close();
+
+// device setup and decoders (exposed for testing against a FakeBus)
+bool mpu9250_setup( bus_device_t *dev, bool spi );
+bool bmp280_setup( bus_device_t *dev );
+bool ms4525do_setup( bus_device_t *dev, double range_psi );
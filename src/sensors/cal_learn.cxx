@@ -0,0 +1,530 @@
+/**
+ * \file: cal_learn.cxx
+ *
+ * Onboard imu temperature bias learning.
+ */
+
+#include <pyprops.hxx>
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>		// strerror()
+#include <unistd.h>		// usleep()
+
+#include <string>
+using std::string;
+
+#include "init/runtime.hxx"
+#include "util/seqlock.hxx"
+#include "util/sg_path.hxx"
+
+#include "cal_learn.hxx"
+
+static const int max_bins = 64;
+static const int axes = 6;
+static const char *axis_names[axes] = { "p", "q", "r", "ax", "ay", "az" };
+static const char *bias_names[axes] = { "p_bias", "q_bias", "r_bias",
+					"ax_bias", "ay_bias", "az_bias" };
+static const double bin_cap = 600.0;	// beyond this a bin is a running average
+static const double min_bin_samples = 30.0;
+
+struct cal_bin_t {
+    double n;
+    double temp;
+    double bias[axes];
+};
+
+static pyPropertyNode imu_node;
+static pyPropertyNode cal_node;		// status
+static pyPropertyNode file_node;	// calibration file contents
+
+static bool configured = false;
+static bool enabled = false;
+static bool apply = false;
+static bool loaded = false;
+static string file;
+static double min_temp = -20.0;
+static double max_temp = 60.0;
+static double bin_size = 2.0;
+static int num_bins = 40;
+static double settle_sec = 120.0;
+static double stationary_sec = 10.0;
+
+static cal_bin_t bins[max_bins];
+
+// moment sums over the usable bins, each bin weighted 1, in the
+// normalized temperature x = (temp - temp_center) / temp_scale
+static double temp_center = 20.0;
+static double temp_scale = 40.0;
+static double sx[5];			// sum x^k
+static double sxy[axes][3];		// sum y x^k
+
+static double valid_sec = 0.0;
+static double still_sec = 0.0;
+static double last_sample_time = 0.0;
+static long samples = 0;
+static long saved_samples = 0;
+
+// everything that goes in the calibration file, as plain data so the
+// helper thread can write it without touching the property tree
+struct cal_file_t {
+    double min_temp_C, max_temp_C;
+    bool learned;
+    char bias[axes][64];
+    char scale[axes][64];
+    char mag_affine[384];
+    // the learn subtree
+    double learn_min_temp_C, learn_bin_C;
+    long samples;
+    int num_bins;
+    cal_bin_t bins[max_bins];
+};
+
+static cal_file_t contents;
+static SeqLock<cal_file_t> pending;	// flight thread -> helper
+static pthread_mutex_t file_mutex = PTHREAD_MUTEX_INITIALIZER;
+static long written_samples = -1;	// newest on disk (file_mutex)
+
+
+static void configure() {
+    if ( configured ) {
+	return;
+    }
+    configured = true;
+    pyPropertyNode config = pyGetNode("/config/imu_cal_learn", true);
+    enabled = config.getBool("enable");
+    apply = config.getBool("apply");
+    if ( config.hasChild("file") ) {
+	file = config.getString("file");
+    } else {
+	SGPath path( pyGetNode("/config", true).getString("root-path") );
+	path.append( "imucal.json" );
+	file = path.str();
+    }
+    if ( config.hasChild("min_temp_C") ) {
+	min_temp = config.getDouble("min_temp_C");
+    }
+    if ( config.hasChild("max_temp_C") ) {
+	max_temp = config.getDouble("max_temp_C");
+    }
+    if ( config.hasChild("bin_C") ) {
+	bin_size = config.getDouble("bin_C");
+    }
+    if ( config.hasChild("settle_sec") ) {
+	settle_sec = config.getDouble("settle_sec");
+    }
+    if ( config.hasChild("stationary_sec") ) {
+	stationary_sec = config.getDouble("stationary_sec");
+    }
+    if ( bin_size <= 0.0 ) {
+	bin_size = 2.0;
+    }
+    num_bins = ceil( (max_temp - min_temp) / bin_size );
+    if ( num_bins > max_bins ) {
+	printf("imu cal learn: %d bins is too many, using %d\n",
+	       num_bins, max_bins);
+	num_bins = max_bins;
+	max_temp = min_temp + num_bins * bin_size;
+    }
+    if ( num_bins < 1 ) {
+	num_bins = 1;
+    }
+    temp_center = 0.5 * (min_temp + max_temp);
+    temp_scale = 0.5 * num_bins * bin_size;
+}
+
+// add (sign = 1) or remove (sign = -1) a bin's share of the moment sums
+static void bin_moments( const cal_bin_t &b, double sign ) {
+    if ( b.n < min_bin_samples ) {
+	return;
+    }
+    double x = (b.temp - temp_center) / temp_scale;
+    double xk = 1.0;
+    for ( int k = 0; k < 5; k++ ) {
+	sx[k] += sign * xk;
+	if ( k < 3 ) {
+	    for ( int a = 0; a < axes; a++ ) {
+		sxy[a][k] += sign * b.bias[a] * xk;
+	    }
+	}
+	xk *= x;
+    }
+}
+
+static void add_sample( double temp, const double bias[axes] ) {
+    int i = floor( (temp - min_temp) / bin_size );
+    if ( i < 0 || i >= num_bins ) {
+	return;
+    }
+    cal_bin_t &b = bins[i];
+    bin_moments( b, -1.0 );
+    if ( b.n < bin_cap ) {
+	b.n += 1.0;
+    }
+    double k = 1.0 / b.n;
+    b.temp += k * (temp - b.temp);
+    for ( int a = 0; a < axes; a++ ) {
+	b.bias[a] += k * (bias[a] - b.bias[a]);
+    }
+    bin_moments( b, 1.0 );
+    samples++;
+}
+
+// solve the n x n (n <= 3) system m a = v in place
+static bool solve( double m[3][3], double v[3], int n, double a[3] ) {
+    for ( int c = 0; c < n; c++ ) {
+	int pivot = c;
+	for ( int r = c + 1; r < n; r++ ) {
+	    if ( fabs(m[r][c]) > fabs(m[pivot][c]) ) {
+		pivot = r;
+	    }
+	}
+	if ( fabs(m[pivot][c]) < 1e-12 ) {
+	    return false;
+	}
+	for ( int k = 0; k < n; k++ ) {
+	    double tmp = m[c][k]; m[c][k] = m[pivot][k]; m[pivot][k] = tmp;
+	}
+	double tmp = v[c]; v[c] = v[pivot]; v[pivot] = tmp;
+	for ( int r = c + 1; r < n; r++ ) {
+	    double f = m[r][c] / m[c][c];
+	    for ( int k = c; k < n; k++ ) {
+		m[r][k] -= f * m[c][k];
+	    }
+	    v[r] -= f * v[c];
+	}
+    }
+    for ( int r = n - 1; r >= 0; r-- ) {
+	double sum = v[r];
+	for ( int k = r + 1; k < n; k++ ) {
+	    sum -= m[r][k] * a[k];
+	}
+	a[r] = sum / m[r][r];
+    }
+    return true;
+}
+
+// fit every axis from the moment sums and publish the polynomials (in
+// the AuraCalTemp form: bias[0]*t*t + bias[1]*t + bias[2]) into the
+// file node.  The order drops when the covered temperature span is too
+// narrow to support it.
+static bool refit() {
+    int count = 0;
+    double lo = 0.0, hi = 0.0;
+    for ( int i = 0; i < num_bins; i++ ) {
+	if ( bins[i].n >= min_bin_samples ) {
+	    if ( count == 0 || bins[i].temp < lo ) { lo = bins[i].temp; }
+	    if ( count == 0 || bins[i].temp > hi ) { hi = bins[i].temp; }
+	    count++;
+	}
+    }
+    if ( count == 0 ) {
+	return false;
+    }
+    int terms = 3;
+    if ( count < 2 || hi - lo < 3.0 ) {
+	terms = 1;
+    } else if ( count < 3 || hi - lo < 10.0 ) {
+	terms = 2;
+    }
+
+    for ( int a = 0; a < axes; a++ ) {
+	double m[3][3], v[3], x[3] = { 0.0, 0.0, 0.0 };
+	for ( int j = 0; j < terms; j++ ) {
+	    for ( int k = 0; k < terms; k++ ) {
+		m[j][k] = sx[j + k];
+	    }
+	    v[j] = sxy[a][j];
+	}
+	if ( !solve( m, v, terms, x ) ) {
+	    return false;
+	}
+	// back from the normalized temperature to degrees C
+	double qa = x[2] / (temp_scale * temp_scale);
+	double la = x[1] / temp_scale;
+	double c0 = qa;
+	double c1 = la - 2.0 * qa * temp_center;
+	double c2 = x[0] - la * temp_center + qa * temp_center * temp_center;
+	char buf[128];
+	snprintf( buf, sizeof(buf), "%.8g %.8g %.8g", c0, c1, c2 );
+	pyPropertyNode axis = file_node.getChild( axis_names[a], true );
+	axis.setString( "bias", buf );
+	if ( !axis.hasChild("scale") ) {
+	    axis.setString( "scale", "0 0 1" );
+	}
+	snprintf( contents.bias[a], sizeof(contents.bias[a]), "%s", buf );
+	if ( contents.scale[a][0] == 0 ) {
+	    snprintf( contents.scale[a], sizeof(contents.scale[a]), "0 0 1" );
+	}
+    }
+    file_node.setDouble( "min_temp_C", lo );
+    file_node.setDouble( "max_temp_C", hi );
+    file_node.setBool( "learned", true );
+    contents.min_temp_C = lo;
+    contents.max_temp_C = hi;
+    contents.learned = true;
+    cal_node.setLong( "bins", count );
+    cal_node.setLong( "order", terms - 1 );
+    return true;
+}
+
+static void load() {
+    if ( loaded ) {
+	return;
+    }
+    loaded = true;
+    file_node = pyGetNode("/sensors/imu_cal/calibration", true);
+    for ( int i = 0; i < max_bins; i++ ) {
+	bins[i].n = 0.0;
+	bins[i].temp = 0.0;
+	for ( int a = 0; a < axes; a++ ) {
+	    bins[i].bias[a] = 0.0;
+	}
+    }
+    memset( &contents, 0, sizeof(contents) );
+    SGPath path( file );
+    if ( !path.exists() || !readJSON( file, &file_node ) ) {
+	return;
+    }
+    printf("imu cal learn: loaded %s\n", file.c_str());
+    contents.min_temp_C = file_node.getDouble("min_temp_C");
+    contents.max_temp_C = file_node.getDouble("max_temp_C");
+    contents.learned = file_node.getBool("learned");
+    for ( int a = 0; a < axes; a++ ) {
+	if ( file_node.hasChild(axis_names[a]) ) {
+	    pyPropertyNode axis = file_node.getChild( axis_names[a] );
+	    snprintf( contents.bias[a], sizeof(contents.bias[a]), "%s",
+		      axis.getString("bias").c_str() );
+	    snprintf( contents.scale[a], sizeof(contents.scale[a]), "%s",
+		      axis.getString("scale").c_str() );
+	}
+    }
+    snprintf( contents.mag_affine, sizeof(contents.mag_affine), "%s",
+	      file_node.getString("mag_affine").c_str() );
+    if ( !file_node.hasChild("learn") ) {
+	return;
+    }
+    // the bins only carry over if the layout hasn't changed
+    pyPropertyNode learn = file_node.getChild("learn");
+    if ( learn.getDouble("min_temp_C") != min_temp
+	 || learn.getDouble("bin_C") != bin_size
+	 || learn.getLen("n") != num_bins )
+    {
+	printf("imu cal learn: bin layout changed, starting over\n");
+	return;
+    }
+    for ( int i = 0; i < num_bins; i++ ) {
+	bins[i].n = learn.getDouble("n", i);
+	bins[i].temp = learn.getDouble("temp", i);
+	for ( int a = 0; a < axes; a++ ) {
+	    bins[i].bias[a] = learn.getDouble(axis_names[a], i);
+	}
+	bin_moments( bins[i], 1.0 );
+    }
+    samples = learn.getLong("samples");
+    saved_samples = samples;
+    written_samples = samples;
+}
+
+// write the file the same layout 2-fit-calibration.py and writeJSON()
+// produce.  Runs on the helper thread (and at close), so no property
+// tree access.  A snapshot no newer than what's on disk is skipped.
+static void write_file( const cal_file_t &c ) {
+    pthread_mutex_lock( &file_mutex );
+    if ( c.samples <= written_samples ) {
+	pthread_mutex_unlock( &file_mutex );
+	return;
+    }
+    string tmp = file + ".tmp";
+    FILE *fp = fopen( tmp.c_str(), "w" );
+    if ( fp == NULL ) {
+	printf("imu cal learn: unable to write %s\n", file.c_str());
+	pthread_mutex_unlock( &file_mutex );
+	return;
+    }
+    fprintf( fp, "{\n" );
+    fprintf( fp, "    \"min_temp_C\": %.10g,\n", c.min_temp_C );
+    fprintf( fp, "    \"max_temp_C\": %.10g,\n", c.max_temp_C );
+    fprintf( fp, "    \"learned\": %s,\n", c.learned ? "true" : "false" );
+    for ( int a = 0; a < axes; a++ ) {
+	if ( c.bias[a][0] ) {
+	    fprintf( fp, "    \"%s\": {\"bias\": \"%s\", \"scale\": \"%s\"},\n",
+		     axis_names[a], c.bias[a], c.scale[a] );
+	}
+    }
+    if ( c.mag_affine[0] ) {
+	fprintf( fp, "    \"mag_affine\": \"%s\",\n", c.mag_affine );
+    }
+    fprintf( fp, "    \"learn\": {\n" );
+    fprintf( fp, "        \"min_temp_C\": %.10g,\n", c.learn_min_temp_C );
+    fprintf( fp, "        \"bin_C\": %.10g,\n", c.learn_bin_C );
+    fprintf( fp, "        \"samples\": %ld,\n", c.samples );
+    fprintf( fp, "        \"n\": [" );
+    for ( int i = 0; i < c.num_bins; i++ ) {
+	fprintf( fp, "%s%.10g", i ? ", " : "", c.bins[i].n );
+    }
+    fprintf( fp, "],\n        \"temp\": [" );
+    for ( int i = 0; i < c.num_bins; i++ ) {
+	fprintf( fp, "%s%.10g", i ? ", " : "", c.bins[i].temp );
+    }
+    for ( int a = 0; a < axes; a++ ) {
+	fprintf( fp, "],\n        \"%s\": [", axis_names[a] );
+	for ( int i = 0; i < c.num_bins; i++ ) {
+	    fprintf( fp, "%s%.10g", i ? ", " : "", c.bins[i].bias[a] );
+	}
+    }
+    fprintf( fp, "]\n    }\n}\n" );
+    bool result = !ferror( fp );
+    result = (fclose( fp ) == 0) && result;
+    result = result && rename( tmp.c_str(), file.c_str() ) == 0;
+    if ( result ) {
+	written_samples = c.samples;
+	printf("imu cal learn: saved %ld samples to %s\n", c.samples,
+	       file.c_str());
+    } else {
+	printf("imu cal learn: unable to write %s\n", file.c_str());
+    }
+    pthread_mutex_unlock( &file_mutex );
+}
+
+// fill in the learn subtree of the file contents
+static void snapshot() {
+    contents.learn_min_temp_C = min_temp;
+    contents.learn_bin_C = bin_size;
+    contents.samples = samples;
+    contents.num_bins = num_bins;
+    for ( int i = 0; i < num_bins; i++ ) {
+	contents.bins[i] = bins[i];
+    }
+}
+
+static void *cal_learn_main( void *arg ) {
+    runtime_helper_thread_init( "cal learn" );
+    static cal_file_t c;
+    unsigned int last = 0;
+    while ( true ) {
+	unsigned int n = pending.read( &c );
+	if ( n != last ) {
+	    last = n;
+	    write_file( c );
+	}
+	sleep( 1 );
+    }
+    return NULL;
+}
+
+void cal_learn_overlay( pyPropertyNode *calibration ) {
+    configure();
+    if ( !enabled || !apply ) {
+	return;
+    }
+    load();
+    if ( !file_node.getBool("learned") ) {
+	return;
+    }
+    calibration->setDouble( "min_temp_C", file_node.getDouble("min_temp_C") );
+    calibration->setDouble( "max_temp_C", file_node.getDouble("max_temp_C") );
+    // the drivers only apply the accel temperature calibration
+    for ( int a = 3; a < axes; a++ ) {
+	pyPropertyNode learned = file_node.getChild( axis_names[a], true );
+	pyPropertyNode axis = calibration->getChild( axis_names[a], true );
+	axis.setString( "bias", learned.getString("bias") );
+    }
+    printf("imu cal learn: using the learned accel bias fit\n");
+}
+
+void cal_learn_init() {
+    configure();
+    if ( !enabled ) {
+	return;
+    }
+    imu_node = pyGetNode("/sensors/imu", true);
+    cal_node = pyGetNode("/sensors/imu_cal", true);
+    load();
+    refit();
+    cal_node.setLong( "samples", samples );
+    cal_node.setBool( "stationary", false );
+}
+
+void cal_learn_update( pyPropertyNode *filter_node, double dt ) {
+    if ( !enabled ) {
+	return;
+    }
+    if ( filter_node->getString("navigation") != "valid" ) {
+	valid_sec = 0.0;
+	still_sec = 0.0;
+	return;
+    }
+    valid_sec += dt;
+
+    // still: no ground speed and (bias corrected) rates near zero
+    double p = imu_node.getDouble("p_rad_sec") - filter_node->getDouble("p_bias");
+    double q = imu_node.getDouble("q_rad_sec") - filter_node->getDouble("q_bias");
+    double r = imu_node.getDouble("r_rad_sec") - filter_node->getDouble("r_bias");
+    if ( filter_node->getDouble("groundspeed_ms") < 0.5
+	 && fabs(p) < 0.02 && fabs(q) < 0.02 && fabs(r) < 0.02 )
+    {
+	still_sec += dt;
+    } else {
+	still_sec = 0.0;
+    }
+    bool stationary = still_sec >= stationary_sec;
+    cal_node.setBool( "stationary", stationary );
+    if ( valid_sec < settle_sec || !stationary ) {
+	return;
+    }
+
+    // one sample a second is plenty, the biases move slowly
+    double imu_time = imu_node.getDouble("timestamp");
+    if ( imu_time < last_sample_time + 1.0 ) {
+	return;
+    }
+    last_sample_time = imu_time;
+
+    // the filter biases are residuals on top of whatever calibration
+    // the driver applied (the drivers publish the accel calibration
+    // bias, the gyros have none)
+    double bias[axes];
+    for ( int a = 0; a < axes; a++ ) {
+	bias[a] = filter_node->getDouble( bias_names[a] );
+	if ( a >= 3 ) {
+	    bias[a] += imu_node.getDouble( bias_names[a] );
+	}
+    }
+    double temp = imu_node.getDouble("temp_C");
+    add_sample( temp, bias );
+    refit();
+    cal_node.setLong( "samples", samples );
+    cal_node.setDouble( "temp_C", temp );
+
+    // hand a copy to the helper thread to write out
+    if ( samples - saved_samples >= 300 ) {
+	snapshot();
+	pending.write( contents );
+	saved_samples = samples;
+    }
+}
+
+bool cal_learn_start() {
+    if ( !enabled ) {
+	return true;
+    }
+    pthread_t thread;
+    int result = pthread_create( &thread, NULL, cal_learn_main, NULL );
+    if ( result != 0 ) {
+	printf("imu cal learn: unable to start helper thread - %s\n",
+	       strerror(result));
+	return false;
+    }
+    pthread_detach( thread );
+    return true;
+}
+
+void cal_learn_close() {
+    if ( enabled ) {
+	// also covers a hand off the helper hasn't written yet
+	snapshot();
+	write_file( contents );
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ * \file: cal_learn.hxx
+ *
+ * Onboard imu temperature bias learning.
+ *
+ * While the aircraft sits still with a converged nav filter, the total
+ * sensor bias (the calibration bias in use at the current temperature
+ * plus the residual the filter estimates on top of it) is sampled once
+ * a second into fixed temperature bins.  Each bin keeps a running mean
+ * of temperature and of the six biases.  The bins feed weighted moment
+ * sums that are adjusted in place whenever a bin changes, so each
+ * sample and each refit of the p, q, r, ax, ay, az bias polynomials
+ * (the AuraCalTemp form) is O(1).  Bins are weighted equally so a long
+ * session at one temperature doesn't swamp the rest of the curve.
+ *
+ * The fit and the bins are saved to the aircraft imucal.json (same
+ * layout 2-fit-calibration.py writes, plus a "learn" subtree) every
+ * 300 samples by a helper thread and at close, and learning picks up
+ * from there on the next start.
+ *
+ * Configured under /config/imu_cal_learn:
+ *
+ *   enable         : turn learning on (default off)
+ *   file           : calibration file (default imucal.json in the
+ *                    config root-path)
+ *   apply          : use the learned accel bias fit at startup in
+ *                    place of the configured one
+ *   min_temp_C, max_temp_C, bin_C : bin layout (-20 to 60 by 2)
+ *   settle_sec     : filter valid time before sampling (120)
+ *   stationary_sec : time still before sampling (10)
+ *
+ * Status and the current fit are published under /sensors/imu_cal.
+ */
+
+#pragma once
+
+#include <pyprops.hxx>
+
+// called by the imu drivers (APM2, Aura3, bus) before they read their
+// calibration section: replaces the accel bias fits and temperature
+// range with the learned ones when apply is set and a fit exists.
+void cal_learn_overlay( pyPropertyNode *calibration );
+
+void cal_learn_init();
+
+// once per filter update with the output of the filter in use
+void cal_learn_update( pyPropertyNode *filter_node, double dt );
+
+// start the helper thread that writes the calibration file (after
+// runtime_init() so it lands on the helper cpus.)
+bool cal_learn_start();
+
+// save the learned state
+void cal_learn_close();
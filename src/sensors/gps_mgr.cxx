@@ -15,10 +15,8 @@
 #include <string.h>
 #include <sys/time.h>
 
-#include <sstream>
 #include <string>
 #include <vector>
-using std::ostringstream;
 using std::string;
 using std::vector;
 
@@ -38,6 +36,7 @@ using std::vector;
 #include "gps_gpsd.hxx"
 #include "gps_ublox6.hxx"
 #include "gps_ublox8.hxx"
+#include "sensor_mgr.hxx"
 #include "ugfile.hxx"
 
 #include "gps_mgr.hxx"
@@ -49,58 +48,48 @@ using std::vector;
 static double gps_last_time = -31557600.0; // default to t minus one year old
 
 static pyPropertyNode gps_node;
-static vector<pyPropertyNode> sections;
-static vector<pyPropertyNode> outputs;
 
-static int remote_link_skip = 0;
-static int logging_skip = 0;
+static void pack_gps( message::gps_v4_t *gps, pyPropertyNode *output ) {
+    gps->timestamp_sec = output->getDouble("timestamp");
+    gps->latitude_deg = output->getDouble("latitude_deg");
+    gps->longitude_deg = output->getDouble("longitude_deg");
+    gps->altitude_m = output->getDouble("altitude_m");
+    gps->vn_ms = output->getDouble("vn_ms");
+    gps->ve_ms = output->getDouble("ve_ms");
+    gps->vd_ms = output->getDouble("vd_ms");
+    gps->unixtime_sec = output->getDouble("unix_time_sec");
+    gps->satellites = output->getLong("satellites");
+    gps->horiz_accuracy_m = output->getDouble("horiz_accuracy_m");
+    gps->vert_accuracy_m = output->getDouble("vert_accuracy_m");
+    gps->pdop = output->getDouble("pdop");
+    gps->fix_type = output->getLong("fixType");
+}
+
+static const sensor_driver_t gps_drivers[] = {
+    { "APM2",
+      []( string path, pyPropertyNode *config ) { APM2_gps_init( path, config ); },
+      APM2_gps_update, APM2_gps_close, NULL },
+    { "Aura3",
+      []( string path, pyPropertyNode *config ) { Aura3_gps_init( path, config ); },
+      Aura3_gps_update, Aura3_gps_close, NULL },
+    { "fgfs",
+      []( string path, pyPropertyNode *config ) { fgfs_gps_init( path, config ); },
+      fgfs_gps_update, fgfs_gps_close, NULL },
+    { "file",
+      []( string path, pyPropertyNode *config ) { ugfile_gps_init( path, config ); },
+      ugfile_get_gps, ugfile_close, NULL },
+    { "gpsd", gpsd_init, gpsd_get_gps, NULL /* fixme */, NULL },
+    { "ublox6", gps_ublox6_init, gps_ublox6_update, gps_ublox6_close, NULL },
+    { "ublox8", gps_ublox8_init, gps_ublox8_update, gps_ublox8_close, NULL },
+};
+
+static SensorGroup<message::gps_v4_t> gpses( pack_gps );
 
 void GPS_init() {
     gps_node = pyGetNode("/sensors/gps", true);
-    
-    pyPropertyNode remote_link_node = pyGetNode("/config/remote_link", true);
-    pyPropertyNode logging_node = pyGetNode("/config/logging", true);
-    remote_link_skip = remote_link_node.getDouble("gps_skip");
-    logging_skip = logging_node.getDouble("gps_skip");
-
-    // traverse configured modules
-    pyPropertyNode group_node = pyGetNode("/config/sensors/gps_group", true);
-    vector<string> children = group_node.getChildren();
-    printf("Found %d gps sections\n", (int)children.size());
-    for ( unsigned int i = 0; i < children.size(); i++ ) {
-	pyPropertyNode section_node = group_node.getChild(children[i].c_str());
-	sections.push_back(section_node);
-	string source = section_node.getString("source");
-	bool enabled = section_node.getBool("enable");
-	if ( !enabled ) {
-	    continue;
-	}
-	ostringstream output_path;
-	output_path << "/sensors/gps" << '[' << i << ']';
-        pyPropertyNode output_node = pyGetNode(output_path.str(), true);
-        outputs.push_back(output_node);
-	printf("gps: %d = %s\n", i, source.c_str());
-	if ( source == "null" ) {
-	    // do nothing
-	} else if ( source == "APM2" ) {
-	    APM2_gps_init( output_path.str(), &section_node );
-	} else if ( source == "Aura3" ) {
-	    Aura3_gps_init( output_path.str(), &section_node );
-	} else if ( source == "fgfs" ) {
-	    fgfs_gps_init( output_path.str(), &section_node );
-	} else if ( source == "file" ) {
-	    ugfile_gps_init( output_path.str(), &section_node );
-	} else if ( source == "gpsd" ) {
-	    gpsd_init( output_path.str(), &section_node );
-	} else if ( source == "ublox6" ) {
-	    gps_ublox6_init( output_path.str(), &section_node );
-	} else if ( source == "ublox8" ) {
-	    gps_ublox8_init( output_path.str(), &section_node );
-	} else {
-	    printf("Unknown gps source = '%s' in config file\n",
-		   source.c_str());
-	}
-    }
+    gpses.init( "gps", "/config/sensors/gps_group", "/sensors/gps", "source",
+		"gps_skip", gps_drivers,
+		sizeof(gps_drivers) / sizeof(gps_drivers[0]) );
 }
 
 
@@ -132,92 +121,15 @@ static void compute_magvar() {
 bool GPS_update() {
     gps_prof.start();
 
-    bool fresh_data = false;
     static int gps_state = 0;
 
-    static int remote_link_count = 0;
-    static int logging_count = 0;
-
-    // traverse configured modules
-    for ( unsigned int i = 0; i < sections.size(); i++ ) {
-	string source = sections[i].getString("source");
-        bool enabled = sections[i].getBool("enable");
-	if ( !enabled ) {
-	    continue;
-	}
-
-	// printf("i = %d  name = %s source = %s\n",
-	//	   i, name.c_str(), source.c_str());
-	if ( source == "null" ) {
-	    // do nothing
-	} else if ( source == "APM2" ) {
-	    fresh_data = APM2_gps_update();
-	} else if ( source == "Aura3" ) {
-	    fresh_data = Aura3_gps_update();
-	} else if ( source == "fgfs" ) {
-	    fresh_data = fgfs_gps_update();
-	} else if ( source == "file" ) {
-	    fresh_data = ugfile_get_gps();
-	} else if ( source == "gpsd" ) {
-	    fresh_data = gpsd_get_gps();
-	} else if ( source == "ublox6" ) {
-	    fresh_data = gps_ublox6_update();
-	} else if ( source == "ublox8" ) {
-	    fresh_data = gps_ublox8_update();
-	} else {
-	    printf("Unknown gps source = '%s' in config file\n",
-		   source.c_str());
-	}
-	
-	if ( fresh_data ) {
-	    bool send_remote_link = false;
-	    if ( remote_link_count < 0 ) {
-		send_remote_link = true;
-		remote_link_count = remote_link_skip;
-	    }
-	
-	    bool send_logging = false;
-	    if ( logging_count < 0 ) {
-		send_logging = true;
-		logging_count = logging_skip;
-	    }
-	
-	    if ( send_remote_link || send_logging ) {
-                // generate the message
-                message::gps_v4_t gps;
-                gps.index = i;
-                gps.timestamp_sec = outputs[i].getDouble("timestamp");
-                gps.latitude_deg = outputs[i].getDouble("latitude_deg");
-                gps.longitude_deg = outputs[i].getDouble("longitude_deg");
-                gps.altitude_m = outputs[i].getDouble("altitude_m");
-                gps.vn_ms = outputs[i].getDouble("vn_ms");
-                gps.ve_ms = outputs[i].getDouble("ve_ms");
-                gps.vd_ms = outputs[i].getDouble("vd_ms");
-                gps.unixtime_sec = outputs[i].getDouble("unix_time_sec");
-                gps.satellites = outputs[i].getLong("satellites");
-                gps.horiz_accuracy_m = outputs[i].getDouble("horiz_accuracy_m");
-                gps.vert_accuracy_m = outputs[i].getDouble("vert_accuracy_m");
-                gps.pdop = outputs[i].getDouble("pdop");
-                gps.fix_type = outputs[i].getLong("fixType");
-                gps.pack();
-		if ( send_remote_link ) {
-		    remote_link->send_message( gps.id, gps.payload, gps.len );
-		}
-		if ( send_logging ) {
-		    logging->log_message( gps.id, gps.payload, gps.len );
-		}
-	    }
-	}
-    }
+    bool fresh_data = gpses.update();
 
     gps_prof.stop();
 
     if ( fresh_data ) {
 	// for computing gps data age
 	gps_last_time = gps_node.getDouble("timestamp");
-
-        remote_link_count--;
-        logging_count--;
     }
     
     if ( gps_node.getLong("status") == 2 && !gps_state ) {
@@ -287,37 +199,7 @@ bool GPS_update() {
 
 
 void GPS_close() {
-
-    // traverse configured modules
-    for ( unsigned int i = 0; i < sections.size(); i++ ) {
-	string source = sections[i].getString("source");
-	bool enabled = sections[i].getBool("enable");
-	if ( !enabled ) {
-	    continue;
-	}
-	//printf("i = %d  name = %s source = %s\n",
-	//       i, name.c_str(), source.c_str());
-	if ( source == "null" ) {
-	    // do nothing
-	} else if ( source == "APM2" ) {
-	    APM2_gps_close();
-	} else if ( source == "Aura3" ) {
-	    Aura3_gps_close();
-	} else if ( source == "fgfs" ) {
-	    fgfs_gps_close();
-	} else if ( source == "file" ) {
-	    ugfile_close();
-	} else if ( source == "gpsd" ) {
-	    // fixme
-	} else if ( source == "ublox6" ) {
-	    gps_ublox6_close();
-	} else if ( source == "ublox8" ) {
-	    gps_ublox8_close();
-	} else {
-	    printf("Unknown gps source = '%s' in config file\n",
-		   source.c_str());
-	}
-    }
+    gpses.close();
 }
 
 
@@ -31,6 +31,7 @@ using namespace Eigen;
 
 #include "comms/display.hxx"
 #include "comms/logging.hxx"
+#include "comms/trace.hxx"
 #include "init/globals.hxx"
 //#include "math/SGMath.hxx"
 //#include "math/SGGeodesy.hxx"
@@ -50,6 +51,8 @@ static string device_name = "/dev/ttyS0";
 static int baud = 57600;
 static int gps_fix_value = 0;
 
+static int bogus_ecef_event = trace_register("ublox6", "bogus_ecef", "received bogus ecef data");
+
 // initialize gpsd input property nodes
 static void bind_input( pyPropertyNode *config ) {
     if ( config->hasChild("device") ) {
@@ -240,7 +243,7 @@ static bool parse_ublox6_msg( uint8_t msg_class, uint8_t msg_id,
 	    // of the ecef coordinates is beyond this radius we know
 	    // we have bad data.  This means we won't toss data until
 	    // above about 423,000' MSL
-	    events->log( "ublox6", "received bogus ecef data" );
+	    trace_event( bogus_ecef_event );
 	} else if ( wgs84[2] > 60000 ) {
 	    // sanity check: assume altitude > 60k meters (200k feet) is bad
 	} else if ( wgs84[2] < -1000 ) {
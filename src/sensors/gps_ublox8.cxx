@@ -44,6 +44,33 @@ static string device_name = "/dev/ttyS0";
 static int baud = 115200;
 static int gps_fix_value = 0;
 
+// receive buffer, complete messages are parsed straight out of it
+static const int UBX_MAX_PAYLOAD = 400;
+static uint8_t rx_buf[4096];
+static int rx_len = 0;
+
+// when the bytes in rx_buf came in: chunk i starts at rx_chunk_pos[i]
+// and was read at rx_chunk_time[i] (local clock.)  A message is
+// stamped with the chunk its sync bytes arrived in, so one that spans
+// several reads isn't made late by the reads that finished it.
+static const int RX_MAX_CHUNKS = 64;
+static int rx_chunk_pos[RX_MAX_CHUNKS];
+static double rx_chunk_time[RX_MAX_CHUNKS];
+static int rx_chunks = 0;
+
+// local clock minus gps time of week: the smallest offset seen so far
+// (i.e. the least delayed message) is the best estimate of when a fix
+// was valid on the local (imu) clock.  Even the least delayed message
+// leaves the receiver some time after its epoch (solution and output
+// latency, 50-150ms on an M8 depending on rate and constellations)
+// and that part never shows up in the minimum, so it is configured
+// (output_latency_sec) and taken off on top.
+static const double TOV_DRIFT = 0.0001; // sec/sec allowed clock drift
+static double output_latency_sec = 0.08;
+static double tov_offset = 0.0;
+static double tov_last_rx = 0.0;
+static bool tov_inited = false;
+
 // initialize gpsd input property nodes
 static void bind_input( pyPropertyNode *config ) {
     if ( config->hasChild("device") ) {
@@ -52,6 +79,9 @@ static void bind_input( pyPropertyNode *config ) {
     if ( config->hasChild("baud") ) {
 	baud = config->getLong("baud");
     }
+    if ( config->hasChild("output_latency_sec") ) {
+	output_latency_sec = config->getDouble("output_latency_sec");
+    }
 }
 
 
@@ -81,7 +111,11 @@ static bool gps_ublox8_open() {
     // tcgetattr(fd,&oldTio); 
 
     int config_baud = B115200;
-    if ( baud == 115200 ) {
+    if ( baud == 460800 ) {
+	config_baud = B460800;
+    } else if ( baud == 230400 ) {
+	config_baud = B230400;
+    } else if ( baud == 115200 ) {
 	config_baud = B115200;
     } else if ( baud == 57600 ) {
 	config_baud = B57600;
@@ -142,11 +176,130 @@ static void my_swap( uint8_t *buf, int index, int count ) {
 }
 
 
+// NAV-PVT carries lla position, ned velocity, accuracies and utc time
+// in one message so it is all the gps_mgr needs.
+static bool parse_nav_pvt( uint8_t *payload, double msg_time ) {
+    bool new_position = false;
+
+    my_swap( payload, 0, 4);
+    my_swap( payload, 4, 2);
+    my_swap( payload, 12, 4);
+    my_swap( payload, 16, 4);
+    my_swap( payload, 24, 4);
+    my_swap( payload, 28, 4);
+    my_swap( payload, 32, 4);
+    my_swap( payload, 36, 4);
+    my_swap( payload, 40, 4);
+    my_swap( payload, 44, 4);
+    my_swap( payload, 48, 4);
+    my_swap( payload, 52, 4);
+    my_swap( payload, 56, 4);
+    my_swap( payload, 60, 4);
+    my_swap( payload, 64, 4);
+    my_swap( payload, 68, 4);
+    my_swap( payload, 72, 4);
+    my_swap( payload, 76, 2);
+    my_swap( payload, 78, 2);
+    my_swap( payload, 80, 4);
+
+    uint8_t *p = payload;
+    uint32_t iTOW = *((uint32_t *)p+0);
+    int16_t year = *((uint16_t *)(p+4));
+    uint8_t month = p[6];
+    uint8_t day = p[7];
+    uint8_t hour = p[8];
+    uint8_t min = p[9];
+    uint8_t sec = p[10];
+    // uint8_t valid = p[11];
+    uint32_t tAcc = *((uint32_t *)(p+12));
+    int32_t nano = *((int32_t *)(p+16));
+    uint8_t fixType = p[20];
+    // uint8_t flags = p[21];
+    uint8_t numSV = p[23];
+    int32_t lon = *((int32_t *)(p+24));
+    int32_t lat = *((int32_t *)(p+28));
+    // int32_t height = *((int32_t *)(p+32));
+    int32_t hMSL = *((int32_t *)(p+36));
+    uint32_t hAcc = *((uint32_t *)(p+40));
+    uint32_t vAcc = *((uint32_t *)(p+44));
+    int32_t velN = *((int32_t *)(p+48));
+    int32_t velE = *((int32_t *)(p+52));
+    int32_t velD = *((int32_t *)(p+56));
+    uint32_t gSpeed = *((uint32_t *)(p+60));
+    int32_t heading = *((int32_t *)(p+64));
+    // uint32_t sAcc = *((uint32_t *)(p+68));
+    uint32_t headingAcc = *((uint32_t *)(p+72));
+    uint16_t pDOP = *((uint16_t *)(p+76));
+
+    // time of validity on the local clock.  The offset estimate is
+    // allowed to creep up slowly so it can follow clock drift, a
+    // week rollover or a receiver restart resets it.
+    double itow_sec = iTOW / 1000.0;
+    double offset = msg_time - itow_sec;
+    if ( tov_inited ) {
+	tov_offset += TOV_DRIFT * (msg_time - tov_last_rx);
+    }
+    if ( !tov_inited || offset < tov_offset || offset > tov_offset + 1.0 ) {
+	tov_offset = offset;
+	tov_inited = true;
+    }
+    tov_last_rx = msg_time;
+    double tov = itow_sec + tov_offset - output_latency_sec;
+
+    gps_fix_value = fixType;
+    if ( gps_fix_value == 0 ) {
+	gps_node.setLong( "status", 0 );
+    } else if ( gps_fix_value == 1 || gps_fix_value == 2 ) {
+	gps_node.setLong( "status", 1 );
+    } else if ( gps_fix_value == 3 ) {
+	gps_node.setLong( "status", 2 );
+    }
+    // printf("fix: %d lon: %.8f lat: %.8f\n", fixType, (double)lon, (double)lat);
+
+    if ( fixType == 3 ) {
+	// gps thinks we have a good 3d fix so flag our data good.
+	new_position = true;
+    }
+
+    gps_node.setDouble( "timestamp", msg_time );
+    gps_node.setDouble( "tov_timestamp", tov );
+
+    struct tm gps_time;
+    gps_time.tm_sec = sec;
+    gps_time.tm_min = min;
+    gps_time.tm_hour = hour;
+    gps_time.tm_mday = day;
+    gps_time.tm_mon = month - 1;
+    gps_time.tm_year = year - 1900;
+    double unix_sec = (double)mktime( &gps_time ) - timezone;
+    unix_sec += nano / 1000000000.0;
+    gps_node.setDouble( "unix_time_sec", unix_sec );
+    gps_node.setDouble( "time_accuracy_ns", tAcc );
+
+    gps_node.setLong( "satellites", numSV );
+
+    gps_node.setDouble( "latitude_deg", (double)lat / 10000000.0);
+    gps_node.setDouble( "longitude_deg", (double)lon / 10000000.0);
+    gps_node.setDouble( "altitude_m", (float)hMSL / 1000.0 );
+    gps_node.setDouble( "vn_ms", (float)velN / 1000.0 );
+    gps_node.setDouble( "ve_ms", (float)velE / 1000.0 );
+    gps_node.setDouble( "vd_ms", (float)velD / 1000.0 );
+    gps_node.setDouble( "horiz_accuracy_m", hAcc / 1000.0 );
+    gps_node.setDouble( "vert_accuracy_m", vAcc / 1000.0 );
+    gps_node.setDouble( "groundspeed_ms", gSpeed / 1000.0 );
+    gps_node.setDouble( "groundtrack_deg", heading / 100000.0 );
+    gps_node.setDouble( "heading_accuracy_deg", headingAcc / 100000.0 );
+    gps_node.setDouble( "pdop", pDOP / 100.0 );
+    gps_node.setLong( "fixType", fixType);
+
+    return new_position;
+}
+
+
 static bool parse_ublox8_msg( uint8_t msg_class, uint8_t msg_id,
 			      uint16_t payload_length, uint8_t *payload )
 {
     bool new_position = false;
-    static bool set_system_time = false;
 
     if ( msg_class == 0x01 && msg_id == 0x02 ) {
 	// NAV-POSLLH: Please refer to the ublox6 driver (here or in the
@@ -156,102 +309,8 @@ static bool parse_ublox8_msg( uint8_t msg_class, uint8_t msg_id,
 	// code history) for a nav-sol parser that transforms eced
 	// pos/vel to lla pos/ned vel.
     } else if ( msg_class == 0x01 && msg_id == 0x07 ) {
-	// NAV-PVT
-	my_swap( payload, 0, 4);
-	my_swap( payload, 4, 2);
-	my_swap( payload, 12, 4);
-	my_swap( payload, 16, 4);
-	my_swap( payload, 24, 4);
-	my_swap( payload, 28, 4);
-	my_swap( payload, 32, 4);
-	my_swap( payload, 36, 4);
-	my_swap( payload, 40, 4);
-	my_swap( payload, 44, 4);
-	my_swap( payload, 48, 4);
-	my_swap( payload, 52, 4);
-	my_swap( payload, 56, 4);
-	my_swap( payload, 60, 4);
-	my_swap( payload, 64, 4);
-	my_swap( payload, 68, 4);
-	my_swap( payload, 72, 4);
-	my_swap( payload, 76, 2);
-	my_swap( payload, 78, 2);
-	my_swap( payload, 80, 4);
-
-	uint8_t *p = payload;
-	uint32_t iTOW = *((uint32_t *)p+0);
-	int16_t year = *((uint16_t *)(p+4));
-	uint8_t month = p[6];
-	uint8_t day = p[7];
-	uint8_t hour = p[8];
-	uint8_t min = p[9];
-	uint8_t sec = p[10];
-	uint8_t valid = p[11];
-	uint32_t tAcc = *((uint32_t *)(p+12));
-	int32_t nano = *((int32_t *)(p+16));
-	uint8_t fixType = p[20];
-	uint8_t flags = p[21];
-	uint8_t numSV = p[23];
-	int32_t lon = *((int32_t *)(p+24));
-	int32_t lat = *((int32_t *)(p+28));
-	int32_t height = *((int32_t *)(p+32));
-	int32_t hMSL = *((int32_t *)(p+36));
-	uint32_t hAcc = *((uint32_t *)(p+40));
-	uint32_t vAcc = *((uint32_t *)(p+44));
-	int32_t velN = *((int32_t *)(p+48));
-	int32_t velE = *((int32_t *)(p+52));
-	int32_t velD = *((int32_t *)(p+56));
-	uint32_t gSpeed = *((uint32_t *)(p+60));
-	int32_t heading = *((int32_t *)(p+64));
-	uint32_t sAcc = *((uint32_t *)(p+68));
-	uint32_t headingAcc = *((uint32_t *)(p+72));
-	uint16_t pDOP = *((uint16_t *)(p+76));
-
- 	gps_fix_value = fixType;
-	if ( gps_fix_value == 0 ) {
-	    gps_node.setLong( "status", 0 );
-	} else if ( gps_fix_value == 1 || gps_fix_value == 2 ) {
-	    gps_node.setLong( "status", 1 );
-	} else if ( gps_fix_value == 3 ) {
-	    gps_node.setLong( "status", 2 );
-	}
-	// printf("fix: %d lon: %.8f lat: %.8f\n", fixType, (double)lon, (double)lat);
-
-	if ( fixType == 3 ) {
-	    // gps thinks we have a good 3d fix so flag our data good.
- 	    new_position = true;
-	}
-
-	gps_node.setDouble( "timestamp", get_Time() );
-
-	struct tm gps_time;
-	gps_time.tm_sec = sec;
-	gps_time.tm_min = min;
-	gps_time.tm_hour = hour;
-	gps_time.tm_mday = day;
-	gps_time.tm_mon = month - 1;
-	gps_time.tm_year = year - 1900;
-	double unix_sec = (double)mktime( &gps_time ) - timezone;
-	unix_sec += nano / 1000000000.0;
-	gps_node.setDouble( "unix_time_sec", unix_sec );
-	gps_node.setDouble( "time_accuracy_ns", tAcc );
-	    
-	gps_node.setLong( "satellites", numSV );
-	    
-	gps_node.setDouble( "latitude_deg", (double)lat / 10000000.0);
-	gps_node.setDouble( "longitude_deg", (double)lon / 10000000.0);
-	gps_node.setDouble( "altitude_m", (float)hMSL / 1000.0 );
-	gps_node.setDouble( "vn_ms", (float)velN / 1000.0 );
-	gps_node.setDouble( "ve_ms", (float)velE / 1000.0 );
-	gps_node.setDouble( "vd_ms", (float)velD / 1000.0 );
-	gps_node.setDouble( "horiz_accuracy_m", hAcc / 1000.0 );
-	gps_node.setDouble( "vert_accuracy_m", vAcc / 1000.0 );
-	gps_node.setDouble( "groundspeed_ms", gSpeed / 1000.0 );
-	gps_node.setDouble( "groundtrack_deg", heading / 100000.0 );
-	gps_node.setDouble( "heading_accuracy_deg", headingAcc / 100000.0 );
-	gps_node.setDouble( "pdop", pDOP / 100.0 );
-	gps_node.setLong( "fixType", fixType);
-   } else if ( msg_class == 0x01 && msg_id == 0x12 ) {
+	// NAV-PVT: handled by the fast path in read_ublox8()
+    } else if ( msg_class == 0x01 && msg_id == 0x12 ) {
 	// NAV-VELNED: Please refer to the ublox6 driver (here or in the
 	// code history) for a nav-velned parser
     } else if ( msg_class == 0x01 && msg_id == 0x21 ) {
@@ -293,134 +352,125 @@ static bool parse_ublox8_msg( uint8_t msg_class, uint8_t msg_id,
     return new_position;
 }
 
-static bool read_ublox8() {
-    static int state = 0;
-    static int msg_class = 0, msg_id = 0;
-    static int length_lo = 0, length_hi = 0, payload_length = 0;
-    static int counter = 0;
-    static uint8_t cksum_A = 0, cksum_B = 0, cksum_lo = 0, cksum_hi = 0;
-    int len;
-    uint8_t input[500];
-    static uint8_t payload[500];
+// fletcher checksum over class, id, length and payload in one pass
+static void ubx_checksum( uint8_t *buf, int len, uint8_t *cksum_A,
+			  uint8_t *cksum_B )
+{
+    uint8_t a = 0, b = 0;
+    for ( int i = 0; i < len; i++ ) {
+	a += buf[i];
+	b += a;
+    }
+    *cksum_A = a;
+    *cksum_B = b;
+}
 
-    // printf("read ublox8, entry state = %d\n", state);
+// local clock time the byte at rx_buf[pos] was read
+static double rx_arrival_time( int pos ) {
+    if ( rx_chunks == 0 ) {
+	return get_Time();
+    }
+    int i = rx_chunks - 1;
+    while ( i > 0 && rx_chunk_pos[i] > pos ) {
+	i--;
+    }
+    return rx_chunk_time[i];
+}
 
+// the first n bytes of rx_buf are gone
+static void rx_consume_chunks( int n ) {
+    int first = 0;
+    while ( first + 1 < rx_chunks && rx_chunk_pos[first+1] <= n ) {
+	first++;
+    }
+    int j = 0;
+    for ( int i = first; i < rx_chunks; i++, j++ ) {
+	rx_chunk_pos[j] = rx_chunk_pos[i] > n ? rx_chunk_pos[i] - n : 0;
+	rx_chunk_time[j] = rx_chunk_time[i];
+    }
+    rx_chunks = j;
+    if ( rx_len == 0 ) {
+	rx_chunks = 0;
+    }
+}
+
+// Drain everything the uart has and parse every complete message in
+// the buffer.  At 10-25hz several messages can arrive per frame; only
+// the newest NAV-PVT is published so the property tree is written
+// once per frame at most.
+static bool read_ublox8() {
     bool new_position = false;
 
-    if ( state == 0 ) {
-	counter = 0;
-	cksum_A = cksum_B = 0;
-	len = read( fd, input, 1 );
-	while ( len > 0 && input[0] != 0xB5 ) {
-	    // fprintf( stderr, "state0: len = %d val = %2X\n", len, input[0] );
-	    len = read( fd, input, 1 );
-	}
-	if ( len > 0 && input[0] == 0xB5 ) {
-	    // fprintf( stderr, "read 0xB5\n");
-	    state++;
-	}
-    }
-    if ( state == 1 ) {
-	len = read( fd, input, 1 );
-	if ( len > 0 ) {
-	    if ( input[0] == 0x62 ) {
-		// fprintf( stderr, "read 0x62\n");
-		state++;
-	    } else if ( input[0] == 0xB5 ) {
-		// fprintf( stderr, "read 0xB5\n");
-	    } else {
-		state = 0;
-	    }
+    while ( rx_len < (int)sizeof(rx_buf) ) {
+	int len = read( fd, rx_buf + rx_len, sizeof(rx_buf) - rx_len );
+	if ( len <= 0 ) {
+	    break;
 	}
+	if ( rx_chunks < RX_MAX_CHUNKS ) {
+	    rx_chunk_pos[rx_chunks] = rx_len;
+	    rx_chunk_time[rx_chunks] = get_Time();
+	    rx_chunks++;
+	} // else: counted with the previous chunk (stamped early)
+	rx_len += len;
     }
-    if ( state == 2 ) {
-	len = read( fd, input, 1 );
-	if ( len > 0 ) {
-	    msg_class = input[0];
-	    cksum_A += input[0];
-	    cksum_B += cksum_A;
-	    // fprintf( stderr, "msg class = %d\n", msg_class );
-	    state++;
+
+    uint8_t *pvt_payload = NULL;
+    double pvt_time = 0.0;
+    int pos = 0;
+    while ( rx_len - pos >= 8 ) {
+	if ( rx_buf[pos] != 0xB5 || rx_buf[pos+1] != 0x62 ) {
+	    pos++;
+	    continue;
 	}
-    }
-    if ( state == 3 ) {
-	len = read( fd, input, 1 );
-	if ( len > 0 ) {
-	    msg_id = input[0];
-	    cksum_A += input[0];
-	    cksum_B += cksum_A;
-	    // fprintf( stderr, "msg id = %d\n", msg_id );
-	    state++;
+	uint8_t msg_class = rx_buf[pos+2];
+	uint8_t msg_id = rx_buf[pos+3];
+	int payload_length = rx_buf[pos+4] + rx_buf[pos+5]*256;
+	if ( payload_length > UBX_MAX_PAYLOAD ) {
+	    // not a real header, resync on the next byte
+	    pos++;
+	    continue;
 	}
-    }
-    if ( state == 4 ) {
-	len = read( fd, input, 1 );
-	if ( len > 0 ) {
-	    length_lo = input[0];
-	    cksum_A += input[0];
-	    cksum_B += cksum_A;
-	    state++;
+	if ( rx_len - pos < payload_length + 8 ) {
+	    // wait for the rest of the message
+	    break;
 	}
-    }
-    if ( state == 5 ) {
-	len = read( fd, input, 1 );
-	if ( len > 0 ) {
-	    length_hi = input[0];
-	    cksum_A += input[0];
-	    cksum_B += cksum_A;
-	    payload_length = length_hi*256 + length_lo;
-	    // fprintf( stderr, "payload len = %d\n", payload_length );
-	    if ( payload_length > 400 ) {
-		state = 0;
-	    } else {
-		state++;
+	uint8_t cksum_A, cksum_B;
+	ubx_checksum( rx_buf + pos + 2, payload_length + 4, &cksum_A, &cksum_B );
+	uint8_t *payload = rx_buf + pos + 6;
+	if ( cksum_A != payload[payload_length]
+	     || cksum_B != payload[payload_length+1] ) {
+	    if ( display_on && 0 ) {
+		printf("checksum failed %d %d (computed) != %d %d (message)\n",
+		       cksum_A, cksum_B, payload[payload_length],
+		       payload[payload_length+1] );
 	    }
+	    pos++;
+	    continue;
 	}
-    }
-    if ( state == 6 ) {
-	len = read( fd, input, 1 );
-	while ( len > 0 ) {
-	    payload[counter++] = input[0];
-	    //fprintf( stderr, "%02X ", input[0] );
-	    cksum_A += input[0];
-	    cksum_B += cksum_A;
-	    if ( counter >= payload_length ) {
-		break;
-	    }
-	    len = read( fd, input, 1 );
+	if ( msg_class == 0x01 && msg_id == 0x07 && payload_length >= 84 ) {
+	    // fast path: remember the newest, publish below
+	    pvt_payload = payload;
+	    pvt_time = rx_arrival_time( pos );
+	} else {
+	    parse_ublox8_msg( msg_class, msg_id, payload_length, payload );
 	}
+	pos += payload_length + 8;
+    }
 
-	if ( counter >= payload_length ) {
-	    state++;
-	    //fprintf( stderr, "\n" );
-	}
+    if ( pvt_payload != NULL ) {
+	new_position = parse_nav_pvt( pvt_payload, pvt_time );
     }
-    if ( state == 7 ) {
-	len = read( fd, input, 1 );
-	if ( len > 0 ) {
-	    cksum_lo = input[0];
-	    state++;
-	}
+
+    // keep any partial message for next time
+    if ( pos > 0 ) {
+	memmove( rx_buf, rx_buf + pos, rx_len - pos );
+	rx_len -= pos;
+	rx_consume_chunks( pos );
     }
-    if ( state == 8 ) {
-	len = read( fd, input, 1 );
-	if ( len > 0 ) {
-	    cksum_hi = input[0];
-	    if ( cksum_A == cksum_lo && cksum_B == cksum_hi ) {
-		// fprintf( stderr, "checksum passes (%d)!\n", msg_id );
-		new_position = parse_ublox8_msg( msg_class, msg_id,
-						 payload_length, payload );
-		state++;
-	    } else {
-		if ( display_on && 0 ) {
-		    printf("checksum failed %d %d (computed) != %d %d (message)\n",
-			   cksum_A, cksum_B, cksum_lo, cksum_hi );
-		}
-	    }
-	    // this is the end of a record, reset state to 0 to start
-	    // looking for next record
-	    state = 0;
-	}
+    if ( rx_len >= (int)sizeof(rx_buf) ) {
+	// nothing but garbage, start over
+	rx_len = 0;
+	rx_chunks = 0;
     }
 
     return new_position;
@@ -0,0 +1,140 @@
+/**
+ * \file: imu_filter.cxx
+ *
+ * Optional vibration filtering of the imu outputs.
+ */
+
+#include <pyprops.hxx>
+
+#include <math.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+#include "util/biquad.hxx"
+
+#include "imu_filter.hxx"
+
+static const int IMU_AXES = 9;
+static const char *imu_axis_names[IMU_AXES] = {
+    "p_rad_sec", "q_rad_sec", "r_rad_sec",
+    "ax_mps_sec", "ay_mps_sec", "az_mps_sec",
+    "hx", "hy", "hz"
+};
+struct imu_filter_t {
+    string output_path;		// the section's driver output
+    bool enabled = false;
+    BiquadBank<IMU_AXES, 2> bank; // section 0: lowpass, 1: notch
+    double sample_hz = 100.0;
+    double notch_q = 2.0;
+    double notch_min_hz = 0.0, notch_max_hz = 0.0;
+    double notch_hz = 0.0;	// current notch center
+    // throttle tracking notch designs across notch_min_hz..notch_max_hz,
+    // computed at init so the flight thread only picks one
+    vector<BiquadCoeffs> notch_table;
+    int notch_index = 0;
+};
+static const double notch_step_hz = 0.5;
+// sized once in IMU_filter_init() (before the drivers bind to them)
+static vector<imu_filter_t> filters;
+static pyPropertyNode act_node;
+
+
+static void imu_filter_init( imu_filter_t *f, pyPropertyNode *config ) {
+    if ( config->hasChild("sample_hz") ) {
+	f->sample_hz = config->getDouble("sample_hz");
+    }
+    if ( config->hasChild("lowpass_hz") ) {
+	f->bank.set_section( 0, biquad_lowpass( f->sample_hz,
+						config->getDouble("lowpass_hz"),
+						M_SQRT1_2 ) );
+	f->enabled = true;
+    }
+    if ( config->hasChild("notch_q") ) {
+	f->notch_q = config->getDouble("notch_q");
+    }
+    if ( config->hasChild("notch_min_hz") && config->hasChild("notch_max_hz") ) {
+	f->notch_min_hz = config->getDouble("notch_min_hz");
+	f->notch_max_hz = config->getDouble("notch_max_hz");
+	f->notch_hz = f->notch_min_hz;
+	int steps = floor( (f->notch_max_hz - f->notch_min_hz) / notch_step_hz );
+	for ( int i = 0; i <= steps; i++ ) {
+	    double hz = f->notch_min_hz + i * notch_step_hz;
+	    f->notch_table.push_back( biquad_notch( f->sample_hz, hz,
+						    f->notch_q ) );
+	}
+	act_node = pyGetNode("/actuators", true);
+    } else if ( config->hasChild("notch_hz") ) {
+	f->notch_hz = config->getDouble("notch_hz");
+    }
+    if ( f->notch_hz > 0.0 ) {
+	f->bank.set_section( 1, biquad_notch( f->sample_hz, f->notch_hz,
+					      f->notch_q ) );
+	f->enabled = true;
+    }
+}
+
+static void imu_filter_update( imu_filter_t *f, float x[IMU_AXES] ) {
+    if ( !f->notch_table.empty() ) {
+	// switch to the precomputed notch nearest the throttle
+	double throttle = act_node.getDouble("throttle");
+	if ( throttle < 0.0 ) { throttle = 0.0; }
+	if ( throttle > 1.0 ) { throttle = 1.0; }
+	double center = f->notch_min_hz
+	    + throttle * (f->notch_max_hz - f->notch_min_hz);
+	int index = lround( (center - f->notch_min_hz) / notch_step_hz );
+	if ( index >= (int)f->notch_table.size() ) {
+	    index = f->notch_table.size() - 1;
+	}
+	if ( index != f->notch_index ) {
+	    f->notch_index = index;
+	    f->notch_hz = f->notch_min_hz + index * notch_step_hz;
+	    f->bank.set_section( 1, f->notch_table[index] );
+	}
+    }
+    if ( !f->bank.is_primed() ) {
+	f->bank.prime( x );
+    }
+    f->bank.update( x );
+}
+
+
+void IMU_filter_init( string group_path, string output_base ) {
+    // filters are indexed by config section
+    pyPropertyNode group_node = pyGetNode(group_path, true);
+    vector<string> children = group_node.getChildren();
+    filters.clear();
+    for ( unsigned int i = 0; i < children.size(); i++ ) {
+	pyPropertyNode section = group_node.getChild(children[i].c_str());
+	filters.push_back( imu_filter_t() );
+	ostringstream output_path;	// as SensorGroup::init() names it
+	output_path << output_base << '[' << i << ']';
+	filters.back().output_path = output_path.str();
+	if ( section.hasChild("vibration_filter") ) {
+	    pyPropertyNode filter_node = section.getChild("vibration_filter");
+	    imu_filter_init( &filters.back(), &filter_node );
+	}
+    }
+}
+
+imu_filter_t *IMU_filter_bind( string output_path ) {
+    for ( unsigned int i = 0; i < filters.size(); i++ ) {
+	if ( filters[i].enabled && filters[i].output_path == output_path ) {
+	    return &filters[i];
+	}
+    }
+    return NULL;
+}
+
+void IMU_publish( imu_filter_t *filter, pyPropertyNode *node, float x[IMU_AXES] ) {
+    if ( filter != NULL ) {
+	imu_filter_update( filter, x );
+    }
+    for ( int j = 0; j < IMU_AXES; j++ ) {
+	node->setDouble( imu_axis_names[j], x[j] );
+    }
+}
@@ -0,0 +1,32 @@
+/**
+ * \file: imu_filter.hxx
+ *
+ * Optional vibration filtering of the imu outputs, configured per imu
+ * section under "vibration_filter": a lowpass (lowpass_hz) and a
+ * notch (notch_hz, notch_q).  If notch_min_hz/notch_max_hz are given
+ * the notch tracks throttle across that range instead (in 0.5 hz
+ * steps, designed up front.)
+ *
+ * Drivers publish their nine motion outputs through IMU_publish(),
+ * which filters them on the way into the tree.  Bind the filter in
+ * the driver's init with its output path; NULL means no filter.
+ */
+
+#pragma once
+
+#include <pyprops.hxx>
+
+#include <string>
+using std::string;
+
+struct imu_filter_t;
+
+// configure one filter per section of group_path, matched to the
+// drivers by output_base[i] (call before the drivers are initialized)
+void IMU_filter_init( string group_path, string output_base );
+
+imu_filter_t *IMU_filter_bind( string output_path );
+
+// x: p_rad_sec, q_rad_sec, r_rad_sec, ax_mps_sec, ay_mps_sec,
+//    az_mps_sec, hx, hy, hz (filtered in place)
+void IMU_publish( imu_filter_t *filter, pyPropertyNode *node, float x[9] );
@@ -19,6 +19,7 @@
 #include "include/globaldefs.h"
 
 #include "comms/display.hxx"
+#include "sensors/imu_filter.hxx"
 #include "util/strutils.hxx"
 #include "util/timing.h"
 
@@ -27,6 +28,7 @@
 
 // imu property nodes
 static pyPropertyNode imu_node;
+static imu_filter_t *imu_filter = NULL;
 
 static int fd = -1;
 static string device_name = "/dev/spike";
@@ -43,6 +45,7 @@ static void bind_imu_input( pyPropertyNode *config ) {
 // initialize imu output property nodes 
 static void bind_imu_output( string output_path ) {
     imu_node = pyGetNode(output_path, true);
+    imu_filter = IMU_filter_bind( output_path );
 }
 
 
@@ -112,52 +115,54 @@ static bool imu_vn100_spi_parse_msg( uint8_t *msg_buf, int size )
     imu_node.setLong( "driver_overruns", *iptr );
     
     float p, q, r;
+    float x[9];
     int i = 16;
 
     float *fptr = NULL;
 
     fptr = (float *)&msg_buf[i]; i += 4;
     // hx_filter = 0.75*hx_filter + 0.25*(*fptr);
-    imu_node.setDouble( "hx", *fptr );
+    x[6] = *fptr;
 
     fptr = (float *)&msg_buf[i]; i += 4;
     // hy_filter = 0.75*hy_filter + 0.25**fptr;
-    imu_node.setDouble( "hy", *fptr );
+    x[7] = *fptr;
 
     fptr = (float *)&msg_buf[i]; i += 4;
     // hz_filter = 0.75*hz_filter + 0.25**fptr;
-    imu_node.setDouble( "hz", *fptr );
+    x[8] = *fptr;
 
     fptr = (float *)&msg_buf[i]; i += 4;
     // ax_filter = 0.75*ax_filter + 0.25**fptr;
-    imu_node.setDouble( "ax_mps_sec", *fptr );
+    x[3] = *fptr;
 
     fptr = (float *)&msg_buf[i]; i += 4;
     // ay_filter = 0.75*ay_filter + 0.25**fptr;
-    imu_node.setDouble( "ay_mps_sec", *fptr );
+    x[4] = *fptr;
 
     fptr = (float *)&msg_buf[i]; i += 4;
     // az_filter = 0.75*az_filter + 0.25**fptr;
-    imu_node.setDouble( "az_mps_sec", *fptr );
+    x[5] = *fptr;
 
     fptr = (float *)&msg_buf[i]; i += 4;
     p = *fptr;
     // p_filter = 0.75*p_filter + 0.25*p;
-    imu_node.setDouble( "p_rad_sec", p - p_bias );
+    x[0] = p - p_bias;
 
     fptr = (float *)&msg_buf[i]; i += 4;
     q = *fptr;
     // q_filter = 0.75*q_filter + 0.25*q;
-    imu_node.setDouble( "q_rad_sec", q - q_bias );
+    x[1] = q - q_bias;
 
     fptr = (float *)&msg_buf[i]; i += 4;
     r = *fptr;
     // r_filter = 0.75*r_filter + 0.25*r;
-    imu_node.setDouble( "r_rad_sec", r - r_bias );
+    x[2] = r - r_bias;
 
     fptr = (float *)&msg_buf[i]; i += 4;
     imu_node.setDouble( "temp_C", *fptr );
 
+    IMU_publish( imu_filter, &imu_node, x );
     imu_node.setDouble( "timestamp", current_time );
 
     if ( !bias_ready ) {
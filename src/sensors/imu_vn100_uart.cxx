@@ -20,6 +20,7 @@
 #include "include/globaldefs.h"
 
 #include "comms/display.hxx"
+#include "sensors/imu_filter.hxx"
 #include "util/strutils.hxx"
 #include "util/timing.h"
 
@@ -28,6 +29,7 @@
 
 // imu nodes
 static pyPropertyNode imu_node;
+static imu_filter_t *imu_filter = NULL;
 
 static int fd = -1;
 static string device_name = "/dev/ttyS0";
@@ -44,6 +46,7 @@ static void bind_imu_input( pyPropertyNode *config ) {
 // initialize imu output property nodes 
 static void bind_imu_output( string output_path ) {
     imu_node = pyGetNode(output_path, true);
+    imu_filter = IMU_filter_bind( output_path );
 }
 
 
@@ -247,46 +250,48 @@ static bool imu_vn100_uart_parse_msg( char *msg_buf, int size )
     vector<string> tokens = split( msg.c_str(), "," );
     if ( tokens[0] == "VNCMV" && tokens.size() == 11 ) {
 	double val, p, q, r;
+	float x[9];
 	val = atof( tokens[1].c_str() );
 	// hx_filter = 0.75*hx_filter + 0.25*val;
-	imu_node.setDouble( "hx", val );
+	x[6] = val;
 
 	val = atof( tokens[2].c_str() );
 	// hy_filter = 0.75*hy_filter + 0.25*val;
-	imu_node.setDouble( "hy", val );
+	x[7] = val;
 
 	val = atof( tokens[3].c_str() );
 	// hz_filter = 0.75*hz_filter + 0.25*val;
-	imu_node.setDouble( "hz", val );
+	x[8] = val;
 
 	val = atof( tokens[4].c_str() );
 	// ax_filter = 0.75*ax_filter + 0.25*val;
-	imu_node.setDouble( "ax_mps_sec", val );
+	x[3] = val;
 
 	val = atof( tokens[5].c_str() );
 	// ay_filter = 0.75*ay_filter + 0.25*val;
-	imu_node.setDouble( "ay_mps_sec", val );
+	x[4] = val;
 
 	val = atof( tokens[6].c_str() );
 	// az_filter = 0.75*az_filter + 0.25*val;
-	imu_node.setDouble( "az_mps_sec", val );
+	x[5] = val;
 
 	p = val = atof( tokens[7].c_str() );
 	// p_filter = 0.75*p_filter + 0.25*val;
-	imu_node.setDouble( "p_rad_sec", val - p_bias );
+	x[0] = val - p_bias;
 
 	q = val = atof( tokens[8].c_str() );
 	// q_filter = 0.75*q_filter + 0.25*val;
-	imu_node.setDouble( "q_rad_sec", val - q_bias );
+	x[1] = val - q_bias;
 
 	r = val = atof( tokens[9].c_str() );
 	// r_filter = 0.75*r_filter + 0.25*val;
-	imu_node.setDouble( "r_rad_sec", val - r_bias );
+	x[2] = val - r_bias;
 
 	val = atof( tokens[10].c_str() );
 	// r_filter = 0.75*r_filter + 0.25*val;
 	imu_node.setDouble( "temp_C", val );
 
+	IMU_publish( imu_filter, &imu_node, x );
 	imu_node.setDouble( "timestamp", current_time );
 
 	if ( !bias_ready ) {
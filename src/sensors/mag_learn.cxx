@@ -0,0 +1,335 @@
+/**
+ * \file: mag_learn.cxx
+ *
+ * Online magnetometer ellipsoid calibration.
+ */
+
+#include <pyprops.hxx>
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>		// strerror()
+#include <unistd.h>		// usleep()
+
+#include <vector>
+using std::vector;
+
+#include <eigen3/Eigen/Dense>
+
+#include "init/runtime.hxx"
+
+#include "mag_learn.hxx"
+
+static vector<AuraMagLearn *> learners;
+
+
+AuraMagLearn::AuraMagLearn():
+    enabled(false),
+    decimate(10),
+    count(0),
+    head(0),
+    tail(0),
+    scale(0.0),
+    coverage(0),
+    updates(0),
+    new_samples(0),
+    min_bins(48),
+    max_residual(0.05),
+    last_result(0),
+    fits(0),
+    installs(0)
+{
+    cal.setIdentity();
+    for ( int i = 0; i < bins; i++ ) {
+	have_sample[i] = false;
+    }
+    ata.setZero();
+    atb.setZero();
+}
+
+void AuraMagLearn::init( const Matrix4d &mag_cal ) {
+    pyPropertyNode config = pyGetNode("/config/mag_learn", true);
+    enabled = config.getBool("enable");
+    if ( !enabled ) {
+	return;
+    }
+    if ( config.hasChild("decimate") ) {
+	decimate = config.getLong("decimate");
+    }
+    if ( config.hasChild("min_bins") ) {
+	min_bins = config.getLong("min_bins");
+    }
+    if ( config.hasChild("max_residual") ) {
+	max_residual = config.getDouble("max_residual");
+    }
+    if ( decimate < 1 ) {
+	decimate = 1;
+    }
+    cal = mag_cal;
+    status_node = pyGetNode("/sensors/imu_mag_cal", true);
+    status_node.setLong( "coverage", 0 );
+    status_node.setLong( "fits", 0 );
+    status_node.setLong( "installs", 0 );
+    learners.push_back( this );
+}
+
+void AuraMagLearn::sample( double hx_raw, double hy_raw, double hz_raw ) {
+    if ( !enabled ) {
+	return;
+    }
+    count++;
+    if ( count < decimate ) {
+	return;
+    }
+    count = 0;
+    uint32_t h = head.load( std::memory_order_relaxed );
+    if ( h - tail.load( std::memory_order_acquire ) >= ring_size ) {
+	return;			// helper is behind, drop it
+    }
+    float *s = ring[h & (ring_size - 1)];
+    s[0] = hx_raw;
+    s[1] = hy_raw;
+    s[2] = hz_raw;
+    head.store( h + 1, std::memory_order_release );
+}
+
+bool AuraMagLearn::update( Matrix4d *mag_cal ) {
+    if ( !enabled ) {
+	return false;
+    }
+    fit_t f;
+    unsigned int n = result.read( &f );
+    if ( n == last_result ) {
+	return false;
+    }
+    last_result = n;
+    fits++;
+    status_node.setLong( "coverage", f.coverage );
+    status_node.setLong( "fits", fits );
+    status_node.setDouble( "residual", f.residual );
+    status_node.setDouble( "installed_residual", f.installed_residual );
+    if ( !f.accepted ) {
+	return false;
+    }
+    char buf[512];
+    int len = 0;
+    for ( int i = 0; i < 16; i++ ) {
+	(*mag_cal)(i / 4, i % 4) = f.affine[i];
+	len += snprintf( buf + len, sizeof(buf) - len, i ? " %.10g" : "%.10g",
+			 f.affine[i] );
+    }
+    installs++;
+    status_node.setLong( "installs", installs );
+    status_node.setString( "mag_affine", buf );
+    printf("mag learn: installed new calibration (residual %.4f, was %.4f)\n",
+	   f.residual, f.installed_residual);
+    return true;
+}
+
+// design row of the ellipsoid fit
+static void design( const double x[3], Matrix<double, 9, 1> *d ) {
+    (*d)(0) = x[0] * x[0];
+    (*d)(1) = x[1] * x[1];
+    (*d)(2) = x[2] * x[2];
+    (*d)(3) = 2.0 * x[0] * x[1];
+    (*d)(4) = 2.0 * x[0] * x[2];
+    (*d)(5) = 2.0 * x[1] * x[2];
+    (*d)(6) = 2.0 * x[0];
+    (*d)(7) = 2.0 * x[1];
+    (*d)(8) = 2.0 * x[2];
+}
+
+// rank-one update (sign = 1) or downdate (sign = -1) of the normal
+// equations
+void AuraMagLearn::add( const double x[3], double sign ) {
+    Matrix<double, 9, 1> d;
+    design( x, &d );
+    ata.noalias() += sign * d * d.transpose();
+    atb += sign * d;
+}
+
+// start over from the binned samples now and then so rounding from
+// the downdates can't build up
+void AuraMagLearn::rebuild() {
+    ata.setZero();
+    atb.setZero();
+    for ( int i = 0; i < bins; i++ ) {
+	if ( have_sample[i] ) {
+	    add( sample_raw[i], 1.0 );
+	}
+    }
+    updates = 0;
+}
+
+// direction of the calibrated vector, equal area elevation bands
+int AuraMagLearn::bin( const double raw[3] ) {
+    Vector4d hs( raw[0] * scale, raw[1] * scale, raw[2] * scale, 1.0 );
+    Vector4d hc = cal * hs;
+    double norm = hc.head<3>().norm();
+    if ( norm < 1e-9 ) {
+	return -1;
+    }
+    double z = hc(2) / norm;
+    int el = (z + 1.0) * 0.5 * el_bands;
+    if ( el >= el_bands ) { el = el_bands - 1; }
+    if ( el < 0 ) { el = 0; }
+    double az = atan2( hc(1), hc(0) ) + M_PI;
+    int a = az / (2.0 * M_PI) * az_bands;
+    if ( a >= az_bands ) { a = az_bands - 1; }
+    if ( a < 0 ) { a = 0; }
+    return el * az_bands + a;
+}
+
+// rms deviation of the calibrated magnitude from its mean (relative)
+double AuraMagLearn::residual( const Matrix4d &m, double *mean_norm ) {
+    double norms[bins];
+    int n = 0;
+    double sum = 0.0;
+    for ( int i = 0; i < bins; i++ ) {
+	if ( have_sample[i] ) {
+	    Vector4d hs( sample_raw[i][0] * scale, sample_raw[i][1] * scale,
+			 sample_raw[i][2] * scale, 1.0 );
+	    norms[n] = (m * hs).head<3>().norm();
+	    sum += norms[n];
+	    n++;
+	}
+    }
+    if ( n == 0 || sum <= 0.0 ) {
+	*mean_norm = 1.0;
+	return 1.0;
+    }
+    double mean = sum / n;
+    double sq = 0.0;
+    for ( int i = 0; i < n; i++ ) {
+	double e = norms[i] / mean - 1.0;
+	sq += e * e;
+    }
+    *mean_norm = mean;
+    return sqrt( sq / n );
+}
+
+// solve for the ellipsoid and turn it into an affine calibration
+// (in raw units) that maps it onto the unit sphere
+bool AuraMagLearn::fit( Matrix4d *m ) {
+    Matrix<double, 9, 1> p = ata.ldlt().solve( atb );
+    Matrix3d q;
+    q << p(0), p(3), p(4),
+	 p(3), p(1), p(5),
+	 p(4), p(5), p(2);
+    Vector3d v( p(6), p(7), p(8) );
+    if ( !p.allFinite() || fabs(q.determinant()) < 1e-12 ) {
+	return false;
+    }
+    Vector3d center = -q.inverse() * v;
+    double k = 1.0 + center.dot( q * center );
+    if ( k <= 0.0 ) {
+	return false;
+    }
+    SelfAdjointEigenSolver<Matrix3d> eig( q / k );
+    Vector3d ev = eig.eigenvalues();
+    if ( ev.minCoeff() <= 0.0 ) {
+	return false;		// not an ellipsoid
+    }
+    Matrix3d w = eig.eigenvectors() * ev.cwiseSqrt().asDiagonal()
+	* eig.eigenvectors().transpose();
+    m->setIdentity();
+    m->block<3,3>(0,0) = w / scale;
+    m->block<3,1>(0,3) = -w * center;
+    return true;
+}
+
+void AuraMagLearn::process() {
+    uint32_t t = tail.load( std::memory_order_relaxed );
+    uint32_t h = head.load( std::memory_order_acquire );
+    while ( t != h ) {
+	const float *s = ring[t & (ring_size - 1)];
+	double raw[3] = { s[0], s[1], s[2] };
+	t++;
+	tail.store( t, std::memory_order_release );
+	if ( scale == 0.0 ) {
+	    double norm = sqrt( raw[0]*raw[0] + raw[1]*raw[1] + raw[2]*raw[2] );
+	    if ( norm < 1e-9 ) {
+		continue;
+	    }
+	    scale = norm;
+	}
+	// binned samples are kept in scaled units (about 1) so the
+	// normal equations stay well conditioned
+	double x[3] = { raw[0] / scale, raw[1] / scale, raw[2] / scale };
+	int b = bin( x );
+	if ( b < 0 ) {
+	    continue;
+	}
+	if ( have_sample[b] ) {
+	    add( sample_raw[b], -1.0 );
+	} else {
+	    have_sample[b] = true;
+	    coverage++;
+	}
+	sample_raw[b][0] = x[0];
+	sample_raw[b][1] = x[1];
+	sample_raw[b][2] = x[2];
+	add( x, 1.0 );
+	new_samples++;
+	if ( ++updates >= 1000 ) {
+	    rebuild();
+	}
+    }
+
+    if ( coverage < min_bins || new_samples < 50 ) {
+	return;
+    }
+    new_samples = 0;
+
+    fit_t f;
+    memset( &f, 0, sizeof(f) );
+    f.coverage = coverage;
+    double installed_norm;
+    f.installed_residual = residual( cal, &installed_norm );
+    f.residual = 1.0;
+    Matrix4d candidate;
+    if ( fit( &candidate ) ) {
+	double norm;
+	f.residual = residual( candidate, &norm );
+	// keep the output magnitude the installed calibration had
+	candidate.block<3,4>(0,0) *= installed_norm / norm;
+	if ( f.residual < max_residual
+	     && f.residual < 0.8 * f.installed_residual )
+	{
+	    f.accepted = true;
+	    cal = candidate;
+	}
+    }
+    for ( int i = 0; i < 16; i++ ) {
+	f.affine[i] = cal(i / 4, i % 4);
+    }
+    result.write( f );
+}
+
+
+static void *mag_learn_main( void *arg ) {
+    runtime_helper_thread_init( "mag learn" );
+    while ( true ) {
+	for ( unsigned int i = 0; i < learners.size(); i++ ) {
+	    learners[i]->process();
+	}
+	usleep( 50000 );
+    }
+    return NULL;
+}
+
+bool mag_learn_start() {
+    if ( learners.empty() ) {
+	return true;
+    }
+    pthread_t thread;
+    int result = pthread_create( &thread, NULL, mag_learn_main, NULL );
+    if ( result != 0 ) {
+	printf("mag learn: unable to start helper thread - %s\n",
+	       strerror(result));
+	return false;
+    }
+    pthread_detach( thread );
+    return true;
+}
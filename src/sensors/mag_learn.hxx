@@ -0,0 +1,122 @@
+/**
+ * \file: mag_learn.hxx
+ *
+ * Online magnetometer ellipsoid calibration.
+ *
+ * The imu driver hands every raw magnetometer sample to sample() and
+ * keeps using its own mag_cal affine matrix.  A helper thread keeps a
+ * fixed set of samples binned by direction over the sphere (one per
+ * bin, the newest wins) and the normal equations of the ellipsoid
+ * fit
+ *
+ *   a x^2 + b y^2 + c z^2 + 2d xy + 2e xz + 2f yz + 2g x + 2h y + 2i z = 1
+ *
+ * over those samples.  Replacing a bin's sample is a rank-one downdate
+ * and update of the 9x9 system, so the cost per sample doesn't grow
+ * with coverage.  Once enough of the sphere is covered the system is
+ * solved for the hard iron offset and the (symmetric) soft iron
+ * matrix.  The candidate is scored by the rms deviation from a sphere
+ * over the binned samples, as is the calibration currently installed,
+ * and update() swaps it into the driver's mag_cal on the flight thread
+ * only if it is clearly better.  The output keeps the magnitude of the
+ * calibration it replaces.
+ *
+ * Configured under /config/mag_learn:
+ *
+ *   enable       : turn learning on (default off)
+ *   decimate     : use every n'th sample (10)
+ *   min_bins     : bins that must be filled before fitting (48 of 128)
+ *   max_residual : never install a fit worse than this (0.05)
+ *
+ * Status is published under /sensors/imu_mag_cal.
+ */
+
+#pragma once
+
+#include <pyprops.hxx>
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+#include "util/seqlock.hxx"
+
+class AuraMagLearn {
+
+public:
+
+    static const int ring_size = 256;	// samples, power of 2
+    static const int el_bands = 8;
+    static const int az_bands = 16;
+    static const int bins = el_bands * az_bands;
+
+    // fit result, written by the helper thread
+    struct fit_t {
+	double affine[16];	// row major
+	float residual;		// of the candidate
+	float installed_residual;
+	int coverage;		// filled bins
+	bool accepted;
+    };
+
+private:
+
+    bool enabled;
+    int decimate;
+    int count;
+
+    // raw samples, flight thread -> helper thread
+    float ring[ring_size][3];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+
+    // helper thread state
+    Matrix4d cal;		// installed (or about to be) calibration
+    double scale;		// raw units -> about 1
+    bool have_sample[bins];
+    double sample_raw[bins][3];	// scaled
+    int coverage;
+    Matrix<double, 9, 9> ata;
+    Matrix<double, 9, 1> atb;
+    int updates;
+    int new_samples;
+    int min_bins;
+    double max_residual;
+
+    SeqLock<fit_t> result;	// helper thread -> flight thread
+    unsigned int last_result;
+    int fits;
+    int installs;
+
+    pyPropertyNode status_node;
+
+    void add( const double x[3], double sign );
+    void rebuild();
+    int bin( const double raw[3] );
+    double residual( const Matrix4d &m, double *mean_norm );
+    bool fit( Matrix4d *m );
+
+public:
+
+    AuraMagLearn();
+
+    // flight thread: the driver's initial calibration
+    void init( const Matrix4d &mag_cal );
+
+    // flight thread, every sample (cheap: decimate and queue)
+    void sample( double hx_raw, double hy_raw, double hz_raw );
+
+    // flight thread: install an accepted fit into mag_cal, true if it
+    // changed
+    bool update( Matrix4d *mag_cal );
+
+    // helper thread: process the queued samples and fit when due
+    void process();
+};
+
+// start the helper thread that serves every learner (after
+// runtime_init() so it lands on the helper cpus.)
+bool mag_learn_start();
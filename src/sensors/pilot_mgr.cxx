@@ -14,16 +14,15 @@
 #include <stdio.h>
 #include <string.h>
 
-#include <sstream>
 #include <string>
 #include <vector>
-using std::ostringstream;
 using std::string;
 using std::vector;
 
 #include "comms/aura_messages.h"
 #include "comms/logging.hxx"
 #include "comms/remote_link.hxx"
+#include "comms/trace.hxx"
 #include "include/globaldefs.h"
 #include "init/globals.hxx"
 #include "util/myprof.hxx"
@@ -31,6 +30,7 @@ using std::vector;
 #include "APM2.hxx"
 #include "Aura3/Aura3.hxx"
 #include "FGFS.hxx"
+#include "sensor_mgr.hxx"
 
 #include "pilot_mgr.hxx"
 
@@ -43,128 +43,53 @@ static pyPropertyNode pilot_node;
 static pyPropertyNode flight_node;
 static pyPropertyNode engine_node;
 static pyPropertyNode ap_node;
-static vector<pyPropertyNode> sections;
-static vector<pyPropertyNode> outputs;
 
-static int remote_link_skip = 0;
-static int logging_skip = 0;
+static int fail_safe_event = trace_register("Aura3", "fail_safe", "Receiver fail safe = %.0f");
+
+static void pack_pilot( message::pilot_v3_t *pilot, pyPropertyNode *output ) {
+    pilot->timestamp_sec = output->getDouble("timestamp");
+    for ( int i = 0; i < 8; i++ ) {
+	pilot->channel[i] = output->getDouble("channel", i);
+    }
+    pilot->status = 0;
+}
+
+static const sensor_driver_t pilot_drivers[] = {
+    { "APM2",
+      []( string path, pyPropertyNode *config ) { APM2_pilot_init( path, config ); },
+      APM2_pilot_update, APM2_pilot_close, NULL },
+    { "Aura3",
+      []( string path, pyPropertyNode *config ) { Aura3_pilot_init( path, config ); },
+      Aura3_pilot_update, Aura3_pilot_close, NULL },
+    { "fgfs",
+      []( string path, pyPropertyNode *config ) { fgfs_pilot_init( path, config ); },
+      fgfs_pilot_update, fgfs_pilot_close, NULL },
+};
+
+static SensorGroup<message::pilot_v3_t> pilots( pack_pilot );
 
 void PilotInput_init() {
     pilot_node = pyGetNode("/sensors/pilot_input", true);
     flight_node = pyGetNode("/controls/flight", true);
     engine_node = pyGetNode("/controls/engine", true);
     ap_node = pyGetNode("/autopilot", true);
-    
-    pyPropertyNode remote_link_node = pyGetNode("/config/remote_link", true);
-    pyPropertyNode logging_node = pyGetNode("/config/logging", true);
-    remote_link_skip = remote_link_node.getDouble("pilot_skip");
-    logging_skip = logging_node.getDouble("pilot_skip");
-
-    // traverse configured modules
-    pyPropertyNode group_node = pyGetNode("/config/sensors/pilot_inputs", true);
-    vector<string> children = group_node.getChildren();
-    printf("Found %d pilot sections\n", (int)children.size());
-    for ( unsigned int i = 0; i < children.size(); i++ ) {
-	pyPropertyNode section = group_node.getChild(children[i].c_str());
-	sections.push_back(section);
-	string source = section.getString("source");
-	bool enabled = section.getBool("enable");
-	if ( !enabled ) {
-	    continue;
-	}
-	ostringstream output_path;
-	output_path << "/sensors/pilot_input" << '[' << i << ']';
-        pyPropertyNode output_node = pyGetNode(output_path.str(), true);
-        outputs.push_back(output_node);
-	printf("pilot: %d = %s\n", i, source.c_str());
-	if ( source == "null" ) {
-	    // do nothing
-	} else if ( source == "APM2" ) {
-	    APM2_pilot_init( output_path.str(), &section );
-	} else if ( source == "Aura3" ) {
-	    Aura3_pilot_init( output_path.str(), &section );
-	} else if ( source == "fgfs" ) {
-	    fgfs_pilot_init( output_path.str(), &section );
-	} else {
-	    printf("Unknown pilot input source = '%s' in config file\n",
-		   source.c_str());
-	}
-    }
+
+    pilots.init( "pilot", "/config/sensors/pilot_inputs",
+		 "/sensors/pilot_input", "source", "pilot_skip", pilot_drivers,
+		 sizeof(pilot_drivers) / sizeof(pilot_drivers[0]) );
 }
 
 
 bool PilotInput_update() {
     pilot_prof.start();
 
-    bool fresh_data = false;
-
-    static int remote_link_count = 0;
-    static int logging_count = 0;
-
-    // traverse configured modules
-    for ( unsigned int i = 0; i < sections.size(); i++ ) {
-	string source = sections[i].getString("source");
-	bool enabled = sections[i].getBool("enable");
-	if ( !enabled ) {
-	    continue;
-	}
-	if ( source == "null" ) {
-	    // do nothing
-	} else if ( source == "APM2" ) {
-	    fresh_data = APM2_pilot_update();
-	} else if ( source == "Aura3" ) {
-	    fresh_data = Aura3_pilot_update();
-	} else if ( source == "fgfs" ) {
-	    fresh_data = fgfs_pilot_update();
-	} else {
-	    printf("Unknown pilot input source = '%s' in config file\n",
-		   source.c_str());
-	}
-	if ( fresh_data ) {
-	    bool send_remote_link = false;
-	    if ( remote_link_count < 0 ) {
-		send_remote_link = true;
-		remote_link_count = remote_link_skip;
-	    }
-	
-	    bool send_logging = false;
-	    if ( logging_count < 0 ) {
-		send_logging = true;
-		logging_count = logging_skip;
-	    }
-	
-	    if ( send_remote_link || send_logging ) {
-                message::pilot_v3_t pilot;
-                pilot.index = i;
-                pilot.timestamp_sec = outputs[i].getDouble("timestamp");
-                pilot.channel[0] = outputs[i].getDouble("channel", 0);
-                pilot.channel[1] = outputs[i].getDouble("channel", 1);
-                pilot.channel[2] = outputs[i].getDouble("channel", 2);
-                pilot.channel[3] = outputs[i].getDouble("channel", 3);
-                pilot.channel[4] = outputs[i].getDouble("channel", 4);
-                pilot.channel[5] = outputs[i].getDouble("channel", 5);
-                pilot.channel[6] = outputs[i].getDouble("channel", 6);
-                pilot.channel[7] = outputs[i].getDouble("channel", 7);
-                pilot.status = 0;
-                pilot.pack();
-		if ( send_remote_link ) {
-		    remote_link->send_message( pilot.id, pilot.payload, pilot.len );
-		}
-		if ( send_logging ) {
-		    logging->log_message( pilot.id, pilot.payload, pilot.len );
-		}
-	    }
-	}
-    }
+    bool fresh_data = pilots.update();
 
     if ( fresh_data ) {
         // log receiver fail safe changes
         static bool last_fail_safe = false;
         if ( pilot_node.getBool("fail_safe") != last_fail_safe ) {
-            char buf[128];
-            snprintf( buf, 32, "Receiver fail safe = %d",
-                      pilot_node.getBool("fail_safe") );
-            events->log("Aura3", buf );
+            trace_event( fail_safe_event, pilot_node.getBool("fail_safe") );
             last_fail_safe = pilot_node.getBool("fail_safe");
         }
         
@@ -180,9 +105,6 @@ bool PilotInput_update() {
 	    flight_node.setDouble( "rudder", pilot_node.getDouble("rudder") );
 	    flight_node.setDouble( "flaps", pilot_node.getDouble("flaps") );
 	}
-
-        remote_link_count--;
-        logging_count--;
     }
 
     pilot_prof.stop();
@@ -192,24 +114,5 @@ bool PilotInput_update() {
 
 
 void PilotInput_close() {
-    // traverse configured modules
-    for ( unsigned int i = 0; i < sections.size(); i++ ) {
-	string source = sections[i].getString("source");
-	bool enabled = sections[i].getBool("enable");
-	if ( !enabled ) {
-	    continue;
-	}
-	if ( source == "null" ) {
-	    // do nothing
-	} else if ( source == "APM2" ) {
-	    APM2_pilot_close();
-	} else if ( source == "Aura3" ) {
-	    Aura3_pilot_close();
-	} else if ( source == "fgfs" ) {
-	    fgfs_pilot_close();
-	} else {
-	    printf("Unknown pilot input source = '%s' in config file\n",
-		   source.c_str());
-	}
-    }
+    pilots.close();
 }
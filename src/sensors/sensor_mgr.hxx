@@ -0,0 +1,271 @@
+//
+// sensor_mgr.hxx - shared plumbing for the multi-instance managers
+//
+// The imu, gps, airdata, pilot input and actuator managers all walk a
+// config group of sections, start the driver named by each section's
+// "source" (or "module"), poll the enabled instances every frame and
+// send a message for fresh data at the configured remote link and
+// logging skip rates.
+//
+// Each manager lists its drivers in a sensor_driver_t table.  The
+// table entry for every section is looked up once at init, so the
+// per frame loop is a walk over function pointers with no string
+// compares or config lookups.
+//
+
+#pragma once
+
+#include <pyprops.hxx>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+#include "init/globals.hxx"
+
+struct sensor_driver_t {
+    const char *source;
+    void (*init)( string output_path, pyPropertyNode *config );
+    bool (*update)();		// true if fresh data was produced
+    void (*close)();		// optional
+    void (*calibrate)();	// optional
+};
+
+
+// remote link and logging message rate control, configured by name
+// under /config/remote_link and /config/logging.  A message goes out
+// every (skip + 1) frames with fresh data.
+class MessageRate {
+
+private:
+
+    int remote_link_skip = 0;
+    int logging_skip = 0;
+    int remote_link_count = 0;
+    int logging_count = 0;
+
+public:
+
+    void init( const char *skip_name ) {
+	pyPropertyNode remote_link_node = pyGetNode("/config/remote_link", true);
+	pyPropertyNode logging_node = pyGetNode("/config/logging", true);
+	remote_link_skip = remote_link_node.getDouble(skip_name);
+	logging_skip = logging_node.getDouble(skip_name);
+    }
+
+    // which destinations are due, resets the counters of those that are
+    inline void due( bool *send_remote_link, bool *send_logging ) {
+	*send_remote_link = false;
+	if ( remote_link_count < 0 ) {
+	    *send_remote_link = true;
+	    remote_link_count = remote_link_skip;
+	}
+	*send_logging = false;
+	if ( logging_count < 0 ) {
+	    *send_logging = true;
+	    logging_count = logging_skip;
+	}
+    }
+
+    // call once per frame with fresh data
+    inline void tick() {
+	remote_link_count--;
+	logging_count--;
+    }
+};
+
+
+// With the actuator fast path on (/config/actuator_fast_path) the
+// groups hold back their messages while the frame's inputs are read
+// and send them from sensor_messages_flush() once the actuator
+// command is out, so packing and link writes don't sit between the
+// imu sample and the servos.
+class SensorGroupBase {
+public:
+    virtual void flush() = 0;
+};
+
+inline vector<SensorGroupBase *> &sensor_groups() {
+    static vector<SensorGroupBase *> groups;
+    return groups;
+}
+
+inline bool &sensor_messages_deferred() {
+    static bool deferred = false;
+    return deferred;
+}
+
+inline void sensor_messages_defer( bool defer ) {
+    sensor_messages_deferred() = defer;
+}
+
+inline void sensor_messages_flush() {
+    vector<SensorGroupBase *> &groups = sensor_groups();
+    for ( unsigned int i = 0; i < groups.size(); i++ ) {
+	groups[i]->flush();
+    }
+}
+
+
+// MSG is one of the message:: types (id, payload, len, index, pack())
+template <class MSG>
+class SensorGroup: public SensorGroupBase {
+
+public:
+
+    // fill in a message from an instance's output node
+    typedef void (*pack_fn)( MSG *msg, pyPropertyNode *output );
+
+private:
+
+    struct instance_t {
+	int index;		// section index in the config group
+	const sensor_driver_t *driver;
+	pyPropertyNode output;
+	bool pending;		// fresh data waiting for flush()
+    };
+
+    vector<instance_t> instances;
+    MessageRate rate;
+    pack_fn pack;
+    bool fresh_pending = false;
+
+    void send( int index, pyPropertyNode *output ) {
+	bool send_remote_link, send_logging;
+	rate.due( &send_remote_link, &send_logging );
+	if ( send_remote_link || send_logging ) {
+	    MSG msg;
+	    msg.index = index;
+	    pack( &msg, output );
+	    msg.pack();
+	    if ( send_remote_link ) {
+		remote_link->send_message( msg.id, msg.payload, msg.len );
+	    }
+	    if ( send_logging ) {
+		logging->log_message( msg.id, msg.payload, msg.len );
+	    }
+	}
+    }
+
+public:
+
+    SensorGroup( pack_fn _pack ): pack(_pack) {}
+
+    // name:        label for the console messages
+    // group_path:  config group of sections ("/config/sensors/imu_group")
+    // output_base: instances publish to output_base[i] ("/sensors/imu"),
+    //              NULL if the drivers have no output node
+    // key:         section key naming the driver ("source")
+    // skip_name:   remote link / logging skip config name ("imu_skip")
+    void init( const char *name, const char *group_path,
+	       const char *output_base, const char *key,
+	       const char *skip_name,
+	       const sensor_driver_t *drivers, int count )
+    {
+	rate.init( skip_name );
+	sensor_groups().push_back( this );
+
+	pyPropertyNode group_node = pyGetNode(group_path, true);
+	vector<string> children = group_node.getChildren();
+	printf("Found %d %s sections\n", (int)children.size(), name);
+	for ( unsigned int i = 0; i < children.size(); i++ ) {
+	    pyPropertyNode section = group_node.getChild(children[i].c_str());
+	    if ( !section.getBool("enable") ) {
+		continue;
+	    }
+	    string source = section.getString(key);
+	    ostringstream output_path;
+	    if ( output_base != NULL ) {
+		output_path << output_base << '[' << i << ']';
+	    }
+	    printf("%s: %d = %s\n", name, i, source.c_str());
+	    if ( source == "null" ) {
+		continue;
+	    }
+	    const sensor_driver_t *driver = NULL;
+	    for ( int j = 0; j < count; j++ ) {
+		if ( source == drivers[j].source ) {
+		    driver = &drivers[j];
+		    break;
+		}
+	    }
+	    if ( driver == NULL ) {
+		printf("Unknown %s source = '%s' in config file\n",
+		       name, source.c_str());
+		continue;
+	    }
+	    instance_t instance;
+	    instance.index = i;
+	    instance.driver = driver;
+	    instance.pending = false;
+	    if ( output_base != NULL ) {
+		instance.output = pyGetNode(output_path.str(), true);
+	    }
+	    instances.push_back( instance );
+	    driver->init( output_path.str(), &section );
+	}
+    }
+
+    // poll every instance, returns true if any produced fresh data
+    bool update() {
+	bool fresh_data = false;
+	for ( unsigned int i = 0; i < instances.size(); i++ ) {
+	    instance_t *instance = &instances[i];
+	    if ( !instance->driver->update() ) {
+		continue;
+	    }
+	    fresh_data = true;
+	    if ( sensor_messages_deferred() ) {
+		instance->pending = true;
+	    } else {
+		send( instance->index, &instance->output );
+	    }
+	}
+	if ( fresh_data ) {
+	    if ( sensor_messages_deferred() ) {
+		fresh_pending = true;
+	    } else {
+		rate.tick();
+	    }
+	}
+	return fresh_data;
+    }
+
+    // send the messages held back by update()
+    void flush() {
+	if ( !fresh_pending ) {
+	    return;
+	}
+	for ( unsigned int i = 0; i < instances.size(); i++ ) {
+	    instance_t *instance = &instances[i];
+	    if ( instance->pending ) {
+		instance->pending = false;
+		send( instance->index, &instance->output );
+	    }
+	}
+	fresh_pending = false;
+	rate.tick();
+    }
+
+    void calibrate() {
+	for ( unsigned int i = 0; i < instances.size(); i++ ) {
+	    if ( instances[i].driver->calibrate != NULL ) {
+		instances[i].driver->calibrate();
+	    }
+	}
+    }
+
+    void close() {
+	for ( unsigned int i = 0; i < instances.size(); i++ ) {
+	    if ( instances[i].driver->close != NULL ) {
+		instances[i].driver->close();
+	    }
+	}
+    }
+};
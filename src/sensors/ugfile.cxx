@@ -14,6 +14,7 @@
 #include "util/timing.h"
 
 #include "gps_mgr.hxx"
+#include "imu_filter.hxx"
 
 #include "ugfile.hxx"
 
@@ -75,6 +76,7 @@ static NavState state;
 
 // property nodes
 static pyPropertyNode imu_node;
+static imu_filter_t *imu_filter = NULL;
 static pyPropertyNode gps_node;
 
 
@@ -209,6 +211,7 @@ static void bind_input( pyPropertyNode *config ) {
 /// initialize imu output property nodes 
 static void bind_imu_output( string output_path ) {
     imu_node = pyGetNode(output_path, true);
+    imu_filter = IMU_filter_bind( output_path );
 }
 
 
@@ -334,15 +337,10 @@ void ugfile_close() {
 bool ugfile_get_imu() {
     if ( imu_data_valid ) {
 	imu_node.setDouble( "timestamp", imu_data.time );
-	imu_node.setDouble( "p_rad_sec", imu_data.p );
-	imu_node.setDouble( "q_rad_sec", imu_data.q );
-	imu_node.setDouble( "r_rad_sec", imu_data.r );
-	imu_node.setDouble( "ax_mps_sec", imu_data.ax );
-	imu_node.setDouble( "ay_mps_sec", imu_data.ay );
-	imu_node.setDouble( "az_mps_sec", imu_data.az );
-	imu_node.setDouble( "hx", imu_data.hx );
-	imu_node.setDouble( "hy", imu_data.hy );
-	imu_node.setDouble( "hz", imu_data.hz );
+	float x[9] = { (float)imu_data.p, (float)imu_data.q, (float)imu_data.r,
+		       (float)imu_data.ax, (float)imu_data.ay, (float)imu_data.az,
+		       (float)imu_data.hx, (float)imu_data.hy, (float)imu_data.hz };
+	IMU_publish( imu_filter, &imu_node, x );
     }
 
     return imu_data_valid;
@@ -2,21 +2,30 @@ import math
 
 from props import getNode
 
+from auracore import coverage
 import control.route
 import control.waypoint
 
-import survey.point as point
-import survey.vector as vector
-import survey.area as area
-
 ft2m = 0.3048
+kt2mps = 0.5144444444444444444
 d2r = math.pi / 180.0
+r2d = 180.0 / math.pi
+g = 9.81
 
 wind_node = getNode("/filters/wind", True)
 task_node = getNode( '/task', True )
 targets_node = getNode( '/autopilot/targets', True )
+L1_node = getNode('/config/autopilot/L1_controller', True)
+
+# planning runs a few scan lines (or transect picks) per frame so a
+# large area never stalls the main loop
+planner = coverage.Planner()
+planning = False
+work_per_frame = 8
 
 def do_survey( request ):
+    global planning
+
     # validate the inputs
     print('do survey:', request)
     if 'agl_ft' in request:
@@ -44,24 +53,21 @@ def do_survey( request ):
     else:
         lfov = 40
 
-    # generate the boundary polygon
-    poly = []
-    if not 'area' in request:
-        return    
-    for p in request['area']:
-        poly.append( point.Point(p[0], p[1]) )
-    ref = poly[0]
-    cart = area.geod2cart( ref, poly )
-    cart_area = area.Area( cart )
-
-    # convert to cartesian coordinates
+    # the boundary polygon, holes (no coverage needed) and no-fly
+    # areas, all lists of (lon, lat)
+    if not 'area' in request or len(request['area']) < 3:
+        return
+    holes = request.get('holes', [])
+    nofly = request.get('nofly', [])
+
     # advance direction is upwind by default
+    wind_north_mps = wind_node.getFloat('wind_north_mps')
+    wind_east_mps = wind_node.getFloat('wind_east_mps')
     if wind_node.getFloat('wind_speed_kt') > 2:
-        advance_dir = vector.Vector( wind_node.getFloat('wind_east_mps'),
-                                     wind_node.getFloat('wind_north_mps') )
+        advance_deg = math.atan2(wind_east_mps, wind_north_mps) * r2d
     else:
         # little or no wind
-        advance_dir = vector.Vector(0, 1) # north
+        advance_deg = 0.0       # north
 
     # survey altitude
     if agl_ft >= 100 and agl_ft <= 400:
@@ -75,18 +81,40 @@ def do_survey( request ):
     fov2_tan = math.tan(lfov*0.5 * d2r)
     slap_dist_m = 2 * fov2_tan * agl_m * (1.0 - slap)
 
-    # slice the area and make the route
-    cart_route = area.slice(cart_area, advance_dir, step=slap_dist_m,
-                            extend=extend_m)
-    geod_route = area.cart2geod( ref, cart_route )
+    # turn radius at the L1 bank limit for the turn cost
+    tas_mps = wind_node.getFloat('true_airspeed_kt') * kt2mps
+    if tas_mps < 10:
+        tas_mps = targets_node.getFloat('airspeed_kt') * kt2mps
+    if tas_mps < 10:
+        tas_mps = 10
+    bank_deg = L1_node.getFloat('bank_limit_deg')
+    if bank_deg < 5:
+        bank_deg = 25
+    turn_radius_m = tas_mps * tas_mps / (g * math.tan(bank_deg * d2r))
+
+    planner.start( request['area'], holes, nofly, slap_dist_m, extend_m,
+                   advance_deg, wind_north_mps, wind_east_mps,
+                   tas_mps, turn_radius_m )
+    planning = True
+
+# call every frame, makes the new route active once planning finishes
+def update():
+    global planning
+
+    if not planning:
+        return
+    if not planner.update(work_per_frame):
+        return
+    planning = False
+    print('survey: %d transects' % planner.transect_count())
 
     # assemble the route
     control.route.standby_route = []
-    for p in geod_route:
+    for (lon, lat) in planner.route():
         wp = control.waypoint.Waypoint()
         wp.mode = 'absolute'
-        wp.lon_deg = p.x
-        wp.lat_deg = p.y
+        wp.lon_deg = lon
+        wp.lat_deg = lat
         control.route.standby_route.append(wp)
 
     # make active
@@ -0,0 +1,54 @@
+// biquad coefficient design.  Lowpass and notch follow the RBJ audio
+// eq cookbook, the butterworth sections match butter.cxx.
+
+#include <math.h>
+
+#include "biquad.hxx"
+
+static BiquadCoeffs normalize( double b0, double b1, double b2,
+			       double a0, double a1, double a2 )
+{
+    BiquadCoeffs c;
+    c.b0 = b0 / a0;
+    c.b1 = b1 / a0;
+    c.b2 = b2 / a0;
+    c.a1 = a1 / a0;
+    c.a2 = a2 / a0;
+    return c;
+}
+
+BiquadCoeffs biquad_passthrough() {
+    return normalize( 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 );
+}
+
+BiquadCoeffs biquad_lowpass( double sample_hz, double cutoff_hz, double q ) {
+    double w0 = 2.0 * M_PI * cutoff_hz / sample_hz;
+    double cw = cos(w0);
+    double alpha = sin(w0) / (2.0 * q);
+    return normalize( (1.0 - cw) / 2.0, 1.0 - cw, (1.0 - cw) / 2.0,
+		      1.0 + alpha, -2.0 * cw, 1.0 - alpha );
+}
+
+BiquadCoeffs biquad_notch( double sample_hz, double center_hz, double q ) {
+    double w0 = 2.0 * M_PI * center_hz / sample_hz;
+    double cw = cos(w0);
+    double alpha = sin(w0) / (2.0 * q);
+    return normalize( 1.0, -2.0 * cw, 1.0,
+		      1.0 + alpha, -2.0 * cw, 1.0 - alpha );
+}
+
+void biquad_butterworth( int order, double sample_hz, double cutoff_hz,
+			 BiquadCoeffs *sections )
+{
+    int n = order / 2;
+    double a = tan( M_PI * cutoff_hz / sample_hz );
+    double a2 = a*a;
+    for ( int i = 0; i < n; ++i ) {
+        double r = sin(M_PI*(2.0*i+1.0)/(4.0*n));
+        double s = a2 + 2.0*a*r + 1.0;
+        double A = a2/s;
+        double d1 = 2.0*(1-a2)/s;
+        double d2 = -(a2 - 2.0*a*r + 1.0)/s;
+	sections[i] = normalize( A, 2.0*A, A, 1.0, -d1, -d2 );
+    }
+}
@@ -0,0 +1,178 @@
+// fixed size biquad (second order section) filters.
+//
+// Coefficients are designed once (see the design functions below,
+// they use trig and belong outside the main loop) and the cascades
+// below only do multiply/adds on fixed size arrays.  The sections run
+// in transposed direct form II:
+//
+//     y  = b0*x + z1
+//     z1 = b1*x - a1*y + z2
+//     z2 = b2*x - a2*y
+
+#pragma once
+
+struct BiquadCoeffs {
+    float b0, b1, b2;
+    float a1, a2;		// a0 normalized to 1
+};
+
+// coefficient design
+BiquadCoeffs biquad_passthrough();
+BiquadCoeffs biquad_lowpass( double sample_hz, double cutoff_hz, double q );
+BiquadCoeffs biquad_notch( double sample_hz, double center_hz, double q );
+// order/2 sections, same response as ButterworthFilter (butter.hxx)
+void biquad_butterworth( int order, double sample_hz, double cutoff_hz,
+			 BiquadCoeffs *sections );
+
+
+// one channel through SECTIONS cascaded biquads
+template <int SECTIONS>
+class BiquadCascade {
+
+private:
+
+    BiquadCoeffs c[SECTIONS];
+    float z1[SECTIONS], z2[SECTIONS];
+
+public:
+
+    BiquadCascade() {
+	for ( int s = 0; s < SECTIONS; s++ ) {
+	    c[s] = biquad_passthrough();
+	}
+	reset();
+    }
+
+    inline void set_section( int s, const BiquadCoeffs &coeffs ) {
+	c[s] = coeffs;
+    }
+
+    inline void reset() {
+	for ( int s = 0; s < SECTIONS; s++ ) {
+	    z1[s] = z2[s] = 0.0f;
+	}
+    }
+
+    // start out in steady state at value
+    void prime( float value ) {
+	for ( int s = 0; s < SECTIONS; s++ ) {
+	    float y = value * (c[s].b0 + c[s].b1 + c[s].b2)
+		/ (1.0f + c[s].a1 + c[s].a2);
+	    z2[s] = c[s].b2 * value - c[s].a2 * y;
+	    z1[s] = y - c[s].b0 * value;
+	    value = y;
+	}
+    }
+
+    inline float update( float x ) {
+	for ( int s = 0; s < SECTIONS; s++ ) {
+	    float y = c[s].b0 * x + z1[s];
+	    z1[s] = c[s].b1 * x - c[s].a1 * y + z2[s];
+	    z2[s] = c[s].b2 * x - c[s].a2 * y;
+	    x = y;
+	}
+	return x;
+    }
+};
+
+
+// drop in replacement for ButterworthFilter with the order fixed at
+// compile time (ORDER must be even.)
+template <int ORDER>
+class ButterworthLowpass {
+
+private:
+
+    BiquadCascade<ORDER/2> cascade;
+
+public:
+
+    ButterworthLowpass( double sample_hz, double cutoff_hz ) {
+	BiquadCoeffs sections[ORDER/2];
+	biquad_butterworth( ORDER, sample_hz, cutoff_hz, sections );
+	for ( int s = 0; s < ORDER/2; s++ ) {
+	    cascade.set_section( s, sections[s] );
+	}
+    }
+
+    inline float update( float x ) {
+	return cascade.update( x );
+    }
+};
+
+
+// CHANNELS signals through the same SECTIONS cascade.  The filter
+// state is stored channel-minor (structure of arrays) so each section
+// is one short loop across all channels that the compiler can
+// vectorize.
+template <int CHANNELS, int SECTIONS>
+class BiquadBank {
+
+private:
+
+    BiquadCoeffs c[SECTIONS];
+    float z1[SECTIONS][CHANNELS];
+    float z2[SECTIONS][CHANNELS];
+    bool primed;
+
+public:
+
+    BiquadBank() {
+	for ( int s = 0; s < SECTIONS; s++ ) {
+	    c[s] = biquad_passthrough();
+	}
+	reset();
+    }
+
+    inline void set_section( int s, const BiquadCoeffs &coeffs ) {
+	c[s] = coeffs;
+    }
+
+    void reset() {
+	for ( int s = 0; s < SECTIONS; s++ ) {
+	    for ( int ch = 0; ch < CHANNELS; ch++ ) {
+		z1[s][ch] = z2[s][ch] = 0.0f;
+	    }
+	}
+	primed = false;
+    }
+
+    // start every channel out in steady state at its current value
+    void prime( const float *x ) {
+	float v[CHANNELS];
+	for ( int ch = 0; ch < CHANNELS; ch++ ) {
+	    v[ch] = x[ch];
+	}
+	for ( int s = 0; s < SECTIONS; s++ ) {
+	    float gain = (c[s].b0 + c[s].b1 + c[s].b2)
+		/ (1.0f + c[s].a1 + c[s].a2);
+	    for ( int ch = 0; ch < CHANNELS; ch++ ) {
+		float y = v[ch] * gain;
+		z2[s][ch] = c[s].b2 * v[ch] - c[s].a2 * y;
+		z1[s][ch] = y - c[s].b0 * v[ch];
+		v[ch] = y;
+	    }
+	}
+	primed = true;
+    }
+
+    inline bool is_primed() {
+	return primed;
+    }
+
+    // filter x[CHANNELS] in place
+    inline void update( float *x ) {
+	for ( int s = 0; s < SECTIONS; s++ ) {
+	    const float b0 = c[s].b0, b1 = c[s].b1, b2 = c[s].b2;
+	    const float a1 = c[s].a1, a2 = c[s].a2;
+	    float *w1 = z1[s];
+	    float *w2 = z2[s];
+	    for ( int ch = 0; ch < CHANNELS; ch++ ) {
+		float y = b0 * x[ch] + w1[ch];
+		w1[ch] = b1 * x[ch] - a1 * y + w2[ch];
+		w2[ch] = b2 * x[ch] - a2 * y;
+		x[ch] = y;
+	    }
+	}
+    }
+};
@@ -11,9 +11,9 @@ ButterworthFilter::ButterworthFilter(int order, int samplerate, double cutoff)
     A = new double[n];
     d1 = new double[n];
     d2 = new double[n];
-    w0 = new double[n];
-    w1 = new double[n];
-    w2 = new double[n];
+    w0 = new double[n]();
+    w1 = new double[n]();
+    w2 = new double[n]();
 
     // generate coefficients
     for ( int i = 0; i < n; ++i ) {
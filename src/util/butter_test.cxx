@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "biquad.hxx"
 #include "butter.hxx"
 #include "lowpass.hxx"
 
@@ -22,6 +23,7 @@ static float pitot_butter_filt(float input) {
 
 int main() {
     ButterworthFilter bf(2, 100, 1.5);
+    ButterworthLowpass<2> bq(100, 1.5);
     LowPassFilter lp(0.5);
 
     float dt = 0.01; // 100hz
@@ -31,9 +33,10 @@ int main() {
         signal += drand48() * 1.0 - 0.5;
         double pbf = pitot_butter_filt(signal);
         double gbf = bf.update(signal);
+        double bqf = bq.update(signal);
         double lpf = lp.update(signal, dt);
         
-        printf("%.4f %.4f %.4f %.4f\n", signal, pbf, gbf, lpf);
+        printf("%.4f %.4f %.4f %.4f %.4f\n", signal, pbf, gbf, bqf, lpf);
         time += dt;
     }
 }
@@ -0,0 +1,93 @@
+// fixed bin latency histogram.
+//
+// add() is a short scan over a static bin table with no allocation so
+// it can run every frame.  Percentiles are reported as the upper edge
+// of the bin they fall in.
+
+#pragma once
+
+#include <stdio.h>
+
+class LatencyHistogram {
+
+public:
+
+    // upper bin edges in ms, anything beyond the last edge lands in
+    // the overflow bin
+    static const int BINS = 18;
+
+private:
+
+    const float *edges() {
+	static const float e[BINS - 1] = { 1, 2, 3, 4, 5, 6, 8, 10, 12, 15,
+					   20, 25, 30, 40, 50, 75, 100 };
+	return e;
+    }
+
+    unsigned int bins[BINS];
+    unsigned int count;
+    double sum_ms;
+    double max_ms;
+    double last_ms;
+
+public:
+
+    LatencyHistogram() {
+	reset();
+    }
+
+    void reset() {
+	for ( int i = 0; i < BINS; i++ ) {
+	    bins[i] = 0;
+	}
+	count = 0;
+	sum_ms = 0.0;
+	max_ms = 0.0;
+	last_ms = 0.0;
+    }
+
+    inline void add( double sec ) {
+	double ms = sec * 1000.0;
+	const float *e = edges();
+	int i = 0;
+	while ( i < BINS - 1 && ms > e[i] ) {
+	    i++;
+	}
+	bins[i]++;
+	count++;
+	sum_ms += ms;
+	if ( ms > max_ms ) {
+	    max_ms = ms;
+	}
+	last_ms = ms;
+    }
+
+    // p in [0, 1]
+    double percentile_ms( double p ) {
+	if ( count == 0 ) {
+	    return 0.0;
+	}
+	unsigned int target = p * count;
+	unsigned int total = 0;
+	const float *e = edges();
+	for ( int i = 0; i < BINS - 1; i++ ) {
+	    total += bins[i];
+	    if ( total > target ) {
+		return e[i];
+	    }
+	}
+	return max_ms;
+    }
+
+    inline unsigned int get_count() { return count; }
+    inline unsigned int get_bin( int i ) { return bins[i]; }
+    inline double get_mean_ms() { return count ? sum_ms / count : 0.0; }
+    inline double get_max_ms() { return max_ms; }
+    inline double get_last_ms() { return last_ms; }
+
+    void print( const char *name ) {
+	printf("%s latency (ms): n=%u mean=%.2f p50=%.0f p95=%.0f p99=%.0f max=%.2f\n",
+	       name, count, get_mean_ms(), percentile_ms(0.5),
+	       percentile_ms(0.95), percentile_ms(0.99), max_ms);
+    }
+};
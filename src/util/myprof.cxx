@@ -3,6 +3,7 @@
 #include <stdio.h>
 
 #include "comms/logging.hxx"
+#include "comms/trace.hxx"
 #include "init/globals.hxx"
 #include "timing.h"
 #include "myprof.hxx"
@@ -14,6 +15,8 @@ myprofile::myprofile() {
     max_interval = 0.0;
     min_interval = 1000.0;
     enabled = false;
+    trace_id = -1;
+    overrun_id = -1;
 }
 
 myprofile::~myprofile() {
@@ -21,35 +24,59 @@ myprofile::~myprofile() {
 
 void myprofile::set_name( const string _name ) {
     name = _name;
+    trace_id = trace_register( "frame", name.c_str() );
+    overrun_id = trace_register( name.c_str(), "overrun",
+                                 "t1 = %.3f t2 = %.3f int = %.3f" );
 }
 
 void myprofile::start() {
+    if ( trace_id >= 0 ) {
+	trace_begin( trace_id );
+    }
     if ( !enabled ) {
 	return;
     }
     
     if ( init_time <= 0.0001 ) {
-	init_time = get_Time();
+	init_time = get_HostTime();
     }
-    start_time = get_Time();
+    start_time = get_HostTime();
     count++;
 }
 
 void myprofile::stop() {
+    if ( trace_id >= 0 ) {
+	trace_end( trace_id );
+    }
     if ( !enabled ) {
 	return;
     }
     
-    double stop_time = get_Time();
-    last_interval = stop_time - start_time;
+    double stop_time = get_HostTime();
+    record( stop_time - start_time );
+}
+
+// i.e. code that ran on a worker thread, timed there and handed back
+void myprofile::add( double interval ) {
+    if ( !enabled ) {
+	return;
+    }
+    if ( init_time <= 0.0001 ) {
+	init_time = get_HostTime();
+    }
+    start_time = get_HostTime() - interval;
+    count++;
+    record( interval );
+}
+
+void myprofile::record( double interval ) {
+    double stop_time = start_time + interval;
+    last_interval = interval;
     sum_time += last_interval;
     
     // log situations where a module took longer that 0.10 sec to execute
     if ( last_interval > 0.10 ) {
-	char msg[256];
-	snprintf(msg, 256, "t1 = %.3f t2 = %.3f int = %.3f",
-		 start_time, stop_time, last_interval);
-	events->log( name.c_str(), msg );
+	trace_event( overrun_id, start_time, stop_time, last_interval );
     }
 
     if ( last_interval < min_interval ) {
@@ -61,11 +88,11 @@ void myprofile::stop() {
 }
 
 void myprofile::stats() {
-    if ( !enabled ) {
+    if ( !enabled || count == 0 ) {
 	return;
     }
     
-    double total_time = get_Time() - init_time;
+    double total_time = get_HostTime() - init_time;
     double avg_hz = 0.0;
     if ( total_time > 1.0 ) {
 	avg_hz = (double)count / total_time;
@@ -83,6 +110,7 @@ myprofile gps_prof;
 myprofile air_prof;
 myprofile pilot_prof;
 myprofile filter_prof;
+myprofile filter_gps_prof;
 myprofile mission_prof;
 myprofile control_prof;
 myprofile health_prof;
@@ -19,6 +19,10 @@ private:
     double sum_time;
     string name;
     bool enabled;
+    int trace_id;		// frame timeline
+    int overrun_id;		// event log message
+
+    void record( double interval );
 
 public:
 
@@ -28,6 +32,7 @@ public:
     void set_name( const string _name );
     void start();
     void stop();
+    void add( double interval ); // an interval timed elsewhere
     void stats();
     inline double get_last_interval() { return last_interval; }
     inline void enable() { enabled = true; }
@@ -41,6 +46,7 @@ extern myprofile gps_prof;
 extern myprofile air_prof;
 extern myprofile pilot_prof;
 extern myprofile filter_prof;
+extern myprofile filter_gps_prof;
 extern myprofile mission_prof;
 extern myprofile control_prof;
 extern myprofile health_prof;
@@ -0,0 +1,49 @@
+// single writer, many reader sequence lock.
+//
+// The writer bumps the sequence to odd, copies the value in and bumps
+// it back to even.  Readers copy the value out and retry if the
+// sequence was odd or moved while they were copying.  Neither side
+// ever blocks or allocates, so a helper thread can publish to the
+// flight loop without the flight loop waiting on it.  T must be
+// trivially copyable.
+
+#pragma once
+
+#include <atomic>
+#include <string.h>		// memcpy()
+
+template <class T>
+class SeqLock {
+
+private:
+
+    std::atomic<unsigned int> seq;
+    T value;
+
+public:
+
+    SeqLock(): seq(0) {
+	memset( (void *)&value, 0, sizeof(T) );
+    }
+
+    void write( const T &v ) {
+	unsigned int s = seq.load( std::memory_order_relaxed );
+	seq.store( s + 1, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+	memcpy( (void *)&value, &v, sizeof(T) );
+	seq.store( s + 2, std::memory_order_release );
+    }
+
+    // returns the number of completed writes (0 if nothing has been
+    // published yet.)
+    unsigned int read( T *v ) const {
+	unsigned int s0, s1;
+	do {
+	    s0 = seq.load( std::memory_order_acquire );
+	    memcpy( (void *)v, (const void *)&value, sizeof(T) );
+	    std::atomic_thread_fence( std::memory_order_acquire );
+	    s1 = seq.load( std::memory_order_relaxed );
+	} while ( (s0 & 1) || s0 != s1 );
+	return s0 / 2;
+    }
+};
@@ -6,6 +6,8 @@
 #include <unistd.h>
 #include <time.h>
 
+#include <atomic>
+
 
 void print_Time_Resolution()
 {
@@ -15,7 +17,36 @@ void print_Time_Resolution()
 	   res.tv_nsec);
 }
 
-double get_Time()
+// helper threads (trace drain, sysmon, bus polling) read the clock
+// while the flight thread switches it
+static std::atomic<double (*)()> time_source(NULL);
+
+void set_Time_source( double (*source)() )
+{
+    time_source.store( source );
+}
+
+void release_Time_source( double (*source)() )
+{
+    time_source.compare_exchange_strong( source, NULL );
+}
+
+static std::atomic<double> virtual_time(0.0);
+
+static double get_virtual_time()
+{
+    return virtual_time.load( std::memory_order_relaxed );
+}
+
+void set_Time_virtual( double t )
+{
+    virtual_time.store( t, std::memory_order_relaxed );
+    if ( time_source.load( std::memory_order_relaxed ) != get_virtual_time ) {
+        time_source.store( get_virtual_time );
+    }
+}
+
+double get_HostTime()
 {
     static double tstart;
     static bool init = false;
@@ -32,6 +63,15 @@ double get_Time()
     return tcur - tstart;
 }
 
+double get_Time()
+{
+    double (*source)() = time_source.load( std::memory_order_acquire );
+    if ( source != NULL ) {
+        return source();
+    }
+    return get_HostTime();
+}
+
 double get_RealTime()
 {
     struct timespec t;
@@ -3,3 +3,20 @@
 void print_Time_Resolution();
 extern double get_Time();
 extern double get_RealTime();
+
+// replace the monotonic clock behind get_Time() (i.e. with the
+// recorded clock when replaying a sensor log.)  NULL restores the
+// system clock.
+extern void set_Time_source( double (*source)() );
+
+// restore the system clock, but only if source still drives
+// get_Time() (someone else may have switched it since.)
+extern void release_Time_source( double (*source)() );
+
+// virtual time: from here on get_Time() returns the last value set
+// (i.e. the simulator clock in lockstep mode.)
+extern void set_Time_virtual( double t );
+
+// the host monotonic clock (seconds since first use), whatever drives
+// get_Time().  For measuring how long code takes to run.
+extern double get_HostTime();
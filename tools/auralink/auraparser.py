@@ -3,10 +3,12 @@ import sys
 
 sys.path.append("../src")
 from comms import aura_messages
+import comms.link_codec
 import comms.packer
 import comms.serial_parser
 
 parser = None
+codec = comms.link_codec.decoder()
 f = None
 
 def init():
@@ -18,9 +20,19 @@ def update(ser):
     global parser
     pkt_id = parser.read(ser)
     if pkt_id >= 0:
-        parse_msg(pkt_id, parser.payload)
-        log_msg(f, pkt_id, parser.pkt_len, parser.payload,
-                parser.cksum_lo, parser.cksum_hi)
+        # log the plain message so the flight log reads like an
+        # uncoded one
+        pkt_id, payload = codec.decode(pkt_id, parser.payload)
+        if pkt_id < 0:
+            return
+        parse_msg(pkt_id, payload)
+        if payload is parser.payload:
+            log_msg(f, pkt_id, parser.pkt_len, payload,
+                    parser.cksum_lo, parser.cksum_hi)
+        else:
+            (cksum0, cksum1) = comms.serial_parser.checksum(pkt_id, payload,
+                                                            len(payload))
+            log_msg(f, pkt_id, len(payload), payload, cksum0, cksum1)
 
 # simple 2-byte checksum
 def validate_cksum(id, size, buf, cksum0, cksum1):
@@ -93,10 +105,14 @@ def parse_msg(id, buf):
         index = comms.packer.unpack_ap_status_v6(buf)
     elif id == aura_messages.ap_status_v7_id:
         index = comms.packer.unpack_ap_status_v7(buf)
+    elif id == aura_messages.ap_status_v8_id:
+        index = comms.packer.unpack_ap_status_v8(buf)
     elif id == aura_messages.system_health_v4_id:
         index = comms.packer.unpack_system_health_v4(buf)
     elif id == aura_messages.system_health_v5_id:
         index = comms.packer.unpack_system_health_v5(buf)
+    elif id == aura_messages.system_health_v6_id:
+        index = comms.packer.unpack_system_health_v6(buf)
     elif id == aura_messages.payload_v2_id:
         index = comms.packer.unpack_payload_v2(buf)
     elif id == aura_messages.payload_v3_id:
@@ -156,6 +172,9 @@ def file_read(buf):
 
     if validate_cksum(id, size, savebuf, cksum0, cksum1):
         # print "check sum passed"
+        id, savebuf = codec.decode(id, savebuf)
+        if id < 0:
+            return (-1, -1, counter)
         index = parse_msg(id, savebuf)
         return (id, index, counter)
 
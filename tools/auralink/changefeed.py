@@ -0,0 +1,117 @@
+# Incremental change feed for the property tree.
+#
+# The tree (or just the subtrees someone asked for) is walked once per
+# refresh and compared leaf by leaf against a shadow copy.  Every refresh bumps a generation counter and
+# each leaf remembers the generation it last changed in, so any number
+# of clients can each ask for "what changed since generation N" and
+# get only those leaves.  Paths use the props syntax
+# (/sensors/gps[0]/latitude_deg) so clients can apply them to a mirror
+# of the full_json tree.
+
+from collections import deque
+
+import props_json
+
+# refreshes kept for answering 'changes since', older clients just get
+# the whole tree again
+max_history = 100
+
+# subtree paths as given by a client ('/' or None is the whole tree),
+# '' stands for the root
+def normalize(paths):
+    if paths is None:
+        return [ '' ]
+    result = [ path.rstrip('/') for path in paths ]
+    if '' in result:
+        return [ '' ]
+    # drop subtrees already covered by a shorter path
+    result.sort()
+    collapsed = []
+    for path in result:
+        if not len(collapsed) or not under(path, collapsed[-1:]):
+            collapsed.append(path)
+    return collapsed
+
+# is the leaf at path inside one of the (normalized) subtrees
+def under(path, subtrees):
+    for subtree in subtrees:
+        if subtree == '' or path == subtree \
+           or path.startswith(subtree + '/'):
+            return True
+    return False
+
+class ChangeFeed():
+    def __init__(self, root):
+        self.root = root
+        self.generation = 0
+        self.leaves = {}        # path -> value
+        self.history = deque(maxlen=max_history) # (gen, changed, removed)
+
+    def flatten(self, prefix, node, result):
+        if isinstance(node, dict):
+            for key, value in node.items():
+                self.flatten(prefix + '/' + key, value, result)
+        elif isinstance(node, list) and len(node) \
+             and isinstance(node[0], dict):
+            # enumerated children, i.e. /sensors/gps[0]
+            for i, value in enumerate(node):
+                self.flatten('%s[%d]' % (prefix, i), value, result)
+        else:
+            result[prefix] = node
+
+    # walk the subtrees at paths (i.e. [ '/sensors/gps[0]' ], None for
+    # the whole tree) and record what changed in them, returns the new
+    # generation.  Leaves outside those subtrees keep their last value.
+    def refresh(self, paths=None):
+        subtrees = normalize(paths)
+        current = {}
+        for subtree in subtrees:
+            if subtree == '':
+                node = self.root
+            else:
+                node = self.root.getChild(subtree[1:])
+            if node is None:
+                continue
+            tree = {}
+            props_json.buildDict(tree, node)
+            self.flatten(subtree, tree, current)
+        changed = []
+        for path, value in current.items():
+            if path not in self.leaves or self.leaves[path] != value:
+                changed.append(path)
+        removed = [ path for path in self.leaves
+                    if path not in current and under(path, subtrees) ]
+        for path in removed:
+            del self.leaves[path]
+        self.leaves.update(current)
+        self.generation += 1
+        self.history.append( (self.generation, changed, removed) )
+        return self.generation
+
+    # changes since generation 'since' within the subtrees at paths
+    # (None for the whole tree) as a dict ready for json:
+    # { 'gen': N, 'full': bool, 'set': { path: value }, 'del': [ path ] }
+    def changes(self, since, paths=None):
+        subtrees = normalize(paths)
+        if since <= 0 or not len(self.history) \
+           or since < self.history[0][0] - 1 or since > self.generation:
+            # new client, or too far behind: send everything
+            leaves = { path: value for path, value in self.leaves.items()
+                       if under(path, subtrees) }
+            return { 'gen': self.generation, 'full': True,
+                     'set': leaves, 'del': [] }
+        changed = set()
+        removed = set()
+        for (gen, c, r) in self.history:
+            if gen > since:
+                changed.update(c)
+                changed.difference_update(r)
+                removed.difference_update(c)
+                removed.update(r)
+        result = {}
+        for path in changed:
+            if under(path, subtrees):
+                result[path] = self.leaves[path]
+        removed = [ path for path in removed if under(path, subtrees) ]
+        return { 'gen': self.generation, 'full': False,
+                 'set': result, 'del': removed }
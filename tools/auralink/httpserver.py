@@ -1,6 +1,7 @@
 # tornado based websocket server
 
 import json
+import time
 import tornado
 import tornado.httpserver
 import tornado.websocket
@@ -8,13 +9,23 @@ import tornado.websocket
 from props import root, getNode
 import props_json
 
+import changefeed
 import commands
 import projects
 
+feed = changefeed.ChangeFeed(root)
+feed_time = 0.0
+max_feed_hz = 20                # tree walks per second, shared by all clients
+subscribers = []
+
 class WSHandler(tornado.websocket.WebSocketHandler):
     def open(self):
         print('new connection')
         self.bind_props()
+        self.feed_gen = 0
+        self.feed_dt = 0.0
+        self.feed_next = 0.0
+        self.feed_paths = None
       
     def on_message(self, message):
         # print('message received:  %s' % message)
@@ -28,6 +39,29 @@ class WSHandler(tornado.websocket.WebSocketHandler):
                 props_json.buildDict(dict_mirror, root)
                 self.write_message(json.dumps(dict_mirror, separators=(',',':'),
                                               sort_keys=True) + '\r\n')
+            elif args.startswith('changes'):
+                # poll for the leaves changed since a generation:
+                # get changes <gen> [path ...]
+                tokens = args.split()
+                since = 0
+                if len(tokens) > 1:
+                    since = int(tokens[1])
+                self.feed_paths = tokens[2:] or None # None: whole tree
+                refresh_feed( feed_paths(subscribers + [self]) )
+                self.send_changes(since)
+        elif command == 'subscribe':
+            # push changes at a fixed rate: subscribe <hz> [path ...]
+            tokens = args.split()
+            hz = float(tokens[0])
+            if hz > 0:
+                self.feed_dt = 1.0 / hz
+                self.feed_next = 0.0
+                self.feed_paths = tokens[1:] or None
+                if self not in subscribers:
+                    subscribers.append(self)
+        elif command == 'unsubscribe':
+            if self in subscribers:
+                subscribers.remove(self)
         elif command == 'send':
             # request relay 'args' string up to aircraft
             commands.add(str(args))
@@ -43,6 +77,13 @@ class WSHandler(tornado.websocket.WebSocketHandler):
 
     def on_close(self):
         print('connection closed')
+        if self in subscribers:
+            subscribers.remove(self)
+
+    def send_changes(self, since):
+        delta = feed.changes(since, self.feed_paths)
+        self.feed_gen = delta['gen']
+        self.write_message(json.dumps(delta, separators=(',',':')) + '\r\n')
  
     def check_origin(self, origin):
         return True
@@ -83,6 +124,41 @@ def init(port=8888, html_root='.'):
     print('Http server on http://localhost:' + str(port) + '/')
     print('Websocket server on http://localhost:' + str(port) + '/ws')
     
+# the union of the clients' subtrees, None if any wants the whole tree
+def feed_paths(clients):
+    paths = []
+    for client in clients:
+        if client.feed_paths is None:
+            return None
+        paths.extend(client.feed_paths)
+    return paths
+
+# walk the subscribed subtrees at most max_feed_hz times a second no
+# matter how many clients are asking
+def refresh_feed(paths):
+    global feed_time
+    now = time.time()
+    if now - feed_time >= 1.0 / max_feed_hz:
+        feed_time = now
+        commands.remote_lost_link_predict()
+        root.setBool("main_magic", True)
+        feed.refresh(paths)
+
+def push_changes():
+    now = time.time()
+    paths = feed_paths(subscribers)
+    for client in list(subscribers):
+        if now >= client.feed_next:
+            client.feed_next = now + client.feed_dt
+            refresh_feed(paths)
+            try:
+                client.send_changes(client.feed_gen)
+            except tornado.websocket.WebSocketClosedError:
+                # closed without an on_close() (yet)
+                if client in subscribers:
+                    subscribers.remove(client)
+
 def update():
     tornado.ioloop.IOLoop.instance().run_sync(nullfunc)
+    push_changes()
     
@@ -9,6 +9,12 @@ from aurauas_flightdata import flight_interp
 
 import lowpass
 
+try:
+    import numpy as np
+    from auracore import windtri
+except ImportError:
+    windtri = None
+
 # useful constants
 d2r = math.pi / 180.0
 r2d = 180.0 / math.pi
@@ -76,6 +82,8 @@ class Wind():
         wind_deg = 0
         wind_kt = 0
         ps = 1.0
+        if windtri:
+            return self.estimate_fast(data)
         iter = flight_interp.IterateGroup(data)
         for i in tqdm(range(iter.size())):
             record = iter.next()
@@ -100,3 +108,35 @@ class Wind():
                                 'wind_kt': wind_kt,
                                 'pitot_scale': ps } )
         return winds
+
+    # same estimate run through the auracore array kernel.  Each imu
+    # record is paired with the newest air and filter records at or
+    # before it (as IterateGroup pairs them) by a sorted search over
+    # whole columns.  Returns the result as columns rather than a
+    # dict per record; both load into a DataFrame the same way.
+    def estimate_fast(self, data):
+        time = column(data['imu'], 'time')
+        (airspeed,) = sample_hold(data, 'air', ['airspeed'], time)
+        (psi, vn, ve) = sample_hold(data, 'filter', ['psi', 'vn', 've'], time)
+        result = windtri.estimate(time, airspeed, psi, vn, ve,
+                                  self.wind_time_factor,
+                                  self.pitot_time_factor)
+        return { 'time': time,
+                 'wind_deg': result[:,0],
+                 'wind_kt': result[:,1],
+                 'pitot_scale': result[:,2] }
+
+# one field of a list of records as an array
+def column(records, key):
+    return np.fromiter((r[key] for r in records), dtype=np.float64,
+                       count=len(records))
+
+# the given fields of the newest record in data[group] at or before
+# each time (zero before the first record)
+def sample_hold(data, group, keys, time):
+    records = data.get(group, [])
+    if not len(records):
+        return [ np.zeros(len(time)) for key in keys ]
+    idx = np.searchsorted(column(records, 'time'), time, side='right') - 1
+    # index -1 picks up the appended zero
+    return [ np.append(column(records, key), 0.0)[idx] for key in keys ]
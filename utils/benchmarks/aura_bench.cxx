@@ -0,0 +1,72 @@
+// aura_bench - micro benchmarks for the flight code hot paths
+//
+// Times the nav filters, message packing, serial link parsing, sensor
+// calibration, signal filters, geodesy conversions and property tree
+// access using the same libraries the aura executable links against.
+// Optionally writes the results as json so runs on different boards
+// (or different releases) can be compared with bench_compare.py.
+
+#include <stdio.h>
+#include <stdlib.h>             // exit()
+#include <string.h>
+
+#include <string>
+using std::string;
+
+#include "bench.hxx"
+
+void usage() {
+    printf("\nUsage: aura_bench --option1 arg1 --option2 arg2 ...\n");
+    printf("--json file.json     (write machine readable results)\n");
+    printf("--min-time sec       (target time per timed batch, default 0.2)\n");
+    printf("--repeats n          (timed batches per benchmark, default 5)\n");
+    printf("--filter string      (only run benchmarks containing string)\n");
+    printf("--python_path path   (extra python module path for the props benchmarks)\n");
+    exit(0);
+}
+
+int main( int argc, char **argv ) {
+    string json_file = "";
+    string filter = "";
+    string python_path = "";
+    double min_time = 0.2;
+    int repeats = 5;
+
+    // Parse the command line
+    for ( int iarg = 1; iarg < argc; iarg++ ) {
+        if ( !strcmp(argv[iarg], "--json") && iarg + 1 < argc ) {
+            json_file = argv[++iarg];
+        } else if ( !strcmp(argv[iarg], "--min-time") && iarg + 1 < argc ) {
+            min_time = atof( argv[++iarg] );
+        } else if ( !strcmp(argv[iarg], "--repeats") && iarg + 1 < argc ) {
+            repeats = atoi( argv[++iarg] );
+        } else if ( !strcmp(argv[iarg], "--filter") && iarg + 1 < argc ) {
+            filter = argv[++iarg];
+        } else if ( !strcmp(argv[iarg], "--python_path") && iarg + 1 < argc ) {
+            python_path = argv[++iarg];
+        } else {
+            usage();
+        }
+    }
+
+    AuraBench bench( min_time, repeats );
+    bench.set_filter( filter );
+
+    bench_ekf15( bench );
+    bench_ekf15_mag( bench );
+    bench_messages( bench );
+    bench_serial( bench );
+    bench_util( bench );
+    bench_props( bench, python_path );
+
+    bench.print_summary();
+
+    if ( json_file != "" ) {
+        if ( !bench.write_json( json_file.c_str() ) ) {
+            return 1;
+        }
+        printf("wrote results to %s\n", json_file.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+// bench.cxx - tiny micro benchmark harness for the flight code hot paths
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/utsname.h>
+
+#include <algorithm>
+
+#include "bench.hxx"
+
+volatile double bench_sink = 0.0;
+
+AuraBench::AuraBench( double min_time, int repeats ):
+    min_time(min_time),
+    repeats(repeats)
+{
+    if ( this->repeats < 1 ) {
+        this->repeats = 1;
+    }
+}
+
+bool AuraBench::enabled( const string &name ) {
+    return filter == "" || name.find(filter) != string::npos;
+}
+
+// grow the batch size until a batch takes roughly min_time to run
+long AuraBench::calibrate_batch( double (*timer)(void *, long), void *ctx ) {
+    long n = 1;
+    while ( true ) {
+        double elapsed = timer( ctx, n );
+        if ( elapsed >= min_time || n >= (1L << 30) ) {
+            break;
+        }
+        if ( elapsed < min_time / 100.0 ) {
+            n *= 10;
+        } else {
+            // aim a little past the target so we don't loop forever
+            // on the edge
+            n = (long)(n * 1.2 * min_time / elapsed) + 1;
+        }
+    }
+    return n;
+}
+
+void AuraBench::record( const string &name, long n, vector<double> &elapsed ) {
+    std::sort( elapsed.begin(), elapsed.end() );
+    BenchResult r;
+    r.name = name;
+    r.iterations = n;
+    r.repeats = elapsed.size();
+    r.ns_per_op = 1.0e9 * elapsed[0] / (double)n;
+    r.ns_per_op_median = 1.0e9 * elapsed[elapsed.size() / 2] / (double)n;
+    results.push_back( r );
+    printf( "%-36s %12.1f ns/op (median %.1f, n = %ld)\n",
+            name.c_str(), r.ns_per_op, r.ns_per_op_median, n );
+}
+
+void AuraBench::run_manual( const string &name,
+                            double (*timer)(void *, long), void *ctx )
+{
+    if ( !enabled(name) ) {
+        return;
+    }
+    long n = calibrate_batch( timer, ctx );
+    vector<double> elapsed;
+    for ( int i = 0; i < repeats; i++ ) {
+        elapsed.push_back( timer(ctx, n) );
+    }
+    record( name, n, elapsed );
+}
+
+void AuraBench::skip( const string &name, const string &reason ) {
+    if ( !enabled(name) ) {
+        return;
+    }
+    printf( "%-36s skipped: %s\n", name.c_str(), reason.c_str() );
+    skipped.push_back( name + ": " + reason );
+}
+
+void AuraBench::print_summary() {
+    printf( "%d benchmarks run, %d skipped\n",
+            (int)results.size(), (int)skipped.size() );
+}
+
+// write a json string value with the minimal escaping we need
+static void write_json_string( FILE *fp, const string &s ) {
+    fputc( '"', fp );
+    for ( unsigned int i = 0; i < s.length(); i++ ) {
+        char c = s[i];
+        if ( c == '"' || c == '\\' ) {
+            fputc( '\\', fp );
+            fputc( c, fp );
+        } else if ( (unsigned char)c < 0x20 ) {
+            fprintf( fp, "\\u%04x", c );
+        } else {
+            fputc( c, fp );
+        }
+    }
+    fputc( '"', fp );
+}
+
+bool AuraBench::write_json( const char *file_name ) {
+    FILE *fp = fopen( file_name, "w" );
+    if ( fp == NULL ) {
+        perror( file_name );
+        return false;
+    }
+
+    struct utsname host;
+    if ( uname(&host) != 0 ) {
+        memset( &host, 0, sizeof(host) );
+    }
+
+    fprintf( fp, "{\n" );
+    fprintf( fp, "    \"format\": \"aura-bench-1\",\n" );
+    fprintf( fp, "    \"unix_time_sec\": %ld,\n", (long)time(NULL) );
+    fprintf( fp, "    \"host\": {\n" );
+    fprintf( fp, "        \"nodename\": " );
+    write_json_string( fp, host.nodename );
+    fprintf( fp, ",\n        \"machine\": " );
+    write_json_string( fp, host.machine );
+    fprintf( fp, ",\n        \"sysname\": " );
+    write_json_string( fp, host.sysname );
+    fprintf( fp, ",\n        \"release\": " );
+    write_json_string( fp, host.release );
+    fprintf( fp, "\n    },\n" );
+    fprintf( fp, "    \"compiler\": " );
+    write_json_string( fp, __VERSION__ );
+    fprintf( fp, ",\n    \"min_time_sec\": %.3f,\n", min_time );
+    fprintf( fp, "    \"results\": [\n" );
+    for ( unsigned int i = 0; i < results.size(); i++ ) {
+        BenchResult &r = results[i];
+        fprintf( fp, "        { \"name\": " );
+        write_json_string( fp, r.name );
+        fprintf( fp, ", \"ns_per_op\": %.2f, \"ns_per_op_median\": %.2f, \"iterations\": %ld, \"repeats\": %d }%s\n",
+                 r.ns_per_op, r.ns_per_op_median, r.iterations, r.repeats,
+                 i + 1 < results.size() ? "," : "" );
+    }
+    fprintf( fp, "    ],\n" );
+    fprintf( fp, "    \"skipped\": [\n" );
+    for ( unsigned int i = 0; i < skipped.size(); i++ ) {
+        fprintf( fp, "        " );
+        write_json_string( fp, skipped[i] );
+        fprintf( fp, "%s\n", i + 1 < skipped.size() ? "," : "" );
+    }
+    fprintf( fp, "    ]\n" );
+    fprintf( fp, "}\n" );
+
+    fclose( fp );
+    return true;
+}
@@ -0,0 +1,90 @@
+// bench.hxx - tiny micro benchmark harness for the flight code hot paths
+//
+// Each benchmark case is timed in batches.  The batch size is grown
+// until a batch takes a measurable amount of time, then the batch is
+// repeated a few times and the best (and median) cost per operation
+// is recorded.  Results can be written out as json so runs on
+// different boards or releases can be compared mechanically.
+
+#pragma once
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#include "util/timing.h"
+
+// keep the compiler from optimizing away the work we are timing
+extern volatile double bench_sink;
+
+struct BenchResult {
+    string name;
+    long iterations;            // operations per timed batch
+    int repeats;                // number of timed batches
+    double ns_per_op;           // best batch
+    double ns_per_op_median;    // median batch
+};
+
+class AuraBench {
+
+private:
+
+    double min_time;            // target run time of a single batch (sec)
+    int repeats;                // number of timed batches per case
+    string filter;              // only run cases containing this string
+
+    vector<BenchResult> results;
+    vector<string> skipped;
+
+    long calibrate_batch( double (*timer)(void *, long), void *ctx );
+    void record( const string &name, long n, vector<double> &elapsed );
+
+public:
+
+    AuraBench( double min_time = 0.2, int repeats = 5 );
+    ~AuraBench() {}
+
+    inline void set_filter( const string &f ) { filter = f; }
+    bool enabled( const string &name );
+
+    // time func() called repeatedly; setup() is run (untimed) before
+    // every batch so stateful cases can start from a known state.
+    template <class Setup, class Func>
+    void run( const string &name, Setup setup, Func func ) {
+        struct ctx_t { Setup *setup; Func *func; } ctx = { &setup, &func };
+        run_manual( name, [](void *p, long n) -> double {
+            ctx_t *c = (ctx_t *)p;
+            (*c->setup)();
+            double start = get_Time();
+            for ( long i = 0; i < n; i++ ) {
+                (*c->func)();
+            }
+            return get_Time() - start;
+        }, &ctx );
+    }
+
+    template <class Func>
+    void run( const string &name, Func func ) {
+        run( name, []() {}, func );
+    }
+
+    // the timer callback performs n operations and returns the
+    // elapsed time (sec) it measured.  Use this for cases that need
+    // to exclude per-operation setup work from the measurement.
+    void run_manual( const string &name, double (*timer)(void *, long),
+                     void *ctx );
+
+    void skip( const string &name, const string &reason );
+
+    void print_summary();
+    bool write_json( const char *file_name );
+};
+
+// benchmark groups
+void bench_ekf15( AuraBench &bench );
+void bench_ekf15_mag( AuraBench &bench );
+void bench_messages( AuraBench &bench );
+void bench_serial( AuraBench &bench );
+void bench_util( AuraBench &bench );
+void bench_props( AuraBench &bench, const string &python_path );
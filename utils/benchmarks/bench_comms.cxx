@@ -0,0 +1,149 @@
+// bench_comms.cxx - message packing and serial link benchmarks
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "comms/aura_messages.h"
+#include "comms/serial_link.hxx"
+
+#include "bench.hxx"
+
+void bench_messages( AuraBench &bench ) {
+    static message::imu_v4_t imu;
+    imu.index = 0;
+    imu.timestamp_sec = 1234.56;
+    imu.p_rad_sec = 0.01; imu.q_rad_sec = -0.02; imu.r_rad_sec = 0.03;
+    imu.ax_mps_sec = 0.1; imu.ay_mps_sec = -0.2; imu.az_mps_sec = -9.8;
+    imu.hx = 0.3; imu.hy = 0.1; imu.hz = 0.9;
+    imu.temp_C = 31.5;
+    imu.status = 0;
+    bench.run( "messages.imu_v4.pack", []() {
+        imu.pack();
+        bench_sink = imu.len;
+    } );
+    bench.run( "messages.imu_v4.unpack", []() {
+        static message::imu_v4_t msg;
+        msg.unpack( imu.payload, imu.len );
+        bench_sink = msg.temp_C;
+    } );
+
+    static message::filter_v4_t nav = {};
+    nav.timestamp_sec = 1234.56;
+    nav.latitude_deg = 44.98; nav.longitude_deg = -93.27; nav.altitude_m = 280.0;
+    nav.vn_ms = 10.0; nav.ve_ms = -5.0; nav.vd_ms = 0.5;
+    nav.roll_deg = 10.0; nav.pitch_deg = 2.0; nav.yaw_deg = 270.0;
+    bench.run( "messages.filter_v4.pack", []() {
+        nav.pack();
+        bench_sink = nav.len;
+    } );
+    bench.run( "messages.filter_v4.unpack", []() {
+        static message::filter_v4_t msg;
+        msg.unpack( nav.payload, nav.len );
+        bench_sink = msg.yaw_deg;
+    } );
+
+    static message::gps_v4_t gps = {};
+    gps.timestamp_sec = 1234.56;
+    gps.latitude_deg = 44.98; gps.longitude_deg = -93.27; gps.altitude_m = 280.0;
+    gps.unixtime_sec = 1500000000.0;
+    gps.satellites = 12;
+    bench.run( "messages.gps_v4.pack", []() {
+        gps.pack();
+        bench_sink = gps.len;
+    } );
+    bench.run( "messages.gps_v4.unpack", []() {
+        static message::gps_v4_t msg;
+        msg.unpack( gps.payload, gps.len );
+        bench_sink = msg.latitude_deg;
+    } );
+
+    static message::actuator_v3_t act = {};
+    act.timestamp_sec = 1234.56;
+    act.aileron = 0.1; act.elevator = -0.2; act.throttle = 0.6; act.rudder = 0.05;
+    bench.run( "messages.actuator_v3.pack", []() {
+        act.pack();
+        bench_sink = act.len;
+    } );
+    bench.run( "messages.actuator_v3.unpack", []() {
+        static message::actuator_v3_t msg;
+        msg.unpack( act.payload, act.len );
+        bench_sink = msg.throttle;
+    } );
+}
+
+
+// the serial link is benchmarked through a pseudo terminal so the
+// parser runs through the same tty read() path it uses in flight.
+static const int SERIAL_BATCH = 32;        // stays well under the tty buffer
+static SerialLink serial;
+static int pty_master = -1;
+static uint8_t frame[message::message_max_len + 6];
+static int frame_len = 0;
+
+static void build_frame() {
+    message::imu_v4_t imu = {};
+    imu.az_mps_sec = -9.8;
+    imu.pack();
+    frame[0] = 147;             // START_OF_MSG0
+    frame[1] = 224;             // START_OF_MSG1
+    frame[2] = imu.id;
+    frame[3] = imu.len;
+    memcpy( frame + 4, imu.payload, imu.len );
+    SerialLink::checksum( imu.id, imu.len, imu.payload, imu.len,
+                          &frame[4 + imu.len], &frame[5 + imu.len] );
+    frame_len = imu.len + 6;
+}
+
+static double time_serial_parse( void *ctx, long n ) {
+    double elapsed = 0.0;
+    for ( long done = 0; done < n; done += SERIAL_BATCH ) {
+        int count = SERIAL_BATCH;
+        if ( n - done < count ) {
+            count = n - done;
+        }
+        for ( int i = 0; i < count; i++ ) {
+            if ( write( pty_master, frame, frame_len ) != frame_len ) {
+                perror( "pty write" );
+                exit( 1 );
+            }
+        }
+        double start = get_Time();
+        for ( int i = 0; i < count; i++ ) {
+            while ( !serial.update() );
+        }
+        elapsed += get_Time() - start;
+    }
+    return elapsed;
+}
+
+void bench_serial( AuraBench &bench ) {
+    build_frame();
+
+    bench.run( "serial.checksum", []() {
+        uint8_t c0, c1;
+        SerialLink::checksum( frame[2], frame[3], frame + 4, frame[3],
+                              &c0, &c1 );
+        bench_sink = c0 + c1;
+    } );
+
+    if ( !bench.enabled("serial.parse_imu_packet") ) {
+        return;
+    }
+    pty_master = posix_openpt( O_RDWR | O_NOCTTY );
+    if ( pty_master < 0 || grantpt(pty_master) != 0
+         || unlockpt(pty_master) != 0 ) {
+        bench.skip( "serial.parse_imu_packet", "no pseudo terminal available" );
+        return;
+    }
+    if ( !serial.open( 115200, ptsname(pty_master) ) ) {
+        bench.skip( "serial.parse_imu_packet", "cannot open pty slave" );
+        close( pty_master );
+        return;
+    }
+    bench.run_manual( "serial.parse_imu_packet", time_serial_parse, NULL );
+    serial.close();
+    close( pty_master );
+}
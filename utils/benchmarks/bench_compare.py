@@ -0,0 +1,60 @@
+#!/usr/bin/python3
+
+# compare two aura_bench json result files (i.e. two releases or two
+# boards) and flag the benchmarks that got slower.
+
+import argparse
+import json
+import sys
+
+parser = argparse.ArgumentParser(description='compare aura_bench results.')
+parser.add_argument('baseline', help='baseline results (json)')
+parser.add_argument('current', help='current results (json)')
+parser.add_argument('--threshold', type=float, default=10.0,
+                    help='percent slowdown reported as a regression')
+args = parser.parse_args()
+
+def load(filename):
+    with open(filename, 'r') as f:
+        data = json.load(f)
+    results = {}
+    for r in data['results']:
+        results[r['name']] = r
+    return data, results
+
+base_data, base = load(args.baseline)
+cur_data, cur = load(args.current)
+
+def host_str(data):
+    h = data.get('host', {})
+    return "%s (%s) %s" % (h.get('nodename', '?'), h.get('machine', '?'),
+                           data.get('compiler', ''))
+
+print("baseline:", host_str(base_data))
+print("current: ", host_str(cur_data))
+print()
+print("%-36s %12s %12s %8s" % ("benchmark", "base ns/op", "cur ns/op", "change"))
+
+regressions = 0
+for name in sorted(set(base.keys()) | set(cur.keys())):
+    if name not in base:
+        print("%-36s %12s %12.1f %8s" % (name, "-", cur[name]['ns_per_op'], "new"))
+        continue
+    if name not in cur:
+        print("%-36s %12.1f %12s %8s" % (name, base[name]['ns_per_op'], "-", "gone"))
+        continue
+    b = base[name]['ns_per_op']
+    c = cur[name]['ns_per_op']
+    change = 0.0
+    if b > 0.0:
+        change = 100.0 * (c - b) / b
+    flag = ""
+    if change > args.threshold:
+        flag = "  <-- slower"
+        regressions += 1
+    print("%-36s %12.1f %12.1f %+7.1f%%%s" % (name, b, c, change, flag))
+
+print()
+print("%d benchmark(s) slower by more than %.0f%%" % (regressions, args.threshold))
+if regressions:
+    sys.exit(1)
@@ -0,0 +1,12 @@
+// bench_ekf15.cxx - 15 state ekf (gps only) benchmarks
+
+#include "filters/nav_ekf15/EKF_15state.hxx"
+
+#include "bench_nav.hxx"
+
+void bench_ekf15( AuraBench &bench ) {
+    bench_nav_filter<EKF15>( bench, "ekf15",
+        [](EKF15 &filter, IMUdata &imu, GPSdata &gps) {
+            filter.measurement_update( gps );
+        } );
+}
@@ -0,0 +1,12 @@
+// bench_ekf15_mag.cxx - 15 state ekf (gps + magnetometer) benchmarks
+
+#include "filters/nav_ekf15_mag/EKF_15state.hxx"
+
+#include "bench_nav.hxx"
+
+void bench_ekf15_mag( AuraBench &bench ) {
+    bench_nav_filter<EKF15_mag>( bench, "ekf15_mag",
+        [](EKF15_mag &filter, IMUdata &imu, GPSdata &gps) {
+            filter.measurement_update( imu, gps );
+        } );
+}
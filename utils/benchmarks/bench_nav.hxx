@@ -0,0 +1,97 @@
+// bench_nav.hxx - shared nav filter benchmark driver
+//
+// The ekf15 and ekf15_mag headers can't be included in the same
+// translation unit (they share type names), so each filter gets its
+// own small source file that instantiates this template.
+
+#pragma once
+
+#include <math.h>
+
+#include "filters/nav_common/structs.hxx"
+
+#include "bench.hxx"
+
+// a deterministic, slightly noisy, level and stationary aircraft
+class BenchNavData {
+
+private:
+
+    uint32_t seed;
+
+    float noise( float scale ) {
+        seed = seed * 1664525 + 1013904223;
+        return scale * ((float)(seed >> 8) / 16777216.0f - 0.5f);
+    }
+
+public:
+
+    IMUdata imu;
+    GPSdata gps;
+
+    BenchNavData() {
+        reset();
+    }
+
+    void reset() {
+        seed = 12345;
+        imu.time = 0.0;
+        gps.time = 0.0;
+        gps.unix_sec = 1500000000.0;
+        gps.lat = 44.98;
+        gps.lon = -93.27;
+        gps.alt = 280.0;
+        gps.vn = gps.ve = gps.vd = 0.0;
+        gps.sats = 10;
+        next_imu();
+    }
+
+    void next_imu() {
+        imu.time += 0.01;
+        imu.p = noise(0.002); imu.q = noise(0.002); imu.r = noise(0.002);
+        imu.ax = noise(0.05); imu.ay = noise(0.05); imu.az = -9.81 + noise(0.05);
+        imu.hx = 0.3 + noise(0.01); imu.hy = 0.0 + noise(0.01); imu.hz = 0.9 + noise(0.01);
+        imu.temp = 30.0;
+    }
+
+    void next_gps() {
+        gps.time = imu.time;
+        gps.unix_sec += 0.1;
+    }
+};
+
+template <class Filter, class Update>
+void bench_nav_filter( AuraBench &bench, const string &prefix,
+                       Update measurement_update )
+{
+    static Filter filter;
+    static BenchNavData data;
+
+    auto reinit = []() {
+        data.reset();
+        filter.init( data.imu, data.gps );
+    };
+
+    bench.run( prefix + ".time_update", reinit, []() {
+        data.next_imu();
+        filter.time_update( data.imu );
+    } );
+
+    bench.run( prefix + ".measurement_update", reinit, [&]() {
+        data.next_gps();
+        measurement_update( filter, data.imu, data.gps );
+    } );
+
+    // one 100hz frame with a 10hz gps, as the flight code runs it
+    static int frame = 0;
+    bench.run( prefix + ".frame_100hz", reinit, [&]() {
+        data.next_imu();
+        filter.time_update( data.imu );
+        if ( ++frame % 10 == 0 ) {
+            data.next_gps();
+            measurement_update( filter, data.imu, data.gps );
+        }
+        NAVdata nav = filter.get_nav();
+        bench_sink = nav.phi;
+    } );
+}
@@ -0,0 +1,52 @@
+// bench_props.cxx - python property tree access benchmarks
+
+#include <python_sys.hxx>
+#include <pyprops.hxx>
+
+#include <stdio.h>
+
+#include "bench.hxx"
+
+void bench_props( AuraBench &bench, const string &python_path ) {
+    if ( !bench.enabled("props.") ) {
+        return;
+    }
+
+    // the props benchmarks need the python property system
+    // importable (see --python_path)
+    char progname[] = "aura_bench";
+    char *argv[] = { progname, NULL };
+    AuraPythonInit( 1, argv, python_path.c_str() );
+    PyObject *pModule = PyImport_ImportModule("props");
+    if ( pModule == NULL ) {
+        PyErr_Clear();
+        bench.skip( "props.getDouble", "python props module not found" );
+        bench.skip( "props.setDouble", "python props module not found" );
+        bench.skip( "props.getString", "python props module not found" );
+        bench.skip( "props.pyGetNode", "python props module not found" );
+        return;
+    }
+    Py_DECREF( pModule );
+    pyPropsInit();
+
+    static pyPropertyNode imu_node = pyGetNode("/sensors/imu", true);
+    static pyPropertyNode config_node = pyGetNode("/config/bench", true);
+    imu_node.setDouble( "p_rad_sec", 0.01 );
+    config_node.setString( "source", "Aura3" );
+
+    bench.run( "props.getDouble", []() {
+        bench_sink = imu_node.getDouble( "p_rad_sec" );
+    } );
+    static double val = 0.0;
+    bench.run( "props.setDouble", []() {
+        val += 0.001;
+        imu_node.setDouble( "q_rad_sec", val );
+    } );
+    bench.run( "props.getString", []() {
+        bench_sink = config_node.getString( "source" ).length();
+    } );
+    bench.run( "props.pyGetNode", []() {
+        pyPropertyNode node = pyGetNode( "/sensors/imu" );
+        bench_sink = node.isNull();
+    } );
+}
@@ -0,0 +1,111 @@
+// bench_util.cxx - calibration, signal filter and geodesy benchmarks
+
+#include <math.h>
+
+#include "filters/nav_common/nav_functions_float.hxx"
+#include "sensors/cal_temp.hxx"
+#include "util/biquad.hxx"
+#include "util/butter.hxx"
+#include "util/geodesy.hxx"
+#include "util/linearfit.hxx"
+#include "util/lowpass.hxx"
+
+#include "bench.hxx"
+
+void bench_util( AuraBench &bench ) {
+    static float temp = 20.0;
+    static float raw = 0.1;
+
+    // default calibration (linear bias + scale polynomials)
+    static AuraCalTemp cal;
+    bench.run( "cal_temp.calibrate", []() {
+        temp += 0.001;
+        if ( temp > 40.0 ) { temp = 20.0; }
+        bench_sink = cal.calibrate( raw, temp );
+    } );
+
+    // same order and cutoff as the pitot filter in the APM2/Aura3
+    // drivers
+    static ButterworthFilter butter(2, 100, 0.8);
+    bench.run( "butter.update_order2", []() {
+        raw = -raw;
+        bench_sink = butter.update( raw );
+    } );
+    static ButterworthFilter butter8(8, 100, 10.0);
+    bench.run( "butter.update_order8", []() {
+        raw = -raw;
+        bench_sink = butter8.update( raw );
+    } );
+
+    // same time factor and dt as the imu clock offset fit
+    static LinearFitFilter fit(200.0, 0.01);
+    static double fit_x = 0.0;
+    bench.run( "linearfit.update", []() {
+        fit_x += 0.01;
+        fit.update( fit_x, 0.5 + 0.0001 * fit_x );
+        bench_sink = fit.get_value( fit_x );
+    } );
+
+    static ButterworthLowpass<2> biquad2(100, 0.8);
+    bench.run( "biquad.butterworth_order2", []() {
+        raw = -raw;
+        bench_sink = biquad2.update( raw );
+    } );
+    static ButterworthLowpass<8> biquad8(100, 10.0);
+    bench.run( "biquad.butterworth_order8", []() {
+        raw = -raw;
+        bench_sink = biquad8.update( raw );
+    } );
+
+    // 9 imu axes through a lowpass and a notch
+    static BiquadBank<9, 2> bank;
+    bank.set_section( 0, biquad_lowpass( 100, 30.0, M_SQRT1_2 ) );
+    bank.set_section( 1, biquad_notch( 100, 40.0, 2.0 ) );
+    bench.run( "biquad.bank_9x2", []() {
+        static const float imu[9] = { 0.01, -0.02, 0.03, 0.1, -0.2, -9.8, 0.3, 0.1, 0.9 };
+        float x[9];
+        raw = -raw;
+        for ( int i = 0; i < 9; i++ ) {
+            x[i] = imu[i] + raw;
+        }
+        bank.update( x );
+        bench_sink = x[5];
+    } );
+
+    static LowPassFilter lowpass(0.5);
+    bench.run( "lowpass.update", []() {
+        raw = -raw;
+        bench_sink = lowpass.update( raw, 0.01 );
+    } );
+
+    static Vector3d lla( 44.98 * M_PI / 180.0, -93.27 * M_PI / 180.0, 280.0 );
+    static Vector3d ecef = lla2ecef( lla );
+    bench.run( "geodesy.lla2ecef", []() {
+        Vector3d result = lla2ecef( lla );
+        bench_sink = result(0);
+    } );
+    bench.run( "geodesy.ecef2lla", []() {
+        Vector3d result = ecef2lla( ecef );
+        bench_sink = result(0);
+    } );
+    bench.run( "geodesy.ecef2lla_for_ublox6", []() {
+        Vector3d result = ecef2lla_for_ublox6( ecef );
+        bench_sink = result(0);
+    } );
+    static Vector3d ref = lla;
+    ref(2) = 0.0;
+    bench.run( "geodesy.ecef2ned", []() {
+        Vector3f result = ecef2ned( ecef, ref );
+        bench_sink = result(0);
+    } );
+    bench.run( "geodesy.fromLonLatRad", []() {
+        Quaterniond q = fromLonLatRad( lla(1), lla(0) );
+        bench_sink = q.w();
+    } );
+    static Vector3d vel_ecef( 3.0, -45.0, 40.0 );
+    static Quaterniond ecef2ned_q = fromLonLatRad( lla(1), lla(0) );
+    bench.run( "geodesy.quat_backtransform", []() {
+        Vector3d result = quat_backtransform( ecef2ned_q, vel_ecef );
+        bench_sink = result(0);
+    } );
+}